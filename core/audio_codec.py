@@ -0,0 +1,254 @@
+"""
+Audio Codec Module - Uplink audio decoding for ESP32 STT streams
+Decodes negotiated uplink codecs (IMA-ADPCM, optional Opus) back to 16 kHz mono PCM16
+"""
+
+import struct
+import sys
+import warnings
+from array import array
+from typing import List, Optional
+
+# Codec names exchanged in the WebSocket handshake
+CODEC_PCM16 = "pcm16"
+CODEC_IMA_ADPCM = "ima_adpcm"
+CODEC_OPUS = "opus"
+
+UPLINK_SAMPLE_RATE = 16000
+OPUS_FRAME_SAMPLES = 320  # 20ms @ 16kHz, must match the firmware encoder
+
+# Optional Opus support - only advertised when the binding is installed
+try:
+    import opuslib  # type: ignore
+    OPUS_AVAILABLE = True
+except Exception:
+    opuslib = None
+    OPUS_AVAILABLE = False
+
+# IMA-ADPCM tables (identical to the firmware encoder in audio_codec.c)
+_IMA_INDEX_TABLE = (-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8)
+_IMA_STEP_TABLE = (
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+    11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+    32767
+)
+
+ADPCM_HEADER_SIZE = 4
+ADPCM_FLAG_ODD_SAMPLES = 0x01
+
+# C table decoder from the stdlib (same IMA algorithm; deprecated in 3.11, gone in 3.13).
+# Without it frames fall back to the pure-Python loop, which callers run off the event loop.
+try:
+    with warnings.catch_warnings():
+        warnings.simplefilter("ignore", DeprecationWarning)
+        import audioop  # type: ignore
+except ImportError:
+    audioop = None
+
+ADPCM_FAST = audioop is not None
+
+# audioop takes the high nibble first; our frames pack the low nibble first
+_NIBBLE_SWAP = bytes(((b & 0x0F) << 4) | (b >> 4) for b in range(256))
+
+
+def supported_codecs() -> List[str]:
+    """Codecs this server can decode, most compact first."""
+    codecs = [CODEC_IMA_ADPCM]
+    if OPUS_AVAILABLE:
+        codecs.insert(0, CODEC_OPUS)
+    codecs.append(CODEC_PCM16)
+    return codecs
+
+
+def negotiate_codec(offered: Optional[List[str]], forced: Optional[str] = None) -> str:
+    """
+    Pick the uplink codec for a session.
+
+    Args:
+        offered: Codec names from the device handshake, in device preference order.
+                 Missing/empty means a legacy device that only sends PCM16.
+        forced: Optional server override (STT_UPLINK_CODEC); honoured if the device offered it
+
+    Returns:
+        Codec name to announce in the "connected" reply
+    """
+    if not offered:
+        return CODEC_PCM16
+
+    available = supported_codecs()
+    if forced and forced in offered and forced in available:
+        return forced
+
+    for codec in offered:
+        if codec in available:
+            return codec
+    return CODEC_PCM16
+
+
+def decode_ima_adpcm_block(block: bytes) -> bytes:
+    """
+    Decode one self-contained IMA-ADPCM WebSocket frame.
+
+    Frame layout: int16 LE predictor, uint8 step index, uint8 flags, then packed
+    nibbles (low nibble first). Each frame carries its own starting state, so a
+    dropped frame on the device never desynchronizes later ones.
+    """
+    if len(block) < ADPCM_HEADER_SIZE:
+        return b""
+
+    predictor, index, flags = struct.unpack_from("<hBB", block, 0)
+    index = min(max(index, 0), 88)
+
+    if audioop is not None:
+        nibbles = block[ADPCM_HEADER_SIZE:].translate(_NIBBLE_SWAP)
+        pcm, _ = audioop.adpcm2lin(nibbles, 2, (predictor, index))
+        if (flags & ADPCM_FLAG_ODD_SAMPLES) and pcm:
+            pcm = pcm[:-2]
+        if sys.byteorder != "little":
+            pcm = audioop.byteswap(pcm, 2)
+        return pcm
+
+    return _decode_ima_adpcm_python(block[ADPCM_HEADER_SIZE:], predictor, index, flags)
+
+
+def _decode_ima_adpcm_python(payload: bytes, predictor: int, index: int, flags: int) -> bytes:
+    """Reference decoder for interpreters without audioop (~11 ms per second of audio)."""
+    out = array("h")
+
+    for byte in payload:
+        for nibble in (byte & 0x0F, byte >> 4):
+            step = _IMA_STEP_TABLE[index]
+            delta = step >> 3
+            if nibble & 4:
+                delta += step
+            if nibble & 2:
+                delta += step >> 1
+            if nibble & 1:
+                delta += step >> 2
+            if nibble & 8:
+                predictor -= delta
+                if predictor < -32768:
+                    predictor = -32768
+            else:
+                predictor += delta
+                if predictor > 32767:
+                    predictor = 32767
+            index += _IMA_INDEX_TABLE[nibble]
+            if index < 0:
+                index = 0
+            elif index > 88:
+                index = 88
+            out.append(predictor)
+
+    if (flags & ADPCM_FLAG_ODD_SAMPLES) and len(out) > 0:
+        out.pop()
+
+    if out.itemsize != 2:
+        raise RuntimeError("array('h') is not 16-bit on this platform")
+    if struct.pack("=h", 1) != struct.pack("<h", 1):
+        out.byteswap()
+    return out.tobytes()
+
+
+class UplinkDecoder:
+    """Per-session decoder turning uplink WebSocket frames into PCM16 bytes."""
+
+    def __init__(self, codec: str):
+        self.codec = codec
+        self._opus = None
+        if codec == CODEC_OPUS:
+            if not OPUS_AVAILABLE:
+                raise ValueError("Opus uplink negotiated but opuslib is not installed")
+            self._opus = opuslib.Decoder(UPLINK_SAMPLE_RATE, 1)
+
+    @property
+    def blocking(self) -> bool:
+        """True when decode() is slow enough that it should not run on the event loop."""
+        return self.codec == CODEC_OPUS or (self.codec == CODEC_IMA_ADPCM and not ADPCM_FAST)
+
+    def decode(self, payload: bytes) -> bytes:
+        if self.codec == CODEC_IMA_ADPCM:
+            return decode_ima_adpcm_block(payload)
+        if self.codec == CODEC_OPUS:
+            return self._decode_opus(payload)
+        return payload
+
+    def _decode_opus(self, payload: bytes) -> bytes:
+        # Frame layout: repeated [uint16 LE packet length][Opus packet]
+        pcm = bytearray()
+        offset = 0
+        while offset + 2 <= len(payload):
+            (packet_len,) = struct.unpack_from("<H", payload, offset)
+            offset += 2
+            packet = payload[offset:offset + packet_len]
+            offset += packet_len
+            if len(packet) != packet_len:
+                break
+            pcm += self._opus.decode(packet, OPUS_FRAME_SAMPLES)
+        return bytes(pcm)
+
+
+def encode_ima_adpcm(pcm: bytes, frame_bytes: int) -> bytes:
+    """
+    Encode PCM16 mono into back-to-back IMA-ADPCM frames of `frame_bytes`
+    (the last one may be shorter), in the same layout the device streams.
+
+    Encoder state carries across frames and each header snapshots it, exactly
+    like the firmware encoder, so the device can decode frames one at a time.
+    """
+    samples = array("h")
+    samples.frombytes(pcm[: len(pcm) - (len(pcm) % 2)])
+    if struct.pack("=h", 1) != struct.pack("<h", 1):
+        samples.byteswap()
+
+    per_frame = (frame_bytes - ADPCM_HEADER_SIZE) * 2
+    if per_frame <= 0:
+        raise ValueError(f"ADPCM frame of {frame_bytes} bytes holds no samples")
+
+    predictor = 0
+    index = 0
+    out = bytearray()
+
+    for start in range(0, len(samples), per_frame):
+        chunk = samples[start:start + per_frame]
+        flags = ADPCM_FLAG_ODD_SAMPLES if len(chunk) & 1 else 0
+        out += struct.pack("<hBB", predictor, index, flags)
+
+        codes = []
+        for sample in chunk:
+            step = _IMA_STEP_TABLE[index]
+            diff = sample - predictor
+            code = 0
+            if diff < 0:
+                code = 8
+                diff = -diff
+            # Reconstruct exactly as the decoder will, so predictor tracking never drifts
+            delta = step >> 3
+            if diff >= step:
+                code |= 4
+                diff -= step
+                delta += step
+            step >>= 1
+            if diff >= step:
+                code |= 2
+                diff -= step
+                delta += step
+            step >>= 1
+            if diff >= step:
+                code |= 1
+                delta += step
+
+            predictor += -delta if code & 8 else delta
+            predictor = min(max(predictor, -32768), 32767)
+            index = min(max(index + _IMA_INDEX_TABLE[code], 0), 88)
+            codes.append(code)
+
+        if len(codes) & 1:
+            codes.append(0)
+        out += bytes(codes[i] | (codes[i + 1] << 4) for i in range(0, len(codes), 2))
+
+    return bytes(out)
@@ -0,0 +1,53 @@
+"""
+Control Frames Module - binary control messages on the session WebSocket
+Compact alternative to the JSON status messages, negotiated at handshake
+(see json_protocol.h on the ESP32)
+"""
+
+import struct
+from typing import Iterator, Optional
+
+# Frame header (little-endian, 8 bytes): magic, version, type, payload length
+CONTROL_FRAME_MAGIC = b"HPCT"
+CONTROL_FRAME_VERSION = 1
+CONTROL_FRAME_HEADER = struct.Struct("<4sBBH")
+
+CONTROL_FRAME_TYPE_ACK = 1
+ACK_PAYLOAD = struct.Struct("<III")  # chunks_received, bytes_received, window_bytes
+
+CONTROL_FRAME_TYPE_PROMPT_CHUNK = 2
+PROMPT_CHUNK_HEADER = struct.Struct("<III")  # pack version, pack size, offset; data follows
+PROMPT_CHUNK_BYTES = 4096  # Fits the device's receive buffer with room to spare
+
+CONTROL_FRAMING_JSON = "json"
+CONTROL_FRAMING_BINARY = "binary"
+
+
+def negotiate_control_framing(requested: Optional[str], enabled: bool) -> str:
+    """Binary only when the device offered it and the server allows it; legacy devices get JSON."""
+    if enabled and requested == CONTROL_FRAMING_BINARY:
+        return CONTROL_FRAMING_BINARY
+    return CONTROL_FRAMING_JSON
+
+
+def encode_ack(chunks_received: int, bytes_received: int, window_bytes: int) -> bytes:
+    """Binary equivalent of {"status": "receiving", "chunks_received", "bytes_received", "window_bytes"}."""
+    payload = ACK_PAYLOAD.pack(
+        chunks_received & 0xFFFFFFFF,
+        bytes_received & 0xFFFFFFFF,
+        window_bytes & 0xFFFFFFFF,
+    )
+    header = CONTROL_FRAME_HEADER.pack(
+        CONTROL_FRAME_MAGIC, CONTROL_FRAME_VERSION, CONTROL_FRAME_TYPE_ACK, len(payload)
+    )
+    return header + payload
+
+
+def encode_prompt_chunks(pack: bytes, version: int, chunk_bytes: int = PROMPT_CHUNK_BYTES) -> Iterator[bytes]:
+    """Split a prompt pack into in-order chunk frames; the device writes each straight to flash."""
+    for offset in range(0, len(pack), chunk_bytes):
+        payload = PROMPT_CHUNK_HEADER.pack(version & 0xFFFFFFFF, len(pack), offset) + pack[offset:offset + chunk_bytes]
+        header = CONTROL_FRAME_HEADER.pack(
+            CONTROL_FRAME_MAGIC, CONTROL_FRAME_VERSION, CONTROL_FRAME_TYPE_PROMPT_CHUNK, len(payload)
+        )
+        yield header + payload
@@ -0,0 +1,85 @@
+"""
+Image Frames Module - JPEG captures sent over the session WebSocket
+Reassembles tagged binary image frames from the ESP32 (see websocket_client.h)
+"""
+
+import struct
+from typing import Optional
+
+# Frame header (little-endian, 12 bytes): magic, version, flags, chunk seq, total JPEG length
+IMAGE_FRAME_MAGIC = b"HPIM"
+IMAGE_FRAME_VERSION = 1
+IMAGE_FRAME_HEADER = struct.Struct("<4sBBHI")
+IMAGE_FRAME_HEADER_SIZE = IMAGE_FRAME_HEADER.size
+
+IMAGE_FLAG_FIRST = 0x01
+IMAGE_FLAG_LAST = 0x02
+
+# Anything larger is not a camera frame from this device (UXGA JPEGs stay well below)
+MAX_IMAGE_BYTES = 1024 * 1024
+
+
+def is_image_frame(payload: bytes) -> bool:
+    """True when a binary WebSocket message carries image data rather than uplink audio."""
+    if len(payload) < IMAGE_FRAME_HEADER_SIZE or payload[:4] != IMAGE_FRAME_MAGIC:
+        return False
+    magic, version, flags, seq, total = IMAGE_FRAME_HEADER.unpack_from(payload, 0)
+    return version == IMAGE_FRAME_VERSION and 0 < total <= MAX_IMAGE_BYTES
+
+
+class ImageAssembler:
+    """Per-session reassembly of one JPEG from consecutive image frames."""
+
+    def __init__(self):
+        self._buffer: Optional[bytearray] = None
+        self._expected_len = 0
+        self._next_seq = 0
+
+    def feed(self, payload: bytes) -> Optional[bytes]:
+        """
+        Add one image frame.
+
+        Returns:
+            The complete JPEG bytes once the LAST frame arrives, otherwise None.
+
+        Raises:
+            ValueError: On out-of-order, oversized or truncated frames (the partial image is dropped)
+        """
+        magic, version, flags, seq, total = IMAGE_FRAME_HEADER.unpack_from(payload, 0)
+        chunk = memoryview(payload)[IMAGE_FRAME_HEADER_SIZE:]
+
+        if flags & IMAGE_FLAG_FIRST:
+            # A new capture always restarts, even if a previous one was cut short
+            self._buffer = bytearray()
+            self._expected_len = total
+            self._next_seq = 0
+        elif self._buffer is None:
+            raise ValueError(f"image frame {seq} without a preceding first frame")
+
+        try:
+            if seq != self._next_seq or total != self._expected_len:
+                raise ValueError(f"image frame {seq} out of sequence (expected {self._next_seq})")
+            if len(self._buffer) + len(chunk) > self._expected_len:
+                raise ValueError(f"image frames exceed declared length {self._expected_len}")
+
+            self._buffer += chunk
+            self._next_seq = (self._next_seq + 1) & 0xFFFF
+
+            if not flags & IMAGE_FLAG_LAST:
+                return None
+            if len(self._buffer) != self._expected_len:
+                raise ValueError(
+                    f"image truncated: {len(self._buffer)} of {self._expected_len} bytes"
+                )
+            image = bytes(self._buffer)
+        except ValueError:
+            self.reset()
+            raise
+
+        self.reset()
+        return image
+
+    def reset(self) -> None:
+        self._buffer = None
+        self._expected_len = 0
+        self._next_seq = 0
@@ -0,0 +1,112 @@
+"""
+Image Preprocessing Module - vision-model sized captures with a content-hash cache
+Downscales and recompresses device JPEGs before they are base64'd into the LLM
+request, and remembers the result so a re-sent capture costs one hash
+"""
+
+import base64
+import hashlib
+import io
+import os
+import threading
+from collections import OrderedDict
+
+from dotenv import load_dotenv
+
+try:
+    from PIL import Image
+except ImportError:  # Pillow is optional: without it captures are forwarded as-is
+    Image = None
+
+load_dotenv()
+
+# Longest side sent to the vision model; VGA captures are larger than it needs for
+# scene questions and every extra pixel is prompt tokens (0 = never resize)
+VISION_IMAGE_MAX_SIDE = int(os.getenv("VISION_IMAGE_MAX_SIDE", 512))
+
+# JPEG quality for the recompressed copy
+VISION_IMAGE_QUALITY = int(os.getenv("VISION_IMAGE_QUALITY", 80))
+
+# Prepared images kept by content hash (each entry is one base64 string)
+IMAGE_CACHE_ENTRIES = int(os.getenv("IMAGE_CACHE_ENTRIES", 32))
+
+
+class ImagePreprocessor:
+    """
+    Prepares captures for the multimodal LLM call.
+
+    prepare() is BLOCKING (decode + resize + encode): run it via asyncio.to_thread.
+    It is safe to call from several threads; the same capture prepared twice
+    at once just does the work twice and caches one copy.
+    """
+
+    def __init__(self, max_side: int = VISION_IMAGE_MAX_SIDE, quality: int = VISION_IMAGE_QUALITY,
+                 max_entries: int = IMAGE_CACHE_ENTRIES):
+        self.max_side = max_side
+        self.quality = quality
+        self.max_entries = max(1, max_entries)
+        self._cache: "OrderedDict[str, str]" = OrderedDict()
+        self._lock = threading.Lock()
+        self.hits = 0
+        self.misses = 0
+        self.bytes_in = 0
+        self.bytes_out = 0
+        if Image is None:
+            print("⚠️ Pillow not installed: images go to the LLM at capture size (pip install pillow)")
+
+    @staticmethod
+    def key(image_data: bytes) -> str:
+        return hashlib.sha256(image_data).hexdigest()
+
+    def _process(self, image_data: bytes) -> bytes:
+        if Image is None or self.max_side <= 0:
+            return image_data
+        try:
+            with Image.open(io.BytesIO(image_data)) as image:
+                image = image.convert("RGB")
+                if max(image.size) > self.max_side:
+                    image.thumbnail((self.max_side, self.max_side), Image.LANCZOS)
+                out = io.BytesIO()
+                image.save(out, format="JPEG", quality=self.quality, optimize=True)
+        except Exception as image_error:
+            print(f"⚠ Image preprocessing failed, sending original: {image_error}")
+            return image_data
+        processed = out.getvalue()
+        # A small capture may already be tighter than our re-encode
+        return processed if len(processed) < len(image_data) else image_data
+
+    def prepare(self, image_data: bytes) -> str:
+        """Base64 JPEG for the LLM request, from the cache when this capture was seen before."""
+        digest = self.key(image_data)
+        with self._lock:
+            cached = self._cache.get(digest)
+            if cached is not None:
+                self._cache.move_to_end(digest)
+                self.hits += 1
+                return cached
+
+        processed = self._process(image_data)
+        encoded = base64.b64encode(processed).decode("ascii")
+
+        with self._lock:
+            self.misses += 1
+            self.bytes_in += len(image_data)
+            self.bytes_out += len(processed)
+            self._cache[digest] = encoded
+            self._cache.move_to_end(digest)
+            while len(self._cache) > self.max_entries:
+                self._cache.popitem(last=False)
+        print(f"🖼️ Prepared image {digest[:12]}: {len(image_data)} -> {len(processed)} bytes "
+              f"(max side {self.max_side if Image is not None else 'unchanged'})")
+        return encoded
+
+    def stats(self) -> dict:
+        with self._lock:
+            return {
+                "entries": len(self._cache),
+                "hits": self.hits,
+                "misses": self.misses,
+                "max_side": self.max_side if Image is not None else 0,
+                "bytes_in": self.bytes_in,
+                "bytes_out": self.bytes_out
+            }
@@ -4,10 +4,12 @@ Handles conversation state and low-latency LLM inference using httpx.AsyncClient
 """
 
 import os
+import re
 import time
+import asyncio
 import httpx
 import json
-from typing import Dict, List, Optional
+from typing import AsyncIterator, Dict, List, Optional
 from dotenv import load_dotenv
 
 # Load environment variables
@@ -26,6 +28,27 @@ GROQ_API_BASE_URL = "https://api.groq.com/openai/v1"
 GROQ_API_KEY = os.getenv("GROQ_API_KEY")
 GROQ_MODEL = "meta-llama/llama-4-scout-17b-16e-instruct"
 
+# Streaming sentence cutter: a boundary is terminal punctuation (plus closing quotes/brackets)
+# followed by whitespace. Pieces shorter than MIN_STREAM_SENTENCE_CHARS wait for more text
+# so abbreviations like "Dr." or "e.g." rarely split a sentence early.
+_SENTENCE_BOUNDARY_RE = re.compile(r"[.!?]+[\"')\]]*\s+")
+MIN_STREAM_SENTENCE_CHARS = 12
+
+# History sent with each request is capped by estimated tokens, not message count:
+# oldest turns are folded into a running summary once the budget is exceeded
+LLM_HISTORY_TOKEN_BUDGET = int(os.getenv("LLM_HISTORY_TOKEN_BUDGET", 600))
+
+# Cap on the summary itself (tokens requested from the model / kept by the fallback)
+LLM_SUMMARY_MAX_TOKENS = int(os.getenv("LLM_SUMMARY_MAX_TOKENS", 120))
+
+# Summarize evicted turns with a background Groq call (0 = keep a clipped transcript instead)
+LLM_SUMMARIZE = os.getenv("LLM_SUMMARIZE", "1").strip() not in ("0", "false", "no")
+
+# Rough tokens per message for role and framing
+_MESSAGE_TOKEN_OVERHEAD = 4
+
+SUMMARY_PROMPT = """Summarize the conversation below between a user and the voice assistant Hotpin for the assistant's own memory. Keep names, facts, preferences and anything still unresolved; drop greetings and filler. Plain text, at most three short sentences."""
+
 # Hotpin system prompt - optimized for TTS, wearable interaction, and vision
 SYSTEM_PROMPT = """SYSTEM: You are "Hotpin" — a compact, helpful, and privacy-first voice assistant with vision capabilities. Your goal is to provide short, one-liner answers. Rules:
 
@@ -70,7 +93,17 @@ async def close_client() -> None:
         print("✓ Groq AsyncClient closed")
 
 
-def manage_context(session_id: str, role: str, content: str, max_history_turns: int = 10) -> None:
+def estimate_tokens(text: str) -> int:
+    """Cheap token estimate (~4 characters per token for English); no tokenizer dependency."""
+    return len(text) // 4 + 1
+
+
+def _history_tokens(history: List[dict]) -> int:
+    return sum(estimate_tokens(m["content"]) + _MESSAGE_TOKEN_OVERHEAD for m in history)
+
+
+def manage_context(session_id: str, role: str, content: str,
+                   token_budget: int = LLM_HISTORY_TOKEN_BUDGET) -> None:
     """
     Manage conversation context for a session.
     
@@ -78,64 +111,146 @@ def manage_context(session_id: str, role: str, content: str, max_history_turns:
         session_id: Unique session identifier
         role: Message role ("user" or "assistant")
         content: Message content text
-        max_history_turns: Maximum number of conversation turns to keep (default: 10)
+        token_budget: Estimated tokens of history to keep verbatim (default: LLM_HISTORY_TOKEN_BUDGET)
     
-    Maintains context window by keeping only the last N turns to prevent overflow.
+    Once the history is over budget, the oldest messages move to "evicted" and
+    are folded into the session summary, so prompt size stays bounded however
+    long the conversation runs. The newest message is always kept.
     """
     if session_id not in SESSION_CONTEXTS:
         SESSION_CONTEXTS[session_id] = {
             "history": [],
+            "summary": "",
+            "evicted": [],
+            "summarizing": False,
             "last_activity_ts": time.time()
         }
+    context = SESSION_CONTEXTS[session_id]
     
     # Append new message
-    SESSION_CONTEXTS[session_id]["history"].append({
+    context["history"].append({
         "role": role,
         "content": content
     })
     
     # Update timestamp
-    SESSION_CONTEXTS[session_id]["last_activity_ts"] = time.time()
+    context["last_activity_ts"] = time.time()
+    
+    # Enforce the token budget, oldest first
+    history = context["history"]
+    evicted = 0
+    while len(history) > 1 and _history_tokens(history) > token_budget:
+        context["evicted"].append(history.pop(0))
+        evicted += 1
+    # History must not open with an orphaned assistant reply
+    while len(history) > 1 and history[0]["role"] == "assistant":
+        context["evicted"].append(history.pop(0))
+        evicted += 1
     
-    # Enforce context window limit (keep last N turns)
-    # Each turn = user + assistant message pair
-    max_messages = max_history_turns * 2  # user + assistant per turn
-    if len(SESSION_CONTEXTS[session_id]["history"]) > max_messages:
-        # Keep only the most recent messages
-        SESSION_CONTEXTS[session_id]["history"] = SESSION_CONTEXTS[session_id]["history"][-max_messages:]
+    if evicted:
+        print(f"🧹 [{session_id}] Moved {evicted} message(s) out of the LLM history "
+              f"(~{_history_tokens(history)} tokens kept, budget {token_budget})")
+        _schedule_summary(session_id)
 
 
-async def get_llm_response(session_id: str, transcript: str, image_base64: Optional[str] = None) -> str:
-    """
-    Get LLM response from Groq API with conversation context and optional image.
-    
-    Args:
-        session_id: Unique session identifier
-        transcript: User's transcribed speech input
-        image_base64: Optional base64-encoded JPEG image for multimodal context
+def _clip_summary(text: str) -> str:
+    """Keep the most recent part of a summary within LLM_SUMMARY_MAX_TOKENS."""
+    max_chars = LLM_SUMMARY_MAX_TOKENS * 4
+    if len(text) <= max_chars:
+        return text
+    return "..." + text[-max_chars:].split(" ", 1)[-1]
+
+
+def _fallback_summary(previous: str, messages: List[dict]) -> str:
+    """Summary without a model call: the previous summary plus a clipped transcript."""
+    lines = [previous] if previous else []
+    for message in messages:
+        speaker = "User" if message["role"] == "user" else "Hotpin"
+        lines.append(f"{speaker}: {message['content'].strip()}")
+    return _clip_summary(" ".join(lines))
+
+
+def _schedule_summary(session_id: str) -> None:
+    """Fold evicted messages into the summary, off the turn's critical path when possible."""
+    context = SESSION_CONTEXTS.get(session_id)
+    if context is None or context["summarizing"] or not context["evicted"]:
+        return
+    try:
+        loop = asyncio.get_running_loop()
+    except RuntimeError:
+        loop = None
+    if not LLM_SUMMARIZE or groq_client is None or loop is None:
+        context["summary"] = _fallback_summary(context["summary"], context["evicted"])
+        context["evicted"] = []
+        return
+    context["summarizing"] = True
+    loop.create_task(_summarize_evicted(session_id))
+
+
+async def _summarize_evicted(session_id: str) -> None:
+    """Background task: ask the model to merge evicted turns into the running summary."""
+    context = SESSION_CONTEXTS.get(session_id)
+    if context is None:
+        return
+    batch = context["evicted"]
+    context["evicted"] = []
+    previous = context["summary"]
+    transcript = "\n".join(
+        f"{'User' if m['role'] == 'user' else 'Hotpin'}: {m['content'].strip()}" for m in batch
+    )
+    prompt = f"Earlier summary: {previous}\n\n{transcript}" if previous else transcript
     
-    Returns:
-        str: LLM-generated response text
+    summary = ""
+    try:
+        response = await groq_client.post("/chat/completions", json={
+            "model": GROQ_MODEL,
+            "messages": [
+                {"role": "system", "content": SUMMARY_PROMPT},
+                {"role": "user", "content": prompt}
+            ],
+            "temperature": 0.0,
+            "max_tokens": LLM_SUMMARY_MAX_TOKENS
+        })
+        response.raise_for_status()
+        summary = (response.json()["choices"][0]["message"]["content"] or "").strip()
+    except Exception as e:
+        print(f"⚠ [{session_id}] History summary failed, keeping a clipped transcript: {type(e).__name__}: {e}")
     
-    Raises:
-        Exception: If API call fails or client not initialized
+    # The session may have been reset or closed while the request was in flight
+    if SESSION_CONTEXTS.get(session_id) is not context:
+        return
+    context["summary"] = _clip_summary(summary) if summary else _fallback_summary(previous, batch)
+    context["summarizing"] = False
+    print(f"📝 [{session_id}] History summary updated ({len(batch)} message(s) folded, "
+          f"~{estimate_tokens(context['summary'])} tokens)")
+    # Turns evicted while this request ran get their own pass
+    _schedule_summary(session_id)
+
+
+def _build_payload(session_id: str, transcript: str, image_base64: Optional[str] = None) -> dict:
+    """
+    Record the user turn and build the Groq chat completion payload.
+    Shared by the blocking and streaming request paths.
     """
-    global groq_client
-    
-    if not groq_client:
-        raise RuntimeError("Groq client not initialized. Call init_client() first.")
-    
     # Add user message to context (store as text for history tracking)
     manage_context(session_id, "user", transcript)
     
     # Retrieve conversation history
-    history = SESSION_CONTEXTS[session_id]["history"]
+    context = SESSION_CONTEXTS[session_id]
+    history = context["history"]
     
     # Construct messages with system prompt
     messages = [
         {"role": "system", "content": SYSTEM_PROMPT}
     ]
     
+    # Older turns ride as a summary once they fall out of the token budget
+    if context["summary"]:
+        messages.append({
+            "role": "system",
+            "content": f"Summary of the earlier conversation: {context['summary']}"
+        })
+    
     # Add conversation history, but skip the last user message (we'll add it with image if needed)
     if len(history) > 1:
         messages.extend(history[:-1])
@@ -173,6 +288,31 @@ async def get_llm_response(session_id: str, transcript: str, image_base64: Optio
         "max_tokens": 100,   # Enforce brevity (15-60 words target)
         "top_p": 0.9
     }
+    return payload
+
+
+async def get_llm_response(session_id: str, transcript: str, image_base64: Optional[str] = None) -> str:
+    """
+    Get LLM response from Groq API with conversation context and optional image.
+    
+    Args:
+        session_id: Unique session identifier
+        transcript: User's transcribed speech input
+        image_base64: Optional base64-encoded JPEG image for multimodal context
+    
+    Returns:
+        str: LLM-generated response text
+    
+    Raises:
+        Exception: If API call fails or client not initialized
+    """
+    global groq_client
+    
+    if not groq_client:
+        raise RuntimeError("Groq client not initialized. Call init_client() first.")
+    
+    payload = _build_payload(session_id, transcript, image_base64)
+    messages = payload["messages"]
     
     # Debug logging to verify payload structure
     if image_base64:
@@ -230,6 +370,130 @@ async def get_llm_response(session_id: str, transcript: str, image_base64: Optio
         return "An error occurred. Please try again."
 
 
+class SentenceCutter:
+    """Accumulates streamed tokens and releases complete sentences."""
+
+    def __init__(self, min_chars: int = MIN_STREAM_SENTENCE_CHARS):
+        self.min_chars = min_chars
+        self._buffer = ""
+
+    def feed(self, token: str) -> List[str]:
+        """Append a token; return any sentences that are now complete."""
+        self._buffer += token
+        sentences = []
+        search_from = 0
+        while True:
+            match = _SENTENCE_BOUNDARY_RE.search(self._buffer, search_from)
+            if not match:
+                break
+            candidate = self._buffer[:match.end()].strip()
+            if len(candidate) < self.min_chars:
+                # Too short to be worth its own TTS run - keep scanning past it
+                search_from = match.end()
+                continue
+            sentences.append(candidate)
+            self._buffer = self._buffer[match.end():]
+            search_from = 0
+        return sentences
+
+    def flush(self) -> Optional[str]:
+        """Return whatever text remains once the stream has ended."""
+        remainder = self._buffer.strip()
+        self._buffer = ""
+        return remainder or None
+
+
+async def stream_llm_sentences(session_id: str, transcript: str,
+                               image_base64: Optional[str] = None) -> AsyncIterator[str]:
+    """
+    Stream the Groq completion and yield it one sentence at a time.
+
+    Same request, context handling and fallback messages as get_llm_response(),
+    but with "stream": true so the caller can start TTS on the first sentence
+    while later tokens are still being generated.
+
+    Yields:
+        str: Complete sentences in order; a single fallback message on failure
+    """
+    global groq_client
+
+    if not groq_client:
+        raise RuntimeError("Groq client not initialized. Call init_client() first.")
+
+    payload = _build_payload(session_id, transcript, image_base64)
+    payload["stream"] = True
+
+    cutter = SentenceCutter()
+    parts: List[str] = []
+    spoken: List[str] = []
+    yielded = False
+    fallback: Optional[str] = None
+
+    try:
+        async with groq_client.stream("POST", "/chat/completions", json=payload) as response:
+            if response.status_code >= 400:
+                body = await response.aread()
+                print(f"✗ Groq API HTTP error: {response.status_code} - {body.decode(errors='replace')}")
+                fallback = "Service temporarily unavailable. Please try again."
+            else:
+                # Server-sent events: "data: {json}" lines, terminated by "data: [DONE]"
+                async for line in response.aiter_lines():
+                    if not line.startswith("data:"):
+                        continue
+                    data = line[5:].strip()
+                    if data == "[DONE]":
+                        break
+                    try:
+                        chunk = json.loads(data)
+                        token = chunk["choices"][0].get("delta", {}).get("content") or ""
+                    except (ValueError, KeyError, IndexError) as parse_error:
+                        print(f"⚠ Groq stream chunk parse error: {parse_error}")
+                        continue
+                    if not token:
+                        continue
+                    parts.append(token)
+                    for sentence in cutter.feed(token):
+                        yielded = True
+                        spoken.append(sentence)
+                        yield sentence
+
+        remainder = cutter.flush()
+        if remainder:
+            yielded = True
+            spoken.append(remainder)
+            yield remainder
+
+    except GeneratorExit:
+        # Consumer closed us early (barge-in): the sentences already handed out were
+        # spoken, so history still needs them or the next turn follows a user turn
+        interrupted = " ".join(sentence.strip() for sentence in spoken).strip()
+        if interrupted:
+            manage_context(session_id, "assistant", interrupted)
+        raise
+
+    except httpx.RequestError as e:
+        print(f"✗ Groq API request error: {e}")
+        fallback = "Connection error. Please check your network."
+
+    except Exception as e:
+        print(f"✗ Unexpected error in streaming LLM call: {type(e).__name__}: {e}")
+        import traceback
+        print(traceback.format_exc())
+        fallback = "An error occurred. Please try again."
+
+    assistant_message = "".join(parts).strip()
+    if assistant_message:
+        # Keep whatever was spoken in history, even if the stream broke part-way
+        manage_context(session_id, "assistant", assistant_message)
+    elif fallback is None:
+        print(f"⚠ Groq API returned empty streamed response for session {session_id}")
+        print(f"   Transcript: \"{transcript}\"")
+        fallback = "I'm having trouble responding right now. Please rephrase your question."
+
+    if fallback and not yielded:
+        yield fallback
+
+
 def get_session_context(session_id: str) -> Optional[dict]:
     """
     Retrieve session context for debugging or monitoring.
@@ -0,0 +1,93 @@
+"""
+Prompt Pack Module - Canned spoken prompts for the device's flash prompt store
+Renders the fixed error/status phrases once and packs them in the layout of
+prompt_store.h, so the device can speak them without a network round trip
+"""
+
+import os
+import struct
+import zlib
+from typing import Callable, Dict, Optional, Tuple
+
+from core.audio_codec import encode_ima_adpcm
+
+PACK_MAGIC = b"HPPK"
+PACK_FORMAT = 1
+PACK_HEADER = struct.Struct("<4sBBHIIII")   # magic, format, reserved, count, sample_rate, version, total_size, crc32
+PACK_ENTRY = struct.Struct("<HBBIII")       # id, codec, reserved, offset, length, samples
+
+PROMPT_CODEC_PCM16 = 0
+PROMPT_CODEC_IMA_ADPCM = 1
+
+# Must match CONFIG_PROMPT_ADPCM_BLOCK_BYTES and the "prompts" partition size on the device
+PROMPT_ADPCM_BLOCK_BYTES = int(os.getenv("PROMPT_ADPCM_BLOCK_BYTES", 512))
+PROMPT_PACK_MAX_BYTES = int(os.getenv("PROMPT_PACK_MAX_BYTES", 0x70000))
+
+# "ima_adpcm" (4:1, default) or "pcm16"
+PROMPT_PACK_CODEC = os.getenv("PROMPT_PACK_CODEC", "ima_adpcm").strip().lower()
+
+# Ids are feedback_prompt_t values in feedback_player.h
+PROMPT_TEXTS: Dict[int, str] = {
+    1: "I can't reach the server right now.",
+    2: "Sorry, I didn't catch that. Please try again.",
+    3: "The server is busy. Please try again in a moment.",
+    4: "Something went wrong. Please try again.",
+}
+
+
+def build_prompt_pack(render_pcm: Callable[[str], bytes],
+                      sample_rate: int = 16000,
+                      texts: Optional[Dict[int, str]] = None) -> Tuple[bytes, int]:
+    """
+    Render every prompt and assemble the pack.
+
+    Args:
+        render_pcm: Returns 16-bit mono PCM at `sample_rate` for a phrase
+                    (tts_worker.synthesize_pcm, run on the TTS stage)
+        sample_rate: Playback rate the device checks against its own
+        texts: Prompt id -> phrase (defaults to PROMPT_TEXTS)
+
+    Returns:
+        (pack bytes, version). The version is derived from the content, so the
+        device only downloads a pack again when a phrase or the voice changes.
+
+    Raises:
+        ValueError: If the pack would not fit the device partition
+    """
+    texts = texts or PROMPT_TEXTS
+    use_adpcm = PROMPT_PACK_CODEC == "ima_adpcm"
+    index_end = PACK_HEADER.size + len(texts) * PACK_ENTRY.size
+
+    entries = []
+    clips = bytearray()
+    for prompt_id, text in sorted(texts.items()):
+        pcm = render_pcm(text)
+        samples = len(pcm) // 2
+        if samples == 0:
+            continue
+        if use_adpcm:
+            data = encode_ima_adpcm(pcm, PROMPT_ADPCM_BLOCK_BYTES)
+            codec = PROMPT_CODEC_IMA_ADPCM
+        else:
+            data = pcm[:samples * 2]
+            codec = PROMPT_CODEC_PCM16
+        # Word-align clips so PCM16 can be read straight out of mapped flash
+        while (index_end + len(clips)) % 4:
+            clips.append(0)
+        entries.append((prompt_id, codec, index_end + len(clips), len(data), samples))
+        clips += data
+
+    # The index is sized for every prompt; unused slots stay zeroed past `count`
+    index = bytearray(len(texts) * PACK_ENTRY.size)
+    for position, (prompt_id, codec, offset, length, samples) in enumerate(entries):
+        PACK_ENTRY.pack_into(index, position * PACK_ENTRY.size, prompt_id, codec, 0, offset, length, samples)
+
+    body = bytes(index) + bytes(clips)
+    total_size = PACK_HEADER.size + len(body)
+    if total_size > PROMPT_PACK_MAX_BYTES:
+        raise ValueError(f"prompt pack is {total_size} bytes (partition holds {PROMPT_PACK_MAX_BYTES})")
+
+    crc = zlib.crc32(body) & 0xFFFFFFFF
+    version = zlib.crc32(struct.pack("<BI", PACK_FORMAT, sample_rate), crc) & 0xFFFFFFFF or 1
+    header = PACK_HEADER.pack(PACK_MAGIC, PACK_FORMAT, 0, len(entries), sample_rate, version, total_size, crc)
+    return header + body, version
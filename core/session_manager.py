@@ -0,0 +1,117 @@
+"""
+Session Manager Module - Per-device connection state for the WebSocket server
+One Session object per connected device instead of parallel global dicts,
+with a connection cap and image context that survives reconnects
+"""
+
+import io
+from dataclasses import dataclass, field
+from typing import TYPE_CHECKING, Dict, List, Optional
+
+if TYPE_CHECKING:
+    from core.audio_codec import UplinkDecoder
+    from core.stt_worker import StreamingRecognizer
+
+
+class SessionLimitError(RuntimeError):
+    """Raised by attach() when MAX_SESSIONS devices are already connected."""
+
+
+@dataclass
+class Session:
+    """State owned by one device connection (one utterance buffered at a time)."""
+
+    session_id: str
+    decoder: Optional["UplinkDecoder"] = None
+    recognizer: Optional["StreamingRecognizer"] = None
+    audio_buffer: io.BytesIO = field(default_factory=io.BytesIO)
+    stats: Dict[str, int] = field(default_factory=lambda: {"chunks": 0, "bytes": 0, "pcm_bytes": 0})
+
+    def reset_audio(self) -> None:
+        """Start a fresh utterance: drop buffered audio, counters and recognizer state."""
+        self.audio_buffer = io.BytesIO()
+        self.stats = {"chunks": 0, "bytes": 0, "pcm_bytes": 0}
+        if self.recognizer is not None:
+            self.recognizer.reset()
+
+    def pcm_bytes(self) -> int:
+        """PCM bytes received for the current utterance (buffered or already fed to Vosk)."""
+        return self.stats.get("pcm_bytes", 0)
+
+    def close(self) -> None:
+        """Release the streaming recognizer, if any (its queued audio is dropped)."""
+        if self.recognizer is not None:
+            self.recognizer.close()
+            self.recognizer = None
+
+
+class SessionManager:
+    """
+    Registry of connected sessions plus the image context stored per session_id.
+
+    Images are kept apart from Session because they outlive a connection: the
+    device may upload over POST /image, or disconnect between capture and the
+    voice query, and the next turn for that session_id still uses the picture.
+    All methods run on the event loop thread, so no locking is needed.
+    """
+
+    def __init__(self, max_sessions: int):
+        self.max_sessions = max(1, max_sessions)
+        self._sessions: Dict[str, Session] = {}
+        self._images: Dict[str, bytes] = {}
+        self._rejected = 0
+
+    def attach(self, session: Session) -> Session:
+        """
+        Register a new connection, replacing a stale one with the same session_id.
+
+        Raises:
+            SessionLimitError: When the server is full and this is a new device
+        """
+        previous = self._sessions.get(session.session_id)
+        if previous is None and len(self._sessions) >= self.max_sessions:
+            self._rejected += 1
+            raise SessionLimitError(f"{len(self._sessions)} sessions active (max {self.max_sessions})")
+        if previous is not None:
+            previous.close()
+        self._sessions[session.session_id] = session
+        return session
+
+    def detach(self, session: Session) -> None:
+        """Drop a connection's state; a reconnect that already replaced it is left alone."""
+        if self._sessions.get(session.session_id) is session:
+            del self._sessions[session.session_id]
+        session.close()
+
+    def get(self, session_id: str) -> Optional[Session]:
+        return self._sessions.get(session_id)
+
+    def store_image(self, session_id: str, image_data: bytes) -> None:
+        self._images[session_id] = image_data
+
+    def image(self, session_id: str) -> Optional[bytes]:
+        return self._images.get(session_id)
+
+    def has_image(self, session_id: str) -> bool:
+        return session_id in self._images
+
+    def clear_image(self, session_id: str) -> bool:
+        """Forget a stored capture; True if there was one."""
+        return self._images.pop(session_id, None) is not None
+
+    def image_sessions(self) -> List[str]:
+        return list(self._images.keys())
+
+    def close_all(self) -> None:
+        for session in self._sessions.values():
+            session.close()
+        self._sessions.clear()
+        self._images.clear()
+
+    def stats(self) -> dict:
+        return {
+            "active": len(self._sessions),
+            "max": self.max_sessions,
+            "rejected": self._rejected,
+            "stored_images": len(self._images),
+        }
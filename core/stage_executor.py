@@ -0,0 +1,177 @@
+"""
+Stage Executor Module - Bounded worker pools for blocking pipeline stages
+Gives STT and TTS their own thread pools with admission control and queue metrics,
+so a slow synthesis for one device never holds a slot another device's turn needs
+"""
+
+import asyncio
+import os
+import threading
+import time
+from collections import deque
+from concurrent.futures import Future, ThreadPoolExecutor
+from typing import Any, Callable
+
+# Recent jobs kept for the latency figures reported by /health
+LATENCY_WINDOW = 256
+
+
+class StageBusyError(RuntimeError):
+    """Raised instead of queueing when a stage's backlog is at its limit."""
+
+    def __init__(self, stage: str, queued: int):
+        super().__init__(f"{stage} stage busy ({queued} jobs waiting)")
+        self.stage = stage
+        self.queued = queued
+
+
+def default_workers(share: float = 1.0, minimum: int = 1) -> int:
+    """Worker count as a share of the host's cores."""
+    return max(minimum, int((os.cpu_count() or 1) * share))
+
+
+def _percentile(sorted_values: list, fraction: float) -> float:
+    if not sorted_values:
+        return 0.0
+    index = min(len(sorted_values) - 1, int(round(fraction * (len(sorted_values) - 1))))
+    return sorted_values[index]
+
+
+class StageExecutor:
+    """
+    Thread pool for one blocking stage (Vosk decoding, pyttsx3 synthesis).
+
+    Threads rather than processes: the Vosk model is loaded once and shared by
+    every recognizer, and both engines spend their time in native code that
+    releases the GIL. Jobs beyond `workers` wait in the pool's queue; once
+    `queue_limit` jobs are waiting, new turns get StageBusyError so the caller
+    can turn the device away instead of growing the backlog.
+    """
+
+    def __init__(self, name: str, workers: int, queue_limit: int):
+        self.name = name
+        self.workers = max(1, workers)
+        self.queue_limit = max(0, queue_limit)
+        self._pool = ThreadPoolExecutor(max_workers=self.workers,
+                                        thread_name_prefix=f"hotpin-{name}")
+        self._lock = threading.Lock()
+        self._running = 0
+        self._queued = 0
+        self._peak_queued = 0
+        self._submitted = 0
+        self._completed = 0
+        self._failed = 0
+        self._rejected = 0
+        self._wait_ms: deque = deque(maxlen=LATENCY_WINDOW)
+        self._run_ms: deque = deque(maxlen=LATENCY_WINDOW)
+
+    def _saturated(self) -> bool:
+        return self._queued >= self.queue_limit and self._running >= self.workers
+
+    def admit(self) -> None:
+        """Admission check for a new turn; raises StageBusyError when saturated."""
+        with self._lock:
+            if self._saturated():
+                self._rejected += 1
+                raise StageBusyError(self.name, self._queued)
+
+    def submit(self, fn: Callable[..., Any], *args: Any, admitted: bool = False) -> Future:
+        """
+        Thread-safe, non-async form of run(): queue fn(*args) and return its Future.
+
+        Same admission rule and accounting as run(); usable from any thread
+        (e.g. a job queueing its own follow-up). Raises RuntimeError once the
+        stage is shut down.
+        """
+        with self._lock:
+            if not admitted and self._saturated():
+                self._rejected += 1
+                raise StageBusyError(self.name, self._queued)
+            self._queued += 1
+            self._submitted += 1
+            if self._queued > self._peak_queued:
+                self._peak_queued = self._queued
+        queued_at = time.monotonic()
+
+        def job() -> Any:
+            started = time.monotonic()
+            with self._lock:
+                self._queued -= 1
+                self._running += 1
+                self._wait_ms.append((started - queued_at) * 1000.0)
+            ok = False
+            try:
+                result = fn(*args)
+                ok = True
+                return result
+            finally:
+                with self._lock:
+                    self._running -= 1
+                    self._run_ms.append((time.monotonic() - started) * 1000.0)
+                    if ok:
+                        self._completed += 1
+                    else:
+                        self._failed += 1
+
+        try:
+            future = self._pool.submit(job)
+        except RuntimeError:
+            # Pool was shut down before the job could be queued
+            with self._lock:
+                self._queued -= 1
+            raise
+        # Jobs cancelled by shutdown() never run, so they leave the queue here
+        future.add_done_callback(lambda f: self._forget_cancelled(f))
+        return future
+
+    def _forget_cancelled(self, future: Future) -> None:
+        if future.cancelled():
+            with self._lock:
+                self._queued -= 1
+
+    async def run(self, fn: Callable[..., Any], *args: Any, admitted: bool = False) -> Any:
+        """
+        Run fn(*args) on this stage's pool.
+
+        Raises StageBusyError when saturated, unless `admitted` says the job
+        belongs to a turn that already passed admit() (later sentences of a
+        reply are never dropped halfway through).
+        """
+        return await asyncio.wrap_future(self.submit(fn, *args, admitted=admitted))
+
+    def saturated(self) -> bool:
+        """True when the next unadmitted run() would be rejected."""
+        with self._lock:
+            return self._saturated()
+
+    def stats(self) -> dict:
+        """Queue depth, counters and recent queue-wait / run latency in milliseconds."""
+        with self._lock:
+            waits = sorted(self._wait_ms)
+            runs = sorted(self._run_ms)
+            snapshot = {
+                "workers": self.workers,
+                "queue_limit": self.queue_limit,
+                "running": self._running,
+                "queued": self._queued,
+                "peak_queued": self._peak_queued,
+                "submitted": self._submitted,
+                "completed": self._completed,
+                "failed": self._failed,
+                "rejected": self._rejected,
+            }
+        snapshot["queue_wait_ms"] = {
+            "avg": round(sum(waits) / len(waits), 1) if waits else 0.0,
+            "p95": round(_percentile(waits, 0.95), 1),
+            "max": round(waits[-1], 1) if waits else 0.0,
+        }
+        snapshot["run_ms"] = {
+            "avg": round(sum(runs) / len(runs), 1) if runs else 0.0,
+            "p95": round(_percentile(runs, 0.95), 1),
+            "max": round(runs[-1], 1) if runs else 0.0,
+        }
+        return snapshot
+
+    def shutdown(self) -> None:
+        """Stop accepting jobs; running jobs finish, queued ones are cancelled."""
+        self._pool.shutdown(wait=False, cancel_futures=True)
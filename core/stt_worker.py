@@ -1,15 +1,25 @@
 """
-STT Worker Module - Synchronous Vosk Speech Recognition
-Handles blocking audio transcription in thread pool isolation
+STT Worker Module - Vosk Speech Recognition
+Handles batch transcription in thread pool isolation and per-session
+streaming recognition as serialized jobs on the same bounded STT stage
 """
 
 import os
 import wave
 import io
 import json
+import asyncio
+import threading
+import time
+from collections import deque
+from concurrent.futures import Future
+from typing import TYPE_CHECKING, Callable, Optional
 from vosk import Model, KaldiRecognizer
 from dotenv import load_dotenv
 
+if TYPE_CHECKING:
+    from core.stage_executor import StageExecutor
+
 # Load environment variables
 load_dotenv()
 
@@ -17,6 +27,9 @@ load_dotenv()
 VOSK_MODEL = None
 VOSK_MODEL_PATH = os.getenv("VOSK_MODEL_PATH", "./model")
 
+# Minimum spacing between partial transcript callbacks (seconds)
+STT_PARTIAL_INTERVAL_S = float(os.getenv("STT_PARTIAL_INTERVAL_MS", 250)) / 1000.0
+
 
 def initialize_vosk_model() -> None:
     """
@@ -151,6 +164,199 @@ def process_audio_for_transcription(session_id: str, pcm_bytes: bytes) -> str:
         return ""
 
 
+class StreamingRecognizer:
+    """
+    Per-session streaming Vosk recognizer.
+
+    Audio is fed with feed() as each WebSocket frame arrives and decoded in
+    batches on the shared STT stage, so the event loop never blocks on
+    AcceptWaveform and decode concurrency stays within the stage's workers
+    however many devices are talking. A session's jobs run one at a time and
+    in order (audio, final flush, reset), so frames queued while a batch runs
+    are merged into the next one. At end-of-speech finish() only has to flush
+    the last few frames, making transcription latency after EOS roughly
+    constant instead of proportional to utterance length. The recognizer is
+    reused for the next utterance.
+    """
+
+    _AUDIO = "audio"
+    _FINISH = "finish"
+    _RESET = "reset"
+
+    def __init__(self, session_id: str, executor: "StageExecutor",
+                 on_partial: Optional[Callable[[str], None]] = None,
+                 sample_rate: int = 16000):
+        if VOSK_MODEL is None:
+            raise RuntimeError(
+                "Vosk model not initialized. Call initialize_vosk_model() first."
+            )
+
+        self.session_id = session_id
+        self.sample_rate = sample_rate
+        self._executor = executor
+        self._on_partial = on_partial
+        self._lock = threading.Lock()
+        self._jobs: deque = deque()  # (kind, payload) not yet started, in feed order
+        self._scheduled = False      # a drain job for this session is queued or running
+        self._closed = False
+        self._recognizer = KaldiRecognizer(VOSK_MODEL, sample_rate)
+        self._segments = []
+        self._last_partial = ""
+        self._last_partial_time = 0.0
+        self._fed_bytes = 0
+
+    def feed(self, pcm_bytes: bytes) -> None:
+        """Queue PCM16 audio for recognition (non-blocking)."""
+        if not pcm_bytes:
+            return
+        with self._lock:
+            if self._closed:
+                return
+            if self._jobs and self._jobs[-1][0] == self._AUDIO:
+                self._jobs[-1][1].extend(pcm_bytes)
+            else:
+                self._jobs.append((self._AUDIO, bytearray(pcm_bytes)))
+            self._schedule_locked()
+
+    async def finish(self, timeout: float = 10.0) -> str:
+        """
+        Flush queued audio and return the final transcript for the utterance.
+
+        Runs behind this session's queued audio on the STT stage; the recognizer
+        is reset afterwards. On timeout the flush is cancelled: when it is
+        eventually reached it only discards this utterance, so it can never
+        eat the start of the next one.
+        """
+        done: Future = Future()
+        with self._lock:
+            if self._closed:
+                return ""
+            self._jobs.append((self._FINISH, done))
+            self._schedule_locked()
+        try:
+            return await asyncio.wait_for(asyncio.wrap_future(done), timeout)
+        except asyncio.TimeoutError:
+            print(f"Streaming transcription timed out [{self.session_id}]")
+            return ""
+
+    def reset(self) -> None:
+        """Discard any audio of the current utterance."""
+        with self._lock:
+            if self._closed:
+                return
+            self._drop_audio_locked()
+            self._jobs.append((self._RESET, None))
+            self._schedule_locked()
+
+    def close(self) -> None:
+        """Stop recognizing for this session (pending audio is discarded)."""
+        with self._lock:
+            self._closed = True
+            self._drop_audio_locked()
+            pending = [payload for kind, payload in self._jobs if kind == self._FINISH]
+            self._jobs.clear()
+        for done in pending:
+            if done.set_running_or_notify_cancel():
+                done.set_result("")
+
+    def _drop_audio_locked(self) -> None:
+        kept = [job for job in self._jobs if job[0] != self._AUDIO]
+        self._jobs.clear()
+        self._jobs.extend(kept)
+
+    def _schedule_locked(self) -> None:
+        if self._scheduled or not self._jobs:
+            return
+        try:
+            # Audio of a connected device is never refused; the stage's worker
+            # count is what bounds concurrent decoding
+            self._executor.submit(self._drain, admitted=True)
+        except RuntimeError:
+            return  # stage shut down
+        self._scheduled = True
+
+    def _drain(self) -> None:
+        """One queued job for this session, then hand the worker back to the stage."""
+        with self._lock:
+            if not self._jobs:
+                self._scheduled = False
+                return
+            kind, payload = self._jobs.popleft()
+        try:
+            if kind == self._AUDIO:
+                self._accept(bytes(payload))
+            elif kind == self._FINISH:
+                self._finish(payload)
+            else:
+                self._restart()
+        except Exception as e:
+            print(f"Streaming transcription error [{self.session_id}]: {e}")
+            # A failed utterance must not kill the session
+            if kind == self._FINISH and not payload.done():
+                payload.set_result("")
+            try:
+                self._restart()
+            except Exception:
+                pass
+        finally:
+            # Requeue behind other sessions rather than holding the worker
+            with self._lock:
+                self._scheduled = False
+                self._schedule_locked()
+
+    def _finish(self, done: Future) -> None:
+        if not done.set_running_or_notify_cancel():
+            # finish() gave up waiting: this utterance is already answered
+            self._restart()
+            return
+        start = time.monotonic()
+        tail = json.loads(self._recognizer.FinalResult()).get("text", "")
+        transcript = self._current_text(tail)
+        audio_s = self._fed_bytes / (self.sample_rate * 2)
+        if transcript:
+            print(f"Transcription [{self.session_id}]: \"{transcript}\" "
+                  f"({audio_s:.1f}s audio, {(time.monotonic() - start) * 1000:.0f}ms after EOS)")
+        else:
+            print(f"Empty transcription for session: {self.session_id}")
+        self._restart()
+        done.set_result(transcript)
+
+    def _current_text(self, tail: str) -> str:
+        return " ".join(part for part in self._segments + [tail] if part)
+
+    def _restart(self) -> None:
+        if hasattr(self._recognizer, "Reset"):
+            self._recognizer.Reset()
+        else:
+            self._recognizer = KaldiRecognizer(VOSK_MODEL, self.sample_rate)
+        self._segments = []
+        self._last_partial = ""
+        self._fed_bytes = 0
+
+    def _accept(self, pcm_bytes: bytes) -> None:
+        self._fed_bytes += len(pcm_bytes)
+        if self._recognizer.AcceptWaveform(pcm_bytes):
+            # Vosk closed a segment at a pause; keep it and start the next one
+            text = json.loads(self._recognizer.Result()).get("text", "")
+            if text:
+                self._segments.append(text)
+            partial = self._current_text("")
+        else:
+            partial = self._current_text(
+                json.loads(self._recognizer.PartialResult()).get("partial", "")
+            )
+
+        now = time.monotonic()
+        if (self._on_partial is not None and partial and partial != self._last_partial
+                and (now - self._last_partial_time) >= STT_PARTIAL_INTERVAL_S):
+            self._last_partial = partial
+            self._last_partial_time = now
+            try:
+                self._on_partial(partial)
+            except Exception as e:
+                print(f"Partial transcript callback error [{self.session_id}]: {e}")
+
+
 def get_model_info() -> dict:
     """
     Get information about the loaded Vosk model.
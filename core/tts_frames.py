@@ -0,0 +1,83 @@
+"""
+TTS Frames Module - framed TTS downlink on the session WebSocket
+Replaces the single-WAV-per-reply stream when the device offers "tts": "framed"
+in its handshake (see tts_frame.h on the ESP32)
+"""
+
+import struct
+from typing import Iterator, Optional
+
+# Frame header (little-endian, 16 bytes): magic, version, type, codec, channels,
+# sample rate, sequence number (from 0 per reply); AUDIO payload follows
+TTS_FRAME_MAGIC = b"HPAU"
+TTS_FRAME_VERSION = 1
+TTS_FRAME_HEADER = struct.Struct("<4sBBBBII")
+
+TTS_FRAME_TYPE_AUDIO = 1
+TTS_FRAME_TYPE_FLUSH = 2  # End of a segment (sentence): device plays what it has queued
+TTS_FRAME_TYPE_END = 3    # End of the reply, replaces the zero-length binary frame
+
+TTS_FRAME_CODEC_PCM16 = 1
+
+# Whole frames stay within the 4 KB chunks the device receive path is sized for
+TTS_FRAME_BYTES = 4096
+
+TTS_FRAMING_FRAMED = "framed"
+TTS_FRAMING_WAV = "wav"
+
+
+def negotiate_tts_framing(requested: Optional[str], enabled: bool) -> str:
+    """Framed only when the device offered it and the server allows it; older firmware gets WAV."""
+    if enabled and requested == TTS_FRAMING_FRAMED:
+        return TTS_FRAMING_FRAMED
+    return TTS_FRAMING_WAV
+
+
+def is_tts_frame(payload: bytes) -> bool:
+    """True for a framed TTS message (as opposed to a control frame or legacy WAV bytes)."""
+    return len(payload) >= TTS_FRAME_HEADER.size and payload[:4] == TTS_FRAME_MAGIC
+
+
+class TtsFrameWriter:
+    """
+    Frames one reply. Sequence numbers run across every frame of the reply,
+    so the device can tell a skipped frame from a new reply.
+
+    Each audio frame carries its own format, so consecutive segments may use
+    different rates or channel counts (e.g. cached prompts next to live synthesis).
+    """
+
+    def __init__(self, sample_rate: int, channels: int = 1):
+        self.sample_rate = sample_rate
+        self.channels = channels
+        self.seq = 0
+        self.audio_bytes = 0
+
+    def _frame(self, frame_type: int, payload: bytes = b"") -> bytes:
+        header = TTS_FRAME_HEADER.pack(
+            TTS_FRAME_MAGIC, TTS_FRAME_VERSION, frame_type, TTS_FRAME_CODEC_PCM16,
+            self.channels, self.sample_rate, self.seq & 0xFFFFFFFF
+        )
+        self.seq += 1
+        return header + payload
+
+    def audio(self, pcm: bytes, sample_rate: Optional[int] = None,
+              channels: Optional[int] = None) -> Iterator[bytes]:
+        """Split PCM16 into AUDIO frames of whole sample frames; a new format applies from here on."""
+        if sample_rate is not None:
+            self.sample_rate = sample_rate
+        if channels is not None:
+            self.channels = channels
+        frame_bytes = 2 * self.channels
+        step = ((TTS_FRAME_BYTES - TTS_FRAME_HEADER.size) // frame_bytes) * frame_bytes
+        usable = len(pcm) - (len(pcm) % frame_bytes)
+        for offset in range(0, usable, step):
+            chunk = pcm[offset:min(offset + step, usable)]
+            self.audio_bytes += len(chunk)
+            yield self._frame(TTS_FRAME_TYPE_AUDIO, chunk)
+
+    def flush(self) -> bytes:
+        return self._frame(TTS_FRAME_TYPE_FLUSH)
+
+    def end(self) -> bytes:
+        return self._frame(TTS_FRAME_TYPE_END)
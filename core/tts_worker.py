@@ -2,14 +2,21 @@
 TTS Worker Module - Synchronous pyttsx3 Speech Synthesis
 Handles blocking text-to-speech generation in thread pool isolation while
 normalizing output to the ESP32's 16 kHz mono PCM requirement.
+Engines are long-lived and repeated phrases are served from an in-memory PCM cache.
 """
 
 import os
 import io
+import re
+import sys
 import wave
+import struct
 import tempfile
+import threading
 import pyttsx3
-from typing import Optional
+from collections import OrderedDict
+from contextlib import contextmanager
+from typing import Iterable, Iterator, List, Optional, Tuple
 
 try:
     import audioop  # type: ignore[import]
@@ -18,14 +25,34 @@ except ImportError as exc:
 
 # TTS engine configuration
 DEFAULT_RATE = 175  # Words per minute (moderate speed for clarity)
+DEFAULT_VOICE = os.getenv("TTS_VOICE", "").strip() or None  # Engine voice id; empty = platform default
+
+# Synthesized-phrase cache: total PCM kept in memory, and the longest single entry cached
+TTS_CACHE_BYTES = int(os.getenv("TTS_CACHE_BYTES", 8 * 1024 * 1024))
+TTS_CACHE_MAX_ENTRY_BYTES = int(os.getenv("TTS_CACHE_MAX_ENTRY_BYTES", 320 * 1024))  # ~10 s of speech
+
+# Where engines write their output; RAM-backed when /dev/shm exists
+_DEFAULT_SCRATCH_DIR = "/dev/shm" if os.path.isdir("/dev/shm") and os.access("/dev/shm", os.W_OK) else tempfile.gettempdir()
+TTS_SCRATCH_DIR = os.getenv("TTS_SCRATCH_DIR", _DEFAULT_SCRATCH_DIR)
 
 TARGET_SAMPLE_RATE = 16000  # Fixed 16 kHz to match ESP32 voice pipeline
 TARGET_SAMPLE_WIDTH = 2     # 16-bit PCM
 TARGET_CHANNELS = 1         # Mono playback
 
+# Streaming WAV header: RIFF/data sizes are unknown when the first sentence is sent.
+# 0xFFFFFFFF is the conventional "length unknown" marker; the ESP32 decoder skips its
+# declared-size completion check for it and relies on the zero-length EOS frame instead.
+STREAMING_WAV_SIZE = 0xFFFFFFFF
+
+# Sentence fragments shorter than this are merged into the next one so the
+# pipeline doesn't pay pyttsx3 engine start-up cost for "Ok." or "Well,".
+MIN_SENTENCE_CHARS = 12
+
+_SENTENCE_FALLBACK_RE = re.compile(r"(?<=[.!?])\s+")
 
-def _ensure_pcm_format(wav_bytes: bytes) -> bytes:
-    """Normalize synthesized audio to 16 kHz, mono, 16-bit PCM."""
+
+def _normalize_pcm(wav_bytes: bytes) -> bytes:
+    """Convert synthesized WAV to headerless 16 kHz, mono, 16-bit PCM frames."""
 
     try:
         with wave.open(io.BytesIO(wav_bytes), "rb") as wav_in:
@@ -59,28 +86,248 @@ def _ensure_pcm_format(wav_bytes: bytes) -> bytes:
     if channels != TARGET_CHANNELS or sample_width != TARGET_SAMPLE_WIDTH or sample_rate != TARGET_SAMPLE_RATE:
         raise ValueError("Failed to normalize WAV format")
 
+    return frames
+
+
+def _wrap_wav(pcm: bytes) -> bytes:
+    """Complete WAV file (known length) around 16 kHz mono PCM16 frames."""
     buffer = io.BytesIO()
     with wave.open(buffer, "wb") as wav_out:
         wav_out.setnchannels(TARGET_CHANNELS)
         wav_out.setsampwidth(TARGET_SAMPLE_WIDTH)
         wav_out.setframerate(TARGET_SAMPLE_RATE)
-        wav_out.writeframes(frames)
-
+        wav_out.writeframes(pcm)
     return buffer.getvalue()
 
 
-def synthesize_response_audio(text: str, rate: int = DEFAULT_RATE) -> bytes:
+def _ensure_pcm_format(wav_bytes: bytes) -> bytes:
+    """Normalize synthesized audio to a 16 kHz, mono, 16-bit PCM WAV file."""
+    return _wrap_wav(_normalize_pcm(wav_bytes))
+
+
+class PhraseCache:
+    """
+    Byte-bounded LRU of synthesized PCM keyed by (text, rate, voice).
+
+    Replies repeat more than one would think ("Sure.", greetings, the fallback
+    apology), and a hit skips the engine run entirely. Prewarmed entries are
+    pinned so a burst of long one-off replies cannot evict them.
+    """
+
+    def __init__(self, max_bytes: int, max_entry_bytes: int):
+        self.max_bytes = max(0, max_bytes)
+        self.max_entry_bytes = max_entry_bytes
+        self._entries: "OrderedDict[Tuple[str, int, str], bytes]" = OrderedDict()
+        self._pinned: set = set()
+        self._bytes = 0
+        self._lock = threading.Lock()
+        self.hits = 0
+        self.misses = 0
+
+    def get(self, key: Tuple[str, int, str]) -> Optional[bytes]:
+        with self._lock:
+            pcm = self._entries.get(key)
+            if pcm is None:
+                self.misses += 1
+                return None
+            self._entries.move_to_end(key)
+            self.hits += 1
+            return pcm
+
+    def put(self, key: Tuple[str, int, str], pcm: bytes, pin: bool = False) -> None:
+        if len(pcm) > self.max_entry_bytes or len(pcm) > self.max_bytes:
+            return
+        with self._lock:
+            previous = self._entries.pop(key, None)
+            if previous is not None:
+                self._bytes -= len(previous)
+            self._entries[key] = pcm
+            self._bytes += len(pcm)
+            if pin:
+                self._pinned.add(key)
+            # Evict least recently used, skipping pinned phrases
+            for old_key in list(self._entries.keys()):
+                if self._bytes <= self.max_bytes:
+                    break
+                if old_key in self._pinned or old_key == key:
+                    continue
+                self._bytes -= len(self._entries.pop(old_key))
+
+    def stats(self) -> dict:
+        with self._lock:
+            lookups = self.hits + self.misses
+            return {
+                "entries": len(self._entries),
+                "pinned": len(self._pinned),
+                "bytes": self._bytes,
+                "max_bytes": self.max_bytes,
+                "hits": self.hits,
+                "misses": self.misses,
+                "hit_rate": round(self.hits / lookups, 3) if lookups else 0.0,
+            }
+
+
+_PHRASE_CACHE = PhraseCache(TTS_CACHE_BYTES, TTS_CACHE_MAX_ENTRY_BYTES)
+
+
+def _single_engine_backend() -> bool:
+    """
+    True when the platform driver cannot run two engines in one process.
+
+    pyttsx3's espeak driver (Linux) registers its synthesis callback in the
+    process-global libespeak, so a second Engine silently steals the first
+    one's output; NSSpeechSynthesizer is tied to one run loop. Only SAPI5
+    engines are independent per thread.
+    """
+    return not sys.platform.startswith("win")
+
+
+# Long-lived engines: one shared (locked) engine on espeak/nsss, otherwise one per
+# TTS worker thread so SAPI5's COM apartment stays with the thread that made it
+_SHARED_ENGINE = None
+_SHARED_ENGINE_LOCK = threading.Lock()
+_THREAD_ENGINE = threading.local()
+_ENGINE_STATS = {"created": 0, "discarded": 0}
+_ENGINE_STATS_LOCK = threading.Lock()
+
+
+def _new_engine():
+    # pyttsx3.init() hands every caller the same cached Engine; construct directly
+    # so each pool slot really owns its driver
+    engine = pyttsx3.Engine()
+    if DEFAULT_VOICE:
+        engine.setProperty('voice', DEFAULT_VOICE)
+    with _ENGINE_STATS_LOCK:
+        _ENGINE_STATS["created"] += 1
+    print(f"TTS engine created ({threading.current_thread().name})")
+    return engine
+
+
+def _discard_engine(engine) -> None:
+    try:
+        engine.stop()
+    except Exception:
+        pass
+    with _ENGINE_STATS_LOCK:
+        _ENGINE_STATS["discarded"] += 1
+
+
+@contextmanager
+def _engine_lease() -> Iterator[object]:
+    """
+    Borrow a long-lived engine for one synthesis.
+
+    An engine that raised is dropped and rebuilt on the next lease, so one
+    wedged driver does not poison every later reply.
+    """
+    global _SHARED_ENGINE
+    if _single_engine_backend():
+        with _SHARED_ENGINE_LOCK:
+            if _SHARED_ENGINE is None:
+                _SHARED_ENGINE = _new_engine()
+            try:
+                yield _SHARED_ENGINE
+            except Exception:
+                _discard_engine(_SHARED_ENGINE)
+                _SHARED_ENGINE = None
+                raise
+        return
+
+    engine = getattr(_THREAD_ENGINE, "engine", None)
+    if engine is None:
+        engine = _new_engine()
+        _THREAD_ENGINE.engine = engine
+    try:
+        yield engine
+    except Exception:
+        _discard_engine(engine)
+        _THREAD_ENGINE.engine = None
+        raise
+
+
+def _scratch_path() -> str:
+    """
+    Per-thread output file the engine writes into, reused for every synthesis.
+
+    pyttsx3 can only save to a path on every backend, so the round-trip stays;
+    it goes to RAM-backed /dev/shm where available and skips the per-call
+    mkstemp/unlink.
+    """
+    path = getattr(_THREAD_ENGINE, "scratch_path", None)
+    if path is None:
+        path = os.path.join(TTS_SCRATCH_DIR, f"hotpin_tts_{os.getpid()}_{threading.get_ident()}.wav")
+        _THREAD_ENGINE.scratch_path = path
+    return path
+
+
+def _render_pcm(text: str, rate: int, voice: Optional[str]) -> bytes:
+    """Run the engine once (BLOCKING) and return normalized PCM16 frames."""
+    path = _scratch_path()
+    with _engine_lease() as engine:
+        engine.setProperty('rate', rate)
+        if voice or DEFAULT_VOICE:
+            engine.setProperty('voice', voice or DEFAULT_VOICE)
+        # Some drivers only write the file when they produced audio: clear the
+        # previous phrase first so silence can't come back as the old reply
+        try:
+            os.unlink(path)
+        except FileNotFoundError:
+            pass
+        engine.save_to_file(text, path)
+        # Blocks until the WAV has been written
+        engine.runAndWait()
+        try:
+            with open(path, 'rb') as audio_file:
+                wav_bytes = audio_file.read()
+        except FileNotFoundError:
+            wav_bytes = b""
+
+    if len(wav_bytes) == 0:
+        raise ValueError("TTS synthesis produced empty audio file")
+    pcm = _normalize_pcm(wav_bytes)
+    if len(pcm) == 0:
+        raise ValueError("TTS synthesis produced no audio frames")
+    return pcm
+
+
+def synthesize_pcm(text: str, rate: int = DEFAULT_RATE, voice: Optional[str] = None) -> bytes:
+    """
+    Synthesize text to headerless 16 kHz mono PCM16, served from the phrase cache when possible.
+
+    BLOCKING - run on the TTS stage. Raises ValueError for empty text.
+    """
+    if not text or text.strip() == "":
+        error_msg = "Cannot synthesize empty text. Provide non-empty string."
+        print(f"✗ TTS input validation error: {error_msg}")
+        raise ValueError(error_msg)
+
+    text = text.strip()
+    key = (text, rate, voice or DEFAULT_VOICE or "")
+    pcm = _PHRASE_CACHE.get(key)
+    if pcm is not None:
+        return pcm
+
+    try:
+        pcm = _render_pcm(text, rate, voice)
+    except Exception as e:
+        print(f"TTS synthesis error: {type(e).__name__}: {e}")
+        raise
+    _PHRASE_CACHE.put(key, pcm)
+    return pcm
+
+
+def synthesize_response_audio(text: str, rate: int = DEFAULT_RATE, voice: Optional[str] = None) -> bytes:
     """
-    Generate speech audio from text using pyttsx3.
+    Generate speech audio from text using a pooled pyttsx3 engine.
     
-    This is a BLOCKING function executed in FastAPI's thread pool.
-    pyttsx3 requires exclusive thread control during synthesis via runAndWait().
-    Uses temporary file I/O as pyttsx3 doesn't reliably support in-memory
-    byte output across all platform backends (SAPI5, nsss, espeak).
+    This is a BLOCKING function executed on the TTS stage.
+    pyttsx3 requires exclusive control of an engine during runAndWait(), which
+    the engine lease provides.
     
     Args:
         text: Text content to synthesize into speech
         rate: Speech rate in words per minute (default: 175)
+        voice: Engine voice id (default: TTS_VOICE or the platform default)
     
     Returns:
         bytes: Complete WAV audio file data normalized to 16 kHz mono PCM
@@ -88,106 +335,109 @@ def synthesize_response_audio(text: str, rate: int = DEFAULT_RATE) -> bytes:
     Raises:
         ValueError: If input text is empty or whitespace only
         Exception: If synthesis fails or engine initialization fails
-    
-    Process:
-    1. Initialize pyttsx3 engine (platform-specific backend)
-    2. Configure speech properties (rate, voice)
-    3. Generate unique temporary WAV file path
-    4. Save synthesized speech to temp file
-    5. Execute runAndWait() to block until synthesis completes
-    6. Read WAV bytes from file
-    7. Clean up temporary file
-    8. Return audio bytes
-    """
-    # Input validation - must be done BEFORE thread pool execution
-    if not text or text.strip() == "":
-        error_msg = "Cannot synthesize empty text. Provide non-empty string."
-        print(f"✗ TTS input validation error: {error_msg}")
-        raise ValueError(error_msg)
-    
-    # Sanitize text for TTS (remove problematic characters)
-    text = text.strip()
-    
-    engine = None
-    temp_fd = None
-    temp_path = None
-    
-    try:
-        # Step 1: Initialize pyttsx3 engine
-        # This creates a platform-specific TTS engine instance
-        # Windows: SAPI5, macOS: NSSpeechSynthesizer, Linux: espeak
-        engine = pyttsx3.init()
-        
-        # Step 2: Configure speech properties
-        engine.setProperty('rate', rate)  # Speech speed
-        
-        # Optional: Set voice (can be customized for different languages/accents)
-        # voices = engine.getProperty('voices')
-        # engine.setProperty('voice', voices[0].id)  # Use first available voice
-        
-        # Step 3: Create temporary file for WAV output
-        # mkstemp returns (file_descriptor, file_path)
-        # We need the path for pyttsx3 and will manage cleanup manually
-        temp_fd, temp_path = tempfile.mkstemp(suffix=".wav", prefix="hotpin_tts_")
-        
-        # Close the file descriptor as pyttsx3 will handle file writing
-        os.close(temp_fd)
-        temp_fd = None  # Mark as closed
-        
-        # Step 4: Queue text for synthesis and specify output file
-        engine.save_to_file(text, temp_path)
-        
-        # Step 5: Execute synthesis (BLOCKING OPERATION)
-        # This call blocks the thread until audio generation is complete
-        # and the WAV file has been written to disk
-        engine.runAndWait()
-        
-        # Step 6: Read synthesized audio bytes from temporary file
-        with open(temp_path, 'rb') as audio_file:
-            wav_bytes = audio_file.read()
-        
-        # Verify we got valid audio data
-        if len(wav_bytes) == 0:
-            raise ValueError("TTS synthesis produced empty audio file")
+    """
+    wav_bytes = _wrap_wav(synthesize_pcm(text, rate, voice))
+    print(f"TTS synthesis completed: {len(wav_bytes)} bytes generated")
+    return wav_bytes
 
-        # Normalize to device-friendly PCM format
-        wav_bytes = _ensure_pcm_format(wav_bytes)
-        
-        print(f"TTS synthesis completed: {len(wav_bytes)} bytes generated")
-        
-        return wav_bytes
-    
-    except ValueError as ve:
-        # Re-raise validation errors with context
-        print(f"TTS validation error: {ve}")
-        raise
-    
-    except Exception as e:
-        print(f"TTS synthesis error: {type(e).__name__}: {e}")
-        raise
-    
-    finally:
-        # Step 7: Cleanup - ensure temporary file is deleted
-        if temp_path and os.path.exists(temp_path):
-            try:
-                os.remove(temp_path)
-                print(f"Cleaned up temp file: {temp_path}")
-            except Exception as cleanup_error:
-                print(f"Failed to cleanup temp file {temp_path}: {cleanup_error}")
-        
-        # Close file descriptor if still open (edge case)
-        if temp_fd is not None:
-            try:
-                os.close(temp_fd)
-            except:
-                pass
-        
-        # Stop the TTS engine
-        if engine:
+
+def prewarm_phrases(phrases: Iterable[str], rate: int = DEFAULT_RATE) -> int:
+    """
+    Synthesize fixed prompts ahead of time and pin them in the phrase cache.
+
+    Each phrase is cached whole (full-WAV path) and split into sentences
+    (pipelined path), matching how either path will look it up. BLOCKING.
+
+    Returns:
+        int: Number of cache entries warmed
+    """
+    warmed = 0
+    for phrase in phrases:
+        units = [phrase.strip()] + split_sentences(phrase)
+        for unit in dict.fromkeys(u for u in units if u):
+            key = (unit, rate, DEFAULT_VOICE or "")
             try:
-                engine.stop()
-            except:
-                pass
+                pcm = _PHRASE_CACHE.get(key) or _render_pcm(unit, rate, None)
+            except Exception as e:
+                print(f"⚠ TTS prewarm failed for \"{unit}\": {e}")
+                continue
+            _PHRASE_CACHE.put(key, pcm, pin=True)
+            warmed += 1
+    return warmed
+
+
+def get_tts_cache_stats() -> dict:
+    """Phrase cache and engine pool counters for /health."""
+    stats = _PHRASE_CACHE.stats()
+    with _ENGINE_STATS_LOCK:
+        stats["engines_created"] = _ENGINE_STATS["created"]
+        stats["engines_discarded"] = _ENGINE_STATS["discarded"]
+    stats["shared_engine"] = _single_engine_backend()
+    return stats
+
+
+def split_sentences(text: str) -> List[str]:
+    """
+    Split a response into sentence-sized units for pipelined synthesis.
+
+    Uses NLTK punkt (downloaded at server startup) with a regex fallback.
+    Very short fragments are merged forward so each unit is worth an engine run.
+    """
+    text = (text or "").strip()
+    if not text:
+        return []
+
+    try:
+        from nltk.tokenize import sent_tokenize
+        raw = sent_tokenize(text)
+    except Exception:
+        raw = _SENTENCE_FALLBACK_RE.split(text)
+
+    sentences: List[str] = []
+    pending = ""
+    for part in raw:
+        part = part.strip()
+        if not part:
+            continue
+        pending = f"{pending} {part}" if pending else part
+        if len(pending) >= MIN_SENTENCE_CHARS:
+            sentences.append(pending)
+            pending = ""
+
+    if pending:
+        if sentences:
+            sentences[-1] = f"{sentences[-1]} {pending}"
+        else:
+            sentences.append(pending)
+
+    return sentences
+
+
+def synthesize_sentence_pcm(text: str, rate: int = DEFAULT_RATE) -> bytes:
+    """
+    Synthesize one sentence and return headerless 16 kHz mono PCM16.
+
+    BLOCKING - run on the TTS stage. Used by the pipelined TTS path, which
+    sends a single streaming header and then concatenates raw PCM from each sentence.
+    """
+    return synthesize_pcm(text, rate)
+
+
+def create_streaming_wav_header(sample_rate: int = TARGET_SAMPLE_RATE) -> bytes:
+    """
+    Build a 44-byte PCM WAV header with "unknown" RIFF and data lengths.
+
+    Sent once before the first sentence's PCM so the device's single-header
+    parser configures I2S exactly as it does for a complete WAV file.
+    """
+    block_align = TARGET_CHANNELS * TARGET_SAMPLE_WIDTH
+    return struct.pack(
+        "<4sI4s4sIHHIIHH4sI",
+        b"RIFF", STREAMING_WAV_SIZE, b"WAVE",
+        b"fmt ", 16, 1, TARGET_CHANNELS, sample_rate,
+        sample_rate * block_align, block_align, TARGET_SAMPLE_WIDTH * 8,
+        b"data", STREAMING_WAV_SIZE
+    )
 
 
 def get_available_voices() -> list:
@@ -199,9 +449,9 @@ def get_available_voices() -> list:
         list: List of voice objects with id, name, and language info
     """
     try:
-        engine = pyttsx3.init()
-        voices = engine.getProperty('voices')
-        engine.stop()
+        # Through the pool: a throwaway espeak engine would steal the shared one's callback
+        with _engine_lease() as engine:
+            voices = engine.getProperty('voices')
         
         voice_info = []
         for voice in voices:
@@ -221,14 +471,15 @@ def get_available_voices() -> list:
 def test_tts_engine() -> bool:
     """
     Test if pyttsx3 engine can be initialized successfully.
-    Useful for startup validation.
+    Useful for startup validation; on shared-engine backends this also
+    creates the engine the first reply will use.
     
     Returns:
         bool: True if engine initializes successfully, False otherwise
     """
     try:
-        engine = pyttsx3.init()
-        engine.stop()
+        with _engine_lease():
+            pass
         print("pyttsx3 TTS engine test successful")
         return True
     except Exception as e:
@@ -0,0 +1,155 @@
+"""
+Turn Metrics Module - End-to-end turn latency across device and server
+Each turn is keyed by the id the device sends with EOS. The server times its
+own stages from EOS receipt; the device reports its stage times (measured from
+the end of speech) once the turn ends. Both sides land in sliding windows
+summarised as p50/p95/p99 for GET /metrics
+"""
+
+import os
+import threading
+import time
+from collections import OrderedDict, deque
+from typing import Any, Dict, Optional
+
+# Turns kept per series for the percentiles
+TURN_METRICS_WINDOW = int(os.getenv("TURN_METRICS_WINDOW", 512))
+
+# Finished server timings waiting for their device report
+PENDING_TURNS_LIMIT = 256
+
+# Device report keys (turn_metrics.c), in turn order
+DEVICE_MARKS = ("eos_sent", "transcription", "transcript", "reply",
+                "first_audio", "first_sample", "complete")
+
+# Device values above this are treated as garbage rather than a 10-minute turn
+MAX_DEVICE_MS = 600000
+
+
+def _percentile(sorted_values: list, fraction: float) -> float:
+    if not sorted_values:
+        return 0.0
+    index = min(len(sorted_values) - 1, int(round(fraction * (len(sorted_values) - 1))))
+    return sorted_values[index]
+
+
+class TurnTimer:
+    """
+    Server-side stage clock for one turn, started when EOS arrives.
+
+    stamp() tags outgoing stage messages with the device's turn id (so a late
+    message from an earlier turn is recognisable) and the server time so far.
+    """
+
+    def __init__(self, session_id: str, turn: Any):
+        self.session_id = session_id
+        self.turn: Optional[int] = turn if isinstance(turn, int) and turn > 0 else None
+        self.result = "abandoned"
+        self.marks: Dict[str, float] = {}
+        self._start = time.perf_counter()
+
+    def elapsed_ms(self) -> float:
+        return round((time.perf_counter() - self._start) * 1000.0, 1)
+
+    def mark(self, stage: str) -> None:
+        """Record a stage once; later calls keep the first time."""
+        self.marks.setdefault(stage, self.elapsed_ms())
+
+    def stamp(self, message: dict) -> dict:
+        if self.turn is not None:
+            message["turn"] = self.turn
+            message["server_ms"] = self.elapsed_ms()
+        return message
+
+
+class TurnMetrics:
+    """
+    Sliding-window latency series for every turn stage.
+
+    Series are named "server.<stage>" (from EOS receipt), "device.<stage>"
+    (from the end of speech on the device) and a few derived ones: "net.rtt"
+    (EOS out to the server's acknowledgement) and "device.playout" (first TTS
+    byte to first sample, i.e. jitter-buffer fill).
+    """
+
+    def __init__(self, window: int = TURN_METRICS_WINDOW):
+        self.window = max(16, window)
+        self._lock = threading.Lock()
+        self._series: Dict[str, deque] = {}
+        self._pending: "OrderedDict[tuple, Dict[str, float]]" = OrderedDict()
+        self._results: Dict[str, int] = {}
+        self._device_reports = 0
+        self._matched_reports = 0
+
+    def _add(self, name: str, value: float) -> None:
+        series = self._series.get(name)
+        if series is None:
+            series = deque(maxlen=self.window)
+            self._series[name] = series
+        series.append(value)
+
+    def finish_server(self, timer: TurnTimer) -> None:
+        """Record the server's stage times for a finished turn."""
+        with self._lock:
+            self._results[timer.result] = self._results.get(timer.result, 0) + 1
+            for stage, value in timer.marks.items():
+                self._add(f"server.{stage}", value)
+            if timer.turn is not None:
+                self._pending[(timer.session_id, timer.turn)] = dict(timer.marks)
+                while len(self._pending) > PENDING_TURNS_LIMIT:
+                    self._pending.popitem(last=False)
+
+    def record_device(self, session_id: str, report: dict) -> Optional[Dict[str, float]]:
+        """
+        Record a {"signal": "TURN_METRICS"} report.
+
+        Returns:
+            The device stage times that were accepted, or None for a malformed report
+        """
+        marks = report.get("ms")
+        if not isinstance(marks, dict):
+            return None
+        accepted = {
+            name: float(marks[name]) for name in DEVICE_MARKS
+            if isinstance(marks.get(name), (int, float)) and 0 <= marks[name] <= MAX_DEVICE_MS
+        }
+        turn = report.get("turn")
+
+        with self._lock:
+            self._device_reports += 1
+            for name, value in accepted.items():
+                self._add(f"device.{name}", value)
+            if "eos_sent" in accepted and "transcription" in accepted:
+                # The server answers EOS with "transcription" before doing any work
+                self._add("net.rtt", accepted["transcription"] - accepted["eos_sent"])
+            if "first_audio" in accepted and "first_sample" in accepted:
+                self._add("device.playout", accepted["first_sample"] - accepted["first_audio"])
+            if self._pending.pop((session_id, turn), None) is not None:
+                self._matched_reports += 1
+        return accepted
+
+    def snapshot(self) -> dict:
+        with self._lock:
+            series = {name: sorted(values) for name, values in self._series.items()}
+            results = dict(self._results)
+            device_reports = self._device_reports
+            matched = self._matched_reports
+
+        stages = {}
+        for name in sorted(series):
+            values = series[name]
+            stages[name] = {
+                "count": len(values),
+                "p50": round(_percentile(values, 0.50), 1),
+                "p95": round(_percentile(values, 0.95), 1),
+                "p99": round(_percentile(values, 0.99), 1),
+                "max": round(values[-1], 1) if values else 0.0,
+            }
+        return {
+            "window": self.window,
+            "turns": sum(results.values()),
+            "results": results,
+            "device_reports": device_reports,
+            "matched_reports": matched,
+            "stages_ms": stages,
+        }
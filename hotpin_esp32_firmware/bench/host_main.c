@@ -0,0 +1,124 @@
+/**
+ * @file host_main.c
+ * @brief Host runner for bench_suite: filtering, baselines and regression checks
+ *
+ * Usage:
+ *   hotpin_bench [--filter PREFIX] [--min-ms N] [--save FILE]
+ *                [--compare FILE] [--tolerance PCT]
+ *
+ * --save writes "<case> <ns/op>" lines; --compare reads such a file and exits
+ * with status 1 when any case got slower than the tolerance (default 15%).
+ * Baselines are only comparable on the same machine and compiler.
+ */
+
+#include "bench_suite.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_BASELINE 64
+
+typedef struct {
+    char name[32];
+    double ns_per_op;
+} baseline_entry_t;
+
+typedef struct {
+    baseline_entry_t entries[MAX_BASELINE];
+    size_t count;
+    double tolerance;
+    int regressions;
+    FILE *save;
+} host_run_t;
+
+static size_t load_baseline(const char *path, baseline_entry_t *entries, size_t max) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Cannot read baseline %s\n", path);
+        exit(2);
+    }
+    size_t count = 0;
+    while (count < max && fscanf(file, "%31s %lf", entries[count].name, &entries[count].ns_per_op) == 2) {
+        count++;
+    }
+    fclose(file);
+    return count;
+}
+
+static void on_result(const bench_result_t *result, void *arg) {
+    host_run_t *run = (host_run_t *)arg;
+    if (run->save != NULL) {
+        fprintf(run->save, "%s %.1f\n", result->name, result->ns_per_op);
+    }
+    for (size_t i = 0; i < run->count; i++) {
+        if (strcmp(run->entries[i].name, result->name) != 0 || run->entries[i].ns_per_op <= 0.0) {
+            continue;
+        }
+        double change = (result->ns_per_op / run->entries[i].ns_per_op - 1.0) * 100.0;
+        bool regressed = change > run->tolerance;
+        printf("      %-16s %+6.1f%% vs baseline%s\n", result->name, change, regressed ? "  << REGRESSION" : "");
+        if (regressed) {
+            run->regressions++;
+        }
+        break;
+    }
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [--filter PREFIX] [--min-ms N] [--save FILE] [--compare FILE] [--tolerance PCT]\n",
+            argv0);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    const char *filter = NULL;
+    const char *save_path = NULL;
+    const char *compare_path = NULL;
+    uint32_t min_ms = 0;
+    host_run_t run = { .tolerance = 15.0 };
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+        }
+        if (strcmp(argv[i], "--filter") == 0) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--min-ms") == 0) {
+            min_ms = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--save") == 0) {
+            save_path = argv[++i];
+        } else if (strcmp(argv[i], "--compare") == 0) {
+            compare_path = argv[++i];
+        } else if (strcmp(argv[i], "--tolerance") == 0) {
+            run.tolerance = strtod(argv[++i], NULL);
+        } else {
+            usage(argv[0]);
+        }
+    }
+
+    if (compare_path != NULL) {
+        run.count = load_baseline(compare_path, run.entries, MAX_BASELINE);
+    }
+    if (save_path != NULL) {
+        run.save = fopen(save_path, "w");
+        if (run.save == NULL) {
+            fprintf(stderr, "Cannot write %s\n", save_path);
+            return 2;
+        }
+    }
+
+    esp_err_t ret = bench_suite_run(filter, min_ms, on_result, &run);
+    if (run.save != NULL) {
+        fclose(run.save);
+    }
+    if (ret != ESP_OK) {
+        fprintf(stderr, "Benchmark run failed: %s\n", esp_err_to_name(ret));
+        return 2;
+    }
+    if (run.regressions > 0) {
+        printf("%d case(s) slower than baseline by more than %.0f%%\n", run.regressions, run.tolerance);
+        return 1;
+    }
+    return 0;
+}
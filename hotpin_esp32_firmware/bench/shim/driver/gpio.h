@@ -0,0 +1,11 @@
+/**
+ * @file gpio.h
+ * @brief Host shim: config.h only names pins, it never touches them
+ */
+
+#ifndef HOST_SHIM_DRIVER_GPIO_H
+#define HOST_SHIM_DRIVER_GPIO_H
+
+typedef int gpio_num_t;
+
+#endif // HOST_SHIM_DRIVER_GPIO_H
@@ -0,0 +1,14 @@
+/**
+ * @file esp_attr.h
+ * @brief Host shim: placement attributes are no-ops off the device
+ */
+
+#ifndef HOST_SHIM_ESP_ATTR_H
+#define HOST_SHIM_ESP_ATTR_H
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define EXT_RAM_BSS_ATTR
+#define RTC_DATA_ATTR
+
+#endif // HOST_SHIM_ESP_ATTR_H
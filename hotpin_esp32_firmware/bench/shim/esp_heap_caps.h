@@ -0,0 +1,21 @@
+/**
+ * @file esp_heap_caps.h
+ * @brief Host shim: capability allocators map onto malloc
+ */
+
+#ifndef HOST_SHIM_ESP_HEAP_CAPS_H
+#define HOST_SHIM_ESP_HEAP_CAPS_H
+
+#include <stdlib.h>
+
+#define MALLOC_CAP_8BIT         (1u << 2)
+#define MALLOC_CAP_DMA          (1u << 3)
+#define MALLOC_CAP_SPIRAM       (1u << 10)
+#define MALLOC_CAP_INTERNAL     (1u << 11)
+#define MALLOC_CAP_DEFAULT      (1u << 12)
+
+#define heap_caps_malloc(size, caps)        ((void)(caps), malloc(size))
+#define heap_caps_calloc(n, size, caps)     ((void)(caps), calloc((n), (size)))
+#define heap_caps_free(ptr)                 free(ptr)
+
+#endif // HOST_SHIM_ESP_HEAP_CAPS_H
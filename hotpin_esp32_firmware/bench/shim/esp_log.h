@@ -0,0 +1,43 @@
+/**
+ * @file esp_log.h
+ * @brief Host shim: ESP_LOGx to stderr, warnings and errors only
+ *
+ * Honours LOG_LOCAL_LEVEL like the IDF header, so module floors still compile
+ * out the same calls they do on the device.
+ */
+
+#ifndef HOST_SHIM_ESP_LOG_H
+#define HOST_SHIM_ESP_LOG_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+#ifndef LOG_LOCAL_LEVEL
+#define LOG_LOCAL_LEVEL ESP_LOG_INFO
+#endif
+
+// Benchmark output owns stdout; module chatter above WARN would only skew timings
+#define HOST_LOG_LEVEL ESP_LOG_WARN
+
+#define ESP_LOG_LEVEL(level, tag, format, ...) do {                                         \
+    if (LOG_LOCAL_LEVEL >= (level) && HOST_LOG_LEVEL >= (level)) {                          \
+        fprintf(stderr, "%s: " format "\n", (tag), ##__VA_ARGS__);                          \
+    }                                                                                       \
+} while (0)
+
+#define ESP_LOGE(tag, format, ...)  ESP_LOG_LEVEL(ESP_LOG_ERROR, tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...)  ESP_LOG_LEVEL(ESP_LOG_WARN, tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...)  ESP_LOG_LEVEL(ESP_LOG_INFO, tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...)  ESP_LOG_LEVEL(ESP_LOG_DEBUG, tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...)  ESP_LOG_LEVEL(ESP_LOG_VERBOSE, tag, format, ##__VA_ARGS__)
+
+#endif // HOST_SHIM_ESP_LOG_H
@@ -0,0 +1,18 @@
+/**
+ * @file esp_mac.h
+ * @brief Host shim: fixed MAC for session ids
+ */
+
+#ifndef HOST_SHIM_ESP_MAC_H
+#define HOST_SHIM_ESP_MAC_H
+
+#include "esp_err.h"
+#include <stdint.h>
+
+typedef enum {
+    ESP_MAC_WIFI_STA,
+} esp_mac_type_t;
+
+esp_err_t esp_read_mac(uint8_t *mac, esp_mac_type_t type);
+
+#endif // HOST_SHIM_ESP_MAC_H
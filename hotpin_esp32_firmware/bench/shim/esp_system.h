@@ -0,0 +1,11 @@
+/**
+ * @file esp_system.h
+ * @brief Host shim: nothing from esp_system is used by the benchmarked code
+ */
+
+#ifndef HOST_SHIM_ESP_SYSTEM_H
+#define HOST_SHIM_ESP_SYSTEM_H
+
+#include "esp_err.h"
+
+#endif // HOST_SHIM_ESP_SYSTEM_H
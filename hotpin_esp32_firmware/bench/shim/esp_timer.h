@@ -0,0 +1,13 @@
+/**
+ * @file esp_timer.h
+ * @brief Host shim: esp_timer_get_time() on CLOCK_MONOTONIC
+ */
+
+#ifndef HOST_SHIM_ESP_TIMER_H
+#define HOST_SHIM_ESP_TIMER_H
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
+
+#endif // HOST_SHIM_ESP_TIMER_H
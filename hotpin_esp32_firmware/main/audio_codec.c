@@ -0,0 +1,362 @@
+/**
+ * @file audio_codec.c
+ * @brief STT uplink encoders: IMA-ADPCM (4:1, a few cycles per sample) and optional Opus,
+ *        plus the ADPCM decoder used for stored prompt clips.
+ */
+
+#include "audio_codec.h"
+#include "config.h"
+#include "esp_log.h"
+#include <string.h>
+
+#if CONFIG_STT_CODEC_OPUS_ENABLED
+// Requires an Opus managed component (e.g. add "78/esp-opus" to idf_component.yml)
+#include "opus.h"
+#endif
+
+static const char *TAG = TAG_CODEC;
+
+// ===========================
+// IMA-ADPCM
+// ===========================
+
+static const int8_t s_ima_index_table[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+static const int16_t s_ima_step_table[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+    11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+    32767
+};
+
+// Encoder state carries across frames; each frame header snapshots it
+static int32_t s_adpcm_predictor = 0;
+static int32_t s_adpcm_index = 0;
+
+static inline uint8_t ima_adpcm_encode_sample(int32_t sample) {
+    int32_t step = s_ima_step_table[s_adpcm_index];
+    int32_t diff = sample - s_adpcm_predictor;
+    uint8_t code = 0;
+
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+
+    // Reconstruct exactly as the decoder will, so predictor tracking never drifts
+    int32_t delta = step >> 3;
+    if (diff >= step) {
+        code |= 4;
+        diff -= step;
+        delta += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        code |= 2;
+        diff -= step;
+        delta += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        code |= 1;
+        delta += step;
+    }
+
+    s_adpcm_predictor += (code & 8) ? -delta : delta;
+    if (s_adpcm_predictor > INT16_MAX) {
+        s_adpcm_predictor = INT16_MAX;
+    } else if (s_adpcm_predictor < INT16_MIN) {
+        s_adpcm_predictor = INT16_MIN;
+    }
+
+    s_adpcm_index += s_ima_index_table[code];
+    if (s_adpcm_index < 0) {
+        s_adpcm_index = 0;
+    } else if (s_adpcm_index > 88) {
+        s_adpcm_index = 88;
+    }
+
+    return code;
+}
+
+static esp_err_t ima_adpcm_encode(const uint8_t *pcm, size_t samples, uint8_t *out, size_t out_cap, size_t *out_len) {
+    size_t needed = AUDIO_CODEC_ADPCM_HEADER_BYTES + (samples + 1U) / 2U;
+    if (out_cap < needed) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    out[0] = (uint8_t)(s_adpcm_predictor & 0xFF);
+    out[1] = (uint8_t)((s_adpcm_predictor >> 8) & 0xFF);
+    out[2] = (uint8_t)s_adpcm_index;
+    out[3] = (samples & 1U) ? AUDIO_CODEC_ADPCM_FLAG_ODD_SAMPLES : 0;
+
+    uint8_t *dst = out + AUDIO_CODEC_ADPCM_HEADER_BYTES;
+    for (size_t i = 0; i < samples; i += 2) {
+        int16_t s0 = (int16_t)(pcm[2 * i] | (pcm[2 * i + 1] << 8));
+        uint8_t byte = ima_adpcm_encode_sample(s0);
+        if ((i + 1U) < samples) {
+            int16_t s1 = (int16_t)(pcm[2 * i + 2] | (pcm[2 * i + 3] << 8));
+            byte |= (uint8_t)(ima_adpcm_encode_sample(s1) << 4);
+        }
+        *dst++ = byte;
+    }
+
+    *out_len = needed;
+    return ESP_OK;
+}
+
+static inline int16_t ima_adpcm_decode_sample(uint8_t code, int32_t *predictor, int32_t *index) {
+    int32_t step = s_ima_step_table[*index];
+    int32_t delta = step >> 3;
+    if (code & 4) {
+        delta += step;
+    }
+    if (code & 2) {
+        delta += step >> 1;
+    }
+    if (code & 1) {
+        delta += step >> 2;
+    }
+
+    *predictor += (code & 8) ? -delta : delta;
+    if (*predictor > INT16_MAX) {
+        *predictor = INT16_MAX;
+    } else if (*predictor < INT16_MIN) {
+        *predictor = INT16_MIN;
+    }
+
+    *index += s_ima_index_table[code];
+    if (*index < 0) {
+        *index = 0;
+    } else if (*index > 88) {
+        *index = 88;
+    }
+    return (int16_t)*predictor;
+}
+
+esp_err_t audio_codec_adpcm_decode(const uint8_t *frame, size_t frame_len,
+                                   int16_t *pcm, size_t pcm_cap, size_t *samples) {
+    if (frame == NULL || pcm == NULL || samples == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *samples = 0;
+    if (frame_len < AUDIO_CODEC_ADPCM_HEADER_BYTES) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    int32_t predictor = (int16_t)(frame[0] | (frame[1] << 8));
+    int32_t index = frame[2];
+    if (index > 88) {
+        index = 88;
+    }
+
+    size_t code_bytes = frame_len - AUDIO_CODEC_ADPCM_HEADER_BYTES;
+    size_t count = code_bytes * 2U;
+    if ((frame[3] & AUDIO_CODEC_ADPCM_FLAG_ODD_SAMPLES) && count > 0U) {
+        count--;
+    }
+    if (count > pcm_cap) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    const uint8_t *src = frame + AUDIO_CODEC_ADPCM_HEADER_BYTES;
+    for (size_t i = 0; i < count; i++) {
+        uint8_t byte = src[i / 2U];
+        uint8_t code = (i & 1U) ? (uint8_t)(byte >> 4) : (uint8_t)(byte & 0x0F);
+        pcm[i] = ima_adpcm_decode_sample(code, &predictor, &index);
+    }
+
+    *samples = count;
+    return ESP_OK;
+}
+
+// ===========================
+// Opus (optional)
+// ===========================
+
+#if CONFIG_STT_CODEC_OPUS_ENABLED
+#define OPUS_FRAME_SAMPLES      ((CONFIG_AUDIO_SAMPLE_RATE * 20) / 1000)
+#define OPUS_MAX_PACKET_BYTES   160     // 20ms @ 24 kbps VBR peaks well below this
+
+static OpusEncoder *s_opus_encoder = NULL;
+static int16_t s_opus_pending[OPUS_FRAME_SAMPLES];
+static size_t s_opus_pending_samples = 0;
+
+static esp_err_t opus_encoder_prepare(void) {
+    if (s_opus_encoder == NULL) {
+        int err = OPUS_OK;
+        // One encoder (~20KB, malloc'd by libopus) lives for the rest of the boot
+        s_opus_encoder = opus_encoder_create(CONFIG_AUDIO_SAMPLE_RATE, 1, OPUS_APPLICATION_VOIP, &err);
+        if (s_opus_encoder == NULL || err != OPUS_OK) {
+            ESP_LOGE(TAG, "opus_encoder_create failed: %d", err);
+            s_opus_encoder = NULL;
+            return ESP_ERR_NO_MEM;
+        }
+        opus_encoder_ctl(s_opus_encoder, OPUS_SET_BITRATE(CONFIG_STT_CODEC_OPUS_BITRATE));
+        opus_encoder_ctl(s_opus_encoder, OPUS_SET_COMPLEXITY(0));
+        opus_encoder_ctl(s_opus_encoder, OPUS_SET_SIGNAL(OPUS_SIGNAL_VOICE));
+        ESP_LOGI(TAG, "Opus encoder ready (%d bps, %d samples/frame)",
+                 CONFIG_STT_CODEC_OPUS_BITRATE, OPUS_FRAME_SAMPLES);
+    } else {
+        opus_encoder_ctl(s_opus_encoder, OPUS_RESET_STATE);
+    }
+
+    s_opus_pending_samples = 0;
+    return ESP_OK;
+}
+
+static esp_err_t opus_emit_frame(uint8_t *out, size_t out_cap, size_t *pos) {
+    if ((out_cap - *pos) < (2U + OPUS_MAX_PACKET_BYTES)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    opus_int32 n = opus_encode(s_opus_encoder, s_opus_pending, OPUS_FRAME_SAMPLES,
+                               out + *pos + 2, OPUS_MAX_PACKET_BYTES);
+    s_opus_pending_samples = 0;
+    if (n < 0) {
+        ESP_LOGW(TAG, "opus_encode failed: %d", (int)n);
+        return ESP_FAIL;
+    }
+
+    out[*pos] = (uint8_t)(n & 0xFF);
+    out[*pos + 1] = (uint8_t)((n >> 8) & 0xFF);
+    *pos += 2U + (size_t)n;
+    return ESP_OK;
+}
+
+static esp_err_t opus_encode_block(const uint8_t *pcm, size_t samples, bool flush,
+                                   uint8_t *out, size_t out_cap, size_t *out_len) {
+    size_t pos = 0;
+    esp_err_t ret = ESP_OK;
+
+    for (size_t i = 0; i < samples && ret == ESP_OK; i++) {
+        s_opus_pending[s_opus_pending_samples++] = (int16_t)(pcm[2 * i] | (pcm[2 * i + 1] << 8));
+        if (s_opus_pending_samples == OPUS_FRAME_SAMPLES) {
+            ret = opus_emit_frame(out, out_cap, &pos);
+        }
+    }
+
+    if (ret == ESP_OK && flush && s_opus_pending_samples > 0) {
+        memset(&s_opus_pending[s_opus_pending_samples], 0,
+               (OPUS_FRAME_SAMPLES - s_opus_pending_samples) * sizeof(int16_t));
+        ret = opus_emit_frame(out, out_cap, &pos);
+    }
+
+    *out_len = pos;
+    return ret;
+}
+#endif
+
+// ===========================
+// Public API
+// ===========================
+
+const char *audio_codec_name(audio_codec_t codec) {
+    switch (codec) {
+        case AUDIO_CODEC_IMA_ADPCM: return "ima_adpcm";
+        case AUDIO_CODEC_OPUS:      return "opus";
+        case AUDIO_CODEC_PCM16:
+        default:                    return "pcm16";
+    }
+}
+
+bool audio_codec_is_supported(audio_codec_t codec) {
+    switch (codec) {
+        case AUDIO_CODEC_PCM16:
+            return true;
+        case AUDIO_CODEC_IMA_ADPCM:
+            return CONFIG_STT_CODEC_ADPCM_ENABLED != 0;
+        case AUDIO_CODEC_OPUS:
+            return CONFIG_STT_CODEC_OPUS_ENABLED != 0;
+        default:
+            return false;
+    }
+}
+
+bool audio_codec_from_name(const char *name, audio_codec_t *codec) {
+    if (name == NULL || codec == NULL) {
+        return false;
+    }
+
+    audio_codec_t parsed;
+    if (strcmp(name, "pcm16") == 0) {
+        parsed = AUDIO_CODEC_PCM16;
+    } else if (strcmp(name, "ima_adpcm") == 0) {
+        parsed = AUDIO_CODEC_IMA_ADPCM;
+    } else if (strcmp(name, "opus") == 0) {
+        parsed = AUDIO_CODEC_OPUS;
+    } else {
+        return false;
+    }
+
+    if (!audio_codec_is_supported(parsed)) {
+        return false;
+    }
+    *codec = parsed;
+    return true;
+}
+
+size_t audio_codec_max_encoded_size(audio_codec_t codec, size_t pcm_bytes) {
+    size_t samples = pcm_bytes / sizeof(int16_t);
+    switch (codec) {
+        case AUDIO_CODEC_IMA_ADPCM:
+            return AUDIO_CODEC_ADPCM_HEADER_BYTES + (samples + 1U) / 2U;
+#if CONFIG_STT_CODEC_OPUS_ENABLED
+        case AUDIO_CODEC_OPUS:
+            // +1 frame for the held-over partial frame
+            return ((samples / OPUS_FRAME_SAMPLES) + 2U) * (2U + OPUS_MAX_PACKET_BYTES);
+#endif
+        case AUDIO_CODEC_PCM16:
+        default:
+            return pcm_bytes;
+    }
+}
+
+esp_err_t audio_codec_encoder_reset(audio_codec_t codec) {
+    switch (codec) {
+        case AUDIO_CODEC_IMA_ADPCM:
+            s_adpcm_predictor = 0;
+            s_adpcm_index = 0;
+            return ESP_OK;
+        case AUDIO_CODEC_OPUS:
+#if CONFIG_STT_CODEC_OPUS_ENABLED
+            return opus_encoder_prepare();
+#else
+            return ESP_ERR_NOT_SUPPORTED;
+#endif
+        case AUDIO_CODEC_PCM16:
+        default:
+            return ESP_OK;
+    }
+}
+
+esp_err_t audio_codec_encode(audio_codec_t codec, const uint8_t *pcm, size_t pcm_len, bool flush,
+                             uint8_t *out, size_t out_cap, size_t *out_len) {
+    if (pcm == NULL || out == NULL || out_len == NULL || (pcm_len % sizeof(int16_t)) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *out_len = 0;
+    size_t samples = pcm_len / sizeof(int16_t);
+    (void)flush;
+
+    switch (codec) {
+        case AUDIO_CODEC_IMA_ADPCM:
+            return ima_adpcm_encode(pcm, samples, out, out_cap, out_len);
+#if CONFIG_STT_CODEC_OPUS_ENABLED
+        case AUDIO_CODEC_OPUS:
+            if (s_opus_encoder == NULL) {
+                return ESP_ERR_INVALID_STATE;
+            }
+            return opus_encode_block(pcm, samples, flush, out, out_cap, out_len);
+#endif
+        default:
+            return ESP_ERR_NOT_SUPPORTED;
+    }
+}
@@ -12,15 +12,23 @@
  * to fix LoadStoreError crashes caused by DMA state corruption in the old driver.
  */
 
+// Before any include: esp_log.h reads LOG_LOCAL_LEVEL at each ESP_LOGx call
+#define LOG_LOCAL_LEVEL CONFIG_LOG_FLOOR_AUDIO
+
 #include "audio_driver.h"
 #include "config.h"
+#include "log_manager.h"
+#include "trace.h"
 #include "esp_log.h"
 #include "driver/i2s_std.h"
 #include "driver/gpio.h"
 #include "esp_heap_caps.h"
 #include "esp_timer.h"
+#include "esp_attr.h"
+#include "esp_idf_version.h"
 #include <string.h>
 #include <limits.h>
+#include <stdatomic.h>
 #include "inttypes.h"
 
 #define I2S_DMA_FRAME_MAX 1023U
@@ -28,15 +36,19 @@
 
 static const char *TAG = TAG_AUDIO;
 static bool is_initialized = false;
+static bool s_suspended = false;   // Channels (and their DMA) allocated but disabled for camera mode
 static uint32_t current_tx_sample_rate = CONFIG_AUDIO_SAMPLE_RATE;
 
 /**
- * @brief Global mutex for thread-safe I2S hardware access
+ * @brief Per-direction I2S access mutexes
  * 
- * CRITICAL: Protects concurrent i2s_channel_read() and i2s_channel_write() operations
- * from corrupting the DMA controller state when called from multiple tasks.
+ * TX and RX are separate channel handles with their own DMA, so a blocking
+ * speaker write never stalls microphone reads. Operations that touch the
+ * shared BCLK/WS (deinit, suspend/resume, TX reclock) take both, always
+ * RX first, through i2s_lock_both()/i2s_unlock_both().
  */
-SemaphoreHandle_t g_i2s_access_mutex = NULL;
+SemaphoreHandle_t g_i2s_tx_mutex = NULL;
+SemaphoreHandle_t g_i2s_rx_mutex = NULL;
 
 /**
  * @brief I2S channel handles for modern driver
@@ -47,10 +59,44 @@ SemaphoreHandle_t g_i2s_access_mutex = NULL;
 i2s_chan_handle_t g_i2s_tx_handle = NULL;  // Speaker output channel
 i2s_chan_handle_t g_i2s_rx_handle = NULL;  // Microphone input channel
 
+/**
+ * @brief Interrupt-driven RX capture state
+ *
+ * The on_recv ISR publishes each completed DMA buffer into this descriptor ring and
+ * notifies the registered capture task. The ring holds at most DMA_BUF_COUNT - 1
+ * entries so a published buffer is never one the DMA engine is refilling.
+ * Lives in DRAM because the ISR is IRAM-safe (CONFIG_I2S_ISR_IRAM_SAFE).
+ */
+#define RX_STREAM_SLOTS CONFIG_I2S_DMA_BUF_COUNT
+static DRAM_ATTR audio_rx_frame_t s_rx_slots[RX_STREAM_SLOTS];
+static DRAM_ATTR _Atomic uint32_t s_rx_slot_head = 0;       // Written by ISR only
+static DRAM_ATTR _Atomic uint32_t s_rx_slot_tail = 0;       // Written by capture task only
+static DRAM_ATTR TaskHandle_t volatile s_rx_notify_task = NULL;
+static DRAM_ATTR _Atomic uint32_t s_rx_overruns = 0;
+
+/**
+ * @brief Echo reference: mean |sample| of recently written TX chunks
+ *
+ * Written by audio_driver_write() and read by the capture task, so the VAD can
+ * tell the speaker's own output from a user talking over it.
+ */
+#define TX_REF_SLOTS 8U
+typedef struct {
+    uint16_t level;
+    int64_t written_us;
+} tx_ref_entry_t;
+static tx_ref_entry_t s_tx_ref[TX_REF_SLOTS];
+static uint32_t s_tx_ref_head = 0;
+static portMUX_TYPE s_tx_ref_lock = portMUX_INITIALIZER_UNLOCKED;
+
 // ===========================
 // Private Function Declarations
 // ===========================
 static esp_err_t configure_i2s_std_full_duplex(void);
+static bool i2s_rx_on_recv_isr(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx);
+static bool i2s_lock_both(TickType_t ticks);
+static void i2s_unlock_both(void);
+static void tx_ref_record(const uint8_t *data, size_t size);
 
 // ===========================
 // Public Functions
@@ -64,20 +110,29 @@ esp_err_t audio_driver_init(void) {
     ESP_LOGI(TAG, "╚══════════════════════════════════════════════════════════");
     
     if (is_initialized) {
+        if (s_suspended) {
+            // Fast path for mode switches: channels and DMA are still allocated
+            return audio_driver_resume();
+        }
         ESP_LOGW(TAG, "Audio driver already initialized");
         return ESP_OK;
     }
     
-    // CRITICAL: Create I2S access mutex (only once)
-    if (g_i2s_access_mutex == NULL) {
-        ESP_LOGI(TAG, "[MUTEX] Creating I2S access mutex for thread safety...");
-        g_i2s_access_mutex = xSemaphoreCreateMutex();
-        if (g_i2s_access_mutex == NULL) {
-            ESP_LOGE(TAG, "❌ CRITICAL: Failed to create I2S access mutex");
+    // CRITICAL: Create per-direction I2S access mutexes (only once)
+    if (g_i2s_tx_mutex == NULL || g_i2s_rx_mutex == NULL) {
+        ESP_LOGI(TAG, "[MUTEX] Creating I2S TX/RX access mutexes for thread safety...");
+        if (g_i2s_tx_mutex == NULL) {
+            g_i2s_tx_mutex = xSemaphoreCreateMutex();
+        }
+        if (g_i2s_rx_mutex == NULL) {
+            g_i2s_rx_mutex = xSemaphoreCreateMutex();
+        }
+        if (g_i2s_tx_mutex == NULL || g_i2s_rx_mutex == NULL) {
+            ESP_LOGE(TAG, "❌ CRITICAL: Failed to create I2S access mutexes");
             ESP_LOGE(TAG, "  Free heap: %u bytes", (unsigned int)esp_get_free_heap_size());
             return ESP_ERR_NO_MEM;
         }
-        ESP_LOGI(TAG, "  ✓ I2S access mutex created successfully");
+        ESP_LOGI(TAG, "  ✓ I2S TX/RX access mutexes created successfully");
     }
     
     // Configure modern I2S STD driver with separate TX and RX channels
@@ -109,14 +164,17 @@ esp_err_t audio_driver_deinit(void) {
         ESP_LOGW(TAG, "Audio driver not initialized - nothing to deinit");
         return ESP_OK;
     }
+
+    // Detach any capture task before the RX channel (and its ISR) goes away
+    audio_driver_rx_stream_stop();
     
-    // Try to acquire mutex before deinit to prevent conflicts
-    if (g_i2s_access_mutex != NULL && xSemaphoreTake(g_i2s_access_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+    // Try to acquire both direction locks before deinit to prevent conflicts
+    if (i2s_lock_both(pdMS_TO_TICKS(100))) {
         esp_err_t ret = ESP_OK;
         int64_t start_time;
         
-        // Step 1: Disable RX channel
-        if (g_i2s_rx_handle != NULL) {
+        // Step 1: Disable RX channel (already disabled when suspended)
+        if (g_i2s_rx_handle != NULL && !s_suspended) {
             ESP_LOGI(TAG, "[STEP 1/5] Disabling RX (microphone) channel...");
             start_time = esp_timer_get_time();
             ret = i2s_channel_disable(g_i2s_rx_handle);
@@ -131,7 +189,7 @@ esp_err_t audio_driver_deinit(void) {
         }
         
         // Step 2: Disable TX channel
-        if (g_i2s_tx_handle != NULL) {
+        if (g_i2s_tx_handle != NULL && !s_suspended) {
             ESP_LOGI(TAG, "[STEP 2/5] Disabling TX (speaker) channel...");
             start_time = esp_timer_get_time();
             ret = i2s_channel_disable(g_i2s_tx_handle);
@@ -185,10 +243,11 @@ esp_err_t audio_driver_deinit(void) {
         ESP_LOGI(TAG, "Additional settling time (50ms) for interrupt/GPIO matrix...");
         vTaskDelay(pdMS_TO_TICKS(50));
         
-        xSemaphoreGive(g_i2s_access_mutex);
+        i2s_unlock_both();
         
         // Mark as uninitialized
         is_initialized = false;
+        s_suspended = false;
         current_tx_sample_rate = CONFIG_AUDIO_SAMPLE_RATE;
         
         ESP_LOGI(TAG, "╔══════════════════════════════════════════════════════════");
@@ -201,6 +260,7 @@ esp_err_t audio_driver_deinit(void) {
         ESP_LOGW(TAG, "Could not acquire mutex for safe deinitialization");
         // Still proceed with deinit but with a warning
         is_initialized = false;
+        s_suspended = false;
         current_tx_sample_rate = CONFIG_AUDIO_SAMPLE_RATE;
         return ESP_OK;
     }
@@ -221,9 +281,9 @@ esp_err_t audio_driver_write(const uint8_t *data, size_t size, size_t *bytes_wri
         return ESP_ERR_INVALID_ARG;
     }
     
-    // CRITICAL: Acquire mutex to prevent concurrent I2S access
-    if (g_i2s_access_mutex == NULL) {
-        ESP_LOGE(TAG, "❌ I2S access mutex not initialized");
+    // CRITICAL: Acquire the TX mutex; RX capture runs concurrently on its own lock
+    if (g_i2s_tx_mutex == NULL) {
+        ESP_LOGE(TAG, "❌ I2S TX mutex not initialized");
         if (bytes_written) *bytes_written = 0;
         return ESP_ERR_INVALID_STATE;
     }
@@ -241,9 +301,9 @@ esp_err_t audio_driver_write(const uint8_t *data, size_t size, size_t *bytes_wri
     }
 
     // Try to acquire mutex with caller-aligned timeout to prevent indefinite blocking
-    if (xSemaphoreTake(g_i2s_access_mutex, mutex_wait_ticks) != pdTRUE) {
-        ESP_LOGW(TAG, "⚠ Failed to acquire I2S access mutex within %lu ms (write blocked)",
-                 (unsigned long)((timeout_ms == (uint32_t)portMAX_DELAY) ? UINT32_MAX : timeout_ms ? timeout_ms : 100));
+    if (xSemaphoreTake(g_i2s_tx_mutex, mutex_wait_ticks) != pdTRUE) {
+        LOGW_RL(TAG, "⚠ Failed to acquire I2S TX mutex within %lu ms (write blocked)",
+                (unsigned long)((timeout_ms == (uint32_t)portMAX_DELAY) ? UINT32_MAX : timeout_ms ? timeout_ms : 100));
         if (bytes_written) *bytes_written = 0;
         return ESP_ERR_TIMEOUT;
     }
@@ -258,6 +318,7 @@ esp_err_t audio_driver_write(const uint8_t *data, size_t size, size_t *bytes_wri
                                            : pdMS_TO_TICKS(timeout_ms);
     TickType_t start_tick = xTaskGetTickCount();
 
+    TRACE_SPAN_BEGIN(write);
     while (total_written < size) {
         const uint8_t *chunk_ptr = data + total_written;
         size_t remaining = size - total_written;
@@ -302,16 +363,20 @@ esp_err_t audio_driver_write(const uint8_t *data, size_t size, size_t *bytes_wri
             break;
         }
     }
+    TRACE_SPAN_END(write, TRACE_ID_I2S_TX_WRITE, total_written);
 
     // Release mutex immediately after hardware access
-    xSemaphoreGive(g_i2s_access_mutex);
+    xSemaphoreGive(g_i2s_tx_mutex);
 
     if (bytes_written) {
         *bytes_written = total_written;
     }
+    if (total_written > 0) {
+        tx_ref_record(data, total_written);
+    }
 
     if (total_written < size) {
-        ESP_LOGW(TAG, "Partial write: %zu/%zu bytes (err=%s)", total_written, size, esp_err_to_name(last_err));
+        LOGW_RL(TAG, "Partial write: %zu/%zu bytes (err=%s)", total_written, size, esp_err_to_name(last_err));
         if (last_err == ESP_OK) {
             last_err = ESP_ERR_TIMEOUT;
         }
@@ -345,16 +410,16 @@ esp_err_t audio_driver_read(uint8_t *buffer, size_t size, size_t *bytes_read, ui
         return ESP_ERR_INVALID_ARG;
     }
     
-    // CRITICAL: Acquire mutex to prevent concurrent I2S access
-    if (g_i2s_access_mutex == NULL) {
-        ESP_LOGE(TAG, "❌ I2S access mutex not initialized");
+    // CRITICAL: Acquire the RX mutex; speaker writes never contend for it
+    if (g_i2s_rx_mutex == NULL) {
+        ESP_LOGE(TAG, "❌ I2S RX mutex not initialized");
         if (bytes_read) *bytes_read = 0;
         return ESP_ERR_INVALID_STATE;
     }
     
     // Wait indefinitely for mutex (audio capture is critical path)
-    if (xSemaphoreTake(g_i2s_access_mutex, portMAX_DELAY) != pdTRUE) {
-        ESP_LOGE(TAG, "❌ CRITICAL: Failed to acquire I2S access mutex (should never happen with portMAX_DELAY)");
+    if (xSemaphoreTake(g_i2s_rx_mutex, portMAX_DELAY) != pdTRUE) {
+        ESP_LOGE(TAG, "❌ CRITICAL: Failed to acquire I2S RX mutex (should never happen with portMAX_DELAY)");
         if (bytes_read) *bytes_read = 0;
         return ESP_ERR_TIMEOUT;
     }
@@ -367,7 +432,7 @@ esp_err_t audio_driver_read(uint8_t *buffer, size_t size, size_t *bytes_read, ui
     esp_err_t ret = i2s_channel_read(g_i2s_rx_handle, buffer, size, &read, ticks_to_wait);
     
     // Release mutex immediately after hardware access
-    xSemaphoreGive(g_i2s_access_mutex);
+    xSemaphoreGive(g_i2s_rx_mutex);
     
     if (bytes_read) {
         *bytes_read = read;
@@ -385,8 +450,132 @@ esp_err_t audio_driver_read(uint8_t *buffer, size_t size, size_t *bytes_read, ui
     return ESP_OK;
 }
 
+esp_err_t audio_driver_suspend(void) {
+    if (!CONFIG_MODE_SWITCH_KEEP_I2S) {
+        return audio_driver_deinit();
+    }
+    if (!is_initialized || s_suspended) {
+        return ESP_OK;
+    }
+
+    int64_t start_time = esp_timer_get_time();
+    audio_driver_rx_stream_stop();
+
+    if (!i2s_lock_both(pdMS_TO_TICKS(100))) {
+        ESP_LOGW(TAG, "Could not acquire mutex to suspend - falling back to full deinit");
+        return audio_driver_deinit();
+    }
+
+    // i2s_channel_disable() only returns once the DMA engine has stopped, so
+    // no settle delay is needed; descriptors and DMA buffers stay allocated
+    esp_err_t rx_ret = i2s_channel_disable(g_i2s_rx_handle);
+    esp_err_t tx_ret = i2s_channel_disable(g_i2s_tx_handle);
+    s_suspended = true;
+
+    i2s_unlock_both();
+
+    if (rx_ret != ESP_OK || tx_ret != ESP_OK) {
+        ESP_LOGW(TAG, "Channel disable returned RX=%s TX=%s",
+                 esp_err_to_name(rx_ret), esp_err_to_name(tx_ret));
+    }
+    ESP_LOGI(TAG, "I2S channels suspended (%"PRIu32" us, DMA kept reserved)",
+             (uint32_t)(esp_timer_get_time() - start_time));
+    return ESP_OK;
+}
+
+esp_err_t audio_driver_resume(void) {
+    if (!is_initialized) {
+        return audio_driver_init();
+    }
+    if (!s_suspended) {
+        return ESP_OK;
+    }
+
+    int64_t start_time = esp_timer_get_time();
+    if (!i2s_lock_both(pdMS_TO_TICKS(100))) {
+        ESP_LOGE(TAG, "Could not acquire mutex to resume I2S channels");
+        return ESP_ERR_TIMEOUT;
+    }
+
+    // TX first: RX shares its BCLK/WS, same order as configure_i2s_std_full_duplex()
+    esp_err_t ret = i2s_channel_enable(g_i2s_tx_handle);
+    if (ret == ESP_OK) {
+        ret = i2s_channel_enable(g_i2s_rx_handle);
+        if (ret != ESP_OK) {
+            i2s_channel_disable(g_i2s_tx_handle);
+        }
+    }
+    if (ret == ESP_OK) {
+        s_suspended = false;  // TX clock (current_tx_sample_rate) is unchanged across suspend
+    }
+
+    i2s_unlock_both();
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to resume I2S channels: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    ESP_LOGI(TAG, "I2S channels resumed (%"PRIu32" us)",
+             (uint32_t)(esp_timer_get_time() - start_time));
+    return ESP_OK;
+}
+
+bool audio_driver_is_suspended(void) {
+    return is_initialized && s_suspended;
+}
+
 bool audio_driver_is_initialized(void) {
-    return is_initialized;
+    // Suspended channels cannot move data, so they do not count as initialized
+    return is_initialized && !s_suspended;
+}
+
+esp_err_t audio_driver_rx_stream_start(TaskHandle_t notify_task) {
+    if (!is_initialized || s_suspended || g_i2s_rx_handle == NULL) {
+        ESP_LOGE(TAG, "I2S RX channel not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (notify_task == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Discard anything published before this consumer attached
+    atomic_store(&s_rx_slot_tail, atomic_load(&s_rx_slot_head));
+    atomic_store(&s_rx_overruns, 0);
+    s_rx_notify_task = notify_task;
+
+    ESP_LOGI(TAG, "RX stream attached (DMA callback -> task notification)");
+    return ESP_OK;
+}
+
+void audio_driver_rx_stream_stop(void) {
+    if (s_rx_notify_task == NULL) {
+        return;
+    }
+    s_rx_notify_task = NULL;
+    ESP_LOGI(TAG, "RX stream detached (overruns=%u)", (unsigned int)atomic_load(&s_rx_overruns));
+}
+
+size_t audio_driver_rx_stream_fetch(audio_rx_frame_t *frames, size_t max_frames) {
+    if (frames == NULL || max_frames == 0) {
+        return 0;
+    }
+
+    uint32_t head = atomic_load_explicit(&s_rx_slot_head, memory_order_acquire);
+    uint32_t tail = atomic_load_explicit(&s_rx_slot_tail, memory_order_relaxed);
+    size_t count = 0;
+
+    while (tail != head && count < max_frames) {
+        frames[count++] = s_rx_slots[tail % RX_STREAM_SLOTS];
+        tail++;
+    }
+
+    atomic_store_explicit(&s_rx_slot_tail, tail, memory_order_release);
+    return count;
+}
+
+uint32_t audio_driver_rx_stream_overruns(void) {
+    return atomic_load(&s_rx_overruns);
 }
 
 esp_err_t audio_driver_clear_buffers(void) {
@@ -428,11 +617,12 @@ esp_err_t audio_driver_set_tx_sample_rate(uint32_t sample_rate) {
         return ESP_OK;
     }
 
-    if (g_i2s_access_mutex == NULL) {
+    // TX drives the shared BCLK/WS, so a reclock also pauses RX
+    if (g_i2s_tx_mutex == NULL || g_i2s_rx_mutex == NULL) {
         return ESP_ERR_INVALID_STATE;
     }
 
-    if (xSemaphoreTake(g_i2s_access_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+    if (!i2s_lock_both(pdMS_TO_TICKS(100))) {
         ESP_LOGW(TAG, "⚠ Failed to acquire I2S mutex for clock update");
         return ESP_ERR_TIMEOUT;
     }
@@ -441,7 +631,7 @@ esp_err_t audio_driver_set_tx_sample_rate(uint32_t sample_rate) {
     esp_err_t ret = i2s_channel_disable(g_i2s_tx_handle);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "❌ Unable to disable TX channel for clock update: %s", esp_err_to_name(ret));
-        xSemaphoreGive(g_i2s_access_mutex);
+        i2s_unlock_both();
         return ret;
     }
 
@@ -460,7 +650,7 @@ esp_err_t audio_driver_set_tx_sample_rate(uint32_t sample_rate) {
     }
 
     current_tx_sample_rate = sample_rate;
-    xSemaphoreGive(g_i2s_access_mutex);
+    i2s_unlock_both();
     ESP_LOGI(TAG, "I2S TX sample rate updated to %u Hz", (unsigned int)sample_rate);
     return ESP_OK;
 
@@ -471,7 +661,7 @@ restore_previous_clock:
         i2s_channel_reconfig_std_clock(g_i2s_tx_handle, &restore_cfg);
         i2s_channel_enable(g_i2s_tx_handle);
     }
-    xSemaphoreGive(g_i2s_access_mutex);
+    i2s_unlock_both();
     return ret;
 }
 
@@ -479,10 +669,66 @@ uint32_t audio_driver_get_tx_sample_rate(void) {
     return current_tx_sample_rate;
 }
 
+uint16_t audio_driver_tx_reference_level(uint32_t window_ms) {
+    int64_t cutoff_us = esp_timer_get_time() - (int64_t)window_ms * 1000;
+    uint16_t level = 0;
+
+    taskENTER_CRITICAL(&s_tx_ref_lock);
+    for (uint32_t i = 0; i < TX_REF_SLOTS; i++) {
+        if (s_tx_ref[i].written_us >= cutoff_us && s_tx_ref[i].level > level) {
+            level = s_tx_ref[i].level;
+        }
+    }
+    taskEXIT_CRITICAL(&s_tx_ref_lock);
+    return level;
+}
+
 // ===========================
 // Private Functions
 // ===========================
 
+static bool i2s_lock_both(TickType_t ticks) {
+    if (g_i2s_tx_mutex == NULL || g_i2s_rx_mutex == NULL) {
+        return false;
+    }
+    // Fixed RX -> TX order so two clock-level operations cannot deadlock
+    if (xSemaphoreTake(g_i2s_rx_mutex, ticks) != pdTRUE) {
+        return false;
+    }
+    if (xSemaphoreTake(g_i2s_tx_mutex, ticks) != pdTRUE) {
+        xSemaphoreGive(g_i2s_rx_mutex);
+        return false;
+    }
+    return true;
+}
+
+static void i2s_unlock_both(void) {
+    xSemaphoreGive(g_i2s_tx_mutex);
+    xSemaphoreGive(g_i2s_rx_mutex);
+}
+
+static void tx_ref_record(const uint8_t *data, size_t size) {
+    // Every 4th sample is plenty for an envelope and keeps the write path cheap
+    const int16_t *samples = (const int16_t *)data;
+    size_t count = size / sizeof(int16_t);
+    uint32_t sum = 0;
+    uint32_t taken = 0;
+    for (size_t i = 0; i < count; i += 4) {
+        int32_t v = samples[i];
+        sum += (uint32_t)(v < 0 ? -v : v);
+        taken++;
+    }
+    uint16_t level = taken ? (uint16_t)(sum / taken) : 0;
+
+    taskENTER_CRITICAL(&s_tx_ref_lock);
+    s_tx_ref[s_tx_ref_head % TX_REF_SLOTS] = (tx_ref_entry_t){
+        .level = level,
+        .written_us = esp_timer_get_time(),
+    };
+    s_tx_ref_head++;
+    taskEXIT_CRITICAL(&s_tx_ref_lock);
+}
+
 static esp_err_t configure_i2s_std_full_duplex(void) {
     ESP_LOGI(TAG, "╔══════════════════════════════════════════════════════════");
     ESP_LOGI(TAG, "║ Configuring Modern I2S STD Driver (Separate TX/RX)");
@@ -629,6 +875,18 @@ static esp_err_t configure_i2s_std_full_duplex(void) {
         return ret;
     }
     ESP_LOGI(TAG, "✅ RX channel configured (took %"PRIu32" ms)", (uint32_t)rx_init_time);
+
+    // Callbacks can only be registered while the channel is not yet enabled. The ISR is a
+    // no-op until audio_driver_rx_stream_start() attaches a task, so audio_driver_read()
+    // keeps working for callers that still poll.
+    i2s_event_callbacks_t rx_callbacks = {
+        .on_recv = i2s_rx_on_recv_isr,
+    };
+    ret = i2s_channel_register_event_callback(g_i2s_rx_handle, &rx_callbacks, NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "⚠ RX on_recv callback registration failed: %s (interrupt-driven capture unavailable)",
+                 esp_err_to_name(ret));
+    }
     
     // STEP 4: Enable TX channel
     ESP_LOGI(TAG, "[STEP 4/6] Enabling TX channel...");
@@ -716,3 +974,38 @@ bool audio_driver_is_buffer_nearly_full(void) {
     // This prevents unnecessary throttling in most cases
     return false;
 }
+
+static bool IRAM_ATTR i2s_rx_on_recv_isr(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx) {
+    (void)handle;
+    (void)user_ctx;
+
+    TaskHandle_t task = s_rx_notify_task;
+    if (task == NULL || event == NULL) {
+        return false;
+    }
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 4, 0)
+    const uint8_t *dma_buf = (const uint8_t *)event->dma_buf;
+#else
+    // Before v5.4 'data' points at the descriptor's buffer pointer
+    const uint8_t *dma_buf = (event->data != NULL) ? *(const uint8_t **)event->data : NULL;
+#endif
+    if (dma_buf == NULL || event->size == 0) {
+        return false;
+    }
+
+    uint32_t head = atomic_load_explicit(&s_rx_slot_head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&s_rx_slot_tail, memory_order_acquire);
+    if ((head - tail) >= (RX_STREAM_SLOTS - 1U)) {
+        // Consumer fell a full DMA cycle behind: the oldest slot is about to be refilled
+        atomic_fetch_add_explicit(&s_rx_overruns, 1, memory_order_relaxed);
+    } else {
+        s_rx_slots[head % RX_STREAM_SLOTS].data = dma_buf;
+        s_rx_slots[head % RX_STREAM_SLOTS].len = event->size;
+        atomic_store_explicit(&s_rx_slot_head, head + 1U, memory_order_release);
+    }
+
+    BaseType_t high_task_woken = pdFALSE;
+    vTaskNotifyGiveFromISR(task, &high_task_woken);
+    return high_task_woken == pdTRUE;
+}
@@ -0,0 +1,206 @@
+/**
+ * @file audio_dsp.c
+ * @brief Playback DSP kernels: word-packed stereo duplication, gain/limiter, resampler.
+ */
+
+#include "audio_dsp.h"
+#include "esp_attr.h"
+#include <string.h>
+
+// 32-bit view of sample buffers; may_alias keeps the word-packed loops legal C
+typedef uint32_t __attribute__((may_alias)) dsp_word_t;
+
+static inline uint32_t dup_sample(uint32_t sample)
+{
+    sample &= 0xFFFFU;
+    return sample | (sample << 16);
+}
+
+// ===========================
+// Mono -> Stereo
+// ===========================
+
+void IRAM_ATTR audio_dsp_mono_to_stereo(int16_t *samples, size_t frames)
+{
+    if (samples == NULL || frames == 0) {
+        return;
+    }
+
+    if (((uintptr_t)samples & 3U) != 0) {
+        // Unaligned: scalar back-to-front (frame i lands on [2i, 2i+1], never ahead of the reader)
+        for (size_t i = frames; i-- > 0;) {
+            int16_t s = samples[i];
+            samples[i * 2] = s;
+            samples[i * 2 + 1] = s;
+        }
+        return;
+    }
+
+    dsp_word_t *words = (dsp_word_t *)samples;
+    size_t pairs = frames / 2;
+
+    if (frames & 1U) {
+        words[frames - 1] = dup_sample((uint16_t)samples[frames - 1]);
+    }
+
+    // One load yields two mono samples, two stores write two stereo frames.
+    // Walking backwards, stores to [2w, 2w+1] only cover words already read.
+    for (size_t w = pairs; w-- > 0;) {
+        uint32_t pair = words[w];
+        words[2 * w] = dup_sample(pair);
+        words[2 * w + 1] = dup_sample(pair >> 16);
+    }
+}
+
+void IRAM_ATTR audio_dsp_mono_to_stereo_copy(int16_t *dst, const int16_t *src, size_t frames)
+{
+    if (dst == NULL || src == NULL || frames == 0) {
+        return;
+    }
+
+    if ((((uintptr_t)dst | (uintptr_t)src) & 3U) != 0) {
+        for (size_t i = 0; i < frames; ++i) {
+            dst[i * 2] = src[i];
+            dst[i * 2 + 1] = src[i];
+        }
+        return;
+    }
+
+    const dsp_word_t *in = (const dsp_word_t *)src;
+    dsp_word_t *out = (dsp_word_t *)dst;
+    size_t pairs = frames / 2;
+
+    for (size_t w = 0; w < pairs; ++w) {
+        uint32_t pair = in[w];
+        out[2 * w] = dup_sample(pair);
+        out[2 * w + 1] = dup_sample(pair >> 16);
+    }
+    if (frames & 1U) {
+        out[frames - 1] = dup_sample((uint16_t)src[frames - 1]);
+    }
+}
+
+// ===========================
+// Gain / Soft Clip
+// ===========================
+
+static inline int32_t soft_clip(int32_t v)
+{
+    // Rational soft knee: linear to the knee, then excess * range / (excess + range),
+    // which approaches but never reaches full scale and has no slope discontinuity
+    const int32_t range = INT16_MAX - AUDIO_DSP_SOFT_KNEE;
+    int32_t mag = (v < 0) ? -v : v;
+    if (mag <= AUDIO_DSP_SOFT_KNEE) {
+        return v;
+    }
+    int32_t excess = mag - AUDIO_DSP_SOFT_KNEE;
+    int32_t shaped = AUDIO_DSP_SOFT_KNEE + (int32_t)(((int64_t)excess * range) / (excess + range));
+    return (v < 0) ? -shaped : shaped;
+}
+
+void IRAM_ATTR audio_dsp_apply_gain(int16_t *samples, size_t count, uint16_t gain_q8, bool soft_clip_enabled)
+{
+    if (samples == NULL || count == 0 || gain_q8 == AUDIO_DSP_GAIN_UNITY_Q8) {
+        return;
+    }
+
+    // Attenuation can never exceed full scale, so skip the limiter entirely
+    if (gain_q8 < AUDIO_DSP_GAIN_UNITY_Q8 || !soft_clip_enabled) {
+        for (size_t i = 0; i < count; ++i) {
+            samples[i] = audio_dsp_sat16(((int32_t)samples[i] * gain_q8) >> 8);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        samples[i] = audio_dsp_sat16(soft_clip(((int32_t)samples[i] * gain_q8) >> 8));
+    }
+}
+
+// ===========================
+// Fades
+// ===========================
+
+void IRAM_ATTR audio_dsp_apply_fade(int16_t *stereo, size_t frames, bool rising)
+{
+    if (stereo == NULL || frames == 0) {
+        return;
+    }
+
+    // Q15 gain per frame, shared by both channels
+    for (size_t i = 0; i < frames; ++i) {
+        int32_t gain = (int32_t)(((uint32_t)i << 15) / frames);
+        if (!rising) {
+            gain = 32768 - gain;
+        }
+        stereo[2 * i] = (int16_t)(((int32_t)stereo[2 * i] * gain) >> 15);
+        stereo[2 * i + 1] = (int16_t)(((int32_t)stereo[2 * i + 1] * gain) >> 15);
+    }
+}
+
+// ===========================
+// Resampler
+// ===========================
+
+bool audio_dsp_resampler_init(audio_dsp_resampler_t *rs, uint32_t in_rate, uint32_t out_rate)
+{
+    if (rs == NULL || in_rate == 0 || out_rate == 0) {
+        return false;
+    }
+
+    memset(rs, 0, sizeof(*rs));
+    rs->in_rate = in_rate;
+    rs->out_rate = out_rate;
+    rs->step_q16 = (uint32_t)(((uint64_t)in_rate << 16) / out_rate);
+    if (rs->step_q16 == 0) {
+        rs->step_q16 = 1;
+    }
+    // Start on the first real input sample (index 1 relative to last_sample)
+    rs->pos_q16 = 1U << 16;
+    return true;
+}
+
+size_t audio_dsp_resampler_max_output(const audio_dsp_resampler_t *rs, size_t in_frames)
+{
+    if (rs == NULL || rs->step_q16 == 0) {
+        return 0;
+    }
+    return (size_t)((((uint64_t)in_frames + 1U) << 16) / rs->step_q16) + 2U;
+}
+
+size_t IRAM_ATTR audio_dsp_resample(audio_dsp_resampler_t *rs, const int16_t *in, size_t in_frames,
+                                    int16_t *out, size_t out_cap)
+{
+    if (rs == NULL || in == NULL || out == NULL || in_frames == 0) {
+        return 0;
+    }
+
+    if (!rs->primed) {
+        rs->last_sample = in[0];
+        rs->primed = true;
+    }
+
+    // Virtual input x[0] = last_sample, x[k] = in[k - 1]; interpolate x[idx]..x[idx + 1]
+    const uint64_t end_q16 = (uint64_t)in_frames << 16;
+    uint64_t pos = rs->pos_q16;
+    size_t produced = 0;
+
+    while (pos < end_q16 && produced < out_cap) {
+        size_t idx = (size_t)(pos >> 16);
+        int32_t a = (idx == 0) ? rs->last_sample : in[idx - 1];
+        int32_t b = in[idx];
+        int32_t frac_q15 = (int32_t)((pos & 0xFFFFU) >> 1);
+        out[produced++] = (int16_t)(a + (((b - a) * frac_q15) >> 15));
+        pos += rs->step_q16;
+    }
+
+    // Carry the fractional position and the last sample into the next chunk
+    if (pos >= end_q16) {
+        rs->pos_q16 = (uint32_t)(pos - end_q16);
+    } else {
+        // Output buffer filled early; drop the rest of this chunk's phase
+        rs->pos_q16 = 0;
+    }
+    rs->last_sample = in[in_frames - 1];
+    return produced;
+}
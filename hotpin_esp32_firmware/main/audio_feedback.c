@@ -59,6 +59,7 @@ static esp_err_t audio_feedback_emit_beep(bool allow_temp_driver) {
     esp_err_t ret;
     bool driver_was_initialized = audio_driver_is_initialized();
     bool driver_initialized_here = false;
+    bool driver_was_suspended = false;
     const size_t payload_bytes = sizeof(s_beep_waveform);
     const bool should_log_debug = (s_beep_debug_logs < 6);
 
@@ -68,6 +69,9 @@ static esp_err_t audio_feedback_emit_beep(bool allow_temp_driver) {
             return ESP_ERR_INVALID_STATE;
         }
         
+        // A suspended driver (camera mode) still owns its DMA buffers and only needs resuming
+        driver_was_suspended = audio_driver_is_suspended();
+
         // ✅ FIX #13: Check DMA-capable memory before attempting audio driver init
         // I2S full-duplex driver needs: TX (~8KB) + RX (~8KB) + overhead = ~18KB total
         // Testing shows 27KB passes initial check but fails on RX allocation
@@ -75,7 +79,7 @@ static esp_err_t audio_feedback_emit_beep(bool allow_temp_driver) {
         size_t dma_free = heap_caps_get_free_size(MALLOC_CAP_DMA);
         const size_t MIN_DMA_REQUIRED = 32768; // 32KB minimum (was 20KB, insufficient)
         
-        if (dma_free < MIN_DMA_REQUIRED) {
+        if (!driver_was_suspended && dma_free < MIN_DMA_REQUIRED) {
             ESP_LOGW(TAG, "Insufficient DMA memory for audio driver (%zu bytes free, need %zu) - skipping feedback",
                      dma_free, MIN_DMA_REQUIRED);
             return ESP_ERR_NO_MEM;
@@ -122,7 +126,11 @@ static esp_err_t audio_feedback_emit_beep(bool allow_temp_driver) {
     if (driver_initialized_here) {
         // Allow FIFO to drain before shutting back down.
         vTaskDelay(pdMS_TO_TICKS(20));
-        audio_driver_deinit();
+        if (driver_was_suspended) {
+            audio_driver_suspend();
+        } else {
+            audio_driver_deinit();
+        }
     }
 
     return ret;
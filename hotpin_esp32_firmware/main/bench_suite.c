@@ -0,0 +1,401 @@
+/**
+ * @file bench_suite.c
+ * @brief Hot-path micro-benchmarks, shared by the serial command and the host build
+ *
+ * Every case times the production code (stt_ring.h, wav_header.c, tts_frame.c,
+ * audio_dsp.c, tone_synth.c, json_protocol.c) on fixed inputs sized like the real traffic:
+ * one RX DMA buffer per capture frame, one TTS block per playout, one server
+ * stage message per parse. Batches double until the case has run for the
+ * minimum time, and ns/op is the total over all batches.
+ */
+
+#include "bench_suite.h"
+#include "config.h"
+#include "esp_log.h"
+
+static const char *TAG = TAG_BENCH;
+
+#if CONFIG_BENCH_SUITE_ENABLED
+
+#include "audio_dsp.h"
+#include "json_protocol.h"
+#include "stt_ring.h"
+#include "tone_synth.h"
+#include "tts_frame.h"
+#include "wav_header.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef HOTPIN_HOST_BENCH
+#define bench_yield() ((void)0)
+#else
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+// Between batches only (outside the timed region): keeps the idle task and its watchdog fed
+#define bench_yield() vTaskDelay(1)
+#endif
+
+#define BENCH_FRAME_BYTES       (CONFIG_I2S_DMA_BUF_LEN * sizeof(int16_t))  // One RX DMA buffer, mono
+#define BENCH_UPLINK_CHUNK      2048U       // Streaming task's starting chunk size
+#define BENCH_BLOCK_SAMPLES     (CONFIG_TTS_BLOCK_PAYLOAD_BYTES / sizeof(int16_t))
+#define BENCH_RESAMPLE_RATE     22050U      // Common TTS engine rate, converted to CONFIG_AUDIO_SAMPLE_RATE
+#define BENCH_TONE_FRAMES       (CONFIG_AUDIO_SAMPLE_RATE / 10U)            // 100 ms segment
+#define BENCH_WAV_LEAD_BYTES    96U         // PCM that overtook the header in the streaming case
+#define BENCH_TTS_FRAME_PAYLOAD (4096U - TTS_FRAME_HEADER_SIZE)  // Server frames stay within 4 KB
+#define BENCH_MAX_BATCH         (1U << 16)
+
+typedef struct {
+    stt_ring_t ring;
+    uint8_t *ring_storage;
+    uint8_t *frame;                     // One capture frame
+    int16_t *tts_source;                // Reply audio as received (mono)
+    int16_t *tts_block;                 // Playback block, 2x payload for in-place stereo
+    int16_t *resample_out;              // Stereo
+    size_t resample_cap;                // Frames
+    audio_dsp_resampler_t resampler;
+    int16_t *tone;
+    tone_synth_state_t synth;
+    uint8_t wav_canonical[44];
+    uint8_t wav_streaming[BENCH_WAV_LEAD_BYTES + 80];
+    size_t wav_streaming_len;
+    uint8_t *tts_frame;                 // Framed downlink: header + one block of PCM
+    uint8_t ack_frame[CONTROL_FRAME_HEADER_SIZE + CONTROL_FRAME_ACK_PAYLOAD_SIZE];
+    char handshake[192];
+    volatile uint32_t sink;             // Results land here so no case folds away
+} bench_ctx_t;
+
+typedef struct {
+    const char *name;
+    void (*run)(bench_ctx_t *ctx);
+    uint32_t bytes_per_op;              // 0 = not a byte stream
+    uint32_t audio_us_per_op;           // 0 = not audio
+} bench_case_t;
+
+// Representative server traffic (see main.py): a stage update and a transcript
+static const char s_stage_json[] =
+    "{\"status\":\"processing\",\"stage\":\"llm\",\"turn\":42,\"server_ms\":318.5}";
+static const char s_transcript_json[] =
+    "{\"status\":\"processing\",\"stage\":\"tts\",\"turn\":42,"
+    "\"transcript\":\"what is the weather like this afternoon and should I carry an umbrella\","
+    "\"message\":\"Converting response to speech\",\"server_ms\":512.0}";
+
+static void *bench_alloc(size_t size, bool prefer_psram) {
+    void *ptr = prefer_psram ? heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT) : NULL;
+    if (ptr == NULL) {
+        ptr = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    }
+    return ptr;
+}
+
+static void put_le16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_le32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static size_t build_wav_header(uint8_t *dst, uint32_t data_size, bool with_list) {
+    uint8_t *p = dst;
+    memcpy(p, "RIFF", 4);
+    put_le32(p + 4, data_size == WAV_STREAMING_DATA_SIZE ? WAV_STREAMING_DATA_SIZE : data_size + 36U);
+    memcpy(p + 8, "WAVE", 4);
+    memcpy(p + 12, "fmt ", 4);
+    put_le32(p + 16, 16);
+    put_le16(p + 20, 1);                                    // PCM
+    put_le16(p + 22, 1);                                    // Mono
+    put_le32(p + 24, CONFIG_AUDIO_SAMPLE_RATE);
+    put_le32(p + 28, CONFIG_AUDIO_SAMPLE_RATE * 2U);
+    put_le16(p + 32, 2);
+    put_le16(p + 34, 16);
+    p += 36;
+    if (with_list) {
+        // Metadata chunk some encoders insert before "data"
+        memcpy(p, "LIST", 4);
+        put_le32(p + 4, 18);
+        memcpy(p + 8, "INFOISFT\x06\x00\x00\x00Lavf\x00\x00", 18);
+        p += 26;
+    }
+    memcpy(p, "data", 4);
+    put_le32(p + 4, data_size);
+    return (size_t)(p + 8 - dst);
+}
+
+static esp_err_t ctx_create(bench_ctx_t *ctx) {
+    memset(ctx, 0, sizeof(*ctx));
+
+    ctx->ring_storage = bench_alloc(CONFIG_STT_RING_BUFFER_SIZE, true);
+    ctx->frame = bench_alloc(BENCH_FRAME_BYTES, false);
+    ctx->tts_source = bench_alloc(CONFIG_TTS_BLOCK_PAYLOAD_BYTES, true);
+    ctx->tts_block = bench_alloc(CONFIG_TTS_BLOCK_PAYLOAD_BYTES * 2U, true);
+    ctx->tone = bench_alloc(BENCH_TONE_FRAMES * sizeof(int16_t), false);
+    ctx->tts_frame = bench_alloc(TTS_FRAME_HEADER_SIZE + BENCH_TTS_FRAME_PAYLOAD, false);
+
+    audio_dsp_resampler_init(&ctx->resampler, BENCH_RESAMPLE_RATE, CONFIG_AUDIO_SAMPLE_RATE);
+    ctx->resample_cap = audio_dsp_resampler_max_output(&ctx->resampler, BENCH_BLOCK_SAMPLES);
+    ctx->resample_out = bench_alloc(ctx->resample_cap * sizeof(int16_t) * 2U, true);
+
+    if (ctx->ring_storage == NULL || ctx->frame == NULL || ctx->tts_source == NULL ||
+        ctx->tts_block == NULL || ctx->tone == NULL || ctx->resample_out == NULL || ctx->tts_frame == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    stt_ring_init(&ctx->ring, ctx->ring_storage, CONFIG_STT_RING_BUFFER_SIZE);
+
+    // Speech-like content: a 220 Hz triangle with some amplitude, so gain and
+    // soft clipping see realistic values rather than zeros
+    int16_t *frame = (int16_t *)ctx->frame;
+    for (size_t i = 0; i < BENCH_FRAME_BYTES / sizeof(int16_t); i++) {
+        int32_t phase = (int32_t)((i * 220U * 65536U / CONFIG_AUDIO_SAMPLE_RATE) & 0xFFFFU);
+        frame[i] = (int16_t)((phase < 32768 ? phase : 65535 - phase) - 16384);
+    }
+    for (size_t i = 0; i < BENCH_BLOCK_SAMPLES; i++) {
+        ctx->tts_source[i] = frame[i % (BENCH_FRAME_BYTES / sizeof(int16_t))];
+    }
+
+    tone_synth_init();
+    tone_synth_reset(&ctx->synth, 0x1234567U);
+
+    build_wav_header(ctx->wav_canonical, CONFIG_TTS_BLOCK_PAYLOAD_BYTES, false);
+    memcpy(ctx->wav_streaming, ctx->tts_source, BENCH_WAV_LEAD_BYTES);
+    ctx->wav_streaming_len = BENCH_WAV_LEAD_BYTES +
+                             build_wav_header(ctx->wav_streaming + BENCH_WAV_LEAD_BYTES,
+                                              WAV_STREAMING_DATA_SIZE, true);
+
+    uint8_t *tf = ctx->tts_frame;
+    memcpy(tf, TTS_FRAME_MAGIC, 4);
+    tf[4] = TTS_FRAME_VERSION;
+    tf[5] = TTS_FRAME_TYPE_AUDIO;
+    tf[6] = TTS_FRAME_CODEC_PCM16;
+    tf[7] = 1;
+    put_le32(tf + 8, CONFIG_AUDIO_SAMPLE_RATE);
+    put_le32(tf + 12, 42);
+    memcpy(tf + TTS_FRAME_HEADER_SIZE, ctx->tts_source, BENCH_TTS_FRAME_PAYLOAD);
+
+    uint8_t *ack = ctx->ack_frame;
+    memcpy(ack, CONTROL_FRAME_MAGIC, 4);
+    ack[4] = CONTROL_FRAME_VERSION;
+    ack[5] = CONTROL_FRAME_TYPE_ACK;
+    put_le16(ack + 6, CONTROL_FRAME_ACK_PAYLOAD_SIZE);
+    put_le32(ack + 8, 120);
+    put_le32(ack + 12, 245760);
+    put_le32(ack + 16, 16384);
+    return ESP_OK;
+}
+
+static void ctx_destroy(bench_ctx_t *ctx) {
+    heap_caps_free(ctx->ring_storage);
+    heap_caps_free(ctx->frame);
+    heap_caps_free(ctx->tts_source);
+    heap_caps_free(ctx->tts_block);
+    heap_caps_free(ctx->resample_out);
+    heap_caps_free(ctx->tone);
+    heap_caps_free(ctx->tts_frame);
+}
+
+// ===========================
+// Cases
+// ===========================
+
+// Capture task writes one DMA buffer; streaming task takes it in uplink chunks and releases it
+static void run_stt_ring(bench_ctx_t *ctx) {
+    stt_ring_write(&ctx->ring, ctx->frame, BENCH_FRAME_BYTES);
+    const uint8_t *span = NULL;
+    size_t len;
+    while ((len = stt_ring_peek_contiguous(&ctx->ring, &span, BENCH_UPLINK_CHUNK)) > 0) {
+        ctx->sink += span[0];
+        stt_ring_commit_read(&ctx->ring, len);
+    }
+    stt_ring_release_to(&ctx->ring, ctx->ring.read);
+}
+
+static void run_wav_canonical(bench_ctx_t *ctx) {
+    wav_header_info_t info;
+    size_t consumed = 0;
+    ctx->sink += (uint32_t)wav_header_parse(ctx->wav_canonical, sizeof(ctx->wav_canonical), &info, &consumed);
+    ctx->sink += (uint32_t)consumed;
+}
+
+static void run_wav_streaming(bench_ctx_t *ctx) {
+    wav_header_info_t info;
+    size_t consumed = 0;
+    ctx->sink += (uint32_t)wav_header_parse(ctx->wav_streaming, ctx->wav_streaming_len, &info, &consumed);
+    ctx->sink += (uint32_t)consumed;
+}
+
+// What replaces both wav cases once the downlink is framed: one check per received frame
+static void run_tts_frame(bench_ctx_t *ctx) {
+    tts_frame_t frame;
+    ctx->sink += (uint32_t)tts_frame_parse(ctx->tts_frame, TTS_FRAME_HEADER_SIZE + BENCH_TTS_FRAME_PAYLOAD, &frame);
+    ctx->sink += (uint32_t)frame.payload_len;
+}
+
+// The playback path for a native-rate reply: payload copied into a block, gain, stereo in place
+static void run_tts_playout(bench_ctx_t *ctx) {
+    memcpy(ctx->tts_block, ctx->tts_source, CONFIG_TTS_BLOCK_PAYLOAD_BYTES);
+    audio_dsp_apply_gain(ctx->tts_block, BENCH_BLOCK_SAMPLES, CONFIG_TTS_PLAYBACK_GAIN_Q8,
+                         CONFIG_TTS_SOFT_CLIP_ENABLED);
+    audio_dsp_mono_to_stereo(ctx->tts_block, BENCH_BLOCK_SAMPLES);
+    ctx->sink += (uint16_t)ctx->tts_block[1];
+}
+
+// Same block at a foreign rate: resample into the stereo buffer, then gain and expand
+static void run_tts_resample(bench_ctx_t *ctx) {
+    size_t frames = audio_dsp_resample(&ctx->resampler, ctx->tts_source, BENCH_BLOCK_SAMPLES,
+                                       ctx->resample_out, ctx->resample_cap);
+    audio_dsp_apply_gain(ctx->resample_out, frames, CONFIG_TTS_PLAYBACK_GAIN_Q8,
+                         CONFIG_TTS_SOFT_CLIP_ENABLED);
+    audio_dsp_mono_to_stereo(ctx->resample_out, frames);
+    ctx->sink += (uint32_t)frames;
+}
+
+static void run_tone_dual(bench_ctx_t *ctx) {
+    static const tone_segment_t segment = {
+        .is_noise = false, .primary_freq_hz = 440.0f, .secondary_freq_hz = 659.26f,
+        .duration_ms = 100, .amplitude = 0.6f,
+    };
+    tone_synth_render_segment(&ctx->synth, &segment, ctx->tone, BENCH_TONE_FRAMES);
+    ctx->sink += (uint16_t)ctx->tone[BENCH_TONE_FRAMES / 2];
+}
+
+static void run_tone_noise(bench_ctx_t *ctx) {
+    static const tone_segment_t segment = {
+        .is_noise = true, .duration_ms = 100, .amplitude = 0.6f,
+    };
+    tone_synth_render_segment(&ctx->synth, &segment, ctx->tone, BENCH_TONE_FRAMES);
+    ctx->sink += (uint16_t)ctx->tone[BENCH_TONE_FRAMES / 2];
+}
+
+static void run_json_stage(bench_ctx_t *ctx) {
+    json_protocol_control_t msg;
+    ctx->sink += json_protocol_parse_control(s_stage_json, sizeof(s_stage_json) - 1, &msg) ? msg.fields : 0U;
+}
+
+static void run_json_transcript(bench_ctx_t *ctx) {
+    json_protocol_control_t msg;
+    ctx->sink += json_protocol_parse_control(s_transcript_json, sizeof(s_transcript_json) - 1, &msg) ?
+                 msg.fields : 0U;
+}
+
+static void run_json_ack_frame(bench_ctx_t *ctx) {
+    json_protocol_control_t msg;
+    ctx->sink += json_protocol_decode_control_frame(ctx->ack_frame, sizeof(ctx->ack_frame), &msg) ?
+                 msg.window_bytes : 0U;
+}
+
+static void run_json_handshake(bench_ctx_t *ctx) {
+    static const char *const codecs[] = { "adpcm", "pcm16" };
+    int len = json_protocol_build_handshake("hotpin-A1B2C3-1712345678", codecs, 2, CONFIG_AUDIO_SAMPLE_RATE,
+                                            7, true, true, ctx->handshake, sizeof(ctx->handshake));
+    ctx->sink += (uint32_t)len;
+}
+
+#define AUDIO_US(bytes, rate)   ((uint32_t)(((uint64_t)(bytes) / sizeof(int16_t)) * 1000000ULL / (rate)))
+
+static const bench_case_t s_cases[] = {
+    { "stt_ring.frame",     run_stt_ring,        BENCH_FRAME_BYTES,
+      AUDIO_US(BENCH_FRAME_BYTES, CONFIG_AUDIO_SAMPLE_RATE) },
+    { "wav.canonical",      run_wav_canonical,   0, 0 },
+    { "wav.streaming",      run_wav_streaming,   0, 0 },
+    { "tts_frame.parse",    run_tts_frame,       0, 0 },
+    { "tts.playout",        run_tts_playout,     CONFIG_TTS_BLOCK_PAYLOAD_BYTES,
+      AUDIO_US(CONFIG_TTS_BLOCK_PAYLOAD_BYTES, CONFIG_AUDIO_SAMPLE_RATE) },
+    { "tts.resample",       run_tts_resample,    CONFIG_TTS_BLOCK_PAYLOAD_BYTES,
+      AUDIO_US(CONFIG_TTS_BLOCK_PAYLOAD_BYTES, BENCH_RESAMPLE_RATE) },
+    { "tone.dual",          run_tone_dual,       0, 100000 },
+    { "tone.noise",         run_tone_noise,      0, 100000 },
+    { "json.stage",         run_json_stage,      sizeof(s_stage_json) - 1, 0 },
+    { "json.transcript",    run_json_transcript, sizeof(s_transcript_json) - 1, 0 },
+    { "json.ack_frame",     run_json_ack_frame,  0, 0 },
+    { "json.handshake",     run_json_handshake,  0, 0 },
+};
+
+// ===========================
+// Runner
+// ===========================
+
+static void run_case(bench_ctx_t *ctx, const bench_case_t *bench, int64_t min_us, bench_result_t *result) {
+    bench->run(ctx);  // Warm caches and one-time paths outside the measurement
+
+    uint64_t iterations = 0;
+    int64_t elapsed_us = 0;
+    uint32_t batch = 1;
+    while (elapsed_us < min_us) {
+        int64_t start_us = esp_timer_get_time();
+        for (uint32_t i = 0; i < batch; i++) {
+            bench->run(ctx);
+        }
+        elapsed_us += esp_timer_get_time() - start_us;
+        iterations += batch;
+        if (batch < BENCH_MAX_BATCH) {
+            batch *= 2U;
+        }
+        bench_yield();
+    }
+
+    double seconds = (double)elapsed_us / 1e6;
+    result->name = bench->name;
+    result->iterations = (uint32_t)iterations;
+    result->elapsed_us = elapsed_us;
+    result->ns_per_op = ((double)elapsed_us * 1000.0) / (double)iterations;
+    result->mb_per_s = (bench->bytes_per_op > 0 && seconds > 0.0) ?
+                       ((double)bench->bytes_per_op * (double)iterations) / (seconds * 1e6) : 0.0;
+    result->realtime = (bench->audio_us_per_op > 0 && elapsed_us > 0) ?
+                       ((double)bench->audio_us_per_op * (double)iterations) / (double)elapsed_us : 0.0;
+}
+
+esp_err_t bench_suite_run(const char *filter, uint32_t min_case_ms, bench_report_fn_t report, void *arg) {
+    size_t filter_len = (filter != NULL) ? strlen(filter) : 0;
+    int64_t min_us = (int64_t)(min_case_ms > 0 ? min_case_ms : CONFIG_BENCH_MIN_CASE_MS) * 1000;
+
+    static bench_ctx_t ctx;
+    esp_err_t ret = ctx_create(&ctx);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Benchmark buffers unavailable");
+        ctx_destroy(&ctx);
+        return ret;
+    }
+
+    size_t ran = 0;
+    for (size_t i = 0; i < sizeof(s_cases) / sizeof(s_cases[0]); i++) {
+        const bench_case_t *bench = &s_cases[i];
+        if (filter_len > 0 && strncmp(bench->name, filter, filter_len) != 0) {
+            continue;
+        }
+
+        bench_result_t result;
+        run_case(&ctx, bench, min_us, &result);
+        printf("BENCH %-16s iters=%-8u ns/op=%-10.1f MB/s=%-8.2f rt=%.1f\n", result.name,
+               (unsigned int)result.iterations, result.ns_per_op, result.mb_per_s, result.realtime);
+        if (report != NULL) {
+            report(&result, arg);
+        }
+        ran++;
+    }
+
+    ctx_destroy(&ctx);
+    if (ran == 0) {
+        ESP_LOGW(TAG, "No benchmark matches '%s'", filter);
+        return ESP_ERR_NOT_FOUND;
+    }
+    return ESP_OK;
+}
+
+#else
+
+esp_err_t bench_suite_run(const char *filter, uint32_t min_case_ms, bench_report_fn_t report, void *arg) {
+    (void)filter;
+    (void)min_case_ms;
+    (void)report;
+    (void)arg;
+    ESP_LOGW(TAG, "Built without CONFIG_BENCH_SUITE_ENABLED");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // CONFIG_BENCH_SUITE_ENABLED
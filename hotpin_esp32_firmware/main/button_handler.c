@@ -56,7 +56,7 @@ static uint32_t get_millis(void);
 esp_err_t button_handler_init(void) {
     ESP_LOGI(TAG, "Initializing button handler on GPIO %d", CONFIG_PUSH_BUTTON_GPIO);
     
-    if (event_dispatcher_queue() == NULL) {
+    if (!event_dispatcher_is_ready()) {
         ESP_LOGE(TAG, "Event dispatcher not ready");
         return ESP_ERR_INVALID_STATE;
     }
@@ -1,18 +1,63 @@
 /**
  * @file camera_controller.c
  * @brief OV2640 camera controller implementation
+ *
+ * Supports a warm standby mode: the sensor stays initialized with its output
+ * stopped (COM2 standby) between shots, and the flash is fired only when the
+ * sensor's own auto-exposure reports a dark scene.
  */
 
 #include "camera_controller.h"
 #include "config.h"
 #include "button_handler.h"
+#include "memory_manager.h"
 #include "esp_log.h"
 #include "esp_camera.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
 #include "driver/gpio.h"
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 static const char *TAG = TAG_CAMERA;
 static bool is_initialized = false;
 static bool flash_initialized = false;
+static bool s_in_standby = false;
+static bool s_warm_disabled = false;   // Headroom check failed; per-shot init until next explicit warm-up
+
+// OV2640 sensor-bank registers (esp32-camera encodes the bank in bit 8 of reg)
+#define OV2640_REG_GAIN         0x100   // AGC gain
+#define OV2640_REG_COM2         0x109   // Bit 4: standby (output stopped, registers kept)
+#define OV2640_REG_REG04        0x104   // AEC[1:0]
+#define OV2640_REG_AEC          0x110   // AEC[9:2]
+#define OV2640_REG_REG45        0x145   // AEC[15:10]
+#define OV2640_COM2_STANDBY     0x10
+
+#define AE_SETTLE_MIN_FRAMES    2
+
+typedef struct {
+    const char *name;
+    framesize_t frame_size;
+    int jpeg_quality;
+    uint8_t burst;
+} camera_profile_config_t;
+
+static const camera_profile_config_t s_profiles[CAMERA_PROFILE_COUNT] = {
+    [CAMERA_PROFILE_THUMBNAIL] = { "thumbnail", CONFIG_CAMERA_THUMB_FRAME_SIZE,
+                                   CONFIG_CAMERA_THUMB_JPEG_QUALITY, CONFIG_CAMERA_THUMB_BURST },
+    [CAMERA_PROFILE_STANDARD]  = { "standard", CONFIG_CAMERA_FRAME_SIZE,
+                                   CONFIG_CAMERA_JPEG_QUALITY, CONFIG_CAMERA_STANDARD_BURST },
+    [CAMERA_PROFILE_DETAIL]    = { "detail", CONFIG_CAMERA_FRAME_SIZE,
+                                   CONFIG_CAMERA_DETAIL_JPEG_QUALITY, CONFIG_CAMERA_DETAIL_BURST },
+};
+
+static volatile camera_profile_t s_requested_profile = CONFIG_CAMERA_PROFILE_DEFAULT;
+static camera_profile_t s_applied_profile = CAMERA_PROFILE_STANDARD;  // What the sensor is set to
+
+// Running-best copy for bursts (PSRAM, grown on demand, kept across captures)
+static uint8_t *s_burst_buffer = NULL;
+static size_t s_burst_capacity = 0;
 
 // Initialize the flash LED on GPIO 4
 static esp_err_t flash_led_init(void) {
@@ -56,6 +101,161 @@ static void flash_led_off(void) {
     }
 }
 
+// ===========================
+// Sensor Standby / Auto-Exposure
+// ===========================
+
+static esp_err_t sensor_set_standby(bool standby) {
+    sensor_t *sensor = esp_camera_sensor_get();
+    if (sensor == NULL || sensor->set_reg == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (sensor->set_reg(sensor, OV2640_REG_COM2, OV2640_COM2_STANDBY,
+                        standby ? OV2640_COM2_STANDBY : 0) != 0) {
+        ESP_LOGE(TAG, "Failed to %s sensor standby", standby ? "enter" : "leave");
+        return ESP_FAIL;
+    }
+    s_in_standby = standby;
+    return ESP_OK;
+}
+
+// AGC gain in 1/16 steps: bits 7..4 each double the gain, bits 3..0 add n/16
+static int sensor_read_gain_x16(sensor_t *sensor) {
+    int reg = sensor->get_reg(sensor, OV2640_REG_GAIN, 0xFF);
+    if (reg < 0) {
+        return -1;
+    }
+    int gain = 16 + (reg & 0x0F);
+    for (int bit = 4; bit < 8; bit++) {
+        if (reg & (1 << bit)) {
+            gain *= 2;
+        }
+    }
+    return gain;
+}
+
+static int sensor_read_exposure(sensor_t *sensor) {
+    int high = sensor->get_reg(sensor, OV2640_REG_REG45, 0x3F);
+    int mid = sensor->get_reg(sensor, OV2640_REG_AEC, 0xFF);
+    int low = sensor->get_reg(sensor, OV2640_REG_REG04, 0x03);
+    if (high < 0 || mid < 0 || low < 0) {
+        return -1;
+    }
+    return (high << 10) | (mid << 2) | low;
+}
+
+// Exposure x gain: one number that the AE loop drives towards target brightness
+static int32_t sensor_read_brightness_effort(sensor_t *sensor) {
+    int exposure = sensor_read_exposure(sensor);
+    int gain = sensor_read_gain_x16(sensor);
+    if (exposure < 0 || gain < 0) {
+        return -1;
+    }
+    return (int32_t)exposure * gain;
+}
+
+// Drop frames until AE stops moving (or the budget runs out); returns the last gain read
+static int wait_for_ae_settle(sensor_t *sensor, uint32_t max_ms) {
+    int64_t deadline = esp_timer_get_time() + (int64_t)max_ms * 1000;
+    int32_t previous = -1;
+    int frames = 0;
+
+    while (esp_timer_get_time() < deadline) {
+        camera_fb_t *fb = esp_camera_fb_get();
+        if (fb == NULL) {
+            break;
+        }
+        esp_camera_fb_return(fb);
+        frames++;
+
+        int32_t effort = sensor_read_brightness_effort(sensor);
+        if (effort < 0) {
+            break;
+        }
+        if (frames >= AE_SETTLE_MIN_FRAMES && previous > 0) {
+            int32_t delta = effort - previous;
+            if (delta < 0) {
+                delta = -delta;
+            }
+            if (delta * 100 <= previous * CONFIG_CAMERA_AE_SETTLE_PCT) {
+                break;
+            }
+        }
+        previous = effort;
+    }
+
+    ESP_LOGD(TAG, "AE settled after %d frames", frames);
+    return sensor_read_gain_x16(sensor);
+}
+
+// Settle AE on live frames and turn the flash on (left on) if the scene is dark
+static bool prepare_exposure(sensor_t *sensor, int *gain_out) {
+    // The frame buffer may hold a frame from before standby/init: let AE run on
+    // live frames first and read how hard it is working to expose the scene
+    int gain_x16 = wait_for_ae_settle(sensor, CONFIG_CAMERA_AE_SETTLE_MAX_MS);
+    bool use_flash = (gain_x16 >= CONFIG_CAMERA_FLASH_GAIN_X16);
+
+    if (use_flash) {
+        // Dark scene: light it and give AE a few frames to pull exposure back
+        flash_led_on();
+        wait_for_ae_settle(sensor, CONFIG_CAMERA_AE_SETTLE_MAX_MS);
+    }
+
+    *gain_out = gain_x16;
+    return use_flash;
+}
+
+static esp_err_t apply_profile(sensor_t *sensor, camera_profile_t profile) {
+    if (profile == s_applied_profile) {
+        return ESP_OK;
+    }
+    const camera_profile_config_t *cfg = &s_profiles[profile];
+    if (sensor->set_framesize(sensor, cfg->frame_size) != 0 ||
+        sensor->set_quality(sensor, cfg->jpeg_quality) != 0) {
+        ESP_LOGE(TAG, "Failed to apply capture profile %s", cfg->name);
+        return ESP_FAIL;
+    }
+    s_applied_profile = profile;
+    ESP_LOGI(TAG, "Capture profile: %s (quality %d, burst %u)",
+             cfg->name, cfg->jpeg_quality, (unsigned int)cfg->burst);
+    return ESP_OK;
+}
+
+static bool burst_buffer_reserve(size_t len) {
+    if (len <= s_burst_capacity) {
+        return true;
+    }
+    // The old contents are about to be replaced by a better frame, so nothing is copied.
+    // The arena slot serves anything up to its size; larger frames go to the heap.
+    memory_manager_arena_release(MEMORY_SLOT_CAMERA_BURST, s_burst_buffer);
+    size_t want = memory_manager_arena_slot_capacity(MEMORY_SLOT_CAMERA_BURST);
+    if (want < len) {
+        want = len;
+    }
+    s_burst_buffer = memory_manager_arena_acquire(MEMORY_SLOT_CAMERA_BURST, want);
+    if (s_burst_buffer == NULL) {
+        ESP_LOGW(TAG, "Burst buffer growth to %u bytes failed", (unsigned int)len);
+        s_burst_capacity = 0;
+        return false;
+    }
+    s_burst_capacity = want;
+    return true;
+}
+
+static bool warm_standby_has_dma_headroom(void) {
+    size_t free_dma = heap_caps_get_free_size(MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    if (free_dma < CONFIG_CAMERA_WARM_MIN_FREE_DMA) {
+        ESP_LOGW(TAG, "Warm standby disabled: %u bytes DMA free (need %u)",
+                 (unsigned int)free_dma, (unsigned int)CONFIG_CAMERA_WARM_MIN_FREE_DMA);
+        return false;
+    }
+    return true;
+}
+
+// ===========================
+// Public Functions
+// ===========================
+
 esp_err_t camera_controller_init(void) {
     ESP_LOGI(TAG, "Initializing camera...");
     
@@ -109,8 +309,8 @@ esp_err_t camera_controller_init(void) {
         .ledc_channel = LEDC_CHANNEL_2,
         
         .pixel_format = PIXFORMAT_JPEG,
-        .frame_size = FRAMESIZE_VGA,
-        .jpeg_quality = 12,
+        .frame_size = CONFIG_CAMERA_FRAME_SIZE,   // Largest profile; smaller ones are set per shot
+        .jpeg_quality = CONFIG_CAMERA_JPEG_QUALITY,
         .fb_count = 1,  // ✅ FIX: Reduced from 2 to 1 to free ~61KB PSRAM for I2S DMA buffers
         .fb_location = CAMERA_FB_IN_PSRAM,
         .grab_mode = CAMERA_GRAB_WHEN_EMPTY
@@ -119,6 +319,8 @@ esp_err_t camera_controller_init(void) {
     esp_err_t ret = esp_camera_init(&camera_config);
     if (ret == ESP_OK) {
         is_initialized = true;
+        s_in_standby = false;
+        s_applied_profile = CAMERA_PROFILE_STANDARD;
         ESP_LOGI(TAG, "Camera initialized successfully");
     } else {
         ESP_LOGE(TAG, "Camera init failed: %s", esp_err_to_name(ret));
@@ -145,6 +347,12 @@ esp_err_t camera_controller_deinit(void) {
     esp_err_t ret = esp_camera_deinit();
     if (ret == ESP_OK) {
         is_initialized = false;
+        s_in_standby = false;
+        if (s_burst_buffer != NULL) {
+            memory_manager_arena_release(MEMORY_SLOT_CAMERA_BURST, s_burst_buffer);
+            s_burst_buffer = NULL;
+            s_burst_capacity = 0;
+        }
         ESP_LOGI(TAG, "Camera deinitialized");
     } else {
         ESP_LOGE(TAG, "Camera deinit failed: %s", esp_err_to_name(ret));
@@ -153,29 +361,233 @@ esp_err_t camera_controller_deinit(void) {
     return ret;
 }
 
+esp_err_t camera_controller_enter_warm_standby(void) {
+    if (!CONFIG_CAMERA_WARM_STANDBY) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    if (!is_initialized) {
+        esp_err_t ret = camera_controller_init();
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    // The camera's DMA descriptors stay allocated while warm; back off if that
+    // would leave too little for the feedback/voice I2S channels
+    if (!warm_standby_has_dma_headroom()) {
+        s_warm_disabled = true;
+        camera_controller_deinit();
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret = sensor_set_standby(true);
+    if (ret != ESP_OK) {
+        camera_controller_deinit();
+        return ret;
+    }
+
+    s_warm_disabled = false;
+    ESP_LOGI(TAG, "Camera in warm standby");
+    return ESP_OK;
+}
+
+esp_err_t camera_controller_begin_capture(void) {
+    if (is_initialized) {
+        return s_in_standby ? sensor_set_standby(false) : ESP_OK;
+    }
+    return camera_controller_init();
+}
+
+esp_err_t camera_controller_end_capture(void) {
+    if (CONFIG_CAMERA_WARM_STANDBY && !s_warm_disabled && is_initialized) {
+        if (camera_controller_enter_warm_standby() == ESP_OK) {
+            return ESP_OK;
+        }
+    }
+    return camera_controller_deinit();
+}
+
 camera_fb_t* camera_controller_capture_frame(void) {
     if (!is_initialized) {
         ESP_LOGE(TAG, "Camera not initialized");
         return NULL;
     }
-    
-    // Turn on flash LED before capture
-    flash_led_on();
-    
-    // ✅ CRITICAL FIX: Extended flash duration for better illumination
-    // 100ms was too short - LED needs time to reach full brightness and illuminate scene
-    // 500ms provides adequate lighting for proper image exposure
-    vTaskDelay(pdMS_TO_TICKS(500));
-    
-    // Capture the frame
+
+    sensor_t *sensor = esp_camera_sensor_get();
+    if (sensor == NULL || sensor->get_reg == NULL) {
+        ESP_LOGE(TAG, "Camera sensor unavailable");
+        return NULL;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+
+    int gain_x16 = 0;
+    bool use_flash = prepare_exposure(sensor, &gain_x16);
+
     camera_fb_t *fb = esp_camera_fb_get();
-    
-    // Turn off flash LED immediately after capture
-    flash_led_off();
-    
+
+    if (use_flash) {
+        flash_led_off();
+    }
+
+    ESP_LOGI(TAG, "Frame ready in %u ms (gain %d/16, flash %s)",
+             (unsigned int)((esp_timer_get_time() - start_us) / 1000),
+             gain_x16, use_flash ? "on" : "off");
     return fb;
 }
 
+esp_err_t camera_controller_capture_best(camera_profile_t profile, camera_capture_t *capture) {
+    if (capture == NULL || profile >= CAMERA_PROFILE_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(capture, 0, sizeof(*capture));
+
+    if (!is_initialized) {
+        ESP_LOGE(TAG, "Camera not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    sensor_t *sensor = esp_camera_sensor_get();
+    if (sensor == NULL || sensor->get_reg == NULL) {
+        ESP_LOGE(TAG, "Camera sensor unavailable");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = apply_profile(sensor, profile);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    const uint8_t burst = s_profiles[profile].burst;
+    int64_t start_us = esp_timer_get_time();
+
+    // A profile change also shows up as an AE disturbance, so the settle frames
+    // double as the sensor's frame-size switch-over
+    int gain_x16 = 0;
+    bool use_flash = prepare_exposure(sensor, &gain_x16);
+
+    int32_t previous_effort = sensor_read_brightness_effort(sensor);
+    uint32_t best_score = 0;
+    size_t best_len = 0;
+    camera_fb_t *best_fb = NULL;
+
+    for (uint8_t i = 0; i < burst; i++) {
+        camera_fb_t *fb = esp_camera_fb_get();
+        if (fb == NULL) {
+            ESP_LOGW(TAG, "Burst frame %u/%u missing", (unsigned int)(i + 1), (unsigned int)burst);
+            break;
+        }
+        capture->frames_scored++;
+
+        // At fixed quality a larger JPEG means more high-frequency detail (in focus,
+        // no motion blur); frames taken while AE was still moving are penalized
+        uint32_t score = (uint32_t)fb->len;
+        int32_t effort = sensor_read_brightness_effort(sensor);
+        if (effort > 0 && previous_effort > 0) {
+            int32_t delta = effort - previous_effort;
+            if (delta < 0) {
+                delta = -delta;
+            }
+            if (delta * 100 > previous_effort * CONFIG_CAMERA_AE_SETTLE_PCT) {
+                score /= 2;
+            }
+        }
+        previous_effort = effort;
+
+        bool last = (i + 1 == burst);
+        if (score <= best_score) {
+            esp_camera_fb_return(fb);
+            continue;
+        }
+
+        if (last) {
+            // Winner needs no further frames: hand out the driver buffer itself
+            best_fb = fb;
+        } else if (burst_buffer_reserve(fb->len)) {
+            memcpy(s_burst_buffer, fb->buf, fb->len);
+            best_len = fb->len;
+            esp_camera_fb_return(fb);
+        } else {
+            // No room for a copy: stop here and keep this frame
+            best_fb = fb;
+        }
+        best_score = score;
+        if (best_fb != NULL) {
+            break;
+        }
+    }
+
+    if (use_flash) {
+        flash_led_off();
+    }
+
+    if (best_fb != NULL) {
+        capture->fb = best_fb;
+        capture->data = best_fb->buf;
+        capture->len = best_fb->len;
+    } else if (best_len > 0) {
+        capture->data = s_burst_buffer;
+        capture->len = best_len;
+    } else {
+        return ESP_FAIL;
+    }
+    capture->profile = profile;
+    capture->flash_used = use_flash;
+
+    ESP_LOGI(TAG, "Best of %u frames: %u bytes (%s, %u ms, gain %d/16, flash %s)",
+             (unsigned int)capture->frames_scored, (unsigned int)capture->len,
+             s_profiles[profile].name,
+             (unsigned int)((esp_timer_get_time() - start_us) / 1000),
+             gain_x16, use_flash ? "on" : "off");
+    return ESP_OK;
+}
+
+void camera_controller_release_capture(camera_capture_t *capture) {
+    if (capture == NULL) {
+        return;
+    }
+    if (capture->fb != NULL) {
+        esp_camera_fb_return(capture->fb);
+    }
+    memset(capture, 0, sizeof(*capture));
+}
+
+void camera_controller_set_profile(camera_profile_t profile) {
+    if (profile >= CAMERA_PROFILE_COUNT) {
+        return;
+    }
+    if (profile != s_requested_profile) {
+        ESP_LOGI(TAG, "Next capture profile: %s", s_profiles[profile].name);
+    }
+    s_requested_profile = profile;
+}
+
+camera_profile_t camera_controller_get_profile(void) {
+    return s_requested_profile;
+}
+
+bool camera_profile_from_name(const char *name, camera_profile_t *out_profile) {
+    if (name == NULL || out_profile == NULL) {
+        return false;
+    }
+    for (int i = 0; i < CAMERA_PROFILE_COUNT; i++) {
+        if (strcmp(name, s_profiles[i].name) == 0) {
+            *out_profile = (camera_profile_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *camera_profile_name(camera_profile_t profile) {
+    return (profile < CAMERA_PROFILE_COUNT) ? s_profiles[profile].name : "unknown";
+}
+
 bool camera_controller_is_initialized(void) {
     return is_initialized;
 }
+
+bool camera_controller_is_warm(void) {
+    return is_initialized && s_in_standby;
+}
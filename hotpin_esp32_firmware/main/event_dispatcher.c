@@ -1,43 +1,303 @@
 #include "event_dispatcher.h"
 
+#include "config.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
+#include "freertos/semphr.h"
 
-#define EVENT_QUEUE_DEPTH 16
+// Queue element: the event plus the time it was posted, for latency accounting
+typedef struct {
+    system_event_t evt;
+    int64_t posted_us;
+} event_envelope_t;
+
+typedef struct {
+    const char *name;
+    QueueHandle_t queue;
+    event_lane_stats_t stats;
+    uint64_t latency_sum_us;
+} event_lane_state_t;
+
+typedef struct {
+    system_event_type_t type;
+    event_dispatcher_handler_t handler;
+    void *ctx;
+} event_subscriber_t;
 
 static const char *TAG = "event_dispatcher";
-static QueueHandle_t s_event_queue = NULL;
+
+static event_lane_state_t s_lanes[EVENT_LANE_COUNT] = {
+    [EVENT_LANE_CONTROL]   = { .name = "control" },
+    [EVENT_LANE_PIPELINE]  = { .name = "pipeline" },
+    [EVENT_LANE_TELEMETRY] = { .name = "telemetry" },
+};
+static const UBaseType_t s_lane_depth[EVENT_LANE_COUNT] = {
+    [EVENT_LANE_CONTROL]   = CONFIG_EVENT_LANE_CONTROL_DEPTH,
+    [EVENT_LANE_PIPELINE]  = CONFIG_EVENT_LANE_PIPELINE_DEPTH,
+    [EVENT_LANE_TELEMETRY] = CONFIG_EVENT_LANE_TELEMETRY_DEPTH,
+};
+
+// Counts queued events across all lanes so the consumer can block on one handle
+static SemaphoreHandle_t s_pending = NULL;
+static bool s_ready = false;
+
+static event_subscriber_t s_subscribers[CONFIG_EVENT_MAX_SUBSCRIBERS];
+static size_t s_subscriber_count = 0;
+
+// Tail of the pipeline lane, used to fold back-to-back duplicate stage events.
+// Pipeline posts hold s_pipeline_post_lock from the duplicate check through the
+// enqueue and tail update, so no other event can slip in between them.
+static bool s_tail_is_stage = false;
+static websocket_pipeline_stage_t s_tail_stage;
+static SemaphoreHandle_t s_pipeline_post_lock = NULL;
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
 
 void event_dispatcher_init(void)
 {
-    if (s_event_queue != NULL) {
+    if (s_ready) {
         return; // already initialized
     }
 
-    s_event_queue = xQueueCreate(EVENT_QUEUE_DEPTH, sizeof(system_event_t));
-    if (s_event_queue == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate system event queue");
-    } else {
-        ESP_LOGI(TAG, "System event queue ready (%d entries)", EVENT_QUEUE_DEPTH);
+    UBaseType_t total_depth = 0;
+    for (int lane = 0; lane < EVENT_LANE_COUNT; lane++) {
+        s_lanes[lane].queue = xQueueCreate(s_lane_depth[lane], sizeof(event_envelope_t));
+        if (s_lanes[lane].queue == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate %s event lane", s_lanes[lane].name);
+            return;
+        }
+        total_depth += s_lane_depth[lane];
     }
+
+    s_pending = xSemaphoreCreateCounting(total_depth, 0);
+    if (s_pending == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate event bus semaphore");
+        return;
+    }
+
+    s_pipeline_post_lock = xSemaphoreCreateMutex();
+    if (s_pipeline_post_lock == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate pipeline lane lock");
+        return;
+    }
+
+    s_ready = true;
+    ESP_LOGI(TAG, "System event bus ready (control=%d pipeline=%d telemetry=%d entries)",
+             CONFIG_EVENT_LANE_CONTROL_DEPTH, CONFIG_EVENT_LANE_PIPELINE_DEPTH,
+             CONFIG_EVENT_LANE_TELEMETRY_DEPTH);
 }
 
-QueueHandle_t event_dispatcher_queue(void)
+bool event_dispatcher_is_ready(void)
 {
-    return s_event_queue;
+    return s_ready;
+}
+
+event_lane_t event_dispatcher_lane_for(system_event_type_t type)
+{
+    switch (type) {
+        case SYSTEM_EVENT_SHUTDOWN_REQUEST:
+        case SYSTEM_EVENT_ERROR_SIGNAL:
+        case SYSTEM_EVENT_BUTTON_INPUT:
+        case SYSTEM_EVENT_CAPTURE_REQUEST:
+        case SYSTEM_EVENT_WEBSOCKET_STATUS:
+        case SYSTEM_EVENT_BARGE_IN:
+            return EVENT_LANE_CONTROL;
+        case SYSTEM_EVENT_STT_STARTED:
+        case SYSTEM_EVENT_STT_STOPPED:
+        case SYSTEM_EVENT_TTS_PLAYBACK_STARTED:
+        case SYSTEM_EVENT_TTS_PLAYBACK_FINISHED:
+        case SYSTEM_EVENT_PIPELINE_STAGE:
+        case SYSTEM_EVENT_VAD_SPEECH_START:
+        case SYSTEM_EVENT_VAD_SPEECH_END:
+            return EVENT_LANE_PIPELINE;
+        case SYSTEM_EVENT_BOOT_COMPLETE:
+        case SYSTEM_EVENT_CAPTURE_COMPLETE:
+        case SYSTEM_EVENT_NONE:
+        default:
+            return EVENT_LANE_TELEMETRY;
+    }
 }
 
 bool event_dispatcher_post(const system_event_t *evt, TickType_t timeout_ticks)
 {
-    if ((evt == NULL) || (s_event_queue == NULL)) {
+    if ((evt == NULL) || !s_ready) {
+        return false;
+    }
+
+    event_lane_t lane = event_dispatcher_lane_for(evt->type);
+    event_lane_state_t *state = &s_lanes[lane];
+    bool is_stage = (evt->type == SYSTEM_EVENT_PIPELINE_STAGE);
+    bool pipeline = (lane == EVENT_LANE_PIPELINE);
+
+    // Only producers are serialized; the consumer never takes this lock
+    if (pipeline && xSemaphoreTake(s_pipeline_post_lock, timeout_ticks) != pdTRUE) {
+        taskENTER_CRITICAL(&s_lock);
+        state->stats.dropped++;
+        taskEXIT_CRITICAL(&s_lock);
+        ESP_LOGW(TAG, "%s lane busy dropping event %d", state->name, evt->type);
+        return false;
+    }
+
+    if (is_stage) {
+        // The tail flag is only trusted while the lane still holds events;
+        // once drained, the next stage event is always queued
+        bool duplicate = false;
+        taskENTER_CRITICAL(&s_lock);
+        if (s_tail_is_stage && s_tail_stage == evt->data.pipeline.stage &&
+            uxQueueMessagesWaiting(state->queue) > 0) {
+            state->stats.coalesced++;
+            duplicate = true;
+        }
+        taskEXIT_CRITICAL(&s_lock);
+        if (duplicate) {
+            xSemaphoreGive(s_pipeline_post_lock);
+            return true;
+        }
+    }
+
+    event_envelope_t envelope = {
+        .evt = *evt,
+        .posted_us = esp_timer_get_time(),
+    };
+
+    if (xQueueSend(state->queue, &envelope, timeout_ticks) != pdPASS) {
+        if (pipeline) {
+            xSemaphoreGive(s_pipeline_post_lock);
+        }
+        taskENTER_CRITICAL(&s_lock);
+        state->stats.dropped++;
+        taskEXIT_CRITICAL(&s_lock);
+        ESP_LOGW(TAG, "%s lane full dropping event %d", state->name, evt->type);
+        return false;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    state->stats.posted++;
+    UBaseType_t depth = uxQueueMessagesWaiting(state->queue);
+    if (depth > state->stats.high_water) {
+        state->stats.high_water = depth;
+    }
+    if (pipeline) {
+        s_tail_is_stage = is_stage;
+        if (is_stage) {
+            s_tail_stage = evt->data.pipeline.stage;
+        }
+    }
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (pipeline) {
+        xSemaphoreGive(s_pipeline_post_lock);
+    }
+
+    xSemaphoreGive(s_pending);
+    return true;
+}
+
+esp_err_t event_dispatcher_subscribe(system_event_type_t type,
+                                     event_dispatcher_handler_t handler,
+                                     void *ctx)
+{
+    if (handler == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_OK;
+    taskENTER_CRITICAL(&s_lock);
+    if (s_subscriber_count >= CONFIG_EVENT_MAX_SUBSCRIBERS) {
+        ret = ESP_ERR_NO_MEM;
+    } else {
+        s_subscribers[s_subscriber_count] = (event_subscriber_t){
+            .type = type,
+            .handler = handler,
+            .ctx = ctx,
+        };
+        s_subscriber_count++;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Subscriber table full (%d entries)", CONFIG_EVENT_MAX_SUBSCRIBERS);
+    }
+    return ret;
+}
+
+bool event_dispatcher_dispatch(TickType_t timeout_ticks)
+{
+    if (!s_ready) {
+        vTaskDelay(timeout_ticks);
+        return false;
+    }
+
+    if (xSemaphoreTake(s_pending, timeout_ticks) != pdTRUE) {
         return false;
     }
 
-    if (xQueueSend(s_event_queue, evt, timeout_ticks) != pdPASS) {
-        ESP_LOGW(TAG, "Queue full dropping event %d", evt->type);
+    event_envelope_t envelope;
+    int lane = 0;
+    for (; lane < EVENT_LANE_COUNT; lane++) {
+        if (xQueueReceive(s_lanes[lane].queue, &envelope, 0) == pdTRUE) {
+            break;
+        }
+    }
+    if (lane == EVENT_LANE_COUNT) {
+        // Every give follows a successful send, so this only guards against misuse
         return false;
     }
 
+    int64_t latency_us = esp_timer_get_time() - envelope.posted_us;
+    if (latency_us < 0) {
+        latency_us = 0;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    event_lane_state_t *state = &s_lanes[lane];
+    state->stats.delivered++;
+    state->latency_sum_us += (uint64_t)latency_us;
+    if ((uint32_t)latency_us > state->stats.max_latency_us) {
+        state->stats.max_latency_us = (uint32_t)latency_us;
+    }
+    size_t subscriber_count = s_subscriber_count;
+    taskEXIT_CRITICAL(&s_lock);
+
+    for (size_t i = 0; i < subscriber_count; i++) {
+        if (s_subscribers[i].type == envelope.evt.type) {
+            s_subscribers[i].handler(&envelope.evt, s_subscribers[i].ctx);
+        }
+    }
+
     return true;
 }
+
+esp_err_t event_dispatcher_get_lane_stats(event_lane_t lane, event_lane_stats_t *stats)
+{
+    if ((lane >= EVENT_LANE_COUNT) || (stats == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    *stats = s_lanes[lane].stats;
+    if (stats->delivered > 0) {
+        stats->avg_latency_us = (uint32_t)(s_lanes[lane].latency_sum_us / stats->delivered);
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    return ESP_OK;
+}
+
+void event_dispatcher_log_stats(void)
+{
+    for (int lane = 0; lane < EVENT_LANE_COUNT; lane++) {
+        event_lane_stats_t stats;
+        if (event_dispatcher_get_lane_stats((event_lane_t)lane, &stats) != ESP_OK) {
+            continue;
+        }
+        ESP_LOGI(TAG, "Lane %-9s posted=%lu delivered=%lu dropped=%lu coalesced=%lu "
+                 "high_water=%lu latency avg=%lu us max=%lu us",
+                 s_lanes[lane].name,
+                 (unsigned long)stats.posted, (unsigned long)stats.delivered,
+                 (unsigned long)stats.dropped, (unsigned long)stats.coalesced,
+                 (unsigned long)stats.high_water,
+                 (unsigned long)stats.avg_latency_us, (unsigned long)stats.max_latency_us);
+    }
+}
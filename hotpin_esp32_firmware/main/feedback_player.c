@@ -5,21 +5,22 @@
 
 #include "feedback_player.h"
 #include "audio_driver.h"
+#include "audio_codec.h"
+#include "audio_dsp.h"
 #include "config.h"
 #include "esp_attr.h"
 #include "esp_log.h"
 #include "esp_random.h"
+#include "esp_timer.h"
+#include "memory_manager.h"
+#include "prompt_store.h"
+#include "tone_synth.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 #include "freertos/task.h"
-#include <math.h>
 #include <string.h>
 #include <stdbool.h>
 
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
-
 #define FEEDBACK_SAMPLE_RATE          CONFIG_AUDIO_SAMPLE_RATE
 #define FEEDBACK_MAX_SEGMENT_MS        600U
 #define FEEDBACK_CHANNELS              2U
@@ -40,29 +41,36 @@
 #define NOTE_A4   440.00f  // La (for variations)
 #define NOTE_C4   261.63f  // Do (for error tones)
 
-typedef struct {
-    bool is_noise;
-    float primary_freq_hz;
-    float secondary_freq_hz;
-    uint32_t duration_ms;
-    float amplitude;
-} tone_segment_t;
-
 static const char *TAG = "FEEDBACK_PLAYER";
 static SemaphoreHandle_t s_play_mutex = NULL;
 static bool s_initialized = false;
 static int16_t s_work_buffer[FEEDBACK_MAX_SEGMENT_SAMPLES] DRAM_ATTR __attribute__((aligned(16)));
 
-// Phase continuity for smooth transitions
-static float s_phase_a = 0.0f;
-static float s_phase_b = 0.0f;
+typedef struct {
+    const tone_segment_t *segments;
+    size_t count;
+} tone_sequence_t;
+
+// Sequences pre-rendered at init (mono); samples is NULL when not cached
+typedef struct {
+    const int16_t *samples;
+    size_t frames;
+} tone_cache_entry_t;
 
-// Envelope constants for fade-in/fade-out (reduces clicks)
-#define ENVELOPE_FADE_MS 5
-#define ENVELOPE_FADE_SAMPLES ((FEEDBACK_SAMPLE_RATE * ENVELOPE_FADE_MS) / 1000)
+// Driver/mutex state to undo once a sound has played
+typedef struct {
+    bool config_mutex_taken;
+    bool driver_initialized_here;
+    bool driver_was_suspended;
+} playback_session_t;
 
 static esp_err_t ensure_initialized(void);
+static esp_err_t playback_begin(playback_session_t *session);
+static void playback_end(playback_session_t *session);
 static esp_err_t play_segments(const tone_segment_t *segments, size_t count);
+static esp_err_t play_cached(const tone_cache_entry_t *entry);
+static esp_err_t play_clip(const prompt_clip_t *clip);
+static void build_tone_cache(void);
 
 // Provided by main.c to coordinate audio/camera reconfiguration
 extern SemaphoreHandle_t g_i2s_config_mutex;
@@ -120,6 +128,23 @@ static const tone_segment_t TTS_COMPLETE_SEQUENCE[] = {
     {.is_noise = false, .primary_freq_hz = NOTE_E4, .secondary_freq_hz = 0.0f, .duration_ms = 250, .amplitude = FEEDBACK_DEFAULT_VOLUME},
 };
 
+#define SEQUENCE(table) { (table), sizeof(table) / sizeof((table)[0]) }
+
+static const tone_sequence_t s_sequences[] = {
+    [FEEDBACK_SOUND_BOOT]         = SEQUENCE(BOOT_SEQUENCE),
+    [FEEDBACK_SOUND_SHUTDOWN]     = SEQUENCE(SHUTDOWN_SEQUENCE),
+    [FEEDBACK_SOUND_ERROR]        = SEQUENCE(ERROR_SEQUENCE),
+    [FEEDBACK_SOUND_REC_START]    = SEQUENCE(REC_START_SEQUENCE),
+    [FEEDBACK_SOUND_REC_STOP]     = SEQUENCE(REC_STOP_SEQUENCE),
+    [FEEDBACK_SOUND_CAPTURE]      = SEQUENCE(CAPTURE_SEQUENCE),
+    [FEEDBACK_SOUND_PROCESSING]   = SEQUENCE(PROCESSING_SEQUENCE),
+    [FEEDBACK_SOUND_TTS_COMPLETE] = SEQUENCE(TTS_COMPLETE_SEQUENCE),
+};
+
+#define FEEDBACK_SOUND_COUNT (sizeof(s_sequences) / sizeof(s_sequences[0]))
+
+static tone_cache_entry_t s_tone_cache[FEEDBACK_SOUND_COUNT];
+
 esp_err_t feedback_player_init(void) {
     if (s_initialized) {
         return ESP_OK;
@@ -131,6 +156,10 @@ esp_err_t feedback_player_init(void) {
         return ESP_ERR_NO_MEM;
     }
 
+    tone_synth_init();
+
+    build_tone_cache();
+
     s_initialized = true;
     return ESP_OK;
 }
@@ -146,67 +175,97 @@ esp_err_t feedback_player_play(feedback_sound_t sound) {
         return ESP_ERR_TIMEOUT;
     }
 
-    const tone_segment_t *sequence = NULL;
-    size_t count = 0U;
-    bool config_mutex_taken = false;
-
-    switch (sound) {
-        case FEEDBACK_SOUND_BOOT:
-            sequence = BOOT_SEQUENCE;
-            count = sizeof(BOOT_SEQUENCE) / sizeof(BOOT_SEQUENCE[0]);
-            break;
-        case FEEDBACK_SOUND_SHUTDOWN:
-            sequence = SHUTDOWN_SEQUENCE;
-            count = sizeof(SHUTDOWN_SEQUENCE) / sizeof(SHUTDOWN_SEQUENCE[0]);
-            break;
-        case FEEDBACK_SOUND_ERROR:
-            sequence = ERROR_SEQUENCE;
-            count = sizeof(ERROR_SEQUENCE) / sizeof(ERROR_SEQUENCE[0]);
-            break;
-        case FEEDBACK_SOUND_REC_START:
-            sequence = REC_START_SEQUENCE;
-            count = sizeof(REC_START_SEQUENCE) / sizeof(REC_START_SEQUENCE[0]);
-            break;
-        case FEEDBACK_SOUND_REC_STOP:
-            sequence = REC_STOP_SEQUENCE;
-            count = sizeof(REC_STOP_SEQUENCE) / sizeof(REC_STOP_SEQUENCE[0]);
-            break;
-        case FEEDBACK_SOUND_CAPTURE:
-            sequence = CAPTURE_SEQUENCE;
-            count = sizeof(CAPTURE_SEQUENCE) / sizeof(CAPTURE_SEQUENCE[0]);
-            break;
-        case FEEDBACK_SOUND_PROCESSING:
-            sequence = PROCESSING_SEQUENCE;
-            count = sizeof(PROCESSING_SEQUENCE) / sizeof(PROCESSING_SEQUENCE[0]);
-            break;
-        case FEEDBACK_SOUND_TTS_COMPLETE:
-            sequence = TTS_COMPLETE_SEQUENCE;
-            count = sizeof(TTS_COMPLETE_SEQUENCE) / sizeof(TTS_COMPLETE_SEQUENCE[0]);
-            break;
-        default:
-            ESP_LOGE(TAG, "Invalid sound id: %d", sound);
-            xSemaphoreGive(s_play_mutex);
-            return ESP_ERR_INVALID_ARG;
+    if ((size_t)sound >= FEEDBACK_SOUND_COUNT) {
+        ESP_LOGE(TAG, "Invalid sound id: %d", sound);
+        xSemaphoreGive(s_play_mutex);
+        return ESP_ERR_INVALID_ARG;
     }
 
-    bool driver_was_initialized = audio_driver_is_initialized();
-    bool driver_initialized_here = false;
-    uint32_t total_duration_ms = 0U;
+    const tone_segment_t *sequence = s_sequences[sound].segments;
+    size_t count = s_sequences[sound].count;
 
+    uint32_t total_duration_ms = 0U;
     for (size_t i = 0; i < count; ++i) {
         total_duration_ms += sequence[i].duration_ms;
     }
 
+    playback_session_t session;
+    ret = playback_begin(&session);
+    if (ret == ESP_OK) {
+        if (s_tone_cache[sound].samples != NULL) {
+            ret = play_cached(&s_tone_cache[sound]);
+        } else {
+            ret = play_segments(sequence, count);
+        }
+
+        if (ret == ESP_OK && total_duration_ms > 0U) {
+            uint32_t settle_time_ms = total_duration_ms + 120U;
+            vTaskDelay(pdMS_TO_TICKS(settle_time_ms));
+        }
+        playback_end(&session);
+    }
+
+    xSemaphoreGive(s_play_mutex);
+    return ret;
+}
+
+esp_err_t feedback_player_play_prompt(feedback_prompt_t prompt, feedback_sound_t fallback) {
+    esp_err_t ret = ensure_initialized();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    prompt_clip_t clip;
+    if (!prompt_store_acquire((uint16_t)prompt, &clip)) {
+        return feedback_player_play(fallback);
+    }
+
+    if (xSemaphoreTake(s_play_mutex, pdMS_TO_TICKS(500)) != pdTRUE) {
+        ESP_LOGW(TAG, "Timed out waiting for playback mutex");
+        prompt_store_release();
+        return ESP_ERR_TIMEOUT;
+    }
+
+    playback_session_t session;
+    ret = playback_begin(&session);
+    if (ret == ESP_OK) {
+        ret = play_clip(&clip);
+        if (ret == ESP_OK) {
+            // Samples are queued, not played: wait out the DMA ring before releasing the driver
+            vTaskDelay(pdMS_TO_TICKS(150));
+        }
+        playback_end(&session);
+    }
+
+    xSemaphoreGive(s_play_mutex);
+    prompt_store_release();
+
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Prompt %d playback failed: %s", (int)prompt, esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+static esp_err_t playback_begin(playback_session_t *session) {
+    memset(session, 0, sizeof(*session));
+
     if (g_i2s_config_mutex != NULL) {
         if (xSemaphoreTake(g_i2s_config_mutex, pdMS_TO_TICKS(750)) != pdTRUE) {
             ESP_LOGW(TAG, "Failed to acquire configuration mutex for playback");
-            xSemaphoreGive(s_play_mutex);
             return ESP_ERR_TIMEOUT;
         }
-        config_mutex_taken = true;
+        session->config_mutex_taken = true;
+    }
+
+    if (audio_driver_is_initialized()) {
+        return ESP_OK;
     }
 
-    if (!driver_was_initialized) {
+    // A suspended driver (camera mode) still owns its DMA buffers and only needs resuming
+    session->driver_was_suspended = audio_driver_is_suspended();
+
+    esp_err_t ret = ESP_OK;
+    if (!session->driver_was_suspended) {
         // ✅ FIX #3: Check BOTH total DMA memory AND largest contiguous block
         // I2S full-duplex driver needs: TX (~8KB) + RX (~8KB) + overhead = ~18KB total
         // High fragmentation can cause init failure even with sufficient total memory
@@ -220,44 +279,47 @@ esp_err_t feedback_player_play(feedback_sound_t sound) {
             ESP_LOGW(TAG, "Insufficient DMA memory for audio driver (%zu bytes free, need %zu) - skipping feedback",
                      dma_free, MIN_DMA_TOTAL);
             ret = ESP_ERR_NO_MEM;
-            goto cleanup;
+            goto fail;
         }
         
         if (largest_block < MIN_DMA_CONTIGUOUS) {
             ESP_LOGW(TAG, "DMA memory too fragmented for audio driver (largest block: %zu bytes, need %zu) - skipping feedback",
                      largest_block, MIN_DMA_CONTIGUOUS);
             ret = ESP_ERR_NO_MEM;
-            goto cleanup;
+            goto fail;
         }
-        
-        ret = audio_driver_init();
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to init audio driver for feedback: %s", esp_err_to_name(ret));
-            goto cleanup;
-        }
-        driver_initialized_here = true;
-        vTaskDelay(pdMS_TO_TICKS(10));
     }
 
-    ret = play_segments(sequence, count);
+    ret = audio_driver_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to init audio driver for feedback: %s", esp_err_to_name(ret));
+        goto fail;
+    }
+    session->driver_initialized_here = true;
+    vTaskDelay(pdMS_TO_TICKS(10));
+    return ESP_OK;
 
-    if (ret == ESP_OK && total_duration_ms > 0U) {
-        uint32_t settle_time_ms = total_duration_ms + 120U;
-        vTaskDelay(pdMS_TO_TICKS(settle_time_ms));
+fail:
+    if (session->config_mutex_taken) {
+        xSemaphoreGive(g_i2s_config_mutex);
+        session->config_mutex_taken = false;
     }
+    return ret;
+}
 
-    if (driver_initialized_here) {
+static void playback_end(playback_session_t *session) {
+    if (session->driver_initialized_here) {
         vTaskDelay(pdMS_TO_TICKS(40));
-        audio_driver_deinit();
+        if (session->driver_was_suspended) {
+            audio_driver_suspend();
+        } else {
+            audio_driver_deinit();
+        }
     }
 
-cleanup:
-    if (config_mutex_taken) {
+    if (session->config_mutex_taken) {
         xSemaphoreGive(g_i2s_config_mutex);
     }
-
-    xSemaphoreGive(s_play_mutex);
-    return ret;
 }
 
 static esp_err_t ensure_initialized(void) {
@@ -267,122 +329,171 @@ static esp_err_t ensure_initialized(void) {
     return ESP_OK;
 }
 
-static inline int16_t float_to_sample(float value) {
-    if (value > 1.0f) {
-        value = 1.0f;
-    } else if (value < -1.0f) {
-        value = -1.0f;
+static size_t segment_frame_count(const tone_segment_t *segment) {
+    size_t frame_count = (FEEDBACK_SAMPLE_RATE * segment->duration_ms) / 1000U;
+    if (frame_count > FEEDBACK_MAX_SEGMENT_FRAMES) {
+        ESP_LOGW(TAG, "Segment duration too long (%u ms) - truncating", (unsigned int)segment->duration_ms);
+        frame_count = FEEDBACK_MAX_SEGMENT_FRAMES;
     }
-    return (int16_t)(value * 32767.0f);
+    return frame_count;
 }
 
-static void generate_noise_samples(size_t frame_count, float amplitude) {
-    const float scale = amplitude;
-    size_t idx = 0;
-    for (size_t i = 0; i < frame_count; ++i) {
-        int32_t random_value = (int32_t)(esp_random() & 0xFFFF);
-        float normalized = ((float)random_value / 32768.0f) - 1.0f;
-        int16_t sample = float_to_sample(normalized * scale);
-        s_work_buffer[idx++] = sample;
-        s_work_buffer[idx++] = sample;
-    }
+static void dds_reset(tone_synth_state_t *dds) {
+    // Phase restarts per sequence (continuity is kept within it)
+    tone_synth_reset(dds, esp_random() | 1U);
 }
 
-static void generate_tone_samples(size_t frame_count, float freq_a, float freq_b, float amplitude) {
-    const float omega_a = (freq_a > 0.0f) ? (2.0f * (float)M_PI * freq_a / (float)FEEDBACK_SAMPLE_RATE) : 0.0f;
-    const float omega_b = (freq_b > 0.0f) ? (2.0f * (float)M_PI * freq_b / (float)FEEDBACK_SAMPLE_RATE) : 0.0f;
-    const bool has_dual = (omega_a > 0.0f && omega_b > 0.0f);
-    const float mix_scale = has_dual ? 0.5f : 1.0f;  // Prevent clipping with dual tones
-    size_t idx = 0;
+static void build_tone_cache(void) {
+#if CONFIG_FEEDBACK_TONE_CACHE_ENABLED
+    size_t frames[FEEDBACK_SOUND_COUNT];
+    size_t total_frames = 0U;
+    for (size_t sound = 0; sound < FEEDBACK_SOUND_COUNT; ++sound) {
+        frames[sound] = 0U;
+        for (size_t i = 0; i < s_sequences[sound].count; ++i) {
+            frames[sound] += segment_frame_count(&s_sequences[sound].segments[i]);
+        }
+        total_frames += frames[sound];
+    }
 
-    // Calculate fade envelope samples
-    size_t fade_samples = (frame_count < ENVELOPE_FADE_SAMPLES * 2) ? (frame_count / 4) : ENVELOPE_FADE_SAMPLES;
+    size_t capacity = memory_manager_arena_slot_capacity(MEMORY_SLOT_FEEDBACK_CACHE) / sizeof(int16_t);
+    if (total_frames > capacity) {
+        ESP_LOGW(TAG, "Tone cache holds %u of %u frames - longer sounds render on each play",
+                 (unsigned int)capacity, (unsigned int)total_frames);
+    }
+    size_t reserve = (total_frames < capacity) ? total_frames : capacity;
+    int16_t *cache = (reserve > 0U) ?
+                     memory_manager_arena_acquire(MEMORY_SLOT_FEEDBACK_CACHE, reserve * sizeof(int16_t)) : NULL;
+    if (cache == NULL) {
+        ESP_LOGW(TAG, "No tone cache - feedback sounds render on each play");
+        return;
+    }
 
-    for (size_t i = 0; i < frame_count; ++i) {
-        float sample = 0.0f;
-        
-        // Generate tones with proper mixing
-        if (omega_a > 0.0f) {
-            sample += sinf(s_phase_a);
-            s_phase_a += omega_a;
-            // Keep phase in range to prevent float precision issues
-            if (s_phase_a > (2.0f * (float)M_PI)) {
-                s_phase_a -= (2.0f * (float)M_PI);
-            }
+    int64_t start_us = esp_timer_get_time();
+    size_t used = 0U;
+    size_t cached = 0U;
+    for (size_t sound = 0; sound < FEEDBACK_SOUND_COUNT; ++sound) {
+        if (frames[sound] == 0U || used + frames[sound] > reserve) {
+            continue;
         }
-        if (omega_b > 0.0f) {
-            sample += sinf(s_phase_b);
-            s_phase_b += omega_b;
-            if (s_phase_b > (2.0f * (float)M_PI)) {
-                s_phase_b -= (2.0f * (float)M_PI);
-            }
+        tone_synth_state_t dds;
+        dds_reset(&dds);
+        int16_t *dst = cache + used;
+        for (size_t i = 0; i < s_sequences[sound].count; ++i) {
+            const tone_segment_t *segment = &s_sequences[sound].segments[i];
+            size_t frame_count = segment_frame_count(segment);
+            tone_synth_render_segment(&dds, segment, dst, frame_count);
+            dst += frame_count;
         }
+        s_tone_cache[sound].samples = cache + used;
+        s_tone_cache[sound].frames = frames[sound];
+        used += frames[sound];
+        cached++;
+    }
 
-        // Apply envelope for smooth fade-in/fade-out
-        float envelope = 1.0f;
-        if (i < fade_samples) {
-            envelope = (float)i / (float)fade_samples;  // Fade-in
-        } else if (i >= frame_count - fade_samples) {
-            envelope = (float)(frame_count - i) / (float)fade_samples;  // Fade-out
-        }
+    ESP_LOGI(TAG, "Tone cache: %u/%u sounds, %u bytes, rendered in %lld us",
+             (unsigned int)cached, (unsigned int)FEEDBACK_SOUND_COUNT,
+             (unsigned int)(used * sizeof(int16_t)), (long long)(esp_timer_get_time() - start_us));
+#endif
+}
 
-        // Mix and scale properly
-        sample = sample * mix_scale * amplitude * envelope;
-        
-        int16_t rendered = float_to_sample(sample);
-        s_work_buffer[idx++] = rendered;
-        s_work_buffer[idx++] = rendered;
+static esp_err_t write_work_buffer(size_t frame_count) {
+    const size_t byte_count = frame_count * FEEDBACK_CHANNELS * sizeof(int16_t);
+    size_t total_written = 0U;
+
+    while (total_written < byte_count) {
+        size_t written = 0U;
+        esp_err_t write_ret = audio_driver_write((const uint8_t *)s_work_buffer + total_written,
+                                                 byte_count - total_written,
+                                                 &written,
+                                                 200);
+        if (write_ret != ESP_OK) {
+            ESP_LOGE(TAG, "Audio write failed: %s", esp_err_to_name(write_ret));
+            return write_ret;
+        }
+        if (written == 0U) {
+            ESP_LOGE(TAG, "Audio write returned zero bytes");
+            return ESP_FAIL;
+        }
+        total_written += written;
     }
+    return ESP_OK;
 }
 
 static esp_err_t play_segments(const tone_segment_t *segments, size_t count) {
-    // Reset phase for new sound sequence (maintains continuity within sequence)
-    s_phase_a = 0.0f;
-    s_phase_b = 0.0f;
+    tone_synth_state_t dds;
+    dds_reset(&dds);
 
     for (size_t i = 0; i < count; ++i) {
         const tone_segment_t *segment = &segments[i];
-        if (segment->duration_ms == 0U) {
-            continue;
-        }
-
-        size_t frame_count = (FEEDBACK_SAMPLE_RATE * segment->duration_ms) / 1000U;
+        size_t frame_count = segment_frame_count(segment);
         if (frame_count == 0U) {
             continue;
         }
-        if (frame_count > FEEDBACK_MAX_SEGMENT_FRAMES) {
-            ESP_LOGW(TAG, "Segment duration too long (%u ms) - truncating", (unsigned int)segment->duration_ms);
-            frame_count = FEEDBACK_MAX_SEGMENT_FRAMES;
+
+        tone_synth_render_segment(&dds, segment, s_work_buffer, frame_count);
+        audio_dsp_mono_to_stereo(s_work_buffer, frame_count);
+
+        esp_err_t write_ret = write_work_buffer(frame_count);
+        if (write_ret != ESP_OK) {
+            return write_ret;
         }
+    }
 
-        if (segment->is_noise) {
-            generate_noise_samples(frame_count, segment->amplitude);
-        } else if (segment->primary_freq_hz <= 0.0f && segment->secondary_freq_hz <= 0.0f) {
-            memset(s_work_buffer, 0, frame_count * FEEDBACK_CHANNELS * sizeof(int16_t));
-        } else {
-            generate_tone_samples(frame_count, segment->primary_freq_hz, segment->secondary_freq_hz, segment->amplitude);
+    return ESP_OK;
+}
+
+static esp_err_t play_cached(const tone_cache_entry_t *entry) {
+    const int16_t *samples = entry->samples;
+    size_t remaining = entry->frames;
+    while (remaining > 0U) {
+        size_t frame_count = (remaining > FEEDBACK_MAX_SEGMENT_FRAMES) ? FEEDBACK_MAX_SEGMENT_FRAMES : remaining;
+        audio_dsp_mono_to_stereo_copy(s_work_buffer, samples, frame_count);
+        esp_err_t ret = write_work_buffer(frame_count);
+        if (ret != ESP_OK) {
+            return ret;
         }
+        samples += frame_count;
+        remaining -= frame_count;
+    }
+    return ESP_OK;
+}
 
-        const size_t byte_count = frame_count * FEEDBACK_CHANNELS * sizeof(int16_t);
-        size_t total_written = 0U;
-
-        while (total_written < byte_count) {
-            size_t written = 0U;
-            esp_err_t write_ret = audio_driver_write((const uint8_t *)s_work_buffer + total_written,
-                                                     byte_count - total_written,
-                                                     &written,
-                                                     200);
-            if (write_ret != ESP_OK) {
-                ESP_LOGE(TAG, "Audio write failed: %s", esp_err_to_name(write_ret));
-                return write_ret;
-            }
-            if (written == 0U) {
-                ESP_LOGE(TAG, "Audio write returned zero bytes");
-                return ESP_FAIL;
+static esp_err_t play_clip(const prompt_clip_t *clip) {
+    if (clip->codec == PROMPT_CODEC_PCM16) {
+        const int16_t *samples = (const int16_t *)clip->data;
+        size_t remaining = clip->length / sizeof(int16_t);
+        while (remaining > 0U) {
+            size_t frame_count = (remaining > FEEDBACK_MAX_SEGMENT_FRAMES) ? FEEDBACK_MAX_SEGMENT_FRAMES : remaining;
+            audio_dsp_mono_to_stereo_copy(s_work_buffer, samples, frame_count);
+            esp_err_t ret = write_work_buffer(frame_count);
+            if (ret != ESP_OK) {
+                return ret;
             }
-            total_written += written;
+            samples += frame_count;
+            remaining -= frame_count;
         }
+        return ESP_OK;
     }
 
+    // IMA-ADPCM: fixed-size frames, each decoded into the front half of the work buffer
+    size_t offset = 0U;
+    while (offset < clip->length) {
+        size_t frame_len = clip->length - offset;
+        if (frame_len > CONFIG_PROMPT_ADPCM_BLOCK_BYTES) {
+            frame_len = CONFIG_PROMPT_ADPCM_BLOCK_BYTES;
+        }
+        size_t frame_count = 0U;
+        esp_err_t ret = audio_codec_adpcm_decode(clip->data + offset, frame_len, s_work_buffer,
+                                                 FEEDBACK_MAX_SEGMENT_FRAMES, &frame_count);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        audio_dsp_mono_to_stereo(s_work_buffer, frame_count);
+        ret = write_work_buffer(frame_count);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        offset += frame_len;
+    }
     return ESP_OK;
 }
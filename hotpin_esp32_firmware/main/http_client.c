@@ -1,12 +1,17 @@
 /**
  * @file http_client.c
  * @brief HTTP client implementation for image upload
+ *
+ * Streams the multipart body straight from the caller's frame buffer over a
+ * persistent keep-alive connection instead of assembling it in PSRAM.
  */
 
 #include "http_client.h"
 #include "config.h"
 #include "esp_http_client.h"
 #include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include <string.h>
 #include <stdio.h>
 
@@ -15,6 +20,8 @@
 // ===========================
 #define BOUNDARY_STRING "----HotPinESP32CamBoundary"
 #define MAX_HTTP_RECV_BUFFER 1024
+#define UPLOAD_WRITE_CHUNK 4096        // Largest single esp_http_client_write() call
+#define UPLOAD_MAX_ATTEMPTS 2          // Reused socket may be stale: retry once on a fresh connect
 
 // ===========================
 // Private Variables
@@ -24,6 +31,12 @@ static char server_url[128] = {0};
 static char auth_token[256] = {0};
 static bool is_initialized = false;
 
+// Persistent client reused across captures (keep-alive), created on first upload
+static esp_http_client_handle_t s_client = NULL;
+static SemaphoreHandle_t s_upload_mutex = NULL;
+static char s_content_type[96] = {0};
+static char s_auth_header[300] = {0};
+
 // ===========================
 // Private Functions
 // ===========================
@@ -43,14 +56,8 @@ static esp_err_t http_event_handler(esp_http_client_event_t *evt) {
             ESP_LOGD(TAG, "HTTP_EVENT_ON_HEADER: %s: %s", evt->header_key, evt->header_value);
             break;
         case HTTP_EVENT_ON_DATA:
+            // Body is pulled with esp_http_client_read() in stream_upload_once()
             ESP_LOGD(TAG, "HTTP_EVENT_ON_DATA, len=%d", evt->data_len);
-            if (evt->user_data != NULL && evt->data_len > 0) {
-                // Copy response data to user buffer
-                char *response_buf = (char *)evt->user_data;
-                int remaining_space = MAX_HTTP_RECV_BUFFER - strlen(response_buf) - 1;
-                int copy_len = (evt->data_len < remaining_space) ? evt->data_len : remaining_space;
-                strncat(response_buf, (char *)evt->data, copy_len);
-            }
             break;
         case HTTP_EVENT_ON_FINISH:
             ESP_LOGD(TAG, "HTTP_EVENT_ON_FINISH");
@@ -64,6 +71,113 @@ static esp_err_t http_event_handler(esp_http_client_event_t *evt) {
     return ESP_OK;
 }
 
+static esp_http_client_handle_t get_persistent_client(void) {
+    if (s_client != NULL) {
+        return s_client;
+    }
+
+    char url[256];
+    snprintf(url, sizeof(url), "%s%s", server_url, CONFIG_HTTP_IMAGE_ENDPOINT);
+
+    esp_http_client_config_t config = {
+        .url = url,
+        .method = HTTP_METHOD_POST,
+        .timeout_ms = CONFIG_HTTP_TIMEOUT_MS,
+        .event_handler = http_event_handler,
+        .buffer_size = 1024,
+        .buffer_size_tx = 1024,
+        .keep_alive_enable = true
+    };
+
+    s_client = esp_http_client_init(&config);
+    if (s_client == NULL) {
+        ESP_LOGE(TAG, "Failed to initialize HTTP client");
+        return NULL;
+    }
+
+    // Headers persist on the handle, so they are set once for every upload
+    snprintf(s_content_type, sizeof(s_content_type),
+             "multipart/form-data; boundary=%s", BOUNDARY_STRING);
+    esp_http_client_set_header(s_client, "Content-Type", s_content_type);
+
+    if (auth_token[0] != '\0') {
+        snprintf(s_auth_header, sizeof(s_auth_header), "Bearer %s", auth_token);
+        esp_http_client_set_header(s_client, "Authorization", s_auth_header);
+        ESP_LOGD(TAG, "Authorization header set");
+    }
+
+    ESP_LOGI(TAG, "Persistent upload client created (%s, keep-alive)", url);
+    return s_client;
+}
+
+static esp_err_t write_all(esp_http_client_handle_t client, const char *data, size_t len) {
+    size_t sent = 0;
+    while (sent < len) {
+        size_t chunk = len - sent;
+        if (chunk > UPLOAD_WRITE_CHUNK) {
+            chunk = UPLOAD_WRITE_CHUNK;
+        }
+        int written = esp_http_client_write(client, data + sent, (int)chunk);
+        if (written <= 0) {
+            ESP_LOGE(TAG, "Body write failed at %u/%u bytes",
+                     (unsigned int)sent, (unsigned int)len);
+            return ESP_FAIL;
+        }
+        sent += (size_t)written;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t stream_upload_once(esp_http_client_handle_t client,
+                                    const char *preamble, size_t preamble_len,
+                                    const uint8_t *jpeg_data, size_t jpeg_len,
+                                    const char *closing, size_t closing_len,
+                                    char *response_target, size_t response_size) {
+    size_t total_len = preamble_len + jpeg_len + closing_len;
+
+    esp_err_t err = esp_http_client_open(client, (int)total_len);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open connection: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    // Preamble, then the frame buffer itself, then the closing boundary - no body copy
+    if (write_all(client, preamble, preamble_len) != ESP_OK ||
+        write_all(client, (const char *)jpeg_data, jpeg_len) != ESP_OK ||
+        write_all(client, closing, closing_len) != ESP_OK) {
+        return ESP_FAIL;
+    }
+
+    int64_t content_length = esp_http_client_fetch_headers(client);
+    if (content_length < 0 && !esp_http_client_is_chunked_response(client)) {
+        ESP_LOGE(TAG, "Failed to read response headers");
+        return ESP_FAIL;
+    }
+
+    size_t received = 0;
+    while (received + 1 < response_size) {
+        int read_len = esp_http_client_read(client, response_target + received,
+                                            (int)(response_size - 1 - received));
+        if (read_len <= 0) {
+            break;
+        }
+        received += (size_t)read_len;
+    }
+    response_target[received] = '\0';
+
+    // Drain whatever did not fit so the socket is left clean for the next request
+    esp_http_client_flush_response(client, NULL);
+
+    int status_code = esp_http_client_get_status_code(client);
+    ESP_LOGI(TAG, "HTTP POST Status = %d, content_length = %d", status_code, (int)content_length);
+
+    if (status_code < 200 || status_code >= 300) {
+        ESP_LOGW(TAG, "Server returned non-2xx status: %d", status_code);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    return ESP_OK;
+}
+
 // ===========================
 // Public Functions
 // ===========================
@@ -86,6 +200,14 @@ esp_err_t http_client_init(const char *server_url_param, const char *auth_token_
         ESP_LOGW(TAG, "No authorization token provided");
     }
     
+    if (s_upload_mutex == NULL) {
+        s_upload_mutex = xSemaphoreCreateMutex();
+        if (s_upload_mutex == NULL) {
+            ESP_LOGE(TAG, "Failed to create upload mutex");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
     is_initialized = true;
     ESP_LOGI(TAG, "HTTP client initialized (server: %s)", server_url);
     return ESP_OK;
@@ -93,7 +215,17 @@ esp_err_t http_client_init(const char *server_url_param, const char *auth_token_
 
 esp_err_t http_client_deinit(void) {
     ESP_LOGI(TAG, "Deinitializing HTTP client");
+    if (s_upload_mutex != NULL) {
+        xSemaphoreTake(s_upload_mutex, portMAX_DELAY);
+    }
+    if (s_client != NULL) {
+        esp_http_client_cleanup(s_client);
+        s_client = NULL;
+    }
     is_initialized = false;
+    if (s_upload_mutex != NULL) {
+        xSemaphoreGive(s_upload_mutex);
+    }
     return ESP_OK;
 }
 
@@ -114,123 +246,75 @@ esp_err_t http_client_upload_image(const char *session_id,
     
     ESP_LOGI(TAG, "Uploading image: session=%s, size=%zu bytes", session_id, jpeg_len);
     
-    // Construct full URL
-    char url[256];
-    snprintf(url, sizeof(url), "%s%s", server_url, CONFIG_HTTP_IMAGE_ENDPOINT);
-    
-    // Build multipart/form-data body
-    // Part 1: session field
-    char session_part[512];
-    snprintf(session_part, sizeof(session_part),
+    // Part 1 (session field) and part 2 (file field header) go out as one preamble
+    char preamble[512];
+    int preamble_len = snprintf(preamble, sizeof(preamble),
              "--%s\r\n"
              "Content-Disposition: form-data; name=\"session\"\r\n\r\n"
-             "%s\r\n",
-             BOUNDARY_STRING, session_id);
-    
-    // Part 2: file field header
-    char file_header[256];
-    snprintf(file_header, sizeof(file_header),
+             "%s\r\n"
              "--%s\r\n"
              "Content-Disposition: form-data; name=\"file\"; filename=\"image.jpg\"\r\n"
              "Content-Type: image/jpeg\r\n\r\n",
-             BOUNDARY_STRING);
+             BOUNDARY_STRING, session_id, BOUNDARY_STRING);
+    if (preamble_len < 0 || preamble_len >= (int)sizeof(preamble)) {
+        ESP_LOGE(TAG, "Multipart preamble too long (session id %zu chars)", strlen(session_id));
+        return ESP_ERR_INVALID_SIZE;
+    }
     
     // Part 3: closing boundary
     char closing_boundary[64];
-    snprintf(closing_boundary, sizeof(closing_boundary),
+    int closing_len = snprintf(closing_boundary, sizeof(closing_boundary),
              "\r\n--%s--\r\n",
              BOUNDARY_STRING);
     
-    // Calculate total length
-    size_t total_len = strlen(session_part) + strlen(file_header) + 
-                       jpeg_len + strlen(closing_boundary);
-    
-    // Allocate temporary buffer for entire POST body
-    char *post_data = heap_caps_malloc(total_len, MALLOC_CAP_SPIRAM);
-    if (post_data == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate %zu bytes for POST data", total_len);
-        return ESP_ERR_NO_MEM;
-    }
-    
-    // Assemble POST body
-    size_t offset = 0;
-    memcpy(post_data + offset, session_part, strlen(session_part));
-    offset += strlen(session_part);
-    memcpy(post_data + offset, file_header, strlen(file_header));
-    offset += strlen(file_header);
-    memcpy(post_data + offset, jpeg_data, jpeg_len);
-    offset += jpeg_len;
-    memcpy(post_data + offset, closing_boundary, strlen(closing_boundary));
-    
-    ESP_LOGI(TAG, "POST body assembled: %zu bytes", total_len);
-    
-    // Configure HTTP client
-    char content_type_header[128];
-    snprintf(content_type_header, sizeof(content_type_header),
-             "multipart/form-data; boundary=%s", BOUNDARY_STRING);
-    
     // Prepare response buffer
     char local_response[MAX_HTTP_RECV_BUFFER] = {0};
-    char *response_target = (response_buffer != NULL) ? response_buffer : local_response;
+    char *response_target = local_response;
+    size_t response_size = sizeof(local_response);
     if (response_buffer != NULL && response_buffer_size > 0) {
-        response_buffer[0] = '\0';
+        response_target = response_buffer;
+        response_size = response_buffer_size;
     }
+    response_target[0] = '\0';
     
-    esp_http_client_config_t config = {
-        .url = url,
-        .method = HTTP_METHOD_POST,
-        .timeout_ms = CONFIG_HTTP_TIMEOUT_MS,
-        .event_handler = http_event_handler,
-        .user_data = response_target,
-        .buffer_size = 4096,
-        .buffer_size_tx = 4096
-    };
-    
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    if (client == NULL) {
-        ESP_LOGE(TAG, "Failed to initialize HTTP client");
-        free(post_data);
-        return ESP_FAIL;
-    }
-    
-    // Set headers
-    esp_http_client_set_header(client, "Content-Type", content_type_header);
-    
-    if (auth_token[0] != '\0') {
-        char auth_header[300];
-        snprintf(auth_header, sizeof(auth_header), "Bearer %s", auth_token);
-        esp_http_client_set_header(client, "Authorization", auth_header);
-        ESP_LOGD(TAG, "Authorization header set");
+    if (xSemaphoreTake(s_upload_mutex, pdMS_TO_TICKS(CONFIG_HTTP_TIMEOUT_MS)) != pdTRUE) {
+        ESP_LOGE(TAG, "Upload already in progress");
+        return ESP_ERR_TIMEOUT;
     }
     
-    esp_http_client_set_post_field(client, post_data, total_len);
-    
-    // Perform HTTP request
-    ESP_LOGI(TAG, "Sending POST request to %s", url);
-    esp_err_t err = esp_http_client_perform(client);
-    
-    if (err == ESP_OK) {
-        int status_code = esp_http_client_get_status_code(client);
-        int content_length = esp_http_client_get_content_length(client);
-        
-        ESP_LOGI(TAG, "HTTP POST Status = %d, content_length = %d", status_code, content_length);
+    esp_err_t err = ESP_FAIL;
+    for (int attempt = 1; attempt <= UPLOAD_MAX_ATTEMPTS; attempt++) {
+        esp_http_client_handle_t client = get_persistent_client();
+        if (client == NULL) {
+            err = ESP_FAIL;
+            break;
+        }
         
-        if (status_code >= 200 && status_code < 300) {
+        ESP_LOGI(TAG, "Streaming POST %s%s (%zu bytes body, attempt %d)",
+                 server_url, CONFIG_HTTP_IMAGE_ENDPOINT,
+                 (size_t)preamble_len + jpeg_len + (size_t)closing_len, attempt);
+        err = stream_upload_once(client, preamble, (size_t)preamble_len,
+                                 jpeg_data, jpeg_len,
+                                 closing_boundary, (size_t)closing_len,
+                                 response_target, response_size);
+        if (err == ESP_OK) {
             ESP_LOGI(TAG, "Image uploaded successfully");
             if (response_target[0] != '\0') {
                 ESP_LOGI(TAG, "Server response: %s", response_target);
             }
-        } else {
-            ESP_LOGW(TAG, "Server returned non-2xx status: %d", status_code);
+            break;
+        }
+        
+        // Drop the (possibly half-written or server-closed) socket; next attempt reconnects
+        esp_http_client_close(client);
+        if (err == ESP_ERR_INVALID_RESPONSE) {
             err = ESP_FAIL;
+            break;  // Server answered - retrying the same frame will not help
         }
-    } else {
-        ESP_LOGE(TAG, "HTTP POST failed: %s", esp_err_to_name(err));
+        ESP_LOGW(TAG, "Upload attempt %d failed, %s", attempt,
+                 (attempt < UPLOAD_MAX_ATTEMPTS) ? "reconnecting" : "giving up");
     }
     
-    // Cleanup
-    esp_http_client_cleanup(client);
-    free(post_data);
-    
+    xSemaphoreGive(s_upload_mutex);
     return err;
 }
@@ -0,0 +1,105 @@
+/**
+ * @file audio_codec.h
+ * @brief STT uplink audio encoder (PCM16 passthrough, IMA-ADPCM, optional Opus)
+ *
+ * The codec is negotiated per WebSocket session: the device offers the codecs it
+ * was built with in the handshake and the server answers with one of them.
+ *
+ * Wire formats (one WebSocket binary frame per encode call):
+ *  - pcm16:     raw 16 kHz mono little-endian samples
+ *  - ima_adpcm: int16 LE predictor, uint8 step index, uint8 flags, then 4-bit codes
+ *               (low nibble first). Every frame carries its own start state, so a
+ *               frame dropped after a send failure does not corrupt the next one.
+ *  - opus:      repeated [uint16 LE length][20 ms Opus packet]
+ */
+
+#ifndef AUDIO_CODEC_H
+#define AUDIO_CODEC_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    AUDIO_CODEC_PCM16 = 0,
+    AUDIO_CODEC_IMA_ADPCM,
+    AUDIO_CODEC_OPUS
+} audio_codec_t;
+
+#define AUDIO_CODEC_ADPCM_HEADER_BYTES      4
+#define AUDIO_CODEC_ADPCM_FLAG_ODD_SAMPLES  0x01
+
+/**
+ * @brief Handshake name of a codec ("pcm16", "ima_adpcm", "opus")
+ */
+const char *audio_codec_name(audio_codec_t codec);
+
+/**
+ * @brief Parse a handshake codec name
+ *
+ * @return true if the name is known and the codec is compiled in
+ */
+bool audio_codec_from_name(const char *name, audio_codec_t *codec);
+
+/**
+ * @brief Whether this firmware build can encode the codec
+ */
+bool audio_codec_is_supported(audio_codec_t codec);
+
+/**
+ * @brief Worst-case encoded size for pcm_bytes of input
+ */
+size_t audio_codec_max_encoded_size(audio_codec_t codec, size_t pcm_bytes);
+
+/**
+ * @brief Reset encoder state at the start of an utterance
+ *
+ * @return ESP_OK, or ESP_ERR_NOT_SUPPORTED / ESP_ERR_NO_MEM for Opus
+ */
+esp_err_t audio_codec_encoder_reset(audio_codec_t codec);
+
+/**
+ * @brief Encode PCM16 into one uplink frame
+ *
+ * PCM16 is never encoded (callers send the ring span directly). Opus keeps a
+ * partial 20 ms frame internally, so out_len can be 0; pass flush=true with
+ * the final block of an utterance to pad and emit it.
+ *
+ * @param codec Negotiated codec
+ * @param pcm 16-bit mono samples (byte length must be even)
+ * @param pcm_len Input length in bytes
+ * @param flush Emit any buffered partial frame (Opus only)
+ * @param out Output buffer
+ * @param out_cap Output capacity (see audio_codec_max_encoded_size)
+ * @param out_len Bytes written to out
+ * @return ESP_OK on success
+ */
+esp_err_t audio_codec_encode(audio_codec_t codec, const uint8_t *pcm, size_t pcm_len, bool flush,
+                             uint8_t *out, size_t out_cap, size_t *out_len);
+
+/**
+ * @brief Decode one IMA-ADPCM frame (wire format above) back to PCM16
+ *
+ * Used for prompt clips stored in flash, which are a run of such frames.
+ * Decoder state comes from the frame header, so frames decode independently.
+ *
+ * @param frame Frame bytes (header + codes)
+ * @param frame_len Frame length in bytes
+ * @param pcm Output samples
+ * @param pcm_cap Output capacity in samples
+ * @param samples Samples written
+ * @return ESP_OK, or ESP_ERR_INVALID_SIZE if the frame is short or pcm_cap too small
+ */
+esp_err_t audio_codec_adpcm_decode(const uint8_t *frame, size_t frame_len,
+                                   int16_t *pcm, size_t pcm_cap, size_t *samples);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_CODEC_H
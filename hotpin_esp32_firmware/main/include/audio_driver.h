@@ -15,18 +15,21 @@
 #include "driver/i2s_std.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "freertos/task.h"
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
 
 /**
- * @brief Global mutex for protecting concurrent I2S read/write operations
+ * @brief Per-direction mutexes for concurrent I2S read/write operations
  * 
- * CRITICAL: This mutex prevents race conditions when stt_pipeline_task (Core 1)
- * and tts_playback_task (Core 1) concurrently access the I2S hardware channels.
- * Must be acquired before any i2s_channel_read() or i2s_channel_write() call.
+ * g_i2s_tx_mutex guards i2s_channel_write() on the speaker channel and
+ * g_i2s_rx_mutex guards i2s_channel_read() on the microphone channel, so
+ * playback and capture proceed in parallel. Code touching the shared clock
+ * must take both, RX first.
  */
-extern SemaphoreHandle_t g_i2s_access_mutex;
+extern SemaphoreHandle_t g_i2s_tx_mutex;
+extern SemaphoreHandle_t g_i2s_rx_mutex;
 
 /**
  * @brief I2S channel handles for modern i2s_std driver
@@ -76,9 +79,79 @@ esp_err_t audio_driver_write(const uint8_t *data, size_t size, size_t *bytes_wri
 esp_err_t audio_driver_read(uint8_t *buffer, size_t size, size_t *bytes_read, uint32_t timeout_ms);
 
 /**
- * @brief Check if audio driver is initialized
+ * @brief Completed RX DMA buffer handed out by the interrupt-driven capture path
+ *
+ * @note data points into the driver's DMA ring and stays valid for roughly
+ *       (CONFIG_I2S_DMA_BUF_COUNT - 1) DMA periods; copy it out promptly.
+ */
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+} audio_rx_frame_t;
+
+/**
+ * @brief Attach a task to the RX on_recv DMA callback
+ *
+ * Every completed RX DMA buffer is published to an internal descriptor ring and
+ * the task is woken with a direct-to-task notification (ulTaskNotifyTake).
+ * This path takes no mutex and does not go through i2s_channel_read().
+ *
+ * @param notify_task Task to notify, normally the STT capture task
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if RX is not initialized
+ */
+esp_err_t audio_driver_rx_stream_start(TaskHandle_t notify_task);
+
+/**
+ * @brief Detach the capture task from the RX DMA callback
+ *
+ * Must be called before the attached task is deleted.
+ */
+void audio_driver_rx_stream_stop(void);
+
+/**
+ * @brief Pop completed RX DMA buffers published since the last call
+ *
+ * @param frames Output array
+ * @param max_frames Capacity of frames
+ * @return Number of frames written to frames
+ */
+size_t audio_driver_rx_stream_fetch(audio_rx_frame_t *frames, size_t max_frames);
+
+/**
+ * @brief Number of DMA buffers dropped because the capture task fell behind
+ */
+uint32_t audio_driver_rx_stream_overruns(void);
+
+/**
+ * @brief Disable both I2S channels but keep them (and their DMA) allocated
  * 
- * @return true if initialized, false otherwise
+ * Used for voice -> camera switches instead of audio_driver_deinit(); the
+ * next audio_driver_init() or audio_driver_resume() re-enables the channels
+ * without recreating them. Falls back to a full deinit when
+ * CONFIG_MODE_SWITCH_KEEP_I2S is 0.
+ * 
+ * @return ESP_OK on success
+ */
+esp_err_t audio_driver_suspend(void);
+
+/**
+ * @brief Re-enable channels parked by audio_driver_suspend()
+ * 
+ * Performs a full init if the driver was never created or fully deinitialized.
+ * 
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t audio_driver_resume(void);
+
+/**
+ * @brief Check if channels are allocated but disabled (camera mode)
+ */
+bool audio_driver_is_suspended(void);
+
+/**
+ * @brief Check if audio driver is initialized and able to move data
+ * 
+ * @return true if initialized and not suspended, false otherwise
  */
 bool audio_driver_is_initialized(void);
 
@@ -106,6 +179,16 @@ esp_err_t audio_driver_set_tx_sample_rate(uint32_t sample_rate);
  */
 uint32_t audio_driver_get_tx_sample_rate(void);
 
+/**
+ * @brief Echo reference for full-duplex capture
+ *
+ * Returns the loudest mean |sample| among TX chunks written within the last
+ * window_ms. Chunks play out up to one DMA ring after they are written, so the
+ * window should cover the DMA depth plus one chunk. Returns 0 when the
+ * speaker has been idle for the whole window.
+ */
+uint16_t audio_driver_tx_reference_level(uint32_t window_ms);
+
 /**
  * @brief Get current buffer level as percentage
  * 
@@ -0,0 +1,127 @@
+/**
+ * @file audio_dsp.h
+ * @brief Playback DSP kernels shared by the TTS decoder and feedback player
+ *
+ * - In-place mono -> stereo duplication, two samples per 32-bit load
+ * - Q8.8 volume scaling with an optional soft-knee limiter
+ * - Streaming linear-interpolation resampler (replaces reclocking I2S TX)
+ *
+ * The ESP32's LX6 core has no packed 16-bit SIMD, so the "vector" paths are
+ * 32-bit word packing plus the Xtensa CLAMPS saturation instruction where the
+ * core provides it. Kernels live in IRAM so they keep running at full speed
+ * while Wi-Fi traffic thrashes the flash cache.
+ */
+
+#ifndef AUDIO_DSP_H
+#define AUDIO_DSP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#if defined(__XTENSA__)
+#include "xtensa/config/core-isa.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIO_DSP_GAIN_UNITY_Q8     256U    // 1.0 in Q8.8
+#define AUDIO_DSP_SOFT_KNEE         24576   // ~-2.5 dBFS, limiter is linear below this
+
+#if defined(XCHAL_HAVE_CLAMPS) && XCHAL_HAVE_CLAMPS
+#define AUDIO_DSP_HAVE_CLAMPS 1
+#else
+#define AUDIO_DSP_HAVE_CLAMPS 0
+#endif
+
+/**
+ * @brief Saturate a 32-bit intermediate to int16
+ */
+static inline int16_t audio_dsp_sat16(int32_t value)
+{
+#if AUDIO_DSP_HAVE_CLAMPS
+    int32_t result;
+    __asm__ ("clamps %0, %1, 15" : "=a"(result) : "a"(value));
+    return (int16_t)result;
+#else
+    if (value > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (value < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t)value;
+#endif
+}
+
+/**
+ * @brief Duplicate mono samples to interleaved L/R in place
+ *
+ * @param samples Buffer holding frames mono samples with room for 2 * frames;
+ *                4-byte aligned buffers take the word-packed path
+ * @param frames Number of mono samples
+ */
+void audio_dsp_mono_to_stereo(int16_t *samples, size_t frames);
+
+/**
+ * @brief Duplicate mono samples into a separate interleaved stereo buffer
+ */
+void audio_dsp_mono_to_stereo_copy(int16_t *dst, const int16_t *src, size_t frames);
+
+/**
+ * @brief Scale samples by a Q8.8 gain in place
+ *
+ * Unity gain returns immediately. With soft_clip, peaks above
+ * AUDIO_DSP_SOFT_KNEE are compressed smoothly toward full scale instead of
+ * hard-clipping.
+ */
+void audio_dsp_apply_gain(int16_t *samples, size_t count, uint16_t gain_q8, bool soft_clip);
+
+/**
+ * @brief Linear fade across interleaved stereo frames in place
+ *
+ * @param rising true ramps from silence up to unity (fade-in), false ramps
+ *               from unity down to silence (fade-out)
+ */
+void audio_dsp_apply_fade(int16_t *stereo, size_t frames, bool rising);
+
+/**
+ * @brief Streaming mono resampler state (linear interpolation, Q16 phase)
+ */
+typedef struct {
+    uint32_t in_rate;
+    uint32_t out_rate;
+    uint32_t step_q16;  // Input samples advanced per output sample
+    uint32_t pos_q16;   // Read position; integer part 0 refers to last_sample
+    int16_t last_sample;
+    bool primed;
+} audio_dsp_resampler_t;
+
+/**
+ * @brief Prepare a resampler for a new stream
+ *
+ * @return false if either rate is zero
+ */
+bool audio_dsp_resampler_init(audio_dsp_resampler_t *rs, uint32_t in_rate, uint32_t out_rate);
+
+/**
+ * @brief Upper bound on output frames for in_frames of input
+ */
+size_t audio_dsp_resampler_max_output(const audio_dsp_resampler_t *rs, size_t in_frames);
+
+/**
+ * @brief Resample one chunk of mono PCM, carrying phase across calls
+ *
+ * @param out_cap Capacity of out in frames; size it with audio_dsp_resampler_max_output()
+ * @return Output frames written
+ */
+size_t audio_dsp_resample(audio_dsp_resampler_t *rs, const int16_t *in, size_t in_frames,
+                          int16_t *out, size_t out_cap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_DSP_H
@@ -0,0 +1,59 @@
+/**
+ * @file bench_suite.h
+ * @brief Throughput/latency micro-benchmarks for the firmware hot paths
+ *
+ * The same cases build for the device (serial command 'b') and for Linux
+ * (bench/, a standalone CMake project), so a change can be measured on the
+ * host first and confirmed on the target. Covered: the STT ring, WAV header
+ * parsing, the TTS playout kernels (gain, resample, stereo expansion), tone
+ * rendering and control-message parsing.
+ *
+ * Each result prints as one line:
+ *   BENCH <case> iters=<n> ns/op=<t> MB/s=<r> rt=<x>
+ * MB/s is 0 for cases that are not byte streams; rt is seconds of audio
+ * processed per second of CPU (0 when not audio).
+ */
+
+#ifndef BENCH_SUITE_H
+#define BENCH_SUITE_H
+
+#include "esp_err.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    const char *name;
+    uint32_t iterations;
+    int64_t elapsed_us;
+    double ns_per_op;
+    double mb_per_s;                    // 0 when the case has no byte count
+    double realtime;                    // Audio seconds per CPU second, 0 when not audio
+} bench_result_t;
+
+/**
+ * @brief Called once per finished case (after the BENCH line is printed)
+ */
+typedef void (*bench_report_fn_t)(const bench_result_t *result, void *arg);
+
+/**
+ * @brief Run the cases whose name starts with filter
+ *
+ * Runs in the caller's task. On the device, results are only meaningful while
+ * the pipeline is idle (no recording or playback).
+ *
+ * @param filter Name prefix, NULL or "" for all cases
+ * @param min_case_ms Minimum measuring time per case (0 = CONFIG_BENCH_MIN_CASE_MS)
+ * @param report Optional per-result callback
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if nothing matched, ESP_ERR_NO_MEM, or
+ *         ESP_ERR_NOT_SUPPORTED when built without CONFIG_BENCH_SUITE_ENABLED
+ */
+esp_err_t bench_suite_run(const char *filter, uint32_t min_case_ms, bench_report_fn_t report, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BENCH_SUITE_H
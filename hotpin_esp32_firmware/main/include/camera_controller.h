@@ -10,6 +10,34 @@
 
 #include "esp_err.h"
 #include "esp_camera.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Capture profile requested by the server for the next shot
+ */
+typedef enum {
+    CAMERA_PROFILE_THUMBNAIL = 0,   // QVGA, higher compression, short burst
+    CAMERA_PROFILE_STANDARD,        // VGA at CONFIG_CAMERA_JPEG_QUALITY
+    CAMERA_PROFILE_DETAIL,          // VGA, low compression, longest burst
+    CAMERA_PROFILE_COUNT
+} camera_profile_t;
+
+/**
+ * @brief Best frame of a burst
+ * 
+ * data points either into the driver frame buffer (fb != NULL) or into the
+ * controller's PSRAM burst buffer. Release with camera_controller_release_capture().
+ */
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    camera_profile_t profile;
+    uint8_t frames_scored;
+    bool flash_used;
+    camera_fb_t *fb;
+} camera_capture_t;
 
 /**
  * @brief Initialize camera with AI-Thinker pin configuration
@@ -29,13 +57,77 @@ esp_err_t camera_controller_init(void);
  */
 esp_err_t camera_controller_deinit(void);
 
+/**
+ * @brief Initialize (if needed) and put the sensor into warm standby
+ * 
+ * Keeps the driver and sensor registers alive with image output stopped, so
+ * the next capture skips the power cycle and SCCB/driver init. Refused when
+ * CONFIG_CAMERA_WARM_STANDBY is off or internal DMA headroom is too small;
+ * in that case the camera is left deinitialized.
+ * 
+ * @return ESP_OK when warm, error code otherwise
+ */
+esp_err_t camera_controller_enter_warm_standby(void);
+
+/**
+ * @brief Make the camera ready for camera_controller_capture_frame()
+ * 
+ * Wakes a warm sensor, or performs a full init when the camera is cold.
+ * 
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t camera_controller_begin_capture(void);
+
+/**
+ * @brief Release the camera after a capture
+ * 
+ * Returns to warm standby when enabled and affordable, otherwise deinitializes.
+ * 
+ * @return ESP_OK on success
+ */
+esp_err_t camera_controller_end_capture(void);
+
 /**
  * @brief Capture a single frame
  * 
+ * Waits for auto-exposure to settle and fires the flash only when the sensor
+ * gain shows a dark scene (CONFIG_CAMERA_FLASH_GAIN_X16).
+ * 
  * @return Pointer to frame buffer (must be released with camera_fb_return)
  */
 camera_fb_t* camera_controller_capture_frame(void);
 
+/**
+ * @brief Capture a burst with the given profile and keep only the best frame
+ * 
+ * Exposure is settled (with flash if needed) once, then the profile's burst is
+ * grabbed back to back. Frames are scored by JPEG size - a sharpness proxy at
+ * fixed quality - and halved when auto-exposure was still moving. Only the
+ * running best is copied to PSRAM; the last frame is kept in place if it wins.
+ * 
+ * @param profile Resolution/quality/burst profile
+ * @param capture Filled with the selected frame on success
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t camera_controller_capture_best(camera_profile_t profile, camera_capture_t *capture);
+
+/**
+ * @brief Release a frame returned by camera_controller_capture_best()
+ */
+void camera_controller_release_capture(camera_capture_t *capture);
+
+/**
+ * @brief Set / get the profile used for the next capture (server-selectable)
+ */
+void camera_controller_set_profile(camera_profile_t profile);
+camera_profile_t camera_controller_get_profile(void);
+
+/**
+ * @brief Map between profile names used on the wire ("thumbnail", "standard", "detail")
+ */
+bool camera_profile_from_name(const char *name, camera_profile_t *out_profile);
+const char *camera_profile_name(camera_profile_t profile);
+
 /**
  * @brief Check if camera is initialized
  * 
@@ -43,4 +135,11 @@ camera_fb_t* camera_controller_capture_frame(void);
  */
 bool camera_controller_is_initialized(void);
 
+/**
+ * @brief Check if the camera is initialized and parked in warm standby
+ * 
+ * @return true if warm, false otherwise
+ */
+bool camera_controller_is_warm(void);
+
 #endif // CAMERA_CONTROLLER_H
@@ -104,16 +104,118 @@
 // Audio buffer sizes (PSRAM-backed)
 #define CONFIG_STT_RING_BUFFER_SIZE         (64 * 1024)     // 64KB for 2 seconds @ 16kHz
 #define CONFIG_TTS_BUFFER_SIZE              (512 * 1024)    // 512KB for TTS WAV data
-#define CONFIG_TTS_STEREO_SCRATCH_BYTES     (8 * 1024)      // Scratch buffer for mono→stereo duplication
+#define CONFIG_TTS_BLOCK_PAYLOAD_BYTES      (4 * 1024)      // Received bytes per playback block (storage is 2x for in-place stereo)
+#define CONFIG_TTS_BLOCK_COUNT              16              // Playback blocks in the TTS ring (128KB PSRAM, ~2s @ 16kHz mono)
 
 #if CONFIG_I2S_DMA_BUF_LEN > 1023
 #error "CONFIG_I2S_DMA_BUF_LEN exceeds ESP32 I2S HW limit (1023 samples per DMA frame)"
 #endif
 
-#if (CONFIG_TTS_STEREO_SCRATCH_BYTES % 4) != 0
-#error "CONFIG_TTS_STEREO_SCRATCH_BYTES must be 4-byte aligned"
+#if (CONFIG_TTS_BLOCK_PAYLOAD_BYTES % 4) != 0
+#error "CONFIG_TTS_BLOCK_PAYLOAD_BYTES must be 4-byte aligned"
+#endif
+
+#if CONFIG_TTS_BLOCK_COUNT < 2
+#error "CONFIG_TTS_BLOCK_COUNT must allow receive and playback to overlap (>= 2)"
+#endif
+
+// STT ring uses free-running indices masked by (size - 1)
+#if (CONFIG_STT_RING_BUFFER_SIZE & (CONFIG_STT_RING_BUFFER_SIZE - 1)) != 0
+#error "CONFIG_STT_RING_BUFFER_SIZE must be a power of two"
+#endif
+
+/*******************************************************************************
+ * VOICE ACTIVITY DETECTION (STT uplink gating)
+ ******************************************************************************/
+
+// Energy + zero-crossing VAD between the capture task and the STT ring buffer
+#define CONFIG_STT_VAD_ENABLED              1               // 0 = stream every captured byte (legacy)
+#define CONFIG_STT_VAD_AUTO_EOS             1               // Send EOS automatically after the hangover
+#define CONFIG_STT_VAD_FRAME_MS             20              // Analysis frame length
+#define CONFIG_STT_VAD_ONSET_MS             60              // Speech needed before the gate opens
+#define CONFIG_STT_VAD_HANGOVER_MS          900             // Trailing silence kept (and waited) before end-of-speech
+#define CONFIG_STT_VAD_PREROLL_MS           300             // Audio before onset replayed into the ring buffer
+#define CONFIG_STT_VAD_MIN_ENERGY           90              // Absolute floor on mean |sample| (quiet-room noise)
+#define CONFIG_STT_VAD_NOISE_FACTOR_Q4      48              // Speech threshold = noise floor * 3.0 (Q4)
+#define CONFIG_STT_VAD_ZCR_UNVOICED         40              // Zero crossings per 20ms frame for fricatives (~2kHz)
+
+#if CONFIG_STT_VAD_HANGOVER_MS < CONFIG_STT_VAD_FRAME_MS
+#error "CONFIG_STT_VAD_HANGOVER_MS must cover at least one VAD frame"
 #endif
 
+/*******************************************************************************
+ * FULL-DUPLEX / BARGE-IN
+ ******************************************************************************/
+
+// Keep capturing while a reply plays; speech above the speaker's echo interrupts it
+#define CONFIG_AUDIO_FULL_DUPLEX            1               // 0 = listen again only after playback finishes
+#define CONFIG_BARGE_IN_ECHO_WINDOW_MS      400             // TX history treated as "still audible" (DMA depth + one block)
+#define CONFIG_BARGE_IN_COUPLING_Q8         128             // Initial speaker->mic level ratio (Q8, 128 = 0.5), learned at runtime
+#define CONFIG_BARGE_IN_COUPLING_MAX_Q8     512             // Ceiling for the learned ratio (2.0)
+#define CONFIG_BARGE_IN_MARGIN_Q4           32              // Speech must beat predicted echo by 2x (Q4)
+
+#if CONFIG_AUDIO_FULL_DUPLEX && !CONFIG_STT_VAD_ENABLED
+#error "CONFIG_AUDIO_FULL_DUPLEX requires CONFIG_STT_VAD_ENABLED (barge-in is VAD-triggered)"
+#endif
+#if CONFIG_BARGE_IN_COUPLING_Q8 <= 0 || CONFIG_BARGE_IN_COUPLING_Q8 > CONFIG_BARGE_IN_COUPLING_MAX_Q8
+#error "CONFIG_BARGE_IN_COUPLING_Q8 must be in 1..CONFIG_BARGE_IN_COUPLING_MAX_Q8"
+#endif
+
+/*******************************************************************************
+ * TTS PLAYBACK DSP (audio_dsp.c kernels)
+ ******************************************************************************/
+
+#define CONFIG_TTS_PLAYBACK_GAIN_Q8         256             // Playback volume in Q8.8 (256 = unity, 384 = +3.5 dB)
+#define CONFIG_TTS_SOFT_CLIP_ENABLED        1               // Soft-knee limiter instead of hard clipping when boosting
+#define CONFIG_TTS_DSP_RESAMPLE_ENABLED     1               // Resample non-16kHz mono WAVs instead of reclocking I2S TX
+#define CONFIG_TTS_RESAMPLE_MIN_RATE        8000            // Lowest source rate handled by the resampler (Hz)
+#define CONFIG_TTS_RESAMPLE_MAX_RATE        48000           // Highest source rate handled by the resampler (Hz)
+
+#if CONFIG_TTS_PLAYBACK_GAIN_Q8 <= 0 || CONFIG_TTS_PLAYBACK_GAIN_Q8 > 1024
+#error "CONFIG_TTS_PLAYBACK_GAIN_Q8 must be in 1..1024 (up to 4x)"
+#endif
+
+/*******************************************************************************
+ * FEEDBACK TONES (feedback_player.c)
+ ******************************************************************************/
+
+// Every tone sequence is rendered once at boot into a mono cache in PSRAM and
+// replayed from there; sequences that do not fit are rendered on each play
+#define CONFIG_FEEDBACK_TONE_CACHE_ENABLED  1
+#define CONFIG_FEEDBACK_TONE_CACHE_MS       4000            // All built-in sequences total ~3.6 s
+
+/*******************************************************************************
+ * TTS JITTER BUFFER
+ ******************************************************************************/
+
+// Start threshold = MIN + MULTIPLIER * measured inter-arrival jitter + underrun margin,
+// clamped to MAX; re-applied after every underrun
+#define CONFIG_TTS_JITTER_MIN_PREBUFFER_MS  60              // Floor (clean LAN)
+#define CONFIG_TTS_JITTER_MAX_PREBUFFER_MS  800             // Ceiling, must fit in the block pool
+#define CONFIG_TTS_JITTER_MULTIPLIER        3               // Jitter estimates covered by the prebuffer
+#define CONFIG_TTS_JITTER_INITIAL_MS        40              // Assumed jitter before the first measurement
+#define CONFIG_TTS_JITTER_UNDERRUN_STEP_MS  60              // Margin added per underrun, halved after a clean reply
+#define CONFIG_TTS_JITTER_MAX_WAIT_MS       1500            // Start anyway once data has waited this long
+#define CONFIG_TTS_JITTER_CONCEAL_LEAD_MS   20              // Conceal this long before I2S DMA would run dry
+#define CONFIG_TTS_JITTER_FADE_MS           8               // Underrun fade-out / resume fade-in length
+
+#if (CONFIG_TTS_JITTER_MAX_PREBUFFER_MS * (CONFIG_AUDIO_SAMPLE_RATE * 2 / 1000)) > \
+    ((CONFIG_TTS_BLOCK_COUNT * CONFIG_TTS_BLOCK_PAYLOAD_BYTES * 3) / 4)
+#error "CONFIG_TTS_JITTER_MAX_PREBUFFER_MS must fit in 3/4 of the TTS block pool"
+#endif
+
+#if CONFIG_TTS_JITTER_MIN_PREBUFFER_MS > CONFIG_TTS_JITTER_MAX_PREBUFFER_MS
+#error "CONFIG_TTS_JITTER_MIN_PREBUFFER_MS must not exceed CONFIG_TTS_JITTER_MAX_PREBUFFER_MS"
+#endif
+
+/*******************************************************************************
+ * STT UPLINK CODEC (negotiated in the WebSocket handshake)
+ ******************************************************************************/
+
+#define CONFIG_STT_CODEC_ADPCM_ENABLED      1               // Offer IMA-ADPCM (4:1, 128 kbps -> 32 kbps)
+#define CONFIG_STT_CODEC_OPUS_ENABLED       0               // Offer Opus (needs an Opus managed component)
+#define CONFIG_STT_CODEC_OPUS_BITRATE       24000           // Opus VBR target in bits/s
+
 /*******************************************************************************
  * CAMERA CONFIGURATION
  ******************************************************************************/
@@ -126,6 +228,46 @@
 // Camera initialization timeout
 #define CONFIG_CAMERA_INIT_TIMEOUT_MS       5000
 
+// Warm standby: keep the sensor initialized (OV2640 COM2 standby) between shots
+// instead of a PWDN cycle + SCCB init per capture. Only used while at least
+// CONFIG_CAMERA_WARM_MIN_FREE_DMA of internal DMA RAM stays free for audio.
+#define CONFIG_CAMERA_WARM_STANDBY          1
+#define CONFIG_CAMERA_WARM_MIN_FREE_DMA     (40 * 1024)
+
+// Flash decision from sensor auto-exposure instead of a fixed pre-flash delay
+#define CONFIG_CAMERA_FLASH_GAIN_X16        64              // Fire flash when AGC gain >= 4x (x16 units)
+#define CONFIG_CAMERA_AE_SETTLE_MAX_MS      400             // Max time spent waiting for AE to converge
+#define CONFIG_CAMERA_AE_SETTLE_PCT         10              // Frame-to-frame exposure change counted as settled
+
+#if (CONFIG_CAMERA_AE_SETTLE_PCT < 1) || (CONFIG_CAMERA_AE_SETTLE_PCT > 50)
+#error "CONFIG_CAMERA_AE_SETTLE_PCT must be in 1..50"
+#endif
+
+// Capture profiles (camera_profile_t): burst length and size/quality per request.
+// The driver is initialized at CONFIG_CAMERA_FRAME_SIZE, so no profile may exceed it.
+#define CONFIG_CAMERA_PROFILE_DEFAULT       CAMERA_PROFILE_STANDARD
+#define CONFIG_CAMERA_THUMB_FRAME_SIZE      FRAMESIZE_QVGA  // 320x240 for "what is this?" queries
+#define CONFIG_CAMERA_THUMB_JPEG_QUALITY    15
+#define CONFIG_CAMERA_THUMB_BURST           2
+#define CONFIG_CAMERA_STANDARD_BURST        3
+#define CONFIG_CAMERA_DETAIL_JPEG_QUALITY   8               // Text/label reading at full size
+#define CONFIG_CAMERA_DETAIL_BURST          4
+#define CONFIG_CAMERA_BURST_MAX             4
+
+#if (CONFIG_CAMERA_THUMB_BURST > CONFIG_CAMERA_BURST_MAX) || \
+    (CONFIG_CAMERA_STANDARD_BURST > CONFIG_CAMERA_BURST_MAX) || \
+    (CONFIG_CAMERA_DETAIL_BURST > CONFIG_CAMERA_BURST_MAX)
+#error "Camera profile burst lengths must not exceed CONFIG_CAMERA_BURST_MAX"
+#endif
+
+/*******************************************************************************
+ * MODE SWITCHING (voice <-> camera)
+ ******************************************************************************/
+
+// Keep the I2S channels (and their DMA) allocated across mode switches and only
+// disable/enable them; 0 restores the full audio_driver_deinit()/init() cycle
+#define CONFIG_MODE_SWITCH_KEEP_I2S         1
+
 /*******************************************************************************
  * FREERTOS TASK PRIORITIES (Priority Hierarchy)
  ******************************************************************************/
@@ -138,6 +280,7 @@
 #define TASK_PRIORITY_CAMERA_CAPTURE        6       // Frame acquisition (Core 1)
 #define TASK_PRIORITY_BUTTON_FSM            5       // Button handling (Core 0)
 #define TASK_PRIORITY_TTS_DECODER           7       // Increased from 5 to 7 for better TTS processing
+#define TASK_PRIORITY_LOG                   1       // Deferred log formatting (just above idle)
 
 // Core affinity
 #define TASK_CORE_PRO                       0       // Core 0 - I/O operations
@@ -155,6 +298,55 @@
 #define CONFIG_BUTTON_LONG_PRESS_MS         3000            // Long press threshold
 #define CONFIG_BUTTON_DOUBLE_CLICK_MAX_MS   250             // Double-click window
 
+/*******************************************************************************
+ * EVENT BUS CONFIGURATION
+ ******************************************************************************/
+
+#define CONFIG_EVENT_LANE_CONTROL_DEPTH     8               // Button/shutdown/error/link status
+#define CONFIG_EVENT_LANE_PIPELINE_DEPTH    16              // STT/TTS/VAD and pipeline stages
+#define CONFIG_EVENT_LANE_TELEMETRY_DEPTH   8               // Informational events
+#define CONFIG_EVENT_MAX_SUBSCRIBERS        24              // Total (type, handler) registrations
+
+#if (CONFIG_EVENT_LANE_CONTROL_DEPTH < 4)
+#error "CONFIG_EVENT_LANE_CONTROL_DEPTH must be at least 4"
+#endif
+
+/*******************************************************************************
+ * NETWORK PROFILE
+ ******************************************************************************/
+
+// "Latency" keeps the Wi-Fi modem awake and retries a dropped WebSocket almost
+// at once. "Battery" lets the modem sleep (WIFI_PS_MIN_MODEM) while no voice
+// session or upload is running and backs off further. The modem is always awake
+// during a session, so wake latency never lands inside a turn.
+#define CONFIG_NET_PROFILE_LATENCY          0
+#define CONFIG_NET_PROFILE_BATTERY          1
+#define CONFIG_NET_PROFILE                  CONFIG_NET_PROFILE_LATENCY
+
+#if CONFIG_NET_PROFILE == CONFIG_NET_PROFILE_LATENCY
+#define CONFIG_NET_IDLE_MODEM_SLEEP         0               // Power save outside sessions
+#define CONFIG_NET_RECONNECT_INITIAL_MS     250             // First retry after a failed/dropped connection
+#define CONFIG_NET_RECONNECT_MAX_MS         15000           // Backoff ceiling (doubles per failure)
+#elif CONFIG_NET_PROFILE == CONFIG_NET_PROFILE_BATTERY
+#define CONFIG_NET_IDLE_MODEM_SLEEP         1
+#define CONFIG_NET_RECONNECT_INITIAL_MS     2000
+#define CONFIG_NET_RECONNECT_MAX_MS         60000
+#else
+#error "CONFIG_NET_PROFILE must be CONFIG_NET_PROFILE_LATENCY or CONFIG_NET_PROFILE_BATTERY"
+#endif
+
+#define CONFIG_NET_CONNECT_ATTEMPT_MS       5000            // One connect (TCP + upgrade + handshake) may take this long
+
+// Socket tuning needs the WebSocket transport built in websocket_client.c
+// (ext_transport) so the socket and TLS context are reachable. TCP buffer
+// sizes are lwIP options: see sdkconfig.defaults.
+#define CONFIG_WS_TCP_NODELAY               1               // Nagle off: the TX task already coalesces small frames
+#define CONFIG_WS_TLS_SESSION_TICKETS       1               // wss:// only: resume TLS on reconnect (CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS)
+
+#if (CONFIG_NET_RECONNECT_INITIAL_MS < 100) || (CONFIG_NET_RECONNECT_INITIAL_MS > CONFIG_NET_RECONNECT_MAX_MS)
+#error "CONFIG_NET_RECONNECT_INITIAL_MS must be at least 100 and not above CONFIG_NET_RECONNECT_MAX_MS"
+#endif
+
 /*******************************************************************************
  * NETWORK CONFIGURATION (Using Kconfig - run 'idf.py menuconfig' to change)
  ******************************************************************************/
@@ -167,9 +359,36 @@
 // To change: Run 'idf.py menuconfig' -> "HotPin Network Configuration"
 #define CONFIG_WEBSOCKET_URI                "ws://" CONFIG_HOTPIN_SERVER_IP ":" TOSTRING(CONFIG_HOTPIN_SERVER_PORT) "/ws"
 #define CONFIG_WEBSOCKET_SESSION_ID         CONFIG_HOTPIN_SESSION_ID
-#define CONFIG_WEBSOCKET_RECONNECT_DELAY_MS 5000
+#define CONFIG_WEBSOCKET_RECONNECT_DELAY_MS CONFIG_NET_RECONNECT_INITIAL_MS
 #define CONFIG_WEBSOCKET_TIMEOUT_MS         30000
 #define CONFIG_AUTH_BEARER_TOKEN            CONFIG_HOTPIN_AUTH_TOKEN
+#define CONFIG_WS_BINARY_CONTROL            1               // Offer binary flow-control ACK frames at handshake (server may decline)
+
+// TTS downlink framing (tts_frame.h): a 16-byte header per frame with format and
+// sequence, explicit segment-flush and end frames. Servers that decline keep
+// sending one WAV stream per reply, which needs the WAV compatibility path.
+#define CONFIG_TTS_FRAMED_STREAM            1               // Offer framed TTS at handshake (server may decline)
+#define CONFIG_TTS_WAV_COMPAT               1               // Accept WAV-in-WebSocket replies (8 KB header staging buffer)
+
+#if !CONFIG_TTS_FRAMED_STREAM && !CONFIG_TTS_WAV_COMPAT
+#error "Enable CONFIG_TTS_FRAMED_STREAM or CONFIG_TTS_WAV_COMPAT, or no reply can be played"
+#endif
+
+// Outgoing frames go through one send queue drained by a dedicated TX task.
+// Queued entries reference the caller's memory (ring spans, JPEG buffers) until
+// their completion callback runs; runs of small frames are merged into one
+// wire frame of at most CONFIG_WS_TX_COALESCE_BYTES.
+#define CONFIG_WS_TX_QUEUE_DEPTH            8               // Frames waiting for the TX task
+#define CONFIG_WS_TX_COALESCE_BYTES         1400            // One TCP segment on a 1500-byte MTU
+#define CONFIG_WS_TX_SEND_TIMEOUT_MS        2000            // Single attempt per frame; a stalled socket fails the frame
+
+#if (CONFIG_WS_TX_QUEUE_DEPTH < 4) || (CONFIG_WS_TX_QUEUE_DEPTH > 32)
+#error "CONFIG_WS_TX_QUEUE_DEPTH must be between 4 and 32"
+#endif
+
+#if (CONFIG_WS_TX_COALESCE_BYTES < 256) || (CONFIG_WS_TX_COALESCE_BYTES > 4096)
+#error "CONFIG_WS_TX_COALESCE_BYTES must be between 256 and 4096"
+#endif
 
 /*******************************************************************************
  * WIFI CONFIGURATION (Using Kconfig)
@@ -180,6 +399,22 @@
 #define CONFIG_WIFI_MAXIMUM_RETRY           5
 #define CONFIG_WIFI_CONN_TIMEOUT_MS         10000
 
+// Fast reconnect: the AP's BSSID and channel from the last successful join are
+// kept in NVS, so the next boot connects without a full channel scan. One
+// failed attempt on the cached AP drops the cache and falls back to a scan.
+#define CONFIG_WIFI_FAST_RECONNECT          1
+#define CONFIG_WIFI_FAST_RECONNECT_NVS_NS   "wifi_fast"
+
+/*******************************************************************************
+ * BOOT SEQUENCE
+ ******************************************************************************/
+
+// Audio/prompt/pipeline init runs on the control core while the main task
+// brings up Wi-Fi, LED, button and HTTP; the WebSocket task starts before the
+// state manager so it connects as soon as an IP arrives
+#define CONFIG_BOOT_PARALLEL_INIT           1
+#define CONFIG_BOOT_MEDIA_INIT_TIMEOUT_MS   5000            // Parallel init must finish within this
+
 /*******************************************************************************
  * HTTP SERVER CONFIGURATION (Using Kconfig)
  ******************************************************************************/
@@ -189,6 +424,67 @@
 #define CONFIG_HTTP_IMAGE_ENDPOINT          "/image"                      // Image upload endpoint
 #define CONFIG_HTTP_TIMEOUT_MS              30000                         // HTTP request timeout
 
+/*******************************************************************************
+ * IMAGE TRANSPORT CONFIGURATION
+ ******************************************************************************/
+
+// Send captures as tagged binary frames on the session WebSocket; the HTTP
+// /image POST is only used when the socket is down or this is set to 0
+#define CONFIG_IMAGE_UPLOAD_OVER_WEBSOCKET  1
+#define CONFIG_WS_IMAGE_CHUNK_BYTES         (4 * 1024)                    // JPEG bytes per image frame
+#define CONFIG_WS_IMAGE_SEND_TIMEOUT_MS     2000                          // Per-frame send timeout
+
+#if (CONFIG_WS_IMAGE_CHUNK_BYTES < 512) || (CONFIG_WS_IMAGE_CHUNK_BYTES > 16384)
+#error "CONFIG_WS_IMAGE_CHUNK_BYTES must be between 512 and 16384"
+#endif
+
+/*******************************************************************************
+ * PROMPT STORE CONFIGURATION
+ ******************************************************************************/
+
+// Canned spoken prompts ("no connection", "couldn't understand") live in a
+// versioned pack in their own flash partition and play straight from the
+// memory-mapped image; without a valid pack the tone sequences are used.
+// The server pushes a newer pack as binary control frames after the handshake.
+#define CONFIG_PROMPT_STORE_ENABLED         1
+#define CONFIG_PROMPT_STORE_PARTITION       "prompts"       // Label in partitions.csv
+#define CONFIG_PROMPT_STORE_MAX_CLIPS       32              // Index entries accepted in one pack
+#define CONFIG_PROMPT_ADPCM_BLOCK_BYTES     512             // Stored ADPCM block: 4-byte state + 1016 samples
+
+#if (CONFIG_PROMPT_ADPCM_BLOCK_BYTES < 64) || (CONFIG_PROMPT_ADPCM_BLOCK_BYTES > 2048)
+#error "CONFIG_PROMPT_ADPCM_BLOCK_BYTES must be between 64 and 2048"
+#endif
+
+/*******************************************************************************
+ * MEMORY ARENA CONFIGURATION
+ ******************************************************************************/
+
+// Long-lived buffers are carved out of one reservation per region at boot
+// (memory_manager) and lent to subsystems, so session starts and mode switches
+// never go back to the heap for them. A borrow larger than its slot, or made
+// while the slot is lent out, is served from the heap and counted as a fallback.
+#define CONFIG_ARENA_ENABLED                1
+
+// PSRAM-bulk region
+#define CONFIG_ARENA_STT_RING_BYTES         CONFIG_STT_RING_BUFFER_SIZE
+#define CONFIG_ARENA_STT_PREROLL_BYTES      (CONFIG_STT_VAD_ENABLED ? \
+                                             ((CONFIG_AUDIO_SAMPLE_RATE * 2 * CONFIG_STT_VAD_PREROLL_MS) / 1000) : 0)
+#define CONFIG_ARENA_TTS_BLOCK_BYTES        (CONFIG_TTS_BLOCK_PAYLOAD_BYTES * 2 * CONFIG_TTS_BLOCK_COUNT)
+#define CONFIG_ARENA_TTS_RESAMPLE_BYTES     (CONFIG_TTS_DSP_RESAMPLE_ENABLED ? \
+                                             ((((CONFIG_TTS_BLOCK_PAYLOAD_BYTES / 2) + 1) * CONFIG_AUDIO_SAMPLE_RATE / \
+                                               CONFIG_TTS_RESAMPLE_MIN_RATE + 3) * 4) : 0)   // Stereo output at max upsampling
+#define CONFIG_ARENA_CAMERA_BURST_BYTES     (160 * 1024)    // Best-frame copy; larger JPEGs fall back to the heap
+#define CONFIG_ARENA_FEEDBACK_CACHE_BYTES   (CONFIG_FEEDBACK_TONE_CACHE_ENABLED ? \
+                                             ((CONFIG_AUDIO_SAMPLE_RATE * 2 * CONFIG_FEEDBACK_TONE_CACHE_MS) / 1000) : 0)
+#define CONFIG_ARENA_TRACE_BYTES            (CONFIG_TRACE_ENABLED ? (CONFIG_TRACE_RING_RECORDS * 16) : 0)
+
+// DMA-internal region (kept small: it competes with I2S and camera DMA)
+#define CONFIG_ARENA_STT_ENCODE_BYTES       (8 * 1024)      // Two IMA-ADPCM frames for the largest 8KB chunk (one encoding, one queued)
+
+#if CONFIG_ARENA_STT_ENCODE_BYTES > (8 * 1024)
+#error "CONFIG_ARENA_STT_ENCODE_BYTES is reserved from internal DMA RAM - keep it at or below 8KB"
+#endif
+
 /*******************************************************************************
  * MEMORY ALLOCATION HELPERS
  ******************************************************************************/
@@ -202,12 +498,60 @@
                                     memset(((uint8_t*)(ptr)) + (size), 0xAA, 16); \
                                     memset(((uint8_t*)(ptr)) + (size) + 16, 0xBB, 16)
 
+/*******************************************************************************
+ * TRACING
+ ******************************************************************************/
+
+// Hot-path spans (I2S, STT ring, WebSocket TX, TTS blocks, mode switches) are
+// written as fixed 16-byte records into a PSRAM ring with one atomic add and
+// no lock or log call; the serial 't' command dumps it as a Chrome trace.
+// With tracing off the TRACE_* macros compile to nothing.
+#define CONFIG_TRACE_ENABLED                1
+#define CONFIG_TRACE_RING_RECORDS           4096            // Power of two; oldest records are overwritten
+
+#if CONFIG_TRACE_ENABLED && (CONFIG_TRACE_RING_RECORDS & (CONFIG_TRACE_RING_RECORDS - 1))
+#error "CONFIG_TRACE_RING_RECORDS must be a power of two"
+#endif
+
+/*******************************************************************************
+ * TURN LATENCY TELEMETRY
+ ******************************************************************************/
+
+// Each turn carries an id in EOS; the server echoes it in its stage messages,
+// and after the turn the device reports its stage times (TURN_METRICS signal)
+// for the server's p50/p95/p99 at GET /metrics
+#define CONFIG_TURN_METRICS_ENABLED         1
+
 /*******************************************************************************
  * DEBUG CONFIGURATION
  ******************************************************************************/
 
 #define CONFIG_ENABLE_DEBUG_LOGS            1
-#define CONFIG_LOG_LEVEL                    ESP_LOG_INFO
+#define CONFIG_LOG_LEVEL                    ESP_LOG_INFO    // Runtime level, applied by log_manager_init()
+
+// Compile-time floors for the audio/network modules: each defines
+// LOG_LOCAL_LEVEL as its floor, so ESP_LOGx calls below it are not built in
+// (raise one to ESP_LOG_DEBUG to debug that module)
+#define CONFIG_LOG_FLOOR_AUDIO              CONFIG_LOG_LEVEL
+#define CONFIG_LOG_FLOOR_STT                CONFIG_LOG_LEVEL
+#define CONFIG_LOG_FLOOR_TTS                CONFIG_LOG_LEVEL
+#define CONFIG_LOG_FLOOR_WEBSOCKET          CONFIG_LOG_LEVEL
+
+// Per-call-site token bucket for LOGW_RL/LOGE_RL: a burst, then a steady rate
+#define CONFIG_LOG_RATE_BURST               5
+#define CONFIG_LOG_RATE_PER_SEC             1
+
+// Lines LOG_DEFERRED() can queue for the log task before dropping
+#define CONFIG_LOG_DEFER_QUEUE_DEPTH        32
+
+// UART command console (serial_commands.c). Off by default: it competes with
+// log output on UART0 during voice mode.
+#define CONFIG_SERIAL_COMMANDS_ENABLED      0
+
+// Hot-path micro-benchmarks (bench_suite.c): 'b' on the serial console, or the
+// host build in ../bench. Each case runs for at least CONFIG_BENCH_MIN_CASE_MS.
+#define CONFIG_BENCH_SUITE_ENABLED          1
+#define CONFIG_BENCH_MIN_CASE_MS            200
 
 // Component-specific log tags
 #define TAG_MAIN                            "HOTPIN_MAIN"
@@ -218,6 +562,14 @@
 #define TAG_BUTTON                          "BUTTON"
 #define TAG_STT                             "STT"
 #define TAG_TTS                             "TTS"
+#define TAG_VAD                             "VAD"
+#define TAG_CODEC                           "CODEC"
+#define TAG_PROMPTS                         "PROMPTS"
+#define TAG_TRACE                           "TRACE"
+#define TAG_TURN                            "TURN"
+#define TAG_LOG                             "LOG"
+#define TAG_BENCH                           "BENCH"
+#define TAG_NET                             "NET"
 
 /*******************************************************************************
  * VALIDATION MACROS
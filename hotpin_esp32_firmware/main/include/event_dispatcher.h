@@ -1,6 +1,11 @@
 /**
  * @file event_dispatcher.h
- * @brief Central event queue interface bridging producers to the FSM.
+ * @brief Central event bus bridging producers to the FSM.
+ *
+ * Events are routed into priority lanes by type. The consumer always drains
+ * the CONTROL lane first, so a shutdown or button press never waits behind
+ * a backlog of pipeline notifications. Consumers register per-type handlers
+ * and pump the bus from their own task with event_dispatcher_dispatch().
  */
 
 #ifndef EVENT_DISPATCHER_H
@@ -13,26 +18,91 @@ extern "C" {
 #endif
 
 /**
- * @brief Initialize the global event dispatcher and backing queue.
+ * @brief Delivery lanes, highest priority first.
+ *
+ * Ordering is preserved within a lane, not across lanes.
+ */
+typedef enum {
+    EVENT_LANE_CONTROL = 0,     ///< Button, shutdown, error, capture request, link status, barge-in
+    EVENT_LANE_PIPELINE,        ///< STT/TTS/VAD lifecycle and server pipeline stages
+    EVENT_LANE_TELEMETRY,       ///< Informational events (boot, capture complete)
+    EVENT_LANE_COUNT
+} event_lane_t;
+
+/**
+ * @brief Per-lane counters (latency measured from post to handler dispatch).
+ */
+typedef struct {
+    uint32_t posted;            ///< Events accepted into the lane
+    uint32_t delivered;         ///< Events handed to subscribers
+    uint32_t dropped;           ///< Events rejected because the lane was full
+    uint32_t coalesced;         ///< Duplicate pipeline stages folded into a pending one
+    uint32_t high_water;        ///< Deepest observed backlog
+    uint32_t max_latency_us;
+    uint32_t avg_latency_us;
+} event_lane_stats_t;
+
+/**
+ * @brief Subscriber callback, invoked from the task calling event_dispatcher_dispatch().
+ */
+typedef void (*event_dispatcher_handler_t)(const system_event_t *evt, void *ctx);
+
+/**
+ * @brief Initialize the global event dispatcher and its lane queues.
  *
  * This must be called before any producer attempts to post events.
  */
 void event_dispatcher_init(void);
 
 /**
- * @brief Retrieve the queue handle used by the dispatcher.
+ * @brief Check whether the dispatcher lanes were created successfully.
  */
-QueueHandle_t event_dispatcher_queue(void);
+bool event_dispatcher_is_ready(void);
 
 /**
  * @brief Enqueue an event for asynchronous processing.
  *
+ * A PIPELINE_STAGE event identical to the one most recently queued (and not
+ * yet dispatched) is coalesced and reported as success.
+ *
  * @param evt Event instance to push. Callers should zero unused fields.
- * @param timeout_ticks FreeRTOS ticks to wait if the queue is full.
- * @return true on success, false if the queue overflowed or dispatcher invalid.
+ * @param timeout_ticks FreeRTOS ticks to wait if the lane is full.
+ * @return true on success, false if the lane overflowed or dispatcher invalid.
  */
 bool event_dispatcher_post(const system_event_t *evt, TickType_t timeout_ticks);
 
+/**
+ * @brief Register a handler for one event type.
+ *
+ * @return ESP_ERR_NO_MEM when the subscriber table is full.
+ */
+esp_err_t event_dispatcher_subscribe(system_event_type_t type,
+                                     event_dispatcher_handler_t handler,
+                                     void *ctx);
+
+/**
+ * @brief Wait for the next event (highest lane first) and run its subscribers.
+ *
+ * @param timeout_ticks Maximum time to wait for an event.
+ * @return true if an event was dispatched, false on timeout.
+ */
+bool event_dispatcher_dispatch(TickType_t timeout_ticks);
+
+/**
+ * @brief Lane an event type is routed to.
+ */
+event_lane_t event_dispatcher_lane_for(system_event_type_t type);
+
+/**
+ * @brief Snapshot the counters of one lane.
+ */
+esp_err_t event_dispatcher_get_lane_stats(event_lane_t lane, event_lane_stats_t *stats);
+
+/**
+ * @brief Log per-lane counters.
+ */
+void event_dispatcher_log_stats(void);
+
 #ifdef __cplusplus
 }
 #endif
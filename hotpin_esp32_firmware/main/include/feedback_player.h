@@ -23,9 +23,22 @@ typedef enum {
     FEEDBACK_SOUND_TTS_COMPLETE     // Triple ascending beep for "response complete, ready for input"
 } feedback_sound_t;
 
+// Spoken prompts stored in the prompt pack (ids are part of the pack format)
+typedef enum {
+    FEEDBACK_PROMPT_NO_CONNECTION = 1,  // "I can't reach the server"
+    FEEDBACK_PROMPT_NOT_UNDERSTOOD,     // "Sorry, I didn't catch that"
+    FEEDBACK_PROMPT_SERVER_BUSY,        // "The server is busy, try again in a moment"
+    FEEDBACK_PROMPT_PROCESSING_ERROR    // "Something went wrong"
+} feedback_prompt_t;
+
 esp_err_t feedback_player_init(void);
 esp_err_t feedback_player_play(feedback_sound_t sound);
 
+/**
+ * @brief Play a stored spoken prompt, or the fallback tone if the pack lacks it
+ */
+esp_err_t feedback_player_play_prompt(feedback_prompt_t prompt, feedback_sound_t fallback);
+
 #ifdef __cplusplus
 }
 #endif
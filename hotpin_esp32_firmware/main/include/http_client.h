@@ -2,7 +2,9 @@
  * @file http_client.h
  * @brief HTTP client for camera image upload with multipart/form-data
  * 
- * Provides blocking image upload with Authorization bearer token
+ * Provides blocking image upload with Authorization bearer token. The
+ * multipart body is streamed from the caller's buffer over one keep-alive
+ * connection that is reused across captures.
  */
 
 #ifndef HTTP_CLIENT_H
@@ -35,6 +37,10 @@ esp_err_t http_client_deinit(void);
  * - session: session ID string
  * - file: JPEG binary data
  * 
+ * jpeg_data is written to the socket as-is (no copy), so it must stay valid
+ * until this call returns. A stale keep-alive socket is retried once on a
+ * fresh connection.
+ * 
  * @param session_id Session identifier string
  * @param jpeg_data Pointer to JPEG buffer
  * @param jpeg_len Length of JPEG data
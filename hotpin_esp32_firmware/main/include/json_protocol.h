@@ -5,14 +5,86 @@
  * Provides helpers to build protocol-compliant JSON messages:
  * - start: {"type":"start","session":"id","sampleRate":16000,"channels":1}
  * - end: {"type":"end","session":"id"}
+ * - handshake: {"session_id":"id","codecs":[...],"sample_rate":16000,"control":"binary","tts":"framed"}
+ *
+ * Also decodes server control messages without allocating: a fixed-schema
+ * scanner for the JSON status messages and the negotiated binary control frames.
  */
 
 #ifndef JSON_PROTOCOL_H
 #define JSON_PROTOCOL_H
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
+// Binary control frame (little-endian): magic, version, type, payload length, payload
+#define CONTROL_FRAME_MAGIC             "HPCT"
+#define CONTROL_FRAME_VERSION           1
+#define CONTROL_FRAME_HEADER_SIZE       8
+#define CONTROL_FRAME_TYPE_ACK          1       // Payload: u32 chunks, u32 bytes, u32 window
+#define CONTROL_FRAME_ACK_PAYLOAD_SIZE  12
+#define CONTROL_FRAME_TYPE_PROMPT_CHUNK 2       // Payload: u32 pack version, u32 pack size, u32 offset, pack bytes
+#define CONTROL_FRAME_PROMPT_CHUNK_HEADER 12
+
+// Fields present in a json_protocol_control_t
+#define JSON_PROTO_FIELD_STATUS             (1u << 0)
+#define JSON_PROTO_FIELD_STAGE              (1u << 1)
+#define JSON_PROTO_FIELD_MESSAGE            (1u << 2)
+#define JSON_PROTO_FIELD_TRANSCRIPT         (1u << 3)
+#define JSON_PROTO_FIELD_TRANSCRIPTION      (1u << 4)
+#define JSON_PROTO_FIELD_CODEC              (1u << 5)
+#define JSON_PROTO_FIELD_CAPTURE_PROFILE    (1u << 6)
+#define JSON_PROTO_FIELD_CONTROL            (1u << 7)
+#define JSON_PROTO_FIELD_CHUNKS_RECEIVED    (1u << 8)
+#define JSON_PROTO_FIELD_BYTES_RECEIVED     (1u << 9)
+#define JSON_PROTO_FIELD_WINDOW_BYTES       (1u << 10)
+#define JSON_PROTO_FIELD_FLOW_WINDOW        (1u << 11)
+#define JSON_PROTO_FIELD_SIZE_BYTES         (1u << 12)
+#define JSON_PROTO_FIELD_PROMPT_PACK        (1u << 13)
+#define JSON_PROTO_FIELD_PROMPT_CHUNK       (1u << 14)
+#define JSON_PROTO_FIELD_ERROR_TYPE         (1u << 15)
+#define JSON_PROTO_FIELD_TURN               (1u << 16)
+#define JSON_PROTO_FIELD_TTS                (1u << 17)
+
+/**
+ * @brief String value pointing into the received frame (not NUL-terminated, escapes kept)
+ */
+typedef struct {
+    const char *ptr;
+    size_t len;
+} json_protocol_str_t;
+
+/**
+ * @brief Decoded server control message
+ *
+ * Only the keys the device acts on are extracted; anything else is skipped.
+ */
+typedef struct {
+    uint32_t fields;                        // JSON_PROTO_FIELD_* bits
+    json_protocol_str_t status;
+    json_protocol_str_t stage;
+    json_protocol_str_t message;
+    json_protocol_str_t transcript;
+    json_protocol_str_t transcription;
+    json_protocol_str_t codec;
+    json_protocol_str_t capture_profile;
+    json_protocol_str_t control;
+    json_protocol_str_t error_type;          // Error class, e.g. "busy"
+    json_protocol_str_t tts;                 // Downlink framing the server chose ("framed" or "wav")
+    uint32_t chunks_received;
+    uint32_t bytes_received;
+    uint32_t window_bytes;
+    uint32_t flow_window;
+    uint32_t size_bytes;
+    uint32_t prompt_pack;                   // Server's prompt pack version (JSON key or chunk header)
+    uint32_t turn;                          // Turn id echoed from the device's EOS
+    uint32_t pack_size;                     // Prompt chunk: total pack length
+    uint32_t pack_offset;                   // Prompt chunk: offset of pack_data in the pack
+    const uint8_t *pack_data;               // Prompt chunk: bytes inside the received frame
+    size_t pack_data_len;
+} json_protocol_control_t;
+
 /**
  * @brief Build "start" JSON message for STT streaming
  * 
@@ -48,4 +120,61 @@ int json_protocol_build_end(const char *session_id, char *buffer, size_t buffer_
  */
 int json_protocol_generate_session_id(char *buffer, size_t buffer_size);
 
+/**
+ * @brief Build the session handshake
+ *
+ * Format: {"session_id":"<id>","codecs":["a","b"],"sample_rate":N,"prompt_pack":V[,"control":"binary"][,"tts":"framed"]}
+ *
+ * @param session_id Session identifier string
+ * @param codecs Offered uplink codec names in preference order
+ * @param codec_count Number of entries in codecs
+ * @param sample_rate Capture sample rate in Hz
+ * @param prompt_pack_version Version of the stored prompt pack (0 = none)
+ * @param binary_control Offer binary control frames
+ * @param framed_tts Offer the framed TTS downlink (tts_frame.h)
+ * @param buffer Output buffer
+ * @param buffer_size Size of output buffer
+ * @return Number of bytes written (excluding null terminator), or -1 on error
+ */
+int json_protocol_build_handshake(const char *session_id, const char *const *codecs, size_t codec_count,
+                                  uint32_t sample_rate, uint32_t prompt_pack_version, bool binary_control,
+                                  bool framed_tts, char *buffer, size_t buffer_size);
+
+/**
+ * @brief Scan a server JSON status message without allocating
+ *
+ * Accepts any well-formed top-level object; nested values and unknown keys are
+ * skipped. Numbers are truncated to unsigned 32-bit.
+ *
+ * @param data Message text (need not be NUL-terminated)
+ * @param len Message length
+ * @param msg Receives the extracted fields (zeroed first)
+ * @return true if the message was a well-formed object
+ */
+bool json_protocol_parse_control(const char *data, size_t len, json_protocol_control_t *msg);
+
+/**
+ * @brief Decode a binary control frame
+ *
+ * @param data Binary WebSocket payload
+ * @param len Payload length
+ * @param msg Receives the message in the same form as the JSON scanner
+ * @return true if the payload was a complete control frame of a known type
+ */
+bool json_protocol_decode_control_frame(const uint8_t *data, size_t len, json_protocol_control_t *msg);
+
+/**
+ * @brief Compare a scanned string with a literal
+ */
+bool json_protocol_str_equals(const json_protocol_str_t *str, const char *literal);
+
+/**
+ * @brief Copy a scanned string into a NUL-terminated buffer, resolving simple escapes
+ *
+ * \uXXXX sequences are copied verbatim. Output is truncated to fit.
+ *
+ * @return Number of characters written (excluding null terminator)
+ */
+size_t json_protocol_str_copy(const json_protocol_str_t *str, char *buffer, size_t buffer_size);
+
 #endif // JSON_PROTOCOL_H
@@ -0,0 +1,124 @@
+/**
+ * @file log_manager.h
+ * @brief Hot-path logging: compile-time floors, per-site rate limits, deferred formatting
+ *
+ * Three tools for code that runs per audio frame or per network chunk, where a
+ * synchronous UART write costs the deadline it is reporting on:
+ *
+ *  - Compile-time floors: a module defines LOG_LOCAL_LEVEL as its
+ *    CONFIG_LOG_FLOOR_* before its first include, so ESP_LOGx calls below the
+ *    floor are not built in at all:
+ *        #define LOG_LOCAL_LEVEL CONFIG_LOG_FLOOR_TTS
+ *    (config.h supplies the value; the macro is only expanded at each call)
+ *
+ *  - LOG_RATE_LIMITED(): a token bucket per call site. A burst passes, then at
+ *    most per_sec lines a second; the next line that gets through says how
+ *    many were swallowed.
+ *
+ *  - LOG_DEFERRED(): the caller only queues the format pointer and up to four
+ *    integer arguments; a low-priority task formats and prints them later. The
+ *    format must be a string literal, and %s arguments must be string literals
+ *    too (nothing on the caller's stack survives until printing). A full
+ *    queue drops the line and counts it, rather than blocking the caller.
+ */
+
+#ifndef LOG_MANAGER_H
+#define LOG_MANAGER_H
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "config.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ===========================
+// Rate Limiting
+// ===========================
+
+/**
+ * @brief Token bucket state for one call site (static at the site)
+ */
+typedef struct {
+    int64_t refill_us;                  // Last refill time; 0 = not used yet
+    uint32_t tokens;
+    uint32_t suppressed;                // Lines dropped since the last one printed
+} log_bucket_t;
+
+/**
+ * @brief Take a token from a call site's bucket
+ *
+ * @param suppressed_out Lines dropped since this site last printed (valid when true)
+ * @return true if the line may be printed
+ */
+bool log_manager_allow(log_bucket_t *bucket, uint32_t burst, uint32_t per_sec,
+                       uint32_t *suppressed_out);
+
+#define LOG_RATE_LIMITED(level, tag, burst, per_sec, fmt, ...) do {                         \
+    if (LOG_LOCAL_LEVEL >= (level)) {                                                       \
+        static log_bucket_t log_bucket_;                                                    \
+        uint32_t log_suppressed_ = 0;                                                       \
+        if (log_manager_allow(&log_bucket_, (burst), (per_sec), &log_suppressed_)) {        \
+            if (log_suppressed_ == 0) {                                                     \
+                ESP_LOG_LEVEL((level), (tag), fmt, ##__VA_ARGS__);                          \
+            } else {                                                                        \
+                ESP_LOG_LEVEL((level), (tag), fmt " [+%u suppressed]", ##__VA_ARGS__,       \
+                              (unsigned int)log_suppressed_);                               \
+            }                                                                               \
+        }                                                                                   \
+    }                                                                                       \
+} while (0)
+
+// Defaults for the common case (CONFIG_LOG_RATE_BURST lines, then CONFIG_LOG_RATE_PER_SEC a second)
+#define LOGW_RL(tag, fmt, ...)  LOG_RATE_LIMITED(ESP_LOG_WARN, tag, CONFIG_LOG_RATE_BURST, \
+                                                 CONFIG_LOG_RATE_PER_SEC, fmt, ##__VA_ARGS__)
+#define LOGE_RL(tag, fmt, ...)  LOG_RATE_LIMITED(ESP_LOG_ERROR, tag, CONFIG_LOG_RATE_BURST, \
+                                                 CONFIG_LOG_RATE_PER_SEC, fmt, ##__VA_ARGS__)
+
+// ===========================
+// Deferred Formatting
+// ===========================
+
+/**
+ * @brief Queue a line for the log task (use LOG_DEFERRED)
+ *
+ * Arguments beyond the fourth are ignored.
+ */
+void log_manager_defer(esp_log_level_t level, const char *tag, const char *fmt,
+                       uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3, ...);
+
+#define LOG_DEFERRED(level, tag, fmt, ...) do {                                             \
+    if (LOG_LOCAL_LEVEL >= (level)) {                                                       \
+        log_manager_defer((level), (tag), (fmt), ##__VA_ARGS__, 0, 0, 0, 0);                \
+    }                                                                                       \
+} while (0)
+
+#define LOGI_DEFER(tag, fmt, ...)   LOG_DEFERRED(ESP_LOG_INFO, tag, fmt, ##__VA_ARGS__)
+#define LOGD_DEFER(tag, fmt, ...)   LOG_DEFERRED(ESP_LOG_DEBUG, tag, fmt, ##__VA_ARGS__)
+
+// ===========================
+// Lifecycle
+// ===========================
+
+/**
+ * @brief Apply CONFIG_LOG_LEVEL at runtime and start the deferred log task
+ *
+ * Until this runs, deferred lines are printed synchronously.
+ *
+ * @return ESP_OK, or ESP_ERR_NO_MEM
+ */
+esp_err_t log_manager_init(void);
+
+/**
+ * @brief Deferred lines dropped because the queue was full
+ */
+uint32_t log_manager_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LOG_MANAGER_H
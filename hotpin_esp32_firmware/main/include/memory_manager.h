@@ -7,6 +7,7 @@
 #define MEMORY_MANAGER_H
 
 #include "esp_err.h"
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -92,6 +93,43 @@ typedef struct {
     uint32_t threshold_value;           // Threshold that triggered warning
 } memory_warning_t;
 
+/**
+ * @brief Arena region types (one boot-time reservation each)
+ */
+typedef enum {
+    MEMORY_REGION_DMA_INTERNAL = 0,     // Internal DMA-capable SRAM for hot-path scratch
+    MEMORY_REGION_PSRAM_BULK,           // External PSRAM for large streaming buffers
+    MEMORY_REGION_COUNT
+} memory_region_t;
+
+/**
+ * @brief Named arena slots lent to long-lived subsystem buffers
+ *
+ * Each slot lives in one region and is sized from config.h (CONFIG_ARENA_*).
+ */
+typedef enum {
+    MEMORY_SLOT_STT_RING = 0,           // STT capture ring buffer
+    MEMORY_SLOT_STT_VAD_PREROLL,        // VAD pre-roll history
+    MEMORY_SLOT_STT_UPLINK_ENCODE,      // Encoded uplink chunk
+    MEMORY_SLOT_TTS_BLOCKS,             // TTS playback block pool
+    MEMORY_SLOT_TTS_RESAMPLE,           // Resampled stereo TTS block
+    MEMORY_SLOT_CAMERA_BURST,           // Best-frame copy during burst capture
+    MEMORY_SLOT_FEEDBACK_CACHE,         // Pre-rendered feedback tones (held for the whole run)
+    MEMORY_SLOT_TRACE_RING,             // Span trace records (held for the whole run)
+    MEMORY_SLOT_COUNT
+} memory_slot_t;
+
+/**
+ * @brief Arena region usage
+ */
+typedef struct {
+    const char *name;                   // Region name for logs
+    uint32_t capacity;                  // Bytes reserved at boot (0 if the reservation failed)
+    uint32_t in_use;                    // Bytes currently lent out
+    uint32_t high_water;                // Most bytes lent out at once since boot
+    uint32_t heap_fallbacks;            // Borrows that had to be served from the heap
+} memory_region_stats_t;
+
 /**
  * @brief Memory warning callback function type
  * 
@@ -191,6 +229,54 @@ bool memory_manager_check_dma_available(size_t required_bytes);
  */
 bool memory_manager_check_psram_available(size_t required_bytes);
 
+/**
+ * @brief Reserve the arena regions
+ *
+ * Called by memory_manager_init(). A region whose reservation fails is left
+ * empty and its slots are served from the heap, so this is never fatal.
+ *
+ * @return ESP_OK if every region was reserved, ESP_ERR_NO_MEM otherwise
+ */
+esp_err_t memory_manager_arena_init(void);
+
+/**
+ * @brief Borrow a slot's buffer
+ *
+ * Returns the slot's boot-time storage when @p bytes fits and the slot is free.
+ * Otherwise the buffer comes from the heap with the slot's usual capabilities
+ * (counted as a fallback), so callers never need a second code path.
+ *
+ * @param slot Slot to borrow
+ * @param bytes Bytes needed
+ * @return Buffer (contents undefined) or NULL if the heap fallback also failed
+ */
+void *memory_manager_arena_acquire(memory_slot_t slot, size_t bytes);
+
+/**
+ * @brief Hand back a buffer obtained from memory_manager_arena_acquire()
+ *
+ * @param slot Slot it was borrowed from
+ * @param ptr Buffer (NULL is ignored; heap fallbacks are freed)
+ */
+void memory_manager_arena_release(memory_slot_t slot, void *ptr);
+
+/**
+ * @brief Bytes a slot can lend without falling back to the heap
+ *
+ * @param slot Slot to query
+ * @return Slot size, or 0 when its region could not be reserved
+ */
+size_t memory_manager_arena_slot_capacity(memory_slot_t slot);
+
+/**
+ * @brief Get usage and high-water mark of one arena region
+ *
+ * @param region Region to query
+ * @param stats Pointer to structure to receive statistics
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on bad arguments
+ */
+esp_err_t memory_manager_arena_get_region_stats(memory_region_t region, memory_region_stats_t *stats);
+
 /**
  * @brief Perform memory optimization
  * 
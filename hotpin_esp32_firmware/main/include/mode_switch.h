@@ -0,0 +1,95 @@
+/**
+ * @file mode_switch.h
+ * @brief Voice/camera mode-switch support: readiness events and phase timing
+ *
+ * Transitions wait on explicit readiness bits published by the pipeline
+ * (server stage, TTS drain) instead of polling with fixed sleeps, and every
+ * switch records how long each phase took.
+ */
+
+#ifndef MODE_SWITCH_H
+#define MODE_SWITCH_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Phases of a mode switch, in the order a transition runs them
+ */
+typedef enum {
+    MODE_PHASE_DRAIN = 0,       // Voice pipeline / TTS playback winding down
+    MODE_PHASE_LOCK,            // Waiting for the I2S configuration mutex
+    MODE_PHASE_AUDIO,           // I2S suspend / resume (or full init/deinit)
+    MODE_PHASE_CAMERA,          // Camera warm-up or release
+    MODE_PHASE_START,           // Starting the pipelines of the new mode
+    MODE_PHASE_COUNT
+} mode_switch_phase_t;
+
+/**
+ * @brief Timing of the most recent mode switch
+ */
+typedef struct {
+    const char *target;                     // "voice" or "camera"
+    esp_err_t result;
+    uint32_t total_ms;
+    uint32_t phase_ms[MODE_PHASE_COUNT];
+    uint32_t switch_count;                  // Switches since boot
+} mode_switch_report_t;
+
+/**
+ * @brief Create the readiness event group (idempotent)
+ */
+esp_err_t mode_switch_init(void);
+
+/**
+ * @brief Publish the server pipeline stage (called by websocket_client)
+ *
+ * @param active   true while transcription/llm/tts is running on the server
+ * @param complete true when the last reply finished ("complete")
+ */
+void mode_switch_set_pipeline_state(bool active, bool complete);
+
+/**
+ * @brief Block until the server pipeline is active or has completed
+ *
+ * @return true if the condition was met, false on timeout
+ */
+bool mode_switch_wait_pipeline_started(uint32_t timeout_ms);
+
+/**
+ * @brief Block until the server pipeline is no longer active
+ *
+ * @return true if the condition was met, false on timeout
+ */
+bool mode_switch_wait_pipeline_idle(uint32_t timeout_ms);
+
+/**
+ * @brief Start timing a switch towards target ("voice" / "camera")
+ */
+void mode_switch_begin(const char *target);
+
+/**
+ * @brief Attribute the time since the previous mark to phase
+ */
+void mode_switch_mark(mode_switch_phase_t phase);
+
+/**
+ * @brief Finish timing, log the per-phase breakdown and keep it as the last report
+ */
+void mode_switch_end(esp_err_t result);
+
+/**
+ * @brief Copy the most recent switch report
+ */
+void mode_switch_get_last(mode_switch_report_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODE_SWITCH_H
@@ -0,0 +1,57 @@
+/**
+ * @file network_profile.h
+ * @brief Latency/battery network profile: Wi-Fi power save and WebSocket socket tuning
+ *
+ * CONFIG_NET_PROFILE (config.h) picks the idle power-save level and reconnect
+ * backoff. Activities that need a responsive link (a voice session, an image
+ * upload) mark themselves active; the modem stays awake while any is active
+ * and drops back to the profile's idle level when the last one ends.
+ */
+
+#ifndef NETWORK_PROFILE_H
+#define NETWORK_PROFILE_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Activities that keep the modem awake (bit flags)
+ */
+typedef enum {
+    NET_ACTIVITY_VOICE  = (1U << 0),    // Voice mode: capture, server turn, TTS playback
+    NET_ACTIVITY_UPLOAD = (1U << 1),    // Image capture + upload
+} net_activity_t;
+
+/**
+ * @brief Apply the power-save level for the current activities
+ *
+ * Call once after esp_wifi_start(); before that, activity changes are only recorded.
+ */
+esp_err_t network_profile_apply_wifi(void);
+
+/**
+ * @brief Mark an activity started or finished (idempotent per activity)
+ */
+void network_profile_set_active(net_activity_t activity, bool active);
+
+/**
+ * @brief Tune a freshly connected WebSocket socket (TCP_NODELAY)
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG for a bad descriptor, ESP_FAIL if setsockopt failed
+ */
+esp_err_t network_profile_tune_socket(int sock);
+
+/**
+ * @brief "latency" or "battery"
+ */
+const char *network_profile_name(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NETWORK_PROFILE_H
@@ -0,0 +1,133 @@
+/**
+ * @file prompt_store.h
+ * @brief Flash-resident pack of pre-encoded spoken prompts
+ *
+ * The "prompts" partition holds one pack, memory-mapped at boot. Clips are
+ * read straight out of the mapping, so playing one needs no heap and no
+ * network round trip.
+ *
+ * Pack layout (little-endian):
+ *  - prompt_pack_header_t
+ *  - count x prompt_pack_entry_t
+ *  - clip data: PCM16 mono samples, or back-to-back IMA-ADPCM frames of
+ *    CONFIG_PROMPT_ADPCM_BLOCK_BYTES (the last one may be shorter), each in
+ *    the uplink frame format of audio_codec.h
+ *
+ * crc32 covers every byte after the header. The magic is written last, so a
+ * pack interrupted mid-update never validates.
+ */
+
+#ifndef PROMPT_STORE_H
+#define PROMPT_STORE_H
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ===========================
+// Constants
+// ===========================
+
+#define PROMPT_PACK_MAGIC               "HPPK"
+#define PROMPT_PACK_FORMAT              1
+
+#define PROMPT_CODEC_PCM16              0
+#define PROMPT_CODEC_IMA_ADPCM          1
+
+// ===========================
+// Type Definitions
+// ===========================
+
+typedef struct __attribute__((packed)) {
+    char magic[4];                      // PROMPT_PACK_MAGIC
+    uint8_t format;                     // PROMPT_PACK_FORMAT
+    uint8_t reserved;
+    uint16_t count;                     // Index entries that follow
+    uint32_t sample_rate;               // Must match CONFIG_AUDIO_SAMPLE_RATE
+    uint32_t version;                   // Content version assigned by the server (never 0)
+    uint32_t total_size;                // Header + index + clip data
+    uint32_t crc32;                     // esp_rom_crc32_le(0, ...) over bytes after the header
+} prompt_pack_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint16_t id;                        // feedback_prompt_t value
+    uint8_t codec;                      // PROMPT_CODEC_*
+    uint8_t reserved;
+    uint32_t offset;                    // From the start of the pack
+    uint32_t length;                    // Encoded bytes
+    uint32_t samples;                   // Decoded mono samples
+} prompt_pack_entry_t;
+
+/**
+ * @brief One clip, pointing into mapped flash
+ */
+typedef struct {
+    const uint8_t *data;
+    size_t length;
+    uint32_t samples;
+    uint8_t codec;
+} prompt_clip_t;
+
+// ===========================
+// Public Functions
+// ===========================
+
+/**
+ * @brief Map the prompt partition and validate the stored pack
+ *
+ * A missing partition or an invalid pack is not an error: lookups then fail
+ * and callers fall back to tones.
+ *
+ * @return ESP_OK
+ */
+esp_err_t prompt_store_init(void);
+
+/**
+ * @brief Version of the valid pack, 0 if none (sent in the handshake)
+ */
+uint32_t prompt_store_version(void);
+
+/**
+ * @brief Look up a clip and pin the mapping while it plays
+ *
+ * Fails while an update is being written. Every successful call must be
+ * paired with prompt_store_release().
+ *
+ * @return true if the clip exists in the current pack
+ */
+bool prompt_store_acquire(uint16_t id, prompt_clip_t *clip);
+
+/**
+ * @brief Unpin the mapping after playback
+ */
+void prompt_store_release(void);
+
+/**
+ * @brief Write the next chunk of a pushed pack
+ *
+ * Chunks must arrive in order from offset 0. The first chunk unmaps the old
+ * pack and starts erasing; the chunk ending at total_size verifies the CRC,
+ * writes the magic and maps the new pack. Any gap or failure abandons the
+ * update, leaving no valid pack until the next push.
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_STATE if a clip is playing, ESP_ERR_INVALID_SIZE /
+ *         ESP_ERR_INVALID_CRC for a bad pack, or a flash error
+ */
+esp_err_t prompt_store_write_chunk(uint32_t version, uint32_t total_size, uint32_t offset,
+                                   const uint8_t *data, size_t len);
+
+/**
+ * @brief Drop a partially written update (e.g. the socket closed mid-push)
+ */
+void prompt_store_abort_update(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PROMPT_STORE_H
@@ -70,14 +70,34 @@ void stt_pipeline_cancel_capture(void);
 const stt_pipeline_handle_t *stt_pipeline_get_handle(void);
 
 /**
- * @brief Update flow control state with server acknowledgment
+ * @brief Treat the running capture as full-duplex and arm barge-in
+ *
+ * The capture keeps running through the server's processing stages; the next
+ * speech onset above the speaker's echo posts SYSTEM_EVENT_BARGE_IN once.
+ * No-op when CONFIG_AUDIO_FULL_DUPLEX is 0 or nothing is recording.
+ */
+void stt_pipeline_arm_barge_in(void);
+
+/**
+ * @brief Stop treating speech onsets as barge-in (playback is over)
+ */
+void stt_pipeline_disarm_barge_in(void);
+
+/**
+ * @brief Whether the running capture was started over a playing reply
+ */
+bool stt_pipeline_is_duplex_capture(void);
+
+/**
+ * @brief Update flow control state with server acknowledgment / window advertisement
  * 
- * Called when server sends acknowledgment for received audio chunks.
- * This allows the streaming task to implement backpressure and prevent
- * send buffer overflow.
+ * Called when the server acknowledges received audio or advertises its receive
+ * window. Wakes the streaming task so it can send as soon as credit is available.
  * 
- * @param ack_chunk_number Chunk number acknowledged by server
+ * @param ack_chunk_number Cumulative chunks acknowledged by server (0 = none in this message)
+ * @param ack_bytes Cumulative bytes acknowledged by server (0 = not reported)
+ * @param window_bytes Server receive window in bytes (0 = unchanged)
  */
-void stt_pipeline_update_flow_control(uint32_t ack_chunk_number);
+void stt_pipeline_update_flow_control(uint32_t ack_chunk_number, uint32_t ack_bytes, uint32_t window_bytes);
 
 #endif // STT_PIPELINE_H
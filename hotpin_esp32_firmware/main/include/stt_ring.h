@@ -0,0 +1,180 @@
+/**
+ * @file stt_ring.h
+ * @brief Lock-free SPSC byte ring used between the STT capture and streaming tasks
+ *
+ * Head and tail are free-running byte counters; position = counter & (size - 1).
+ * Only the producer stores head, only the consumer stores tail. The consumer's
+ * read cursor runs ahead of tail over spans queued on the WebSocket but not yet
+ * written; tail only catches up when their send completes.
+ *
+ * Producer side: stt_ring_write(), stt_ring_available_space()
+ * Consumer side: stt_ring_peek_contiguous(), stt_ring_commit_read(),
+ *                stt_ring_unsent_data(), stt_ring_release_to()
+ * Either side:   stt_ring_available_data() (snapshot, may be stale by the time it is used)
+ *
+ * Header-only with no IDF dependencies beyond esp_err.h, so the host benchmark
+ * (bench/) measures exactly the code the pipeline runs.
+ */
+
+#ifndef STT_RING_H
+#define STT_RING_H
+
+#include "esp_err.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint8_t *data;
+    size_t size;                        // Power of two
+    _Atomic uint32_t head;              // Total bytes written (producer-owned)
+    _Atomic uint32_t tail;              // Total bytes released (consumer-owned)
+    uint32_t read;                      // Total bytes handed to the uplink (consumer-only)
+    atomic_bool flush_requested;        // Consumer drops pending data on next peek
+} stt_ring_t;
+
+/**
+ * @brief Only call while neither the producer nor the consumer is touching the ring
+ *
+ * Indices alone define valid data, so the storage is not zeroed.
+ */
+static inline void stt_ring_reset(stt_ring_t *ring) {
+    atomic_store_explicit(&ring->head, 0, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, 0, memory_order_relaxed);
+    ring->read = 0;
+    atomic_store_explicit(&ring->flush_requested, false, memory_order_release);
+}
+
+/**
+ * @brief Attach storage (size must be a power of two) and reset the counters
+ */
+static inline void stt_ring_init(stt_ring_t *ring, uint8_t *data, size_t size) {
+    ring->data = data;
+    ring->size = size;
+    stt_ring_reset(ring);
+}
+
+static inline size_t stt_ring_available_data(stt_ring_t *ring) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    return (size_t)(head - tail);
+}
+
+static inline size_t stt_ring_available_space(stt_ring_t *ring) {
+    return ring->size - stt_ring_available_data(ring);
+}
+
+/**
+ * @return ESP_OK, ESP_ERR_NO_MEM when full (live audio: the frame is lost), or an argument error
+ */
+static inline esp_err_t stt_ring_write(stt_ring_t *ring, const uint8_t *data, size_t len) {
+    if (data == NULL || len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (len > ring->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (ring->size - (size_t)(head - tail) < len) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    // At most two segments: up to the end of the buffer, then from the start
+    size_t pos = (size_t)head & (ring->size - 1U);
+    size_t first = ring->size - pos;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(ring->data + pos, data, first);
+    if (len > first) {
+        memcpy(ring->data, data + first, len - first);
+    }
+
+    // Publish the bytes only after they are in place
+    atomic_store_explicit(&ring->head, head + (uint32_t)len, memory_order_release);
+    return ESP_OK;
+}
+
+/**
+ * @brief Longest contiguous unsent span at the read cursor, up to max_len
+ *
+ * Honours a pending flush request on the consumer side: only the cursor skips
+ * ahead; tail follows once queued spans are written.
+ */
+static inline size_t stt_ring_peek_contiguous(stt_ring_t *ring, const uint8_t **span, size_t max_len) {
+    if (span == NULL) {
+        return 0;
+    }
+    *span = NULL;
+
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint32_t read = ring->read;
+
+    if (atomic_exchange_explicit(&ring->flush_requested, false, memory_order_acq_rel)) {
+        ring->read = head;
+        return 0;
+    }
+
+    size_t available = (size_t)(head - read);
+    if (available == 0) {
+        return 0;
+    }
+
+    size_t pos = (size_t)read & (ring->size - 1U);
+    size_t contiguous = ring->size - pos;
+    size_t len = (available < contiguous) ? available : contiguous;
+    if (len > max_len) {
+        len = max_len;
+    }
+
+    *span = ring->data + pos;
+    return len;
+}
+
+static inline void stt_ring_commit_read(stt_ring_t *ring, size_t len) {
+    if (len == 0) {
+        return;
+    }
+
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (len > (size_t)(head - ring->read)) {
+        len = (size_t)(head - ring->read);  // Never move past the producer
+    }
+    ring->read += (uint32_t)len;
+}
+
+static inline size_t stt_ring_unsent_data(stt_ring_t *ring) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    return (size_t)(head - ring->read);
+}
+
+/**
+ * @brief Free everything up to pos (a read-cursor value) for the producer
+ */
+static inline void stt_ring_release_to(stt_ring_t *ring, uint32_t pos) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    if ((pos - tail) > (ring->read - tail)) {
+        return;  // Behind tail or past the cursor: nothing to release
+    }
+
+    // Release ordering: the producer must not reuse the span before the send is done with it
+    atomic_store_explicit(&ring->tail, pos, memory_order_release);
+}
+
+static inline void stt_ring_request_flush(stt_ring_t *ring) {
+    atomic_store_explicit(&ring->flush_requested, true, memory_order_release);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STT_RING_H
@@ -52,7 +52,10 @@ typedef enum {
     SYSTEM_EVENT_STT_STOPPED,
     SYSTEM_EVENT_TTS_PLAYBACK_STARTED,
     SYSTEM_EVENT_TTS_PLAYBACK_FINISHED,
-    SYSTEM_EVENT_PIPELINE_STAGE
+    SYSTEM_EVENT_PIPELINE_STAGE,
+    SYSTEM_EVENT_VAD_SPEECH_START,
+    SYSTEM_EVENT_VAD_SPEECH_END,
+    SYSTEM_EVENT_BARGE_IN
 } system_event_type_t;
 
 /**
@@ -79,6 +82,11 @@ typedef struct {
         struct {
             esp_err_t result;
         } tts;
+        struct {
+            uint32_t speech_ms;     // Utterance length so far (onset or full utterance)
+            uint16_t energy;        // Mean |sample| of the deciding frame
+            bool auto_eos;          // SPEECH_END only: capture stopped and EOS will follow
+        } vad;                      // Also carries BARGE_IN (onset over playback)
     } data;
 } system_event_t;
 
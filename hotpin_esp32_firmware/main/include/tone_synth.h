@@ -0,0 +1,61 @@
+/**
+ * @file tone_synth.h
+ * @brief Fixed-point DDS renderer for the feedback tones
+ *
+ * 32-bit phase accumulators index a Q15 sine table with linear interpolation;
+ * noise is xorshift32. Rendering is mono at CONFIG_AUDIO_SAMPLE_RATE and has
+ * no driver dependencies, so the host benchmark (bench/) runs the same code.
+ */
+
+#ifndef TONE_SYNTH_H
+#define TONE_SYNTH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    bool is_noise;
+    float primary_freq_hz;
+    float secondary_freq_hz;
+    uint32_t duration_ms;
+    float amplitude;
+} tone_segment_t;
+
+// Oscillator state for one sequence (phase carries across its segments)
+typedef struct {
+    uint32_t phase_a;
+    uint32_t phase_b;
+    uint32_t noise;                     // xorshift32 state
+} tone_synth_state_t;
+
+/**
+ * @brief Build the sine table (idempotent; the only floating-point trig)
+ */
+void tone_synth_init(void);
+
+/**
+ * @brief Restart phases for a new sequence
+ *
+ * @param noise_seed Non-zero xorshift32 seed
+ */
+void tone_synth_reset(tone_synth_state_t *state, uint32_t noise_seed);
+
+/**
+ * @brief Render one segment as mono PCM into dst
+ *
+ * Tones get a short fade in/out so segments join without clicks; dual tones are
+ * halved to stay clear of clipping.
+ */
+void tone_synth_render_segment(tone_synth_state_t *state, const tone_segment_t *segment,
+                               int16_t *dst, size_t frame_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TONE_SYNTH_H
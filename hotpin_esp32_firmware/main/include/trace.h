@@ -0,0 +1,136 @@
+/**
+ * @file trace.h
+ * @brief Hot-path timing spans recorded into a lock-free PSRAM ring
+ *
+ * A span costs two esp_timer reads, one atomic add and a 16-byte store - no
+ * lock, no log call - so it can sit on the audio and network paths without
+ * moving the timings it measures. The ring keeps the most recent
+ * CONFIG_TRACE_RING_RECORDS records and is dumped on demand as Chrome trace
+ * JSON (chrome://tracing, Perfetto): one process per core, one thread per
+ * span id.
+ *
+ * Usage:
+ *   TRACE_SPAN_BEGIN(send);
+ *   ... work ...
+ *   TRACE_SPAN_END(send, TRACE_ID_WS_SEND, bytes);
+ *
+ *   TRACE_INSTANT(TRACE_ID_STATE, new_state);
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "config.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ===========================
+// Type Definitions
+// ===========================
+
+/**
+ * @brief Span identifiers (add the name to trace.c when adding one)
+ */
+typedef enum {
+    TRACE_ID_NONE = 0,
+    TRACE_ID_I2S_RX_FETCH,              // Completed RX DMA buffers taken by the capture task (arg: buffers)
+    TRACE_ID_STT_RING_WRITE,            // Capture frame copied into the STT ring (arg: bytes)
+    TRACE_ID_WS_SEND,                   // One WebSocket wire frame written (arg: bytes)
+    TRACE_ID_TTS_BLOCK_RECV,            // Playback task waiting for the next TTS block (arg: bytes, 0 on timeout)
+    TRACE_ID_I2S_TX_WRITE,              // audio_driver_write() into the TX DMA (arg: bytes)
+    TRACE_ID_MODE_SWITCH,               // Camera/voice mode transition (arg: target system_state_t)
+    TRACE_ID_STATE,                     // FSM state change, instant (arg: old << 8 | new)
+    TRACE_ID_COUNT
+} trace_id_t;
+
+/**
+ * @brief One ring record (16 bytes)
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t start_us;                  // Low 32 bits of esp_timer_get_time()
+    uint32_t dur_us;                    // 0 for instants
+    uint32_t arg;
+    uint8_t id;                         // trace_id_t
+    uint8_t core;
+    uint16_t flags;                     // TRACE_FLAG_*
+} trace_record_t;
+
+#define TRACE_FLAG_INSTANT              0x0001
+
+_Static_assert(sizeof(trace_record_t) == 16, "trace_record_t must stay 16 bytes (CONFIG_ARENA_TRACE_BYTES)");
+
+// ===========================
+// Recording
+// ===========================
+
+#if CONFIG_TRACE_ENABLED
+
+#define TRACE_SPAN_BEGIN(name)          const uint32_t name##_trace_start = trace_now_us()
+#define TRACE_SPAN_END(name, id, arg)   trace_record_span((id), name##_trace_start, (uint32_t)(arg))
+#define TRACE_INSTANT(id, arg)          trace_record_instant((id), (uint32_t)(arg))
+
+#else
+
+#define TRACE_SPAN_BEGIN(name)          ((void)0)
+#define TRACE_SPAN_END(name, id, arg)   ((void)0)
+#define TRACE_INSTANT(id, arg)          ((void)0)
+
+#endif
+
+static inline uint32_t trace_now_us(void) {
+    return (uint32_t)esp_timer_get_time();
+}
+
+/**
+ * @brief Record a finished span (use TRACE_SPAN_END)
+ */
+void trace_record_span(trace_id_t id, uint32_t start_us, uint32_t arg);
+
+/**
+ * @brief Record a point event (use TRACE_INSTANT)
+ */
+void trace_record_instant(trace_id_t id, uint32_t arg);
+
+// ===========================
+// Control
+// ===========================
+
+/**
+ * @brief Borrow the ring from the memory arena and start recording
+ *
+ * Call after memory_manager_init(). Without a ring every record is a no-op.
+ *
+ * @return ESP_OK, or ESP_ERR_NO_MEM
+ */
+esp_err_t trace_init(void);
+
+/**
+ * @brief Pause or resume recording
+ */
+void trace_set_enabled(bool enabled);
+
+/**
+ * @brief Discard every recorded span
+ */
+void trace_clear(void);
+
+/**
+ * @brief Print the ring to stdout as Chrome trace JSON, oldest record first
+ *
+ * Recording pauses while printing, so the dump itself never shows up in the
+ * trace. The JSON sits between "=== TRACE BEGIN ===" and "=== TRACE END ==="
+ * lines for cutting out of a serial log.
+ */
+void trace_dump_chrome(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TRACE_H
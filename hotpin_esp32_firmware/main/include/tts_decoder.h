@@ -2,17 +2,33 @@
  * @file tts_decoder.h
  * @brief Text-to-speech audio decoder
  * 
- * Handles WAV audio reception from WebSocket and playback via I2S TX
+ * Handles TTS audio reception from WebSocket and playback via I2S TX, either
+ * as framed PCM (tts_frame.h, negotiated) or as a legacy WAV stream
  */
 
 #ifndef TTS_DECODER_H
 #define TTS_DECODER_H
 
 #include "esp_err.h"
+#include "tts_frame.h"
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
 
+/**
+ * @brief Jitter buffer counters (cumulative since boot, except the "last" fields)
+ */
+typedef struct {
+    uint32_t underruns;             ///< Playback ran dry mid-reply and was concealed
+    uint32_t overruns;              ///< Received chunks dropped because the block pool stayed full
+    uint32_t overrun_bytes;         ///< Bytes lost to overruns
+    uint32_t concealed_ms;          ///< Fade/silence inserted by underrun concealment
+    uint32_t jitter_ms;             ///< Current inter-arrival jitter estimate
+    uint32_t prebuffer_target_ms;   ///< Audio the next (re)start waits for
+    uint32_t last_prebuffer_ms;     ///< Audio buffered when playback last started
+    uint32_t last_start_delay_ms;   ///< First received byte to first played sample, last reply
+} tts_jitter_stats_t;
+
 /**
  * @brief Initialize TTS decoder
  * 
@@ -47,6 +63,17 @@ esp_err_t tts_decoder_start(void);
  */
 esp_err_t tts_decoder_stop(void);
 
+/**
+ * @brief Cut the current reply short (barge-in)
+ *
+ * Asks the playback task to exit at its next block boundary instead of
+ * deleting it. TTS_PLAYBACK_FINISHED is still posted; the completion chime
+ * is skipped.
+ *
+ * @return ESP_ERR_INVALID_STATE if no playback task is running
+ */
+esp_err_t tts_decoder_interrupt(void);
+
 /**
  * @brief Check if TTS is currently playing
  * 
@@ -108,6 +135,23 @@ void tts_decoder_reset_session(void);
  */
 void tts_decoder_notify_end_of_stream(void);
 
+/**
+ * @brief Declare the format of the framed audio that follows
+ *
+ * Called from the WebSocket receive path before each AUDIO frame's payload is
+ * delivered. A change closes the block being filled, so every playback block
+ * has one format and the switch happens in order, between sentences.
+ */
+void tts_decoder_set_stream_format(const tts_stream_format_t *format);
+
+/**
+ * @brief End of a framed segment (FLUSH frame)
+ *
+ * Publishes the partly filled block and lets playback start below the jitter
+ * prebuffer target: a short sentence plays while the next is synthesized.
+ */
+void tts_decoder_end_segment(void);
+
 /**
  * @brief Flush and reset TTS decoder completely for session transition
  * 
@@ -117,4 +161,11 @@ void tts_decoder_notify_end_of_stream(void);
  */
 esp_err_t tts_decoder_flush_and_reset(void);
 
+/**
+ * @brief Snapshot the playback jitter buffer counters
+ *
+ * @return ESP_ERR_INVALID_ARG if stats is NULL
+ */
+esp_err_t tts_decoder_get_jitter_stats(tts_jitter_stats_t *stats);
+
 #endif // TTS_DECODER_H
@@ -0,0 +1,99 @@
+/**
+ * @file tts_frame.h
+ * @brief Framed TTS downlink: a fixed header per WebSocket frame instead of one WAV stream
+ *
+ * Negotiated at handshake ("tts": "framed"). Every frame says what it carries,
+ * so the device needs no header accumulation and replies of unknown length
+ * end on an explicit frame rather than a byte count:
+ *
+ *   [0..3]   magic "HPAU"
+ *   [4]      version (TTS_FRAME_VERSION)
+ *   [5]      type (TTS_FRAME_TYPE_*)
+ *   [6]      codec (TTS_FRAME_CODEC_*)
+ *   [7]      channels
+ *   [8..11]  sample rate, Hz (u32 LE)
+ *   [12..15] sequence number, from 0 per reply (u32 LE)
+ *   [16..]   payload (AUDIO only)
+ *
+ * Format fields are valid on every frame, so a reply can switch rate or
+ * channel count between sentences. Pure parsing, shared with bench/.
+ */
+
+#ifndef TTS_FRAME_H
+#define TTS_FRAME_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TTS_FRAME_MAGIC             "HPAU"
+#define TTS_FRAME_VERSION           1
+#define TTS_FRAME_HEADER_SIZE       16
+
+#define TTS_FRAME_TYPE_AUDIO        1       // Payload: samples in the frame's format
+#define TTS_FRAME_TYPE_FLUSH        2       // End of a segment (sentence): play what is queued now
+#define TTS_FRAME_TYPE_END          3       // End of the reply (replaces the zero-length frame)
+
+#define TTS_FRAME_CODEC_PCM16       1       // Signed 16-bit little-endian, interleaved
+
+#define TTS_FRAME_MIN_RATE          8000
+#define TTS_FRAME_MAX_RATE          48000
+
+/**
+ * @brief Audio format carried by a frame (sample_rate 0 = not set)
+ */
+typedef struct {
+    uint32_t sample_rate;
+    uint8_t channels;
+    uint8_t codec;
+} tts_stream_format_t;
+
+/**
+ * @brief Decoded frame; payload points into the received buffer
+ */
+typedef struct {
+    uint8_t type;
+    tts_stream_format_t format;
+    uint32_t seq;
+    const uint8_t *payload;
+    size_t payload_len;
+} tts_frame_t;
+
+/**
+ * @brief True when a binary payload starts with the frame magic and version
+ *
+ * A legacy WAV stream never does (it starts with "RIFF" or raw PCM), but only
+ * check once framing was negotiated: raw PCM could match by chance.
+ */
+bool tts_frame_is_framed(const uint8_t *data, size_t len);
+
+/**
+ * @brief Decode and validate one frame
+ *
+ * @return ESP_OK; ESP_ERR_INVALID_SIZE (truncated header, or a payload that is
+ *         not whole samples); ESP_ERR_NOT_SUPPORTED (unknown version, type or
+ *         codec); ESP_ERR_INVALID_ARG (bad arguments, rate or channel count)
+ */
+esp_err_t tts_frame_parse(const uint8_t *data, size_t len, tts_frame_t *frame);
+
+/**
+ * @brief Bytes per second of PCM in a format (0 if unset)
+ */
+static inline uint32_t tts_stream_format_byte_rate(const tts_stream_format_t *format) {
+    return format->sample_rate * format->channels * 2U;
+}
+
+static inline bool tts_stream_format_equal(const tts_stream_format_t *a, const tts_stream_format_t *b) {
+    return a->sample_rate == b->sample_rate && a->channels == b->channels && a->codec == b->codec;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TTS_FRAME_H
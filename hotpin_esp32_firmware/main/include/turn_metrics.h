@@ -0,0 +1,75 @@
+/**
+ * @file turn_metrics.h
+ * @brief Per-turn latency breakdown, correlated with the server by turn id
+ *
+ * A turn starts when the user stops speaking (button release or VAD end of
+ * speech) and gets its id when EOS is sent ({"signal":"EOS","turn":N}). The
+ * server echoes the id in every stage message of that turn, so replies from an
+ * older turn never land on the current one. Each stage is timed from the
+ * start on the device clock; once the turn ends the breakdown is logged and
+ * sent to the server as {"signal":"TURN_METRICS",...} for aggregation.
+ */
+
+#ifndef TURN_METRICS_H
+#define TURN_METRICS_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Turn stages, in the order they normally happen (each recorded once)
+ */
+typedef enum {
+    TURN_MARK_EOS_SENT = 0,             // EOS written to the socket (uplink drained)
+    TURN_MARK_TRANSCRIPTION,            // Server acknowledged EOS (stage "transcription")
+    TURN_MARK_TRANSCRIPT,               // Transcript back, LLM running (stage "llm")
+    TURN_MARK_REPLY,                    // First reply text (stage "tts")
+    TURN_MARK_FIRST_AUDIO,              // First TTS byte received
+    TURN_MARK_FIRST_SAMPLE,             // First TTS sample written to I2S
+    TURN_MARK_COMPLETE,                 // Server reported "complete"
+    TURN_MARK_COUNT
+} turn_mark_t;
+
+/**
+ * @brief Note the moment the user stopped speaking (start of the next turn)
+ */
+void turn_metrics_speech_ended(void);
+
+/**
+ * @brief Open a turn as EOS goes out; a turn still open is dropped unreported
+ *
+ * @return Turn id to put in the EOS signal (0 if telemetry is disabled)
+ */
+uint32_t turn_metrics_begin(void);
+
+/**
+ * @brief Record a stage of the open turn (later calls for the same stage are ignored)
+ */
+void turn_metrics_mark(turn_mark_t mark);
+
+/**
+ * @brief Whether a turn id echoed by the server belongs to the open turn
+ */
+bool turn_metrics_is_current(uint32_t turn);
+
+/**
+ * @brief Close the open turn, log its breakdown and report it to the server
+ *
+ * Call from the state manager task (it sends on the WebSocket). No-op if no
+ * turn is open.
+ *
+ * @param result Outcome sent with the report: "complete", "error", "interrupted", ...
+ * @return ESP_OK, ESP_ERR_INVALID_STATE if no turn is open, or the send error
+ */
+esp_err_t turn_metrics_finish(const char *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TURN_METRICS_H
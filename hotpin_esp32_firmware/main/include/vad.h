@@ -0,0 +1,90 @@
+/**
+ * @file vad.h
+ * @brief Lightweight energy + zero-crossing voice activity detector.
+ *
+ * Runs on 16-bit mono PCM straight out of the RX DMA path. Samples are analysed
+ * in CONFIG_STT_VAD_FRAME_MS frames; partial frames are carried across calls so
+ * any DMA buffer length can be fed in. Pure integer math, no allocation.
+ */
+
+#ifndef VAD_H
+#define VAD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    VAD_EVENT_NONE = 0,
+    VAD_EVENT_SPEECH_START,     // Onset confirmed (CONFIG_STT_VAD_ONSET_MS of speech)
+    VAD_EVENT_SPEECH_END        // CONFIG_STT_VAD_HANGOVER_MS of silence after speech
+} vad_event_t;
+
+/**
+ * @brief Detector state. Treat as opaque; one instance per capture stream.
+ */
+typedef struct {
+    // Frame accumulators (carried across vad_process calls)
+    uint32_t frame_abs_sum;
+    uint16_t frame_samples;
+    uint16_t frame_crossings;
+    int16_t prev_sign;
+    int32_t dc_q8;              // DC offset estimate, Q8
+
+    // Adaptive noise floor (mean |sample|, Q4)
+    uint32_t noise_q4;
+
+    // Decision state
+    bool in_speech;
+    uint16_t onset_ms;
+    uint16_t silence_ms;
+    uint32_t speech_ms;         // Length of the current/last utterance
+    uint16_t last_energy;       // Mean |sample| of the last frame (diagnostics)
+    uint16_t last_zcr;          // Zero crossings of the last frame (diagnostics)
+
+    // Predicted speaker echo (mean |sample|); 0 when the speaker is idle
+    uint16_t echo_floor;
+} vad_state_t;
+
+/**
+ * @brief Reset a detector to the silence state with a default noise floor
+ */
+void vad_init(vad_state_t *vad);
+
+/**
+ * @brief Feed PCM samples into the detector
+ *
+ * @param vad Detector state
+ * @param samples 16-bit mono samples
+ * @param count Number of samples
+ * @return The speech/silence transition produced by this block, if any
+ */
+vad_event_t vad_process(vad_state_t *vad, const int16_t *samples, size_t count);
+
+/**
+ * @brief Set the expected speaker echo level for the following samples
+ *
+ * Frames at or below the echo floor are never speech and do not move the noise
+ * floor, so playback neither triggers the gate nor desensitises it afterwards.
+ */
+static inline void vad_set_echo_floor(vad_state_t *vad, uint16_t floor) {
+    vad->echo_floor = floor;
+}
+
+/**
+ * @brief Whether the detector currently considers the stream to be speech
+ *        (including the hangover period)
+ */
+static inline bool vad_in_speech(const vad_state_t *vad) {
+    return vad->in_speech;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VAD_H
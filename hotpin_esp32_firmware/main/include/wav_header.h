@@ -0,0 +1,58 @@
+/**
+ * @file wav_header.h
+ * @brief RIFF/WAVE header parser for the TTS stream
+ *
+ * Pure parsing (no driver or task state), shared by tts_decoder.c and the host
+ * benchmark in bench/.
+ */
+
+#ifndef WAV_HEADER_H
+#define WAV_HEADER_H
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Pipelined server TTS sends the header before the reply length is known and marks
+// the RIFF/data sizes as 0xFFFFFFFF; end of audio is then signalled only by the EOS frame
+#define WAV_STREAMING_DATA_SIZE 0xFFFFFFFFu
+#define WAV_DATA_SIZE_IS_KNOWN(size) ((size) != 0 && (size) != WAV_STREAMING_DATA_SIZE)
+
+/**
+ * @brief Runtime WAV metadata extracted from the RIFF header
+ */
+typedef struct {
+    uint16_t audio_format;   // Should be 1 (PCM)
+    uint16_t num_channels;   // 1 = mono, 2 = stereo
+    uint32_t sample_rate;    // Samples per second (e.g., 16000)
+    uint32_t byte_rate;      // sample_rate * channels * bits_per_sample / 8
+    uint16_t block_align;    // channels * bits_per_sample / 8
+    uint16_t bits_per_sample;// Typically 16 for PCM
+    uint32_t data_size;      // Bytes of PCM data reported by header
+} wav_header_info_t;
+
+/**
+ * @brief Parse an accumulated header buffer
+ *
+ * The RIFF tag need not be at the start: in streaming, PCM can arrive ahead of
+ * the header, and the bytes before it are skipped.
+ *
+ * @param buffer Bytes received so far
+ * @param length Number of bytes in buffer
+ * @param info Filled on success only
+ * @param header_consumed Bytes up to the first PCM byte (RIFF offset included), may be NULL
+ * @return ESP_OK; ESP_ERR_INVALID_SIZE when more data is needed; ESP_ERR_INVALID_ARG
+ *         (no RIFF yet, bad WAVE tag, non-PCM format) or ESP_FAIL (bad fmt chunk)
+ */
+esp_err_t wav_header_parse(const uint8_t *buffer, size_t length, wav_header_info_t *info,
+                           size_t *header_consumed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WAV_HEADER_H
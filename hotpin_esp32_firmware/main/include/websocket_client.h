@@ -9,10 +9,51 @@
 #define WEBSOCKET_CLIENT_H
 
 #include "esp_err.h"
+#include "audio_codec.h"
+#include "feedback_player.h"
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
 
+// ===========================
+// Image Frame Format
+// ===========================
+
+/*
+ * Captured JPEGs travel as binary frames on the same socket as uplink audio.
+ * Every frame starts with this 12-byte little-endian header so the server can
+ * tell it apart from PCM/ADPCM without any text signalling:
+ *
+ *   [0..3]  magic "HPIM"
+ *   [4]     version (WS_IMAGE_FRAME_VERSION)
+ *   [5]     flags (WS_IMAGE_FLAG_FIRST / WS_IMAGE_FLAG_LAST)
+ *   [6..7]  uint16 chunk sequence, 0 on the first frame
+ *   [8..11] uint32 total JPEG length
+ *
+ * followed by up to CONFIG_WS_IMAGE_CHUNK_BYTES of JPEG data.
+ */
+#define WS_IMAGE_FRAME_MAGIC        "HPIM"
+#define WS_IMAGE_FRAME_VERSION      1
+#define WS_IMAGE_FRAME_HEADER_SIZE  12
+#define WS_IMAGE_FLAG_FIRST         0x01
+#define WS_IMAGE_FLAG_LAST          0x02
+
+// ===========================
+// Send Queue
+// ===========================
+
+/*
+ * All outgoing frames except the handshake pass through one FIFO drained by
+ * the WebSocket TX task, so producers never block on the socket. A queued
+ * frame references the caller's header (copied, up to WEBSOCKET_TX_MAX_HEADER
+ * bytes) and payload (not copied); the payload must stay valid until the
+ * frame's completion callback has run. Header and payload go out as a single
+ * WebSocket message.
+ */
+#define WEBSOCKET_TX_MAX_HEADER     16
+#define WEBSOCKET_TX_FLAG_COALESCE  0x01    // May share a wire frame with adjacent small frames
+#define WEBSOCKET_TX_FLAG_TEXT      0x02    // Text frame (never coalesced)
+
 // ===========================
 // Callback Types
 // ===========================
@@ -52,6 +93,33 @@ typedef enum {
  */
 typedef void (*websocket_status_callback_t)(websocket_status_t status, void *arg);
 
+/**
+ * @brief Completion callback for a queued frame
+ *
+ * Runs exactly once per accepted frame, on the WebSocket TX task; keep it short
+ * and never send from it.
+ *
+ * @param result ESP_OK once written to the socket, ESP_ERR_TIMEOUT if the socket
+ *               did not take it within CONFIG_WS_TX_SEND_TIMEOUT_MS,
+ *               ESP_ERR_INVALID_STATE if the link dropped first, ESP_FAIL otherwise
+ * @param send_ms Time the socket write of the wire frame carrying it took
+ * @param ctx Caller context from websocket_tx_frame_t
+ */
+typedef void (*websocket_tx_done_cb_t)(esp_err_t result, uint32_t send_ms, void *ctx);
+
+/**
+ * @brief One outgoing frame for websocket_client_submit()
+ */
+typedef struct {
+    const uint8_t *header;              // Optional prefix, copied at submit time
+    size_t header_len;                  // <= WEBSOCKET_TX_MAX_HEADER
+    const uint8_t *payload;             // Referenced until done runs
+    size_t payload_len;
+    uint8_t flags;                      // WEBSOCKET_TX_FLAG_*
+    websocket_tx_done_cb_t done;        // Optional
+    void *ctx;
+} websocket_tx_frame_t;
+
 // ===========================
 // Public Functions
 // ===========================
@@ -97,17 +165,45 @@ esp_err_t websocket_client_disconnect(void);
 esp_err_t websocket_client_force_stop(void);
 
 /**
- * @brief Send binary PCM audio data
+ * @brief Queue a frame for the WebSocket TX task without waiting for the send
+ *
+ * @param frame Frame description (copied; the payload is only referenced)
+ * @param timeout_ms How long to wait for room in the send queue
+ * @return ESP_OK if queued (done will run), ESP_ERR_INVALID_STATE when not
+ *         connected, ESP_ERR_TIMEOUT when the queue stayed full
+ */
+esp_err_t websocket_client_submit(const websocket_tx_frame_t *frame, uint32_t timeout_ms);
+
+/**
+ * @brief Send binary PCM audio data and wait for the socket write
  * 
  * @param data PCM audio buffer
  * @param length Buffer length in bytes
+ * @param timeout_ms How long to wait for room in the send queue
  * @return ESP_OK on success, error code otherwise
  */
 esp_err_t websocket_client_send_audio(const uint8_t *data, size_t length, uint32_t timeout_ms);
 
+/**
+ * @brief Stream a JPEG to the server as tagged image frames
+ * 
+ * The image is split into CONFIG_WS_IMAGE_CHUNK_BYTES pieces, each prefixed
+ * with the image frame header, and bound to the handshake session on the
+ * server. Chunks are queued straight from the JPEG buffer without copying.
+ * 
+ * @param jpeg_data JPEG buffer (e.g. camera_fb_t::buf)
+ * @param jpeg_len Length of JPEG data
+ * @param timeout_ms How long to wait for room in the send queue per frame
+ * @return ESP_OK once every frame is written, error code otherwise
+ */
+esp_err_t websocket_client_send_image(const uint8_t *jpeg_data, size_t jpeg_len, uint32_t timeout_ms);
+
 /**
  * @brief Send text message (JSON)
  * 
+ * Queued behind any pending binary frames and waited for, so an EOS always
+ * follows the audio it terminates.
+ * 
  * @param message Text message to send
  * @return ESP_OK on success, error code otherwise
  */
@@ -133,9 +229,21 @@ esp_err_t websocket_client_send_eos(void);
  * @return true if connected, false otherwise
  */
 bool websocket_client_is_connected(void);
+
+/**
+ * @brief True while a started connection attempt has neither connected nor failed
+ */
+bool websocket_client_is_connecting(void);
 bool websocket_client_session_ready(void);
 bool websocket_client_can_stream_audio(void);
 
+/**
+ * @brief Uplink codec negotiated in the handshake for the current connection
+ *
+ * @return AUDIO_CODEC_PCM16 until the server's "connected" reply selects a codec
+ */
+audio_codec_t websocket_client_get_uplink_codec(void);
+
 /**
  * @brief Register callback for incoming audio data (TTS)
  * 
@@ -156,4 +264,9 @@ websocket_pipeline_stage_t websocket_client_get_pipeline_stage(void);
 bool websocket_client_is_pipeline_active(void);
 const char *websocket_client_pipeline_stage_to_string(websocket_pipeline_stage_t stage);
 
+/**
+ * @brief Spoken prompt matching the server's most recent error message
+ */
+feedback_prompt_t websocket_client_error_prompt(void);
+
 #endif // WEBSOCKET_CLIENT_H
@@ -11,10 +11,170 @@
 #include "esp_timer.h"
 #include <stdio.h>
 #include <string.h>
+#include <stddef.h>
 #include <inttypes.h>
 
 static const char *TAG = "JSON_PROTO";
 
+// ===========================
+// Control message scanner
+// ===========================
+
+typedef struct {
+    const char *p;
+    const char *end;
+} scan_t;
+
+typedef struct {
+    const char *key;
+    uint32_t field;
+    bool is_string;
+    size_t offset;      // Offset of the json_protocol_str_t or uint32_t in json_protocol_control_t
+} control_key_t;
+
+#define STR_KEY(name, bit)  { #name, bit, true,  offsetof(json_protocol_control_t, name) }
+#define NUM_KEY(name, bit)  { #name, bit, false, offsetof(json_protocol_control_t, name) }
+
+static const control_key_t s_control_keys[] = {
+    STR_KEY(status,          JSON_PROTO_FIELD_STATUS),
+    STR_KEY(stage,           JSON_PROTO_FIELD_STAGE),
+    STR_KEY(message,         JSON_PROTO_FIELD_MESSAGE),
+    STR_KEY(transcript,      JSON_PROTO_FIELD_TRANSCRIPT),
+    STR_KEY(transcription,   JSON_PROTO_FIELD_TRANSCRIPTION),
+    STR_KEY(codec,           JSON_PROTO_FIELD_CODEC),
+    STR_KEY(capture_profile, JSON_PROTO_FIELD_CAPTURE_PROFILE),
+    STR_KEY(control,         JSON_PROTO_FIELD_CONTROL),
+    STR_KEY(error_type,      JSON_PROTO_FIELD_ERROR_TYPE),
+    STR_KEY(tts,             JSON_PROTO_FIELD_TTS),
+    NUM_KEY(chunks_received, JSON_PROTO_FIELD_CHUNKS_RECEIVED),
+    NUM_KEY(bytes_received,  JSON_PROTO_FIELD_BYTES_RECEIVED),
+    NUM_KEY(window_bytes,    JSON_PROTO_FIELD_WINDOW_BYTES),
+    NUM_KEY(flow_window,     JSON_PROTO_FIELD_FLOW_WINDOW),
+    NUM_KEY(size_bytes,      JSON_PROTO_FIELD_SIZE_BYTES),
+    NUM_KEY(prompt_pack,     JSON_PROTO_FIELD_PROMPT_PACK),
+    NUM_KEY(turn,            JSON_PROTO_FIELD_TURN),
+};
+
+static void scan_skip_ws(scan_t *s) {
+    while (s->p < s->end && (*s->p == ' ' || *s->p == '\t' || *s->p == '\n' || *s->p == '\r')) {
+        s->p++;
+    }
+}
+
+static bool scan_string(scan_t *s, json_protocol_str_t *out) {
+    if (s->p >= s->end || *s->p != '"') {
+        return false;
+    }
+    const char *start = ++s->p;
+    while (s->p < s->end) {
+        if (*s->p == '\\') {
+            s->p += 2;
+            continue;
+        }
+        if (*s->p == '"') {
+            out->ptr = start;
+            out->len = (size_t)(s->p - start);
+            s->p++;
+            return true;
+        }
+        s->p++;
+    }
+    return false;
+}
+
+static bool scan_number(scan_t *s, uint32_t *out) {
+    bool negative = false;
+    if (s->p < s->end && *s->p == '-') {
+        negative = true;
+        s->p++;
+    }
+
+    const char *digits = s->p;
+    uint64_t value = 0;
+    while (s->p < s->end && *s->p >= '0' && *s->p <= '9') {
+        if (value <= UINT32_MAX) {
+            value = (value * 10U) + (uint64_t)(*s->p - '0');
+        }
+        s->p++;
+    }
+    if (s->p == digits) {
+        return false;
+    }
+
+    // Fraction and exponent are accepted but dropped (all protocol numbers are counts)
+    if (s->p < s->end && *s->p == '.') {
+        s->p++;
+        while (s->p < s->end && *s->p >= '0' && *s->p <= '9') {
+            s->p++;
+        }
+    }
+    if (s->p < s->end && (*s->p == 'e' || *s->p == 'E')) {
+        s->p++;
+        if (s->p < s->end && (*s->p == '+' || *s->p == '-')) {
+            s->p++;
+        }
+        while (s->p < s->end && *s->p >= '0' && *s->p <= '9') {
+            s->p++;
+        }
+    }
+
+    *out = negative ? 0U : (value > UINT32_MAX ? UINT32_MAX : (uint32_t)value);
+    return true;
+}
+
+static bool scan_skip_value(scan_t *s) {
+    if (s->p >= s->end) {
+        return false;
+    }
+
+    json_protocol_str_t ignored;
+    char c = *s->p;
+    if (c == '"') {
+        return scan_string(s, &ignored);
+    }
+    if (c == '{' || c == '[') {
+        int depth = 0;
+        while (s->p < s->end) {
+            c = *s->p;
+            if (c == '"') {
+                if (!scan_string(s, &ignored)) {
+                    return false;
+                }
+                continue;
+            }
+            if (c == '{' || c == '[') {
+                depth++;
+            } else if ((c == '}' || c == ']') && --depth == 0) {
+                s->p++;
+                return true;
+            }
+            s->p++;
+        }
+        return false;
+    }
+    if (c == 't' || c == 'f' || c == 'n') {
+        while (s->p < s->end && *s->p >= 'a' && *s->p <= 'z') {
+            s->p++;
+        }
+        return true;
+    }
+    uint32_t number;
+    return scan_number(s, &number);
+}
+
+static const control_key_t *find_control_key(const json_protocol_str_t *key) {
+    for (size_t i = 0; i < sizeof(s_control_keys) / sizeof(s_control_keys[0]); i++) {
+        if (json_protocol_str_equals(key, s_control_keys[i].key)) {
+            return &s_control_keys[i];
+        }
+    }
+    return NULL;
+}
+
+static inline uint32_t read_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
 int json_protocol_build_start(const char *session_id, char *buffer, size_t buffer_size) {
     if (session_id == NULL || buffer == NULL || buffer_size == 0) {
         ESP_LOGE(TAG, "Invalid arguments");
@@ -73,7 +233,7 @@ int json_protocol_generate_session_id(char *buffer, size_t buffer_size) {
     // Format: hotpin-AABBCC-timestamp
     int written = snprintf(buffer, buffer_size,
                            "hotpin-%02X%02X%02X-%lld",
-                           mac[3], mac[4], mac[5], timestamp);
+                           mac[3], mac[4], mac[5], (long long)timestamp);
     
     if (written < 0 || (size_t)written >= buffer_size) {
         ESP_LOGE(TAG, "Buffer too small for session ID");
@@ -83,3 +243,168 @@ int json_protocol_generate_session_id(char *buffer, size_t buffer_size) {
     ESP_LOGI(TAG, "Generated session ID: %s", buffer);
     return written;
 }
+
+int json_protocol_build_handshake(const char *session_id, const char *const *codecs, size_t codec_count,
+                                  uint32_t sample_rate, uint32_t prompt_pack_version, bool binary_control,
+                                  bool framed_tts, char *buffer, size_t buffer_size) {
+    if (session_id == NULL || buffer == NULL || buffer_size == 0 || (codec_count > 0 && codecs == NULL)) {
+        ESP_LOGE(TAG, "Invalid arguments");
+        return -1;
+    }
+
+    int written = snprintf(buffer, buffer_size, "{\"session_id\":\"%s\",\"codecs\":[", session_id);
+    for (size_t i = 0; i < codec_count && written >= 0 && (size_t)written < buffer_size; i++) {
+        written += snprintf(buffer + written, buffer_size - (size_t)written, "%s\"%s\"",
+                            (i > 0) ? "," : "", codecs[i]);
+    }
+    if (written >= 0 && (size_t)written < buffer_size) {
+        written += snprintf(buffer + written, buffer_size - (size_t)written,
+                            "],\"sample_rate\":%" PRIu32 ",\"prompt_pack\":%" PRIu32 "%s%s}",
+                            sample_rate, prompt_pack_version,
+                            binary_control ? ",\"control\":\"binary\"" : "",
+                            framed_tts ? ",\"tts\":\"framed\"" : "");
+    }
+
+    if (written < 0 || (size_t)written >= buffer_size) {
+        ESP_LOGE(TAG, "Buffer too small for handshake message");
+        return -1;
+    }
+
+    ESP_LOGD(TAG, "Built handshake message: %s", buffer);
+    return written;
+}
+
+bool json_protocol_parse_control(const char *data, size_t len, json_protocol_control_t *msg) {
+    if (data == NULL || msg == NULL) {
+        return false;
+    }
+    memset(msg, 0, sizeof(*msg));
+
+    scan_t s = { data, data + len };
+    scan_skip_ws(&s);
+    if (s.p >= s.end || *s.p != '{') {
+        return false;
+    }
+    s.p++;
+    scan_skip_ws(&s);
+    if (s.p < s.end && *s.p == '}') {
+        return true;
+    }
+
+    while (s.p < s.end) {
+        json_protocol_str_t key;
+        if (!scan_string(&s, &key)) {
+            return false;
+        }
+        scan_skip_ws(&s);
+        if (s.p >= s.end || *s.p != ':') {
+            return false;
+        }
+        s.p++;
+        scan_skip_ws(&s);
+        if (s.p >= s.end) {
+            return false;
+        }
+
+        const control_key_t *desc = find_control_key(&key);
+        bool matched = false;
+        if (desc != NULL && desc->is_string && *s.p == '"') {
+            if (!scan_string(&s, (json_protocol_str_t *)((uint8_t *)msg + desc->offset))) {
+                return false;
+            }
+            matched = true;
+        } else if (desc != NULL && !desc->is_string && (*s.p == '-' || (*s.p >= '0' && *s.p <= '9'))) {
+            if (!scan_number(&s, (uint32_t *)((uint8_t *)msg + desc->offset))) {
+                return false;
+            }
+            matched = true;
+        } else if (!scan_skip_value(&s)) {
+            return false;
+        }
+        if (matched) {
+            msg->fields |= desc->field;
+        }
+
+        scan_skip_ws(&s);
+        if (s.p < s.end && *s.p == ',') {
+            s.p++;
+            scan_skip_ws(&s);
+            continue;
+        }
+        return (s.p < s.end && *s.p == '}');
+    }
+
+    return false;
+}
+
+bool json_protocol_decode_control_frame(const uint8_t *data, size_t len, json_protocol_control_t *msg) {
+    if (data == NULL || msg == NULL || len < CONTROL_FRAME_HEADER_SIZE ||
+        memcmp(data, CONTROL_FRAME_MAGIC, 4) != 0 || data[4] != CONTROL_FRAME_VERSION) {
+        return false;
+    }
+
+    size_t payload_len = (size_t)data[6] | ((size_t)data[7] << 8);
+    if (len != CONTROL_FRAME_HEADER_SIZE + payload_len) {
+        return false;
+    }
+
+    const uint8_t *payload = data + CONTROL_FRAME_HEADER_SIZE;
+    switch (data[5]) {
+        case CONTROL_FRAME_TYPE_ACK:
+            if (payload_len != CONTROL_FRAME_ACK_PAYLOAD_SIZE) {
+                return false;
+            }
+            memset(msg, 0, sizeof(*msg));
+            msg->status.ptr = "receiving";
+            msg->status.len = sizeof("receiving") - 1;
+            msg->chunks_received = read_le32(payload);
+            msg->bytes_received = read_le32(payload + 4);
+            msg->window_bytes = read_le32(payload + 8);
+            msg->fields = JSON_PROTO_FIELD_STATUS | JSON_PROTO_FIELD_CHUNKS_RECEIVED |
+                          JSON_PROTO_FIELD_BYTES_RECEIVED | JSON_PROTO_FIELD_WINDOW_BYTES;
+            return true;
+        case CONTROL_FRAME_TYPE_PROMPT_CHUNK:
+            if (payload_len <= CONTROL_FRAME_PROMPT_CHUNK_HEADER) {
+                return false;
+            }
+            memset(msg, 0, sizeof(*msg));
+            msg->prompt_pack = read_le32(payload);
+            msg->pack_size = read_le32(payload + 4);
+            msg->pack_offset = read_le32(payload + 8);
+            msg->pack_data = payload + CONTROL_FRAME_PROMPT_CHUNK_HEADER;
+            msg->pack_data_len = payload_len - CONTROL_FRAME_PROMPT_CHUNK_HEADER;
+            msg->fields = JSON_PROTO_FIELD_PROMPT_PACK | JSON_PROTO_FIELD_PROMPT_CHUNK;
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool json_protocol_str_equals(const json_protocol_str_t *str, const char *literal) {
+    if (str == NULL || str->ptr == NULL || literal == NULL) {
+        return false;
+    }
+    size_t literal_len = strlen(literal);
+    return str->len == literal_len && memcmp(str->ptr, literal, literal_len) == 0;
+}
+
+size_t json_protocol_str_copy(const json_protocol_str_t *str, char *buffer, size_t buffer_size) {
+    if (buffer == NULL || buffer_size == 0) {
+        return 0;
+    }
+
+    size_t out = 0;
+    if (str != NULL && str->ptr != NULL) {
+        for (size_t i = 0; i < str->len && out + 1 < buffer_size; i++) {
+            char c = str->ptr[i];
+            if (c == '\\' && i + 1 < str->len && str->ptr[i + 1] != 'u') {
+                char e = str->ptr[++i];
+                c = (e == 'n') ? '\n' : (e == 't') ? '\t' : (e == 'r') ? '\r' :
+                    (e == 'b') ? '\b' : (e == 'f') ? '\f' : e;
+            }
+            buffer[out++] = c;
+        }
+    }
+    buffer[out] = '\0';
+    return out;
+}
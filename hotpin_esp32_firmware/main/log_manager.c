@@ -0,0 +1,146 @@
+/**
+ * @file log_manager.c
+ * @brief Token buckets and the deferred log task
+ */
+
+#include "log_manager.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+static const char *TAG = TAG_LOG;
+
+// One queued line: pointers to literals plus raw integer arguments
+typedef struct {
+    const char *tag;
+    const char *fmt;
+    uint32_t args[4];
+    uint32_t timestamp_ms;              // esp_log_timestamp() at the call, not at printing
+    uint8_t level;
+} log_record_t;
+
+static QueueHandle_t s_log_queue = NULL;
+static uint32_t s_dropped = 0;
+static uint32_t s_dropped_reported = 0;
+
+static char level_letter(esp_log_level_t level) {
+    switch (level) {
+        case ESP_LOG_ERROR:   return 'E';
+        case ESP_LOG_WARN:    return 'W';
+        case ESP_LOG_INFO:    return 'I';
+        case ESP_LOG_DEBUG:   return 'D';
+        default:              return 'V';
+    }
+}
+
+static void print_record(const log_record_t *rec) {
+    esp_log_level_t level = (esp_log_level_t)rec->level;
+    // Same prefix as ESP_LOGx, with the time the line was queued
+    esp_log_write(level, rec->tag, "%c (%u) %s: ", level_letter(level),
+                  (unsigned int)rec->timestamp_ms, rec->tag);
+    esp_log_write(level, rec->tag, rec->fmt, rec->args[0], rec->args[1], rec->args[2], rec->args[3]);
+    esp_log_write(level, rec->tag, "\n");
+}
+
+static void log_task(void *pvParameters) {
+    (void)pvParameters;
+    log_record_t rec;
+
+    while (1) {
+        if (xQueueReceive(s_log_queue, &rec, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        print_record(&rec);
+
+        uint32_t dropped = __atomic_load_n(&s_dropped, __ATOMIC_RELAXED);
+        if (dropped != s_dropped_reported && uxQueueMessagesWaiting(s_log_queue) == 0) {
+            ESP_LOGW(TAG, "%u deferred log lines dropped (queue full)",
+                     (unsigned int)(dropped - s_dropped_reported));
+            s_dropped_reported = dropped;
+        }
+    }
+}
+
+bool log_manager_allow(log_bucket_t *bucket, uint32_t burst, uint32_t per_sec,
+                       uint32_t *suppressed_out) {
+    int64_t now_us = esp_timer_get_time();
+
+    if (bucket->refill_us == 0) {
+        bucket->refill_us = now_us;
+        bucket->tokens = burst;
+    } else if (per_sec > 0) {
+        // Whole tokens only; the remainder of the interval carries over
+        int64_t interval_us = 1000000LL / per_sec;
+        int64_t earned = (now_us - bucket->refill_us) / interval_us;
+        if (earned > 0) {
+            uint64_t tokens = (uint64_t)bucket->tokens + (uint64_t)earned;
+            bucket->tokens = (tokens > burst) ? burst : (uint32_t)tokens;
+            bucket->refill_us += earned * interval_us;
+            if (bucket->tokens == burst) {
+                bucket->refill_us = now_us;
+            }
+        }
+    }
+
+    if (bucket->tokens == 0) {
+        bucket->suppressed++;
+        return false;
+    }
+    bucket->tokens--;
+    *suppressed_out = bucket->suppressed;
+    bucket->suppressed = 0;
+    return true;
+}
+
+void log_manager_defer(esp_log_level_t level, const char *tag, const char *fmt,
+                       uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3, ...) {
+    log_record_t rec = {
+        .tag = tag,
+        .fmt = fmt,
+        .args = { a0, a1, a2, a3 },
+        .timestamp_ms = esp_log_timestamp(),
+        .level = (uint8_t)level,
+    };
+
+    if (s_log_queue == NULL) {
+        // Early boot: no task yet, print in place
+        print_record(&rec);
+        return;
+    }
+    if (xQueueSend(s_log_queue, &rec, 0) != pdTRUE) {
+        __atomic_fetch_add(&s_dropped, 1U, __ATOMIC_RELAXED);
+    }
+}
+
+esp_err_t log_manager_init(void) {
+    // CONFIG_LOG_LEVEL is the runtime ceiling; module floors in config.h cut below it at compile time
+    esp_log_level_set("*", CONFIG_LOG_LEVEL);
+
+    if (s_log_queue != NULL) {
+        return ESP_OK;
+    }
+
+    s_log_queue = xQueueCreate(CONFIG_LOG_DEFER_QUEUE_DEPTH, sizeof(log_record_t));
+    if (s_log_queue == NULL) {
+        ESP_LOGE(TAG, "Failed to create deferred log queue");
+        return ESP_ERR_NO_MEM;
+    }
+
+    BaseType_t ret = xTaskCreatePinnedToCore(log_task, "log_defer", TASK_STACK_SIZE_SMALL + 1024, NULL,
+                                             TASK_PRIORITY_LOG, NULL, TASK_CORE_CONTROL);
+    if (ret != pdPASS) {
+        vQueueDelete(s_log_queue);
+        s_log_queue = NULL;
+        ESP_LOGE(TAG, "Failed to create deferred log task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Logging: level %d, deferred queue %d lines", (int)CONFIG_LOG_LEVEL,
+             CONFIG_LOG_DEFER_QUEUE_DEPTH);
+    return ESP_OK;
+}
+
+uint32_t log_manager_dropped(void) {
+    return __atomic_load_n(&s_dropped, __ATOMIC_RELAXED);
+}
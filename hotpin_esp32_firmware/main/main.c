@@ -6,10 +6,14 @@
  * 1. Disable brownout detector
  * 2. GPIO 12 button input configuration (AVOIDS STRAPPING PIN CONFLICTS)
  * 3. PSRAM validation
- * 4. NVS and WiFi initialization
- * 5. Mutex and queue creation
- * 6. Module initialization
- * 7. FreeRTOS task spawning with proper core affinity
+ * 4. NVS, mutex and queue creation
+ * 5. WiFi start (association continues in the background, cached AP first)
+ * 6. Module initialization: audio/pipeline modules on the control core in
+ *    parallel with LED, button, WebSocket and HTTP on this core
+ * 7. FreeRTOS task spawning with proper core affinity (WebSocket task first,
+ *    so it connects as soon as an IP arrives while the camera comes up)
+ *
+ * Each phase logs its duration; "Ready to talk" marks the first server connection.
  */
 
 #include <stdio.h>
@@ -24,6 +28,7 @@
 #include "esp_event.h"
 #include "esp_netif.h"
 #include "nvs_flash.h"
+#include "nvs.h"
 #include "esp_timer.h"
 #include "esp_chip_info.h"
 #include "esp_flash.h"
@@ -37,17 +42,22 @@
 #include "camera_controller.h"
 #include "audio_driver.h"
 #include "feedback_player.h"
+#include "prompt_store.h"
 #include "websocket_client.h"
+#include "network_profile.h"
 #include "state_manager.h"
 #include "stt_pipeline.h"
 #include "tts_decoder.h"
 #include "http_client.h"
+#include "mode_switch.h"
 #include "json_protocol.h"
 #include "led_controller.h"
 #include "serial_commands.h"
 #include "event_dispatcher.h"
 #include "system_events.h"
 #include "memory_manager.h"
+#include "trace.h"
+#include "log_manager.h"
 
 // ===========================
 // Forward Declarations
@@ -74,6 +84,19 @@ static volatile bool g_websocket_connected = false;
 // WebSocket coordination
 static EventGroupHandle_t g_network_event_group = NULL;
 
+// Boot timing (esp_timer counts from power-on)
+static int64_t s_boot_phase_start_us = 0;
+static bool s_ready_to_talk_logged = false;
+
+// Audio/pipeline module init, run on the control core during boot
+static SemaphoreHandle_t s_media_init_done = NULL;
+static volatile esp_err_t s_media_init_result = ESP_OK;
+
+#if CONFIG_WIFI_FAST_RECONNECT
+static volatile bool s_wifi_using_cached_ap = false;
+static volatile bool s_wifi_ever_connected = false;
+#endif
+
 #define NETWORK_EVENT_WIFI_CONNECTED     BIT0
 #define NETWORK_EVENT_WEBSOCKET_CONNECTED BIT1
 
@@ -90,6 +113,14 @@ static EventGroupHandle_t g_network_event_group = NULL;
 static esp_err_t validate_psram(void);
 static esp_err_t init_nvs(void);
 static esp_err_t init_wifi(void);
+static esp_err_t init_media_modules(void);
+static void media_init_task(void *pvParameters);
+static void boot_phase_done(const char *phase);
+#if CONFIG_WIFI_FAST_RECONNECT
+static bool wifi_ap_cache_load(wifi_config_t *wifi_config);
+static void wifi_ap_cache_store(void);
+static void wifi_ap_cache_forget(void);
+#endif
 static void wifi_event_handler(void *arg, esp_event_base_t event_base,
                                 int32_t event_id, void *event_data);
 static void print_system_info(void);
@@ -99,6 +130,7 @@ static void print_system_info(void);
 // ===========================
 
 void app_main(void) {
+    s_boot_phase_start_us = esp_timer_get_time();
     ESP_LOGI(TAG, "====================================");
     ESP_LOGI(TAG, "HotPin ESP32-CAM AI Agent Starting");
     ESP_LOGI(TAG, "====================================");
@@ -122,6 +154,7 @@ void app_main(void) {
     
     // Print system information
     print_system_info();
+    boot_phase_done("hardware");
     
     // ===========================
     // Phase 2: Software Infrastructure
@@ -132,6 +165,10 @@ void app_main(void) {
     ESP_ERROR_CHECK(memory_manager_init(NULL));  // Use default thresholds
     ESP_ERROR_CHECK(memory_manager_start_monitoring(15000));  // Monitor every 15 seconds
     memory_manager_log_stats("System Boot");
+    trace_init();  // Tracing is optional; boot continues without a ring
+    if (log_manager_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Deferred logging unavailable - hot-path lines print in place");
+    }
     
     // Initialize NVS (required for WiFi)
     ESP_ERROR_CHECK(init_nvs());
@@ -142,39 +179,32 @@ void app_main(void) {
     event_dispatcher_init();
 
     if (!g_i2s_config_mutex || !g_network_event_group ||
-        event_dispatcher_queue() == NULL) {
+        !event_dispatcher_is_ready() || mode_switch_init() != ESP_OK) {
         ESP_LOGE(TAG, "Failed to create synchronization primitives");
         esp_restart();
     }
     
     ESP_LOGI(TAG, "Synchronization primitives created");
+    boot_phase_done("infrastructure");
     
     // ===========================
     // Phase 3: Network Initialization
     // ===========================
     
-    ESP_ERROR_CHECK(init_wifi());
+    // LED first: Wi-Fi events drive it from here on
+    ESP_LOGI(TAG, "Initializing LED controller...");
+    ESP_ERROR_CHECK(led_controller_init());
+    ESP_ERROR_CHECK(led_controller_set_state(LED_STATE_FAST_BLINK));
     
-    // Wait for WiFi connection (with timeout)
-    ESP_LOGI(TAG, "Waiting for WiFi connection...");
-    vTaskDelay(pdMS_TO_TICKS(5000));  // 5 second timeout
+    // Association runs in the background; nothing below needs an IP
+    ESP_ERROR_CHECK(init_wifi());
+    boot_phase_done("wifi_start");
     
     // ===========================
     // Phase 4: Module Initialization
     // ===========================
     
-    ESP_LOGI(TAG, "Initializing button handler...");
-    ESP_ERROR_CHECK(button_handler_init());
-    
-    // Serial command interface disabled to reduce UART contention during voice mode
-    // ESP_LOGI(TAG, "Initializing serial command interface...");
-    // ESP_ERROR_CHECK(serial_commands_init());
-    
-    ESP_LOGI(TAG, "Initializing LED controller...");
-    ESP_ERROR_CHECK(led_controller_init());
-    ESP_ERROR_CHECK(feedback_player_init());
-    ESP_ERROR_CHECK(led_controller_set_state(LED_STATE_FAST_BLINK));
-    
+    // The WebSocket client registers the audio callback slot the TTS decoder fills in
     ESP_LOGI(TAG, "Initializing WebSocket client...");
     ESP_ERROR_CHECK(websocket_client_init(WS_SERVER_URI, CONFIG_AUTH_BEARER_TOKEN));
     
@@ -182,18 +212,49 @@ void app_main(void) {
     websocket_client_set_status_callback(websocket_status_callback, NULL);
     ESP_LOGI(TAG, "WebSocket status callback registered");
     
+    // Feedback, prompts, STT and TTS only need memory_manager and the WebSocket
+    // client; bring them up on the control core while this core does the rest
+    bool media_parallel = false;
+#if CONFIG_BOOT_PARALLEL_INIT
+    s_media_init_done = xSemaphoreCreateBinary();
+    if (s_media_init_done != NULL &&
+        xTaskCreatePinnedToCore(media_init_task, "boot_media", TASK_STACK_SIZE_LARGE, NULL,
+                                TASK_PRIORITY_STATE_MANAGER - 1, NULL, TASK_CORE_CONTROL) == pdPASS) {
+        media_parallel = true;
+    } else {
+        ESP_LOGW(TAG, "Parallel module init unavailable - running it inline");
+    }
+#endif
+    if (!media_parallel) {
+        s_media_init_result = init_media_modules();
+    }
+    
+    ESP_LOGI(TAG, "Initializing button handler...");
+    ESP_ERROR_CHECK(button_handler_init());
+    
+    // Serial command interface off by default to reduce UART contention during voice mode
+#if CONFIG_SERIAL_COMMANDS_ENABLED
+    ESP_LOGI(TAG, "Initializing serial command interface...");
+    ESP_ERROR_CHECK(serial_commands_init());
+#endif
+    
     ESP_LOGI(TAG, "Initializing HTTP client...");
     ESP_ERROR_CHECK(http_client_init(CONFIG_HTTP_SERVER_URL, CONFIG_AUTH_BEARER_TOKEN));
     
-    // Initialize STT and TTS pipelines
-    ESP_LOGI(TAG, "Initializing STT pipeline...");
-    ESP_ERROR_CHECK(stt_pipeline_init());
-    
-    ESP_LOGI(TAG, "Initializing TTS decoder...");
-    ESP_ERROR_CHECK(tts_decoder_init());
+    if (media_parallel) {
+        if (xSemaphoreTake(s_media_init_done, pdMS_TO_TICKS(CONFIG_BOOT_MEDIA_INIT_TIMEOUT_MS)) != pdTRUE) {
+            ESP_LOGE(TAG, "Audio/pipeline init did not finish within %d ms - restarting",
+                     CONFIG_BOOT_MEDIA_INIT_TIMEOUT_MS);
+            esp_restart();
+        }
+        vSemaphoreDelete(s_media_init_done);
+        s_media_init_done = NULL;
+    }
+    ESP_ERROR_CHECK(s_media_init_result);
     
     // Camera and audio drivers will be initialized by state manager
     ESP_LOGI(TAG, "Camera and audio initialization deferred to state manager");
+    boot_phase_done("modules");
     
     // ===========================
     // Phase 5: Task Creation
@@ -201,19 +262,20 @@ void app_main(void) {
     
     ESP_LOGI(TAG, "Creating FreeRTOS tasks...");
     
-    // State Manager Task (Core 1, Highest Priority)
+    // WebSocket Connection Management Task (Core 0, Medium Priority). Started
+    // before the state manager so the connect overlaps camera bring-up.
     BaseType_t ret = xTaskCreatePinnedToCore(
-        state_manager_task,
-        "state_mgr",
-        TASK_STACK_SIZE_LARGE,
+        websocket_connection_task,
+        "ws_connect",
+        TASK_STACK_SIZE_MEDIUM,
         NULL,
-        TASK_PRIORITY_STATE_MANAGER,
-        &g_state_manager_task_handle,
-    TASK_CORE_CONTROL
+        TASK_PRIORITY_WEBSOCKET - 1,  // Lower priority than main WebSocket I/O
+        &g_websocket_task_handle,
+    TASK_CORE_NETWORK_IO
     );
     
     if (ret != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create state manager task");
+        ESP_LOGE(TAG, "Failed to create WebSocket connection task");
         // Clean up synchronization primitives before restarting
         if (g_i2s_config_mutex) {
             vSemaphoreDelete(g_i2s_config_mutex);
@@ -226,25 +288,25 @@ void app_main(void) {
         esp_restart();
     }
     
-    ESP_LOGI(TAG, "State manager task created on Core 1");
+    ESP_LOGI(TAG, "WebSocket connection task created on Core 0");
     
-    // WebSocket Connection Management Task (Core 0, Medium Priority)
+    // State Manager Task (Core 1, Highest Priority)
     ret = xTaskCreatePinnedToCore(
-        websocket_connection_task,
-        "ws_connect",
-        TASK_STACK_SIZE_MEDIUM,
+        state_manager_task,
+        "state_mgr",
+        TASK_STACK_SIZE_LARGE,
         NULL,
-        TASK_PRIORITY_WEBSOCKET - 1,  // Lower priority than main WebSocket I/O
-        &g_websocket_task_handle,
-    TASK_CORE_NETWORK_IO
+        TASK_PRIORITY_STATE_MANAGER,
+        &g_state_manager_task_handle,
+    TASK_CORE_CONTROL
     );
     
     if (ret != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create WebSocket connection task");
+        ESP_LOGE(TAG, "Failed to create state manager task");
         // Clean up resources before restarting
-        if (g_state_manager_task_handle) {
-            vTaskDelete(g_state_manager_task_handle);
-            g_state_manager_task_handle = NULL;
+        if (g_websocket_task_handle) {
+            vTaskDelete(g_websocket_task_handle);
+            g_websocket_task_handle = NULL;
         }
         if (g_i2s_config_mutex) {
             vSemaphoreDelete(g_i2s_config_mutex);
@@ -257,7 +319,7 @@ void app_main(void) {
         esp_restart();
     }
     
-    ESP_LOGI(TAG, "WebSocket connection task created on Core 0");
+    ESP_LOGI(TAG, "State manager task created on Core 1");
     
     // ===========================
     // Task Watchdog Configuration
@@ -289,6 +351,7 @@ void app_main(void) {
     }
     
     ESP_LOGI(TAG, "Task watchdog configuration complete");
+    boot_phase_done("tasks");
     
     // WebSocket task now runs continuously; state manager handles camera/audio
     
@@ -396,22 +459,163 @@ static esp_err_t init_wifi(void) {
         },
     };
     
+#if CONFIG_WIFI_FAST_RECONNECT
+    // Join the last AP directly on its channel instead of scanning every channel
+    s_wifi_using_cached_ap = wifi_ap_cache_load(&wifi_config);
+#endif
+    
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
     ESP_ERROR_CHECK(esp_wifi_start());
     
-    // 🔧 CRITICAL FIX: Disable WiFi power saving to prevent connection drops during streaming
-    // Modem sleep (type 1) causes packet loss and connection instability during high-throughput audio streaming
-    // Trade-off: ~20-30mA higher power consumption but stable WebSocket connections
-    ESP_LOGI(TAG, "Disabling WiFi power save mode for stable streaming...");
-    ESP_ERROR_CHECK(esp_wifi_set_ps(WIFI_PS_NONE));
-    ESP_LOGI(TAG, "✅ WiFi power save disabled - maximum throughput and stability");
+    // Power save follows the network profile. Modem sleep causes packet loss and
+    // wake latency during streaming, so it is never on while a voice session or
+    // upload runs; the "battery" profile enables it only when the device is idle
+    ESP_ERROR_CHECK(network_profile_apply_wifi());
     
     ESP_LOGI(TAG, "WiFi initialization complete, connecting to %s...", WIFI_SSID);
     
     return ESP_OK;
 }
 
+#if CONFIG_WIFI_FAST_RECONNECT
+/**
+ * @brief Apply the cached BSSID/channel to the station config if it is for this SSID
+ */
+static bool wifi_ap_cache_load(wifi_config_t *wifi_config) {
+    nvs_handle_t handle;
+    if (nvs_open(CONFIG_WIFI_FAST_RECONNECT_NVS_NS, NVS_READONLY, &handle) != ESP_OK) {
+        return false;  // Nothing cached yet
+    }
+    
+    char ssid[33] = {0};
+    size_t ssid_len = sizeof(ssid);
+    uint8_t bssid[6];
+    size_t bssid_len = sizeof(bssid);
+    uint8_t channel = 0;
+    bool valid = nvs_get_str(handle, "ssid", ssid, &ssid_len) == ESP_OK &&
+                 strcmp(ssid, WIFI_SSID) == 0 &&
+                 nvs_get_blob(handle, "bssid", bssid, &bssid_len) == ESP_OK &&
+                 bssid_len == sizeof(bssid) &&
+                 nvs_get_u8(handle, "channel", &channel) == ESP_OK &&
+                 channel >= 1 && channel <= 14;
+    nvs_close(handle);
+    
+    if (!valid) {
+        return false;
+    }
+    
+    memcpy(wifi_config->sta.bssid, bssid, sizeof(bssid));
+    wifi_config->sta.bssid_set = true;
+    wifi_config->sta.channel = channel;
+    ESP_LOGI(TAG, "Fast reconnect: %02x:%02x:%02x:%02x:%02x:%02x on channel %u",
+             bssid[0], bssid[1], bssid[2], bssid[3], bssid[4], bssid[5], channel);
+    return true;
+}
+
+/**
+ * @brief Remember the AP we just joined (skips the flash write if unchanged)
+ */
+static void wifi_ap_cache_store(void) {
+    wifi_ap_record_t ap_info;
+    if (esp_wifi_sta_get_ap_info(&ap_info) != ESP_OK) {
+        return;
+    }
+    
+    nvs_handle_t handle;
+    if (nvs_open(CONFIG_WIFI_FAST_RECONNECT_NVS_NS, NVS_READWRITE, &handle) != ESP_OK) {
+        return;
+    }
+    
+    char ssid[33] = {0};
+    size_t ssid_len = sizeof(ssid);
+    uint8_t bssid[6];
+    size_t bssid_len = sizeof(bssid);
+    uint8_t channel = 0;
+    bool unchanged = nvs_get_str(handle, "ssid", ssid, &ssid_len) == ESP_OK &&
+                     strcmp(ssid, WIFI_SSID) == 0 &&
+                     nvs_get_blob(handle, "bssid", bssid, &bssid_len) == ESP_OK &&
+                     bssid_len == sizeof(bssid) &&
+                     memcmp(bssid, ap_info.bssid, sizeof(bssid)) == 0 &&
+                     nvs_get_u8(handle, "channel", &channel) == ESP_OK &&
+                     channel == ap_info.primary;
+    
+    if (!unchanged) {
+        esp_err_t ret = nvs_set_str(handle, "ssid", WIFI_SSID);
+        if (ret == ESP_OK) {
+            ret = nvs_set_blob(handle, "bssid", ap_info.bssid, sizeof(ap_info.bssid));
+        }
+        if (ret == ESP_OK) {
+            ret = nvs_set_u8(handle, "channel", ap_info.primary);
+        }
+        if (ret == ESP_OK) {
+            ret = nvs_commit(handle);
+        }
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to cache AP for fast reconnect: %s", esp_err_to_name(ret));
+        } else {
+            ESP_LOGI(TAG, "Cached AP on channel %u for fast reconnect", ap_info.primary);
+        }
+    }
+    nvs_close(handle);
+}
+
+/**
+ * @brief Drop a cached AP that no longer answers
+ */
+static void wifi_ap_cache_forget(void) {
+    nvs_handle_t handle;
+    if (nvs_open(CONFIG_WIFI_FAST_RECONNECT_NVS_NS, NVS_READWRITE, &handle) != ESP_OK) {
+        return;
+    }
+    nvs_erase_all(handle);
+    nvs_commit(handle);
+    nvs_close(handle);
+}
+#endif
+
+/**
+ * @brief Log how long the boot phase that just finished took
+ */
+static void boot_phase_done(const char *phase) {
+    int64_t now_us = esp_timer_get_time();
+    ESP_LOGI(TAG, "⏱️ Boot phase %-14s %5lld ms (t=%lld ms)", phase,
+             (long long)((now_us - s_boot_phase_start_us) / 1000),
+             (long long)(now_us / 1000));
+    s_boot_phase_start_us = now_us;
+}
+
+/**
+ * @brief Audio and pipeline modules with no dependency on Wi-Fi, LED or button
+ */
+static esp_err_t init_media_modules(void) {
+    int64_t start_us = esp_timer_get_time();
+    
+    esp_err_t ret = feedback_player_init();
+    if (ret == ESP_OK) {
+        ret = prompt_store_init();
+    }
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Initializing STT pipeline...");
+        ret = stt_pipeline_init();
+    }
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Initializing TTS decoder...");
+        ret = tts_decoder_init();
+    }
+    
+    ESP_LOGI(TAG, "⏱️ Audio/pipeline modules on core %d: %lld ms (%s)", xPortGetCoreID(),
+             (long long)((esp_timer_get_time() - start_us) / 1000), esp_err_to_name(ret));
+    return ret;
+}
+
+static void media_init_task(void *pvParameters) {
+    (void)pvParameters;
+    s_media_init_result = init_media_modules();
+    xSemaphoreGive(s_media_init_done);
+    vTaskDelete(NULL);
+}
+
 /**
  * @brief Callback for WebSocket connection status changes
  */
@@ -431,6 +635,11 @@ static void websocket_status_callback(websocket_status_t status, void *arg) {
     switch (status) {
         case WEBSOCKET_STATUS_CONNECTED:
             ESP_LOGI(TAG, "🎉 WebSocket status callback: CONNECTED");
+            if (!s_ready_to_talk_logged) {
+                s_ready_to_talk_logged = true;
+                ESP_LOGI(TAG, "⏱️ Ready to talk %lld ms after power-on",
+                         (long long)(esp_timer_get_time() / 1000));
+            }
             g_websocket_connected = true;
             if (g_network_event_group != NULL) {
                 xEventGroupSetBits(g_network_event_group, NETWORK_EVENT_WEBSOCKET_CONNECTED);
@@ -465,8 +674,9 @@ static void websocket_status_callback(websocket_status_t status, void *arg) {
  * Automatically retries with exponential backoff when disconnected.
  */
 static void websocket_connection_task(void *pvParameters) {
-    const int MAX_RETRY_DELAY_MS = 30000;
-    int retry_delay_ms = 5000;
+    // Backoff between failed attempts comes from the network profile; each
+    // attempt separately gets CONFIG_NET_CONNECT_ATTEMPT_MS to complete
+    int retry_delay_ms = CONFIG_NET_RECONNECT_INITIAL_MS;
     int attempt = 0;
     bool shutdown_logged = false;  // ✅ FIX #9: Prevent log spam during shutdown
 
@@ -490,7 +700,7 @@ static void websocket_connection_task(void *pvParameters) {
             pdFALSE,
             portMAX_DELAY);
 
-        retry_delay_ms = 5000;
+        retry_delay_ms = CONFIG_NET_RECONNECT_INITIAL_MS;
         attempt = 0;
 
         while ((xEventGroupGetBits(g_network_event_group) & NETWORK_EVENT_WIFI_CONNECTED) != 0) {
@@ -514,8 +724,8 @@ static void websocket_connection_task(void *pvParameters) {
             }
 
             TickType_t start = xTaskGetTickCount();
-            TickType_t poll_delay = pdMS_TO_TICKS(200);
-            TickType_t wait_duration = pdMS_TO_TICKS(retry_delay_ms);
+            TickType_t poll_delay = pdMS_TO_TICKS(50);
+            TickType_t wait_duration = pdMS_TO_TICKS(CONFIG_NET_CONNECT_ATTEMPT_MS);
 
             while (!websocket_client_is_connected()) {
                 // Check for system shutdown state
@@ -536,6 +746,11 @@ static void websocket_connection_task(void *pvParameters) {
                     break;
                 }
 
+                // Refused / unreachable: the client stopped, no point waiting out the window
+                if (!websocket_client_is_connecting()) {
+                    break;
+                }
+
                 vTaskDelay(poll_delay);
             }
 
@@ -557,9 +772,17 @@ static void websocket_connection_task(void *pvParameters) {
                     break;
                 }
 
-                retry_delay_ms = retry_delay_ms + (retry_delay_ms / 2);
-                if (retry_delay_ms > MAX_RETRY_DELAY_MS) {
-                    retry_delay_ms = MAX_RETRY_DELAY_MS;
+                ESP_LOGI(TAG, "Retrying WebSocket in %d ms", retry_delay_ms);
+                TickType_t backoff_start = xTaskGetTickCount();
+                while ((xTaskGetTickCount() - backoff_start) < pdMS_TO_TICKS(retry_delay_ms) &&
+                       (xEventGroupGetBits(g_network_event_group) & NETWORK_EVENT_WIFI_CONNECTED) != 0) {
+                    esp_task_wdt_reset();
+                    vTaskDelay(poll_delay);
+                }
+
+                retry_delay_ms *= 2;
+                if (retry_delay_ms > CONFIG_NET_RECONNECT_MAX_MS) {
+                    retry_delay_ms = CONFIG_NET_RECONNECT_MAX_MS;
                 }
 
                 continue;
@@ -567,7 +790,7 @@ static void websocket_connection_task(void *pvParameters) {
 
             ESP_LOGI(TAG, "📡 WebSocket connection active - monitoring link");
             xEventGroupSetBits(g_network_event_group, NETWORK_EVENT_WEBSOCKET_CONNECTED);
-            retry_delay_ms = 5000;
+            retry_delay_ms = CONFIG_NET_RECONNECT_INITIAL_MS;
 
             // ✅ STABILITY FIX: Monitor connection health with periodic watchdog resets
             // Let WebSocket ping/pong mechanism handle connection health (ping_interval_sec=10)
@@ -621,8 +844,8 @@ static void websocket_connection_task(void *pvParameters) {
             // Force stop the client to clean up any stale state
             websocket_client_force_stop();
             
-            // Wait longer to ensure clean shutdown before reconnect attempt
-            vTaskDelay(pdMS_TO_TICKS(1000));
+            // Short settle before the first retry; failures back off from here
+            vTaskDelay(pdMS_TO_TICKS(CONFIG_NET_RECONNECT_INITIAL_MS));
         }
         
             // Check for system shutdown state
@@ -672,6 +895,20 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
                     xEventGroupClearBits(g_network_event_group, NETWORK_EVENT_WIFI_CONNECTED);
                     xEventGroupClearBits(g_network_event_group, NETWORK_EVENT_WEBSOCKET_CONNECTED);
                 }
+#if CONFIG_WIFI_FAST_RECONNECT
+                if (s_wifi_using_cached_ap && !s_wifi_ever_connected) {
+                    // AP moved or was replaced: forget it and fall back to a full scan
+                    ESP_LOGW(TAG, "Cached AP unreachable - falling back to a full scan");
+                    s_wifi_using_cached_ap = false;
+                    wifi_config_t wifi_config;
+                    if (esp_wifi_get_config(WIFI_IF_STA, &wifi_config) == ESP_OK) {
+                        wifi_config.sta.bssid_set = false;
+                        wifi_config.sta.channel = 0;
+                        esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+                    }
+                    wifi_ap_cache_forget();
+                }
+#endif
                 esp_wifi_connect();
                 break;
                 
@@ -686,8 +923,14 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
         ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
         ESP_LOGI(TAG, "✅ Got IP address: " IPSTR, IP2STR(&event->ip_info.ip));
         
+        ESP_LOGI(TAG, "⏱️ Wi-Fi up %lld ms after power-on", (long long)(esp_timer_get_time() / 1000));
+        
         // Set WiFi connected flag
         g_wifi_connected = true;
+#if CONFIG_WIFI_FAST_RECONNECT
+        s_wifi_ever_connected = true;
+        wifi_ap_cache_store();
+#endif
         if (state_manager_get_state() != SYSTEM_STATE_VOICE_ACTIVE) {
             led_controller_set_state(LED_STATE_BREATHING);
         }
@@ -8,6 +8,7 @@
  * - Automatic memory optimization
  * - Memory leak detection
  * - Heap fragmentation analysis
+ * - Boot-time arena for long-lived subsystem buffers
  */
 
 #include "memory_manager.h"
@@ -18,6 +19,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include <stdlib.h>
 #include <string.h>
 
 static const char *TAG = "MEM_MGR";
@@ -35,11 +37,59 @@ static volatile bool g_monitoring_enabled = false;
 static memory_warning_callback_t g_warning_callbacks[MAX_WARNING_CALLBACKS];
 static int g_warning_callback_count = 0;
 
+// ===========================
+// Arena
+// ===========================
+
+#define ARENA_SLOT_ALIGN    16
+#define ARENA_ALIGN_UP(n)   (((n) + (ARENA_SLOT_ALIGN - 1U)) & ~(uint32_t)(ARENA_SLOT_ALIGN - 1U))
+
+typedef struct {
+    const char *name;
+    memory_region_t region;
+    uint32_t size;
+    uint32_t heap_caps;                 // Capabilities used when the slot cannot serve a borrow
+} arena_slot_desc_t;
+
+typedef struct {
+    uint8_t *base;                      // NULL when the region is not reserved
+    uint32_t offset;                    // Offset within the region
+    uint32_t lent;                      // Bytes of the current arena borrow (0 = free)
+    uint32_t peak_request;              // Largest borrow ever requested
+} arena_slot_t;
+
+static const arena_slot_desc_t g_slot_desc[MEMORY_SLOT_COUNT] = {
+    [MEMORY_SLOT_STT_RING]          = { "stt_ring",     MEMORY_REGION_PSRAM_BULK,   CONFIG_ARENA_STT_RING_BYTES,       MALLOC_CAP_SPIRAM },
+    [MEMORY_SLOT_STT_VAD_PREROLL]   = { "vad_preroll",  MEMORY_REGION_PSRAM_BULK,   CONFIG_ARENA_STT_PREROLL_BYTES,    MALLOC_CAP_SPIRAM },
+    [MEMORY_SLOT_STT_UPLINK_ENCODE] = { "uplink_enc",   MEMORY_REGION_DMA_INTERNAL, CONFIG_ARENA_STT_ENCODE_BYTES,     MALLOC_CAP_SPIRAM },
+    [MEMORY_SLOT_TTS_BLOCKS]        = { "tts_blocks",   MEMORY_REGION_PSRAM_BULK,   CONFIG_ARENA_TTS_BLOCK_BYTES,      MALLOC_CAP_SPIRAM },
+    [MEMORY_SLOT_TTS_RESAMPLE]      = { "tts_resample", MEMORY_REGION_PSRAM_BULK,   CONFIG_ARENA_TTS_RESAMPLE_BYTES,   MALLOC_CAP_SPIRAM },
+    [MEMORY_SLOT_CAMERA_BURST]      = { "cam_burst",    MEMORY_REGION_PSRAM_BULK,   CONFIG_ARENA_CAMERA_BURST_BYTES,   MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT },
+    [MEMORY_SLOT_FEEDBACK_CACHE]    = { "fb_tones",     MEMORY_REGION_PSRAM_BULK,   CONFIG_ARENA_FEEDBACK_CACHE_BYTES, MALLOC_CAP_SPIRAM },
+    [MEMORY_SLOT_TRACE_RING]        = { "trace",        MEMORY_REGION_PSRAM_BULK,   CONFIG_ARENA_TRACE_BYTES,          MALLOC_CAP_SPIRAM },
+};
+
+static const char *const g_region_names[MEMORY_REGION_COUNT] = {
+    [MEMORY_REGION_DMA_INTERNAL] = "dma_internal",
+    [MEMORY_REGION_PSRAM_BULK]   = "psram_bulk",
+};
+
+static const uint32_t g_region_caps[MEMORY_REGION_COUNT] = {
+    [MEMORY_REGION_DMA_INTERNAL] = MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL,
+    [MEMORY_REGION_PSRAM_BULK]   = MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT,
+};
+
+static uint8_t *g_region_base[MEMORY_REGION_COUNT];
+static memory_region_stats_t g_region_stats[MEMORY_REGION_COUNT];
+static arena_slot_t g_slots[MEMORY_SLOT_COUNT];
+static SemaphoreHandle_t g_arena_mutex = NULL;
+
 // Forward declarations
 static void memory_monitor_task(void *pvParameters);
 static void update_memory_stats(void);
 static void check_memory_thresholds(void);
 static uint32_t calculate_fragmentation_percentage(size_t total, size_t largest_block);
+static void log_arena_regions(void);
 
 // ===========================
 // Public Functions
@@ -109,6 +159,11 @@ esp_err_t memory_manager_init(const memory_thresholds_t *thresholds) {
              (unsigned long)g_thresholds.fragmentation_critical);
     ESP_LOGI(TAG, "╚═══════════════════════════════════════════════════════════");
 
+    // Reserve long-lived buffers before the subsystems start and fragment the heap
+    if (memory_manager_arena_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Arena partially reserved - affected buffers will use the heap");
+    }
+
     g_initialized = true;
     return ESP_OK;
 }
@@ -255,6 +310,8 @@ void memory_manager_log_stats(const char *context) {
     ESP_LOGI(TAG, "║   DMA-capable:      %+7ld bytes (%+4ld KB)", (long)delta_dma, (long)(delta_dma / 1024));
     ESP_LOGI(TAG, "║   PSRAM:            %+7ld bytes (%+4ld KB)", (long)delta_psram, (long)(delta_psram / 1024));
     ESP_LOGI(TAG, "║   Total Heap:       %+7ld bytes (%+4ld KB)", (long)delta_total, (long)(delta_total / 1024));
+    ESP_LOGI(TAG, "╠═══════════════════════════════════════════════════════════");
+    log_arena_regions();
     ESP_LOGI(TAG, "╚═══════════════════════════════════════════════════════════");
 }
 
@@ -290,6 +347,135 @@ bool memory_manager_check_psram_available(size_t required_bytes) {
     return true;
 }
 
+esp_err_t memory_manager_arena_init(void) {
+    if (g_arena_mutex != NULL) {
+        return ESP_OK;
+    }
+
+    g_arena_mutex = xSemaphoreCreateMutex();
+    if (g_arena_mutex == NULL) {
+        ESP_LOGE(TAG, "Failed to create arena mutex");
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Lay the slots out back to back; each region is then a single reservation
+    uint32_t region_bytes[MEMORY_REGION_COUNT] = {0};
+    for (int i = 0; i < MEMORY_SLOT_COUNT; i++) {
+        const arena_slot_desc_t *desc = &g_slot_desc[i];
+        g_slots[i].offset = region_bytes[desc->region];
+        region_bytes[desc->region] += ARENA_ALIGN_UP(desc->size);
+    }
+
+    esp_err_t ret = ESP_OK;
+    for (int r = 0; r < MEMORY_REGION_COUNT; r++) {
+        g_region_stats[r].name = g_region_names[r];
+        if (!CONFIG_ARENA_ENABLED || region_bytes[r] == 0) {
+            continue;
+        }
+        g_region_base[r] = heap_caps_aligned_alloc(ARENA_SLOT_ALIGN, region_bytes[r], g_region_caps[r]);
+        if (g_region_base[r] == NULL) {
+            ESP_LOGW(TAG, "Arena region %s: failed to reserve %lu bytes (largest block %lu)",
+                     g_region_names[r], (unsigned long)region_bytes[r],
+                     (unsigned long)heap_caps_get_largest_free_block(g_region_caps[r]));
+            ret = ESP_ERR_NO_MEM;
+            continue;
+        }
+        g_region_stats[r].capacity = region_bytes[r];
+        ESP_LOGI(TAG, "Arena region %s: %lu bytes reserved at %p",
+                 g_region_names[r], (unsigned long)region_bytes[r], g_region_base[r]);
+    }
+
+    for (int i = 0; i < MEMORY_SLOT_COUNT; i++) {
+        uint8_t *region_base = g_region_base[g_slot_desc[i].region];
+        g_slots[i].base = (region_base != NULL && g_slot_desc[i].size > 0) ?
+                          region_base + g_slots[i].offset : NULL;
+    }
+
+    return ret;
+}
+
+void *memory_manager_arena_acquire(memory_slot_t slot, size_t bytes) {
+    if (slot >= MEMORY_SLOT_COUNT || bytes == 0) {
+        return NULL;
+    }
+
+    const arena_slot_desc_t *desc = &g_slot_desc[slot];
+    arena_slot_t *entry = &g_slots[slot];
+    memory_region_stats_t *region = &g_region_stats[desc->region];
+    void *ptr = NULL;
+    bool busy = false;
+
+    if (g_arena_mutex != NULL) {
+        xSemaphoreTake(g_arena_mutex, portMAX_DELAY);
+        if (bytes > entry->peak_request) {
+            entry->peak_request = bytes;
+        }
+        busy = (entry->lent != 0);
+        if (entry->base != NULL && !busy && bytes <= desc->size) {
+            entry->lent = bytes;
+            region->in_use += bytes;
+            if (region->in_use > region->high_water) {
+                region->high_water = region->in_use;
+            }
+            ptr = entry->base;
+        } else {
+            region->heap_fallbacks++;
+        }
+        xSemaphoreGive(g_arena_mutex);
+    }
+
+    if (ptr != NULL) {
+        return ptr;
+    }
+
+    if (entry->base != NULL) {
+        ESP_LOGW(TAG, "Arena slot %s %s (%lu of %lu bytes) - using heap", desc->name,
+                 busy ? "busy" : "too small", (unsigned long)bytes, (unsigned long)desc->size);
+    }
+    return heap_caps_malloc(bytes, desc->heap_caps);
+}
+
+void memory_manager_arena_release(memory_slot_t slot, void *ptr) {
+    if (ptr == NULL || slot >= MEMORY_SLOT_COUNT) {
+        return;
+    }
+
+    arena_slot_t *entry = &g_slots[slot];
+    if (ptr != entry->base || g_arena_mutex == NULL) {
+        heap_caps_free(ptr);
+        return;
+    }
+
+    xSemaphoreTake(g_arena_mutex, portMAX_DELAY);
+    g_region_stats[g_slot_desc[slot].region].in_use -= entry->lent;
+    entry->lent = 0;
+    xSemaphoreGive(g_arena_mutex);
+}
+
+size_t memory_manager_arena_slot_capacity(memory_slot_t slot) {
+    if (slot >= MEMORY_SLOT_COUNT || g_slots[slot].base == NULL) {
+        return 0;
+    }
+    return g_slot_desc[slot].size;
+}
+
+esp_err_t memory_manager_arena_get_region_stats(memory_region_t region, memory_region_stats_t *stats) {
+    if (region >= MEMORY_REGION_COUNT || stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (g_arena_mutex != NULL) {
+        xSemaphoreTake(g_arena_mutex, portMAX_DELAY);
+    }
+    memcpy(stats, &g_region_stats[region], sizeof(memory_region_stats_t));
+    stats->name = g_region_names[region];
+    if (g_arena_mutex != NULL) {
+        xSemaphoreGive(g_arena_mutex);
+    }
+
+    return ESP_OK;
+}
+
 esp_err_t memory_manager_optimize(void) {
     if (!g_initialized) {
         return ESP_ERR_INVALID_STATE;
@@ -504,6 +690,23 @@ static void check_memory_thresholds(void) {
     }
 }
 
+static void log_arena_regions(void) {
+    ESP_LOGI(TAG, "║ Arena Regions (capacity / in use / peak / heap fallbacks):");
+    for (int r = 0; r < MEMORY_REGION_COUNT; r++) {
+        memory_region_stats_t region;
+        memory_manager_arena_get_region_stats((memory_region_t)r, &region);
+        ESP_LOGI(TAG, "║   %-13s %7lu / %7lu / %7lu / %lu", region.name,
+                 (unsigned long)region.capacity, (unsigned long)region.in_use,
+                 (unsigned long)region.high_water, (unsigned long)region.heap_fallbacks);
+    }
+    for (int i = 0; i < MEMORY_SLOT_COUNT; i++) {
+        if (g_slots[i].peak_request > g_slot_desc[i].size) {
+            ESP_LOGW(TAG, "║   slot %s peaked at %lu bytes (sized %lu)", g_slot_desc[i].name,
+                     (unsigned long)g_slots[i].peak_request, (unsigned long)g_slot_desc[i].size);
+        }
+    }
+}
+
 static uint32_t calculate_fragmentation_percentage(size_t total, size_t largest_block) {
     if (total == 0) {
         return 0;
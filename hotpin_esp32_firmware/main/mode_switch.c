@@ -0,0 +1,131 @@
+/**
+ * @file mode_switch.c
+ * @brief Readiness events and per-phase timing for voice/camera mode switches
+ */
+
+#include "mode_switch.h"
+#include "config.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include <string.h>
+
+static const char *TAG = TAG_STATE_MGR;
+
+// ===========================
+// Readiness Bits
+// ===========================
+#define READY_PIPELINE_ACTIVE     (1U << 0)   // Server in transcription / llm / tts
+#define READY_PIPELINE_IDLE       (1U << 1)   // Server not processing (inverse of ACTIVE)
+#define READY_PIPELINE_COMPLETE   (1U << 2)   // Last reply reported "complete"
+
+static const char *s_phase_names[MODE_PHASE_COUNT] = {
+    [MODE_PHASE_DRAIN] = "drain",
+    [MODE_PHASE_LOCK] = "lock",
+    [MODE_PHASE_AUDIO] = "audio",
+    [MODE_PHASE_CAMERA] = "camera",
+    [MODE_PHASE_START] = "start",
+};
+
+static EventGroupHandle_t s_ready_events = NULL;
+
+// Only the state manager task runs transitions, so the timing state is unshared
+static mode_switch_report_t s_current = {0};
+static mode_switch_report_t s_last = {0};
+static int64_t s_start_us = 0;
+static int64_t s_mark_us = 0;
+static uint32_t s_switch_count = 0;
+
+// ===========================
+// Public Functions
+// ===========================
+
+esp_err_t mode_switch_init(void) {
+    if (s_ready_events != NULL) {
+        return ESP_OK;
+    }
+    s_ready_events = xEventGroupCreate();
+    if (s_ready_events == NULL) {
+        ESP_LOGE(TAG, "Failed to create mode-switch event group");
+        return ESP_ERR_NO_MEM;
+    }
+    // Boot state: nothing running on the server
+    xEventGroupSetBits(s_ready_events, READY_PIPELINE_IDLE);
+    return ESP_OK;
+}
+
+void mode_switch_set_pipeline_state(bool active, bool complete) {
+    if (s_ready_events == NULL) {
+        return;
+    }
+    EventBits_t set = active ? READY_PIPELINE_ACTIVE : READY_PIPELINE_IDLE;
+    EventBits_t clear = active ? READY_PIPELINE_IDLE : READY_PIPELINE_ACTIVE;
+    if (complete) {
+        set |= READY_PIPELINE_COMPLETE;
+    } else {
+        clear |= READY_PIPELINE_COMPLETE;
+    }
+    xEventGroupClearBits(s_ready_events, clear);
+    xEventGroupSetBits(s_ready_events, set);
+}
+
+bool mode_switch_wait_pipeline_started(uint32_t timeout_ms) {
+    if (s_ready_events == NULL) {
+        vTaskDelay(pdMS_TO_TICKS(timeout_ms));  // Not initialized: degrade to polling
+        return false;
+    }
+    EventBits_t bits = xEventGroupWaitBits(s_ready_events,
+                                           READY_PIPELINE_ACTIVE | READY_PIPELINE_COMPLETE,
+                                           pdFALSE, pdFALSE, pdMS_TO_TICKS(timeout_ms));
+    return (bits & (READY_PIPELINE_ACTIVE | READY_PIPELINE_COMPLETE)) != 0;
+}
+
+bool mode_switch_wait_pipeline_idle(uint32_t timeout_ms) {
+    if (s_ready_events == NULL) {
+        vTaskDelay(pdMS_TO_TICKS(timeout_ms));  // Not initialized: degrade to polling
+        return false;
+    }
+    EventBits_t bits = xEventGroupWaitBits(s_ready_events, READY_PIPELINE_IDLE,
+                                           pdFALSE, pdFALSE, pdMS_TO_TICKS(timeout_ms));
+    return (bits & READY_PIPELINE_IDLE) != 0;
+}
+
+void mode_switch_begin(const char *target) {
+    memset(&s_current, 0, sizeof(s_current));
+    s_current.target = target;
+    s_start_us = esp_timer_get_time();
+    s_mark_us = s_start_us;
+}
+
+void mode_switch_mark(mode_switch_phase_t phase) {
+    if (phase >= MODE_PHASE_COUNT) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    s_current.phase_ms[phase] += (uint32_t)((now - s_mark_us) / 1000);
+    s_mark_us = now;
+}
+
+void mode_switch_end(esp_err_t result) {
+    s_current.result = result;
+    s_current.total_ms = (uint32_t)((esp_timer_get_time() - s_start_us) / 1000);
+    s_current.switch_count = ++s_switch_count;
+    s_last = s_current;
+
+    ESP_LOGI(TAG, "⏱ Mode switch -> %s: %u ms [%s %u | %s %u | %s %u | %s %u | %s %u] (%s)",
+             s_last.target != NULL ? s_last.target : "?",
+             (unsigned int)s_last.total_ms,
+             s_phase_names[MODE_PHASE_DRAIN], (unsigned int)s_last.phase_ms[MODE_PHASE_DRAIN],
+             s_phase_names[MODE_PHASE_LOCK], (unsigned int)s_last.phase_ms[MODE_PHASE_LOCK],
+             s_phase_names[MODE_PHASE_AUDIO], (unsigned int)s_last.phase_ms[MODE_PHASE_AUDIO],
+             s_phase_names[MODE_PHASE_CAMERA], (unsigned int)s_last.phase_ms[MODE_PHASE_CAMERA],
+             s_phase_names[MODE_PHASE_START], (unsigned int)s_last.phase_ms[MODE_PHASE_START],
+             esp_err_to_name(result));
+}
+
+void mode_switch_get_last(mode_switch_report_t *out) {
+    if (out != NULL) {
+        *out = s_last;
+    }
+}
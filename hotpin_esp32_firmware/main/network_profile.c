@@ -0,0 +1,86 @@
+/**
+ * @file network_profile.c
+ * @brief Wi-Fi power save that follows device activity, plus WebSocket socket options
+ */
+
+#include "network_profile.h"
+#include "config.h"
+#include "esp_log.h"
+#include "esp_wifi.h"
+#include "freertos/FreeRTOS.h"
+#include "lwip/sockets.h"
+#include <errno.h>
+
+static const char *TAG = TAG_NET;
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t s_activities = 0;          // net_activity_t bits currently set
+static bool s_wifi_started = false;
+static wifi_ps_type_t s_applied_ps = WIFI_PS_NONE;
+
+static wifi_ps_type_t idle_power_save(void) {
+#if CONFIG_NET_IDLE_MODEM_SLEEP
+    return WIFI_PS_MIN_MODEM;
+#else
+    return WIFI_PS_NONE;
+#endif
+}
+
+static wifi_ps_type_t wanted_power_save(void) {
+    portENTER_CRITICAL(&s_lock);
+    bool active = s_activities != 0;
+    portEXIT_CRITICAL(&s_lock);
+    return active ? WIFI_PS_NONE : idle_power_save();
+}
+
+static esp_err_t apply_power_save(wifi_ps_type_t mode) {
+    esp_err_t ret = esp_wifi_set_ps(mode);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "esp_wifi_set_ps(%d) failed: %s", (int)mode, esp_err_to_name(ret));
+        return ret;
+    }
+    s_applied_ps = mode;
+    ESP_LOGI(TAG, "Wi-Fi power save %s (%s profile)",
+             mode == WIFI_PS_NONE ? "off" : "modem sleep", network_profile_name());
+    return ESP_OK;
+}
+
+esp_err_t network_profile_apply_wifi(void) {
+    s_wifi_started = true;
+    return apply_power_save(wanted_power_save());
+}
+
+void network_profile_set_active(net_activity_t activity, bool active) {
+    portENTER_CRITICAL(&s_lock);
+    if (active) {
+        s_activities |= (uint32_t)activity;
+    } else {
+        s_activities &= ~(uint32_t)activity;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    // Latency profile never leaves WIFI_PS_NONE, so this is a no-op there
+    wifi_ps_type_t mode = wanted_power_save();
+    if (s_wifi_started && mode != s_applied_ps) {
+        apply_power_save(mode);
+    }
+}
+
+esp_err_t network_profile_tune_socket(int sock) {
+    if (sock < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+#if CONFIG_WS_TCP_NODELAY
+    int one = 1;
+    if (setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)) != 0) {
+        ESP_LOGW(TAG, "TCP_NODELAY on socket %d failed: errno %d", sock, errno);
+        return ESP_FAIL;
+    }
+    ESP_LOGD(TAG, "TCP_NODELAY set on socket %d", sock);
+#endif
+    return ESP_OK;
+}
+
+const char *network_profile_name(void) {
+    return (CONFIG_NET_PROFILE == CONFIG_NET_PROFILE_BATTERY) ? "battery" : "latency";
+}
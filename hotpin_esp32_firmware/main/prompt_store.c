@@ -0,0 +1,306 @@
+/**
+ * @file prompt_store.c
+ * @brief Memory-mapped prompt pack in the "prompts" flash partition
+ */
+
+#include "prompt_store.h"
+#include "config.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+static const char *TAG = TAG_PROMPTS;
+
+static const esp_partition_t *s_partition = NULL;
+
+// Current mapping; s_base is NULL whenever there is no valid pack
+static esp_partition_mmap_handle_t s_mmap_handle;
+static bool s_mapped = false;
+static const uint8_t *s_base = NULL;
+static const prompt_pack_entry_t *s_entries = NULL;
+static uint16_t s_count = 0;
+static uint32_t s_version = 0;
+
+// Playback pins the mapping; an update only starts when nothing is playing
+static int s_readers = 0;
+static bool s_updating = false;
+static uint32_t s_update_version = 0;
+static uint32_t s_update_size = 0;
+static uint32_t s_update_next = 0;
+static uint32_t s_erased_to = 0;
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void unmap_pack(void) {
+    if (s_mapped) {
+        esp_partition_munmap(s_mmap_handle);
+        s_mapped = false;
+    }
+    s_base = NULL;
+    s_entries = NULL;
+    s_count = 0;
+    s_version = 0;
+}
+
+static bool entries_valid(const prompt_pack_header_t *header, const prompt_pack_entry_t *entries) {
+    size_t index_end = sizeof(*header) + (size_t)header->count * sizeof(prompt_pack_entry_t);
+    for (uint16_t i = 0; i < header->count; i++) {
+        const prompt_pack_entry_t *entry = &entries[i];
+        if (entry->offset < index_end || entry->length == 0 ||
+            entry->length > header->total_size - entry->offset) {
+            ESP_LOGW(TAG, "Prompt %u lies outside the pack", (unsigned int)entry->id);
+            return false;
+        }
+        if (entry->codec == PROMPT_CODEC_PCM16) {
+            if (entry->length != entry->samples * sizeof(int16_t)) {
+                ESP_LOGW(TAG, "Prompt %u length does not match its sample count", (unsigned int)entry->id);
+                return false;
+            }
+        } else if (entry->codec != PROMPT_CODEC_IMA_ADPCM) {
+            ESP_LOGW(TAG, "Prompt %u uses unknown codec %u", (unsigned int)entry->id, (unsigned int)entry->codec);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Map the partition and check everything but (optionally) the magic, which
+ * an update writes only after this check has passed.
+ */
+static esp_err_t map_pack(bool require_magic) {
+    unmap_pack();
+
+    prompt_pack_header_t header;
+    esp_err_t ret = esp_partition_read(s_partition, 0, &header, sizeof(header));
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if ((require_magic && memcmp(header.magic, PROMPT_PACK_MAGIC, 4) != 0) ||
+        header.format != PROMPT_PACK_FORMAT) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (header.sample_rate != CONFIG_AUDIO_SAMPLE_RATE || header.version == 0 ||
+        header.count > CONFIG_PROMPT_STORE_MAX_CLIPS ||
+        header.total_size > s_partition->size ||
+        header.total_size < sizeof(header) + (size_t)header.count * sizeof(prompt_pack_entry_t)) {
+        ESP_LOGW(TAG, "Prompt pack header rejected (v%u, %u clips, %u bytes, %u Hz)",
+                 (unsigned int)header.version, (unsigned int)header.count,
+                 (unsigned int)header.total_size, (unsigned int)header.sample_rate);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    const void *ptr = NULL;
+    ret = esp_partition_mmap(s_partition, 0, header.total_size, ESP_PARTITION_MMAP_DATA,
+                             &ptr, &s_mmap_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to map prompt partition: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    s_mapped = true;
+
+    const uint8_t *base = (const uint8_t *)ptr;
+    // Same polynomial and conditioning as zlib.crc32 on the server
+    uint32_t crc = esp_rom_crc32_le(0, base + sizeof(header), header.total_size - sizeof(header));
+    if (crc != header.crc32) {
+        ESP_LOGW(TAG, "Prompt pack v%u CRC mismatch (0x%08x != 0x%08x)",
+                 (unsigned int)header.version, (unsigned int)crc, (unsigned int)header.crc32);
+        unmap_pack();
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    const prompt_pack_entry_t *entries = (const prompt_pack_entry_t *)(base + sizeof(header));
+    if (!entries_valid(&header, entries)) {
+        unmap_pack();
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    s_base = base;
+    s_entries = entries;
+    s_count = header.count;
+    s_version = header.version;
+    return ESP_OK;
+}
+
+esp_err_t prompt_store_init(void) {
+#if CONFIG_PROMPT_STORE_ENABLED
+    s_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                           CONFIG_PROMPT_STORE_PARTITION);
+    if (s_partition == NULL) {
+        ESP_LOGW(TAG, "No '%s' partition - spoken prompts disabled", CONFIG_PROMPT_STORE_PARTITION);
+        return ESP_OK;
+    }
+
+    esp_err_t ret = map_pack(true);
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Prompt pack v%u mapped: %u clips", (unsigned int)s_version, (unsigned int)s_count);
+    } else {
+        ESP_LOGI(TAG, "No valid prompt pack (%s) - tones until the server pushes one", esp_err_to_name(ret));
+    }
+#endif
+    return ESP_OK;
+}
+
+uint32_t prompt_store_version(void) {
+    taskENTER_CRITICAL(&s_lock);
+    uint32_t version = s_updating ? 0 : s_version;
+    taskEXIT_CRITICAL(&s_lock);
+    return version;
+}
+
+bool prompt_store_acquire(uint16_t id, prompt_clip_t *clip) {
+    if (clip == NULL) {
+        return false;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    bool available = !s_updating && s_base != NULL;
+    if (available) {
+        s_readers++;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    if (!available) {
+        return false;
+    }
+
+    for (uint16_t i = 0; i < s_count; i++) {
+        if (s_entries[i].id == id) {
+            clip->data = s_base + s_entries[i].offset;
+            clip->length = s_entries[i].length;
+            clip->samples = s_entries[i].samples;
+            clip->codec = s_entries[i].codec;
+            return true;
+        }
+    }
+
+    prompt_store_release();
+    return false;
+}
+
+void prompt_store_release(void) {
+    taskENTER_CRITICAL(&s_lock);
+    if (s_readers > 0) {
+        s_readers--;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+void prompt_store_abort_update(void) {
+    taskENTER_CRITICAL(&s_lock);
+    bool was_updating = s_updating;
+    s_updating = false;
+    taskEXIT_CRITICAL(&s_lock);
+    if (was_updating) {
+        ESP_LOGW(TAG, "Prompt pack v%u update abandoned at %u/%u bytes",
+                 (unsigned int)s_update_version, (unsigned int)s_update_next, (unsigned int)s_update_size);
+    }
+}
+
+static esp_err_t begin_update(uint32_t version, uint32_t total_size, const uint8_t *data, size_t len) {
+    if (version == 0 || total_size < sizeof(prompt_pack_header_t) || total_size > s_partition->size) {
+        ESP_LOGW(TAG, "Pushed prompt pack v%u (%u bytes) does not fit the partition",
+                 (unsigned int)version, (unsigned int)total_size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (len < sizeof(prompt_pack_header_t) || memcmp(data, PROMPT_PACK_MAGIC, 4) != 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    bool busy = (s_readers > 0);
+    if (!busy) {
+        s_updating = true;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    if (busy) {
+        // The server pushes again on the next connect while the versions differ
+        ESP_LOGW(TAG, "Prompt playing - skipping pack update");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    unmap_pack();
+    s_update_version = version;
+    s_update_size = total_size;
+    s_update_next = 0;
+    s_erased_to = 0;
+    ESP_LOGI(TAG, "Receiving prompt pack v%u (%u bytes)", (unsigned int)version, (unsigned int)total_size);
+    return ESP_OK;
+}
+
+esp_err_t prompt_store_write_chunk(uint32_t version, uint32_t total_size, uint32_t offset,
+                                   const uint8_t *data, size_t len) {
+    if (s_partition == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (data == NULL || len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_OK;
+    if (offset == 0) {
+        ret = begin_update(version, total_size, data, len);
+        if (ret != ESP_OK) {
+            prompt_store_abort_update();
+            return ret;
+        }
+    } else if (!s_updating) {
+        return ESP_ERR_INVALID_STATE;   // Tail of an update that was already dropped
+    } else if (version != s_update_version || total_size != s_update_size || offset != s_update_next) {
+        ESP_LOGW(TAG, "Prompt chunk out of sequence (offset %u, expected %u)",
+                 (unsigned int)offset, (unsigned int)s_update_next);
+        prompt_store_abort_update();
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (len > total_size - offset) {
+        prompt_store_abort_update();
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    uint32_t end = offset + (uint32_t)len;
+    while (ret == ESP_OK && s_erased_to < end) {
+        ret = esp_partition_erase_range(s_partition, s_erased_to, s_partition->erase_size);
+        s_erased_to += s_partition->erase_size;
+    }
+
+    // The magic stays erased until the whole pack has been checked
+    if (ret == ESP_OK) {
+        if (offset == 0) {
+            ret = esp_partition_write(s_partition, 4, data + 4, len - 4);
+        } else {
+            ret = esp_partition_write(s_partition, offset, data, len);
+        }
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Prompt pack flash write failed at %u: %s", (unsigned int)offset, esp_err_to_name(ret));
+        prompt_store_abort_update();
+        return ret;
+    }
+    s_update_next = end;
+
+    if (end < total_size) {
+        return ESP_OK;
+    }
+
+    ret = map_pack(false);
+    if (ret == ESP_OK) {
+        unmap_pack();
+        ret = esp_partition_write(s_partition, 0, PROMPT_PACK_MAGIC, 4);
+    }
+    if (ret == ESP_OK) {
+        ret = map_pack(true);
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    s_updating = false;
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Pushed prompt pack v%u rejected: %s", (unsigned int)version, esp_err_to_name(ret));
+        return ret;
+    }
+    ESP_LOGI(TAG, "Prompt pack v%u installed: %u clips", (unsigned int)s_version, (unsigned int)s_count);
+    return ESP_OK;
+}
@@ -7,6 +7,8 @@
 #include "button_handler.h"
 #include "config.h"
 #include "event_dispatcher.h"
+#include "trace.h"
+#include "bench_suite.h"
 #include "esp_log.h"
 #include "driver/uart.h"
 #include "esp_timer.h"
@@ -31,6 +33,10 @@ static void print_help(void) {
     printf("  c - Capture image\n");
     printf("  l - Long press (shutdown simulation)\n");
     printf("  d - Toggle debug mode\n");
+    printf("  e - Show event bus lane stats\n");
+    printf("  t - Dump span trace (Chrome trace JSON)\n");
+    printf("  x - Clear span trace\n");
+    printf("  b - Run hot-path benchmarks (idle pipeline only)\n");
     printf("  h - Show this help\n");
     printf("========================================\n");
     printf("\n");
@@ -112,6 +118,27 @@ static void serial_command_task(void *pvParameters) {
                     ESP_LOGI(TAG, "Debug toggle command");
                     break;
                     
+                case 'e':
+                    // Per-lane posted/dropped/latency counters
+                    event_dispatcher_log_stats();
+                    break;
+                    
+                case 't':
+                    // Paste the JSON between the markers into chrome://tracing or Perfetto
+                    trace_dump_chrome();
+                    break;
+                    
+                case 'x':
+                    trace_clear();
+                    printf("🧹 Span trace cleared\n");
+                    break;
+                    
+                case 'b':
+                    // Same cases and output format as the host build in bench/
+                    printf("⏱️ Running benchmarks (~%d ms per case)...\n", CONFIG_BENCH_MIN_CASE_MS);
+                    bench_suite_run(NULL, 0, NULL, NULL);
+                    break;
+                    
                 case 'h':
                 case '?':
                     // Show help
@@ -138,8 +165,8 @@ static void serial_command_task(void *pvParameters) {
 }
 
 esp_err_t serial_commands_init(void) {
-    if (event_dispatcher_queue() == NULL) {
-        ESP_LOGE(TAG, "Event dispatcher queue not ready");
+    if (!event_dispatcher_is_ready()) {
+        ESP_LOGE(TAG, "Event dispatcher not ready");
         return ESP_ERR_INVALID_STATE;
     }
 
@@ -11,6 +11,7 @@
 #include "state_manager.h"
 #include "config.h"
 #include "camera_controller.h"
+#include "mode_switch.h"
 #include "audio_driver.h"
 #include "feedback_player.h"
 #include "stt_pipeline.h"
@@ -22,6 +23,9 @@
 #include "event_dispatcher.h"
 #include "system_events.h"
 #include "memory_manager.h"
+#include "trace.h"
+#include "turn_metrics.h"
+#include "network_profile.h"
 #include "esp_camera.h"
 #include "esp_log.h"
 #include "esp_task_wdt.h"
@@ -44,6 +48,7 @@ static bool s_tts_playback_active = false;
 static bool s_transition_scheduled = false;
 static bool s_stt_stopped_awaiting_transcription = false;  // ✅ FIX: Track EOS → transcription gap
 static bool s_user_requested_stop = false;  // ✅ FIX: Track user's request to end voice session
+static bool s_vad_turn_ended = false;       // Turn closed by VAD auto-EOS: listen again after the reply
 
 // Safe watchdog reset function to prevent errors when task is not registered
 // ✅ IMPROVED: Suppress common benign errors (ESP_ERR_NOT_FOUND, ESP_ERR_INVALID_ARG)
@@ -69,6 +74,7 @@ extern SemaphoreHandle_t g_i2s_config_mutex;
 #define VOICE_PIPELINE_STAGE_WAIT_MS   20000
 #define VOICE_PIPELINE_STAGE_GUARD_MS  1500
 #define VOICE_TTS_FLUSH_WAIT_MS        5000
+#define MODE_SWITCH_WAIT_SLICE_MS      500     // Readiness waits wake this often to feed the WDT
 
 // ===========================
 // Private Function Declarations
@@ -80,15 +86,22 @@ static esp_err_t handle_shutdown(void);
 static void handle_error_state(void);
 static const char* state_to_string(system_state_t state);
 static void wait_for_voice_pipeline_shutdown(void);
+static esp_err_t run_camera_mode_transition(void);
+static esp_err_t run_voice_mode_transition(void);
 static esp_err_t capture_and_upload_image(void);
 static void process_button_event(const button_event_payload_t *button_event);
 static void process_websocket_status(websocket_status_t status);
 static void execute_capture_sequence(void);
 static void handle_pipeline_stage_event(websocket_pipeline_stage_t stage);
+static void state_manager_on_event(const system_event_t *evt, void *ctx);
+static void register_event_subscribers(void);
 static void handle_stt_started(void);
 static void handle_stt_stopped(void);
 static void handle_tts_playback_started(void);
 static void handle_tts_playback_finished(esp_err_t result);
+static void handle_vad_speech_start(uint32_t speech_ms);
+static void handle_vad_speech_end(uint32_t speech_ms, bool auto_eos);
+static void handle_barge_in(void);
 static bool guardrails_is_pipeline_busy(void);
 static bool guardrails_should_block_button(button_event_type_t type);
 static bool guardrails_should_block_capture(void);
@@ -123,66 +136,27 @@ void state_manager_task(void *pvParameters) {
         }
     }
     
-    QueueHandle_t event_queue = event_dispatcher_queue();
-    while (event_queue == NULL) {
-        ESP_LOGW(TAG, "Waiting for event dispatcher queue...");
+    while (!event_dispatcher_is_ready()) {
+        ESP_LOGW(TAG, "Waiting for event dispatcher...");
         vTaskDelay(pdMS_TO_TICKS(100));
-        event_queue = event_dispatcher_queue();
     }
-
-    system_event_t incoming_event;
+    register_event_subscribers();
+    
+    system_state_t traced_state = current_state;
+    TRACE_INSTANT(TRACE_ID_STATE, ((uint32_t)SYSTEM_STATE_INIT << 8) | (uint32_t)current_state);
     
     while (1) {
         // Reset watchdog timer
         safe_task_wdt_reset();
         
-        if (xQueueReceive(event_queue, &incoming_event, pdMS_TO_TICKS(100)) == pdTRUE) {
-            switch (incoming_event.type) {
-                case SYSTEM_EVENT_BUTTON_INPUT:
-                    process_button_event(&incoming_event.data.button);
-                    break;
-                case SYSTEM_EVENT_WEBSOCKET_STATUS:
-                    process_websocket_status(incoming_event.data.websocket.status);
-                    break;
-                case SYSTEM_EVENT_CAPTURE_REQUEST:
-                    ESP_LOGI(TAG, "Capture request received via event queue");
-                    execute_capture_sequence();
-                    break;
-                case SYSTEM_EVENT_CAPTURE_COMPLETE:
-                    ESP_LOGI(TAG, "Capture complete event: success=%d (%s)",
-                             incoming_event.data.capture.success,
-                             esp_err_to_name(incoming_event.data.capture.result));
-                    break;
-                case SYSTEM_EVENT_SHUTDOWN_REQUEST:
-                    ESP_LOGW(TAG, "Shutdown requested via event queue");
-                    current_state = SYSTEM_STATE_SHUTDOWN;
-                    break;
-                case SYSTEM_EVENT_ERROR_SIGNAL:
-                    ESP_LOGE(TAG, "Error event received (code=%s)",
-                             esp_err_to_name(incoming_event.data.error.code));
-                    current_state = SYSTEM_STATE_ERROR;
-                    break;
-                case SYSTEM_EVENT_STT_STARTED:
-                    handle_stt_started();
-                    break;
-                case SYSTEM_EVENT_STT_STOPPED:
-                    handle_stt_stopped();
-                    break;
-                case SYSTEM_EVENT_TTS_PLAYBACK_STARTED:
-                    handle_tts_playback_started();
-                    break;
-                case SYSTEM_EVENT_TTS_PLAYBACK_FINISHED:
-                    handle_tts_playback_finished(incoming_event.data.tts.result);
-                    break;
-                case SYSTEM_EVENT_PIPELINE_STAGE:
-                    handle_pipeline_stage_event(incoming_event.data.pipeline.stage);
-                    break;
-                case SYSTEM_EVENT_BOOT_COMPLETE:
-                case SYSTEM_EVENT_NONE:
-                default:
-                    // No action required for these events yet
-                    break;
-            }
+        // Handlers run here, on this task, so FSM state stays single-threaded
+        event_dispatcher_dispatch(pdMS_TO_TICKS(100));
+        
+        // State only changes on this task: record where each pass left it
+        // (the steps inside a mode switch show up as its mode_switch span)
+        if (current_state != traced_state) {
+            TRACE_INSTANT(TRACE_ID_STATE, ((uint32_t)traced_state << 8) | (uint32_t)current_state);
+            traced_state = current_state;
         }
         
         // FSM state-specific logic
@@ -558,6 +532,95 @@ static void process_websocket_status(websocket_status_t status)
     }
 }
 
+static void state_manager_on_event(const system_event_t *evt, void *ctx)
+{
+    (void)ctx;
+
+    switch (evt->type) {
+        case SYSTEM_EVENT_BUTTON_INPUT:
+            process_button_event(&evt->data.button);
+            break;
+        case SYSTEM_EVENT_WEBSOCKET_STATUS:
+            process_websocket_status(evt->data.websocket.status);
+            break;
+        case SYSTEM_EVENT_CAPTURE_REQUEST:
+            ESP_LOGI(TAG, "Capture request received via event bus");
+            execute_capture_sequence();
+            break;
+        case SYSTEM_EVENT_CAPTURE_COMPLETE:
+            ESP_LOGI(TAG, "Capture complete event: success=%d (%s)",
+                     evt->data.capture.success,
+                     esp_err_to_name(evt->data.capture.result));
+            break;
+        case SYSTEM_EVENT_SHUTDOWN_REQUEST:
+            ESP_LOGW(TAG, "Shutdown requested via event bus");
+            current_state = SYSTEM_STATE_SHUTDOWN;
+            break;
+        case SYSTEM_EVENT_ERROR_SIGNAL:
+            ESP_LOGE(TAG, "Error event received (code=%s)",
+                     esp_err_to_name(evt->data.error.code));
+            current_state = SYSTEM_STATE_ERROR;
+            break;
+        case SYSTEM_EVENT_STT_STARTED:
+            handle_stt_started();
+            break;
+        case SYSTEM_EVENT_STT_STOPPED:
+            handle_stt_stopped();
+            break;
+        case SYSTEM_EVENT_TTS_PLAYBACK_STARTED:
+            handle_tts_playback_started();
+            break;
+        case SYSTEM_EVENT_TTS_PLAYBACK_FINISHED:
+            handle_tts_playback_finished(evt->data.tts.result);
+            break;
+        case SYSTEM_EVENT_PIPELINE_STAGE:
+            handle_pipeline_stage_event(evt->data.pipeline.stage);
+            break;
+        case SYSTEM_EVENT_VAD_SPEECH_START:
+            handle_vad_speech_start(evt->data.vad.speech_ms);
+            break;
+        case SYSTEM_EVENT_VAD_SPEECH_END:
+            handle_vad_speech_end(evt->data.vad.speech_ms,
+                                  evt->data.vad.auto_eos);
+            break;
+        case SYSTEM_EVENT_BARGE_IN:
+            handle_barge_in();
+            break;
+        case SYSTEM_EVENT_BOOT_COMPLETE:
+        case SYSTEM_EVENT_NONE:
+        default:
+            // No action required for these events yet
+            break;
+    }
+}
+
+static void register_event_subscribers(void)
+{
+    static const system_event_type_t handled[] = {
+        SYSTEM_EVENT_BUTTON_INPUT,
+        SYSTEM_EVENT_WEBSOCKET_STATUS,
+        SYSTEM_EVENT_CAPTURE_REQUEST,
+        SYSTEM_EVENT_CAPTURE_COMPLETE,
+        SYSTEM_EVENT_SHUTDOWN_REQUEST,
+        SYSTEM_EVENT_ERROR_SIGNAL,
+        SYSTEM_EVENT_STT_STARTED,
+        SYSTEM_EVENT_STT_STOPPED,
+        SYSTEM_EVENT_TTS_PLAYBACK_STARTED,
+        SYSTEM_EVENT_TTS_PLAYBACK_FINISHED,
+        SYSTEM_EVENT_PIPELINE_STAGE,
+        SYSTEM_EVENT_VAD_SPEECH_START,
+        SYSTEM_EVENT_VAD_SPEECH_END,
+        SYSTEM_EVENT_BARGE_IN,
+    };
+
+    for (size_t i = 0; i < sizeof(handled) / sizeof(handled[0]); i++) {
+        esp_err_t ret = event_dispatcher_subscribe(handled[i], state_manager_on_event, NULL);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to subscribe to event %d: %s", handled[i], esp_err_to_name(ret));
+        }
+    }
+}
+
 static void handle_pipeline_stage_event(websocket_pipeline_stage_t stage)
 {
     s_pipeline_stage = stage;
@@ -588,6 +651,17 @@ static void handle_pipeline_stage_event(websocket_pipeline_stage_t stage)
             tts_decoder_notify_end_of_stream();
             led_controller_set_state(LED_STATE_SOLID);
             break;
+        case WEBSOCKET_PIPELINE_STAGE_ERROR: {
+            turn_metrics_finish("error");
+            // Say what went wrong ("server busy", "didn't catch that") when the pack has it
+            esp_err_t prompt_ret = feedback_player_play_prompt(websocket_client_error_prompt(),
+                                                               FEEDBACK_SOUND_ERROR);
+            if (prompt_ret != ESP_OK) {
+                ESP_LOGW(TAG, "Failed to play error feedback: %s", esp_err_to_name(prompt_ret));
+            }
+            led_controller_set_state(LED_STATE_SOLID);
+            break;
+        }
         case WEBSOCKET_PIPELINE_STAGE_IDLE:
             // When entering IDLE state, ensure TTS is fully reset for next session
             if (s_pipeline_stage == WEBSOCKET_PIPELINE_STAGE_COMPLETE) {
@@ -634,6 +708,23 @@ static void handle_tts_playback_started(void)
     if (current_state == SYSTEM_STATE_VOICE_ACTIVE) {
         led_controller_set_state(LED_STATE_SOLID);
     }
+
+#if CONFIG_AUDIO_FULL_DUPLEX
+    // Hands-free turn: listen through the reply so the user can talk over it,
+    // instead of re-arming capture only once playback has finished
+    if (current_state == SYSTEM_STATE_VOICE_ACTIVE && s_vad_turn_ended &&
+        !stt_pipeline_is_recording()) {
+        esp_err_t stt_ret = stt_pipeline_start();
+        if (stt_ret == ESP_OK) {
+            s_vad_turn_ended = false;
+            stt_pipeline_arm_barge_in();
+            ESP_LOGI(TAG, "🎤 Listening during playback (barge-in armed)");
+        } else {
+            // Leave s_vad_turn_ended set: playback-finished re-arms the old way
+            ESP_LOGW(TAG, "Full-duplex capture unavailable: %s", esp_err_to_name(stt_ret));
+        }
+    }
+#endif
 }
 
 static void handle_tts_playback_finished(esp_err_t result)
@@ -645,6 +736,9 @@ static void handle_tts_playback_finished(esp_err_t result)
     }
 
     s_tts_playback_active = false;
+    // Speech from here on is an ordinary new turn, not an interruption
+    stt_pipeline_disarm_barge_in();
+    turn_metrics_finish(result == ESP_OK ? "complete" : "playback_error");
 
     // ✅ FIX: Check if user had previously requested to stop the session
     // If so, now is the safe time to transition back to camera mode
@@ -684,10 +778,70 @@ static void handle_tts_playback_finished(esp_err_t result)
             
             // Small delay to ensure LED state is visible before accepting new input
             vTaskDelay(pdMS_TO_TICKS(100));
+
+            // The last turn was ended by the VAD, not the button: re-arm capture so the
+            // conversation continues hands-free
+            if (s_vad_turn_ended) {
+                s_vad_turn_ended = false;
+                esp_err_t stt_ret = stt_pipeline_start();
+                if (stt_ret != ESP_OK) {
+                    ESP_LOGE(TAG, "Failed to re-arm STT after VAD turn: %s", esp_err_to_name(stt_ret));
+                } else {
+                    ESP_LOGI(TAG, "🎤 Listening for next utterance");
+                }
+            }
         }
     }
 }
 
+static void handle_vad_speech_start(uint32_t speech_ms)
+{
+    ESP_LOGI(TAG, "VAD: speech started (onset %u ms)", (unsigned int)speech_ms);
+    if (current_state == SYSTEM_STATE_VOICE_ACTIVE) {
+        led_controller_set_state(LED_STATE_SOLID);
+    }
+}
+
+static void handle_vad_speech_end(uint32_t speech_ms, bool auto_eos)
+{
+    ESP_LOGI(TAG, "VAD: speech ended after %u ms%s", (unsigned int)speech_ms,
+             auto_eos ? " - auto EOS" : "");
+    if (current_state != SYSTEM_STATE_VOICE_ACTIVE) {
+        return;
+    }
+
+    if (auto_eos) {
+        // STT_STOPPED follows once the uplink drains; show "processing" right away
+        s_vad_turn_ended = true;
+        led_controller_set_state(LED_STATE_PULSING);
+    }
+}
+
+static void handle_barge_in(void)
+{
+    if (current_state != SYSTEM_STATE_VOICE_ACTIVE) {
+        return;
+    }
+
+    ESP_LOGI(TAG, "✋ Barge-in: cutting the reply short, capture continues");
+
+    // Not playing yet (still buffering the first chunk) is fine: the server drops the rest
+    esp_err_t ret = tts_decoder_interrupt();
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGW(TAG, "TTS interrupt failed: %s", esp_err_to_name(ret));
+    }
+
+    // The server stops streaming and answers {"status":"interrupted"}, which makes
+    // the session ready again so the capture already in progress can upload
+    ret = websocket_client_send_text("{\"signal\":\"BARGE_IN\"}");
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to send BARGE_IN signal: %s", esp_err_to_name(ret));
+    }
+    turn_metrics_finish("interrupted");
+
+    led_controller_set_state(LED_STATE_SOLID);
+}
+
 // ===========================
 // Private Functions
 // ===========================
@@ -696,19 +850,13 @@ static void wait_for_voice_pipeline_shutdown(void) {
     TickType_t guard_start = xTaskGetTickCount();
     const TickType_t guard_timeout = pdMS_TO_TICKS(VOICE_PIPELINE_STAGE_GUARD_MS);
 
-    // Guard window: allow the server to transition into an active stage after EOS
-    while (!websocket_client_is_pipeline_active()) {
-        websocket_pipeline_stage_t stage = websocket_client_get_pipeline_stage();
-        if (stage == WEBSOCKET_PIPELINE_STAGE_COMPLETE) {
-            break;  // Complete, can proceed
-        }
-
+    // Guard window: allow the server to transition into an active stage after EOS.
+    // websocket_client publishes stage changes as events, so this wakes immediately
+    while (!mode_switch_wait_pipeline_started(MODE_SWITCH_WAIT_SLICE_MS)) {
         if ((xTaskGetTickCount() - guard_start) >= guard_timeout) {
             break;
         }
-
         safe_task_wdt_reset();
-        vTaskDelay(pdMS_TO_TICKS(50));
     }
 
     const TickType_t overall_start = xTaskGetTickCount();
@@ -737,7 +885,7 @@ static void wait_for_voice_pipeline_shutdown(void) {
         }
 
         safe_task_wdt_reset();
-        vTaskDelay(pdMS_TO_TICKS(50));
+        mode_switch_wait_pipeline_idle(MODE_SWITCH_WAIT_SLICE_MS);
     }
 
     // Wait for TTS playback to complete before proceeding
@@ -845,8 +993,9 @@ static void wait_for_voice_pipeline_shutdown(void) {
     }
     
     // CRITICAL FIX: Additional safety check: ensure all audio components are truly idle before proceeding
-    // This prevents race conditions where audio might still be processing
-    vTaskDelay(pdMS_TO_TICKS(200)); // Extra 200ms delay to ensure audio processing completes
+    // This prevents race conditions where audio might still be processing.
+    // Returns as soon as the playback task has exited instead of a fixed 200ms sleep.
+    tts_decoder_wait_for_idle(200);
     
     // Final check: ensure TTS decoder is really stopped
     if (tts_decoder_is_playing()) {
@@ -856,6 +1005,17 @@ static void wait_for_voice_pipeline_shutdown(void) {
 }
 
 static esp_err_t transition_to_camera_mode(void) {
+    mode_switch_begin("camera");
+    TRACE_SPAN_BEGIN(mode);
+    esp_err_t ret = run_camera_mode_transition();
+    TRACE_SPAN_END(mode, TRACE_ID_MODE_SWITCH, SYSTEM_STATE_CAMERA_STANDBY);
+    mode_switch_end(ret);
+    // The voice session is over; the "battery" profile may let the modem sleep again
+    network_profile_set_active(NET_ACTIVITY_VOICE, false);
+    return ret;
+}
+
+static esp_err_t run_camera_mode_transition(void) {
     ESP_LOGI(TAG, "=== TRANSITION TO CAMERA MODE ===");
     
     // Log memory state before transition
@@ -880,11 +1040,12 @@ static esp_err_t transition_to_camera_mode(void) {
         s_pipeline_stage = WEBSOCKET_PIPELINE_STAGE_IDLE;
         s_stt_stopped_awaiting_transcription = false;  // ✅ FIX: Reset flag when exiting voice mode
 
-        // Small delay for tasks to finish
-        vTaskDelay(pdMS_TO_TICKS(100));
+        // Wait for the playback task to actually exit rather than a fixed 100ms
+        tts_decoder_wait_for_idle(100);
 
         audio_was_initialized = audio_driver_is_initialized();
     }
+    mode_switch_mark(MODE_PHASE_DRAIN);
     
     // Step 2: Acquire I2S mutex (CRITICAL SECTION)
     ESP_LOGI(TAG, "Acquiring I2S mutex...");
@@ -892,41 +1053,53 @@ static esp_err_t transition_to_camera_mode(void) {
         ESP_LOGE(TAG, "Failed to acquire I2S mutex - timeout");
         return ESP_ERR_TIMEOUT;
     }
+    mode_switch_mark(MODE_PHASE_LOCK);
     
-    // Step 3: Deinitialize audio drivers if active
+    // Step 3: Park audio drivers if active. With CONFIG_MODE_SWITCH_KEEP_I2S the
+    // channels are only disabled, so their DMA stays reserved for the next voice
+    // session and nothing is freed that could fragment the DMA heap.
     if (audio_was_initialized) {
-        ESP_LOGI(TAG, "Deinitializing audio drivers...");
-        ret = audio_driver_deinit();
+        ESP_LOGI(TAG, "Suspending audio drivers...");
+        ret = audio_driver_suspend();
         if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to deinit audio: %s", esp_err_to_name(ret));
+            ESP_LOGE(TAG, "Failed to suspend audio: %s", esp_err_to_name(ret));
             xSemaphoreGive(g_i2s_config_mutex);
             return ret;
         }
-        // Ensure audio driver state is updated after deinit
-        vTaskDelay(pdMS_TO_TICKS(50));  // Brief stabilization delay
     } else {
-        ESP_LOGI(TAG, "Audio drivers already inactive; skipping deinit");
+        ESP_LOGI(TAG, "Audio drivers already inactive; skipping suspend");
     }
     
-    // ✅ FIX #4: Allow memory allocator to stabilize and consolidate free blocks
-    // After audio deinit, DMA memory is highly fragmented (56% typical)
-    // Brief delay allows allocator background tasks to coalesce free blocks
-    ESP_LOGI(TAG, "Allowing memory stabilization (100ms)...");
-    vTaskDelay(pdMS_TO_TICKS(100));
+    // ✅ FIX #4: After a full audio deinit DMA memory is highly fragmented (56% typical).
+    // i2s_del_channel() frees synchronously, so no settle delay is needed before
+    // the camera headroom check below; with KEEP_I2S nothing was freed at all.
+    mode_switch_mark(MODE_PHASE_AUDIO);
     
     // ✅ FIX #5: Camera will be initialized ONLY when capturing (on-demand init)
     // This keeps camera deinitialized in CAMERA_STANDBY to free ~46KB DMA memory
     // Previously camera stayed initialized consuming DMA, causing audio feedback failures
-    ESP_LOGI(TAG, "Camera will be initialized on-demand during capture");
+    // CONFIG_CAMERA_WARM_STANDBY relaxes this once the mutex is released, if DMA headroom allows
+    ESP_LOGI(TAG, "Camera stays off during transition (warm standby or on-demand init follows)");
     
     // Step 4: Release I2S mutex
     xSemaphoreGive(g_i2s_config_mutex);
     ESP_LOGI(TAG, "I2S mutex released");
+
+    // Warm the camera now so the first shot skips the power cycle and driver init;
+    // refused (camera stays off) when it would leave too little DMA RAM for audio
+    if (CONFIG_CAMERA_WARM_STANDBY) {
+        esp_err_t warm_ret = camera_controller_enter_warm_standby();
+        if (warm_ret != ESP_OK) {
+            ESP_LOGW(TAG, "Camera warm standby unavailable (%s) - using on-demand init", esp_err_to_name(warm_ret));
+        }
+    }
+    mode_switch_mark(MODE_PHASE_CAMERA);
     
     // Log memory state after transition
     memory_manager_log_stats("After Camera Transition");
     
-    ESP_LOGI(TAG, "✅ Camera mode transition complete (camera deinitialized to conserve DMA)");
+    ESP_LOGI(TAG, "✅ Camera mode transition complete (camera %s)",
+             camera_controller_is_warm() ? "in warm standby" : "deinitialized to conserve DMA");
 
     if (previous_state == SYSTEM_STATE_VOICE_ACTIVE) {
         esp_err_t stop_sound_ret = feedback_player_play(FEEDBACK_SOUND_REC_STOP);
@@ -935,6 +1108,7 @@ static esp_err_t transition_to_camera_mode(void) {
         }
         led_controller_set_state(LED_STATE_BREATHING);
     }
+    mode_switch_mark(MODE_PHASE_START);
 
     return ESP_OK;
 }
@@ -942,27 +1116,29 @@ static esp_err_t transition_to_camera_mode(void) {
 static esp_err_t capture_and_upload_image(void) {
     ESP_LOGI(TAG, "Capturing frame from camera");
 
-    // ✅ FIX #5: Initialize camera ONLY when capturing to free DMA memory
-    // Camera consumes ~46KB DMA memory in standby mode, causing audio feedback init failures
-    // By init/deinit per capture, we free DMA for other operations
-    esp_err_t ret = camera_controller_init();
+    // Warm standby keeps the sensor initialized between shots; when it is off (or
+    // DMA headroom was too small) this falls back to the per-capture init of FIX #5
+    bool was_warm = camera_controller_is_warm();
+    esp_err_t ret = camera_controller_begin_capture();
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to initialize camera for capture: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "Failed to prepare camera for capture: %s", esp_err_to_name(ret));
+        camera_controller_deinit();
         return ret;
     }
-    
-    // Brief stabilization after camera init
-    vTaskDelay(pdMS_TO_TICKS(50));
+    ESP_LOGI(TAG, "Camera ready (%s start)", was_warm ? "warm" : "cold");
 
-    camera_fb_t *fb = camera_controller_capture_frame();
-    if (fb == NULL) {
-        ESP_LOGE(TAG, "Frame capture failed");
+    // Burst with the server-selected profile; only the best-scored frame is uploaded
+    camera_capture_t capture;
+    ret = camera_controller_capture_best(camera_controller_get_profile(), &capture);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Frame capture failed: %s", esp_err_to_name(ret));
         // Deinit camera even on failure to free DMA memory
         camera_controller_deinit();
         return ESP_FAIL;
     }
 
-    ESP_LOGI(TAG, "Frame captured: %zu bytes", fb->len);
+    ESP_LOGI(TAG, "Frame captured: %zu bytes (%s profile, best of %u)",
+             capture.len, camera_profile_name(capture.profile), (unsigned int)capture.frames_scored);
 
     // CRITICAL FIX: Use the same session ID as WebSocket connection to ensure
     // image context is available when processing audio queries.
@@ -970,16 +1146,30 @@ static esp_err_t capture_and_upload_image(void) {
     // session ID, causing image context mismatch.
     const char *session_id = CONFIG_WEBSOCKET_SESSION_ID;
 
-    ESP_LOGI(TAG, "Uploading image using session %s", session_id);
-    char response[512];
-    ret = http_client_upload_image(session_id, fb->buf, fb->len,
-                                             response, sizeof(response));
+    // Prefer the already-authenticated session socket: the server binds the image to
+    // the handshake session, so no second connection or session field is needed
+    bool sent_over_ws = false;
+    if (CONFIG_IMAGE_UPLOAD_OVER_WEBSOCKET && websocket_client_is_connected()) {
+        ESP_LOGI(TAG, "Sending image over WebSocket (session %s)", session_id);
+        ret = websocket_client_send_image(capture.data, capture.len, CONFIG_WS_IMAGE_SEND_TIMEOUT_MS);
+        sent_over_ws = (ret == ESP_OK);
+        if (!sent_over_ws) {
+            ESP_LOGW(TAG, "WebSocket image send failed (%s) - falling back to HTTP", esp_err_to_name(ret));
+        }
+    }
+
+    if (!sent_over_ws) {
+        ESP_LOGI(TAG, "Uploading image using session %s", session_id);
+        char response[512];
+        ret = http_client_upload_image(session_id, capture.data, capture.len,
+                                                 response, sizeof(response));
+    }
 
-    esp_camera_fb_return(fb);
+    camera_controller_release_capture(&capture);
     
-    // ✅ FIX #5: Deinitialize camera immediately after capture to free ~46KB DMA memory
-    camera_controller_deinit();
-    ESP_LOGI(TAG, "Camera deinitialized - DMA memory freed");
+    // Back to warm standby, or deinit to free ~46KB DMA memory (FIX #5) when not affordable
+    camera_controller_end_capture();
+    ESP_LOGI(TAG, "Camera %s", camera_controller_is_warm() ? "returned to warm standby" : "deinitialized - DMA memory freed");
 
     if (ret == ESP_OK) {
         ESP_LOGI(TAG, "Image uploaded successfully");
@@ -1034,7 +1224,9 @@ static esp_err_t handle_camera_capture(void) {
     // Camera is now initialized ON-DEMAND inside capture_and_upload_image() per Fix #5
     // This prevents double initialization crashes and optimizes DMA memory usage
     
+    network_profile_set_active(NET_ACTIVITY_UPLOAD, true);
     ret = capture_and_upload_image();
+    network_profile_set_active(NET_ACTIVITY_UPLOAD, false);
     capture_success = (ret == ESP_OK);
 
     // ✅ FIX #8: Removed obsolete audio restoration logic
@@ -1063,11 +1255,26 @@ static esp_err_t handle_camera_capture(void) {
 }
 
 static esp_err_t transition_to_voice_mode(void) {
+    mode_switch_begin("voice");
+    TRACE_SPAN_BEGIN(mode);
+    // Wake the modem first so the session's first frames see no power-save latency
+    network_profile_set_active(NET_ACTIVITY_VOICE, true);
+    esp_err_t ret = run_voice_mode_transition();
+    if (ret != ESP_OK) {
+        network_profile_set_active(NET_ACTIVITY_VOICE, false);
+    }
+    TRACE_SPAN_END(mode, TRACE_ID_MODE_SWITCH, SYSTEM_STATE_VOICE_ACTIVE);
+    mode_switch_end(ret);
+    return ret;
+}
+
+static esp_err_t run_voice_mode_transition(void) {
     ESP_LOGI(TAG, "=== TRANSITION TO VOICE MODE ===");
     
     // ✅ FIX: Initialize flags at start of voice session
     s_stt_stopped_awaiting_transcription = false;
     s_user_requested_stop = false;
+    s_vad_turn_ended = false;
     
     // Log memory state before transition
     memory_manager_log_stats("Before Voice Transition");
@@ -1095,6 +1302,7 @@ static esp_err_t transition_to_voice_mode(void) {
     }
     int64_t mutex_time = (esp_timer_get_time() - mutex_start) / 1000;
     ESP_LOGI(TAG, "  ✓ Mutex acquired (took %"PRIu32" ms)", (uint32_t)mutex_time);
+    mode_switch_mark(MODE_PHASE_LOCK);
     
     // Step 3: Deinitialize camera
     ESP_LOGI(TAG, "╔══════════════════════════════════════════════════");
@@ -1117,23 +1325,20 @@ static esp_err_t transition_to_voice_mode(void) {
     ESP_LOGI(TAG, "  Free heap after: %u bytes", (unsigned int)esp_get_free_heap_size());
     ESP_LOGI(TAG, "  Free PSRAM after: %u bytes", (unsigned int)heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
     
-    // CRITICAL: Extended delay to allow camera interrupt resources to be fully released
-    ESP_LOGI(TAG, "╔══════════════════════════════════════════════════");
-    ESP_LOGI(TAG, "║ HARDWARE STABILIZATION - CRITICAL");
-    ESP_LOGI(TAG, "╚══════════════════════════════════════════════════");
-    ESP_LOGI(TAG, "  Phase 1: Initial settle (100ms) - Free camera interrupts");
-    vTaskDelay(pdMS_TO_TICKS(100));
-    
-    ESP_LOGI(TAG, "  Phase 2: GPIO matrix settle (100ms) - Reconfigure pins");
-    vTaskDelay(pdMS_TO_TICKS(100));
-    
-    ESP_LOGI(TAG, "  Phase 3: Final settle (50ms) - Stabilize state");
-    vTaskDelay(pdMS_TO_TICKS(50));
-    
-    ESP_LOGI(TAG, "  ✓ Total stabilization: 250ms");
-    ESP_LOGI(TAG, "  Timestamp: %lld ms", (long long)(esp_timer_get_time() / 1000));
+    // Hardware stabilization: the camera runs on I2S0 and audio on its own controller
+    // (CONFIG_I2S_STD_PORT) with disjoint pins, and esp_camera_deinit() releases its
+    // interrupt and DMA synchronously. Resuming parked channels touches neither the
+    // GPIO matrix nor the allocator, so the old fixed 250ms settle is only kept for
+    // a full (re)initialization.
+    int64_t stabilization_time = 0;
+    if (!audio_driver_is_suspended()) {
+        ESP_LOGI(TAG, "  Full I2S init pending - settling 250ms after camera release");
+        vTaskDelay(pdMS_TO_TICKS(250));
+        stabilization_time = 250;
+    }
+    mode_switch_mark(MODE_PHASE_CAMERA);
     
-    // Step 4: Initialize audio drivers (I2S0 full-duplex)
+    // Step 4: Resume (or initialize) audio drivers (full-duplex)
     ESP_LOGI(TAG, "╔══════════════════════════════════════════════════");
     ESP_LOGI(TAG, "║ STEP 4: Initializing I2S audio drivers");
     ESP_LOGI(TAG, "╚══════════════════════════════════════════════════");
@@ -1156,13 +1361,14 @@ static esp_err_t transition_to_voice_mode(void) {
     }
     ESP_LOGI(TAG, "  ✓ Audio initialized (took %"PRIu32" ms)", (uint32_t)audio_init_time);
     ESP_LOGI(TAG, "  Free heap after: %u bytes", (unsigned int)esp_get_free_heap_size());
+    mode_switch_mark(MODE_PHASE_AUDIO);
     
     // Step 5: Release I2S mutex
     xSemaphoreGive(g_i2s_config_mutex);
     ESP_LOGI(TAG, "╔══════════════════════════════════════════════════");
     ESP_LOGI(TAG, "║ STEP 5: I2S mutex released");
     ESP_LOGI(TAG, "║ Total transition time: %"PRIu32" ms", 
-             (uint32_t)(mutex_time + cam_deinit_time + 250 + audio_init_time));
+             (uint32_t)(mutex_time + cam_deinit_time + stabilization_time + audio_init_time));
     ESP_LOGI(TAG, "╚══════════════════════════════════════════════════");
     
     // Step 6: Start STT and TTS pipelines with additional error handling
@@ -1187,9 +1393,7 @@ static esp_err_t transition_to_voice_mode(void) {
     // This ensures sequential operation: STT upload → Server processing → TTS download
     ESP_LOGI(TAG, "TTS decoder will start automatically when server begins TTS streaming");
     
-    // Add safety delay to allow pipeline initialization
-    vTaskDelay(pdMS_TO_TICKS(50));
-    
+    // stt_pipeline_start() returns once its tasks are created; no extra settle delay
     esp_err_t start_sound_ret = feedback_player_play(FEEDBACK_SOUND_REC_START);
     if (start_sound_ret != ESP_OK) {
         ESP_LOGW(TAG, "Voice start feedback failed: %s", esp_err_to_name(start_sound_ret));
@@ -1198,6 +1402,7 @@ static esp_err_t transition_to_voice_mode(void) {
     
     // Log memory state after transition
     memory_manager_log_stats("After Voice Transition");
+    mode_switch_mark(MODE_PHASE_START);
     
     ESP_LOGI(TAG, "✅ Voice mode transition complete");
     return ESP_OK;
@@ -1258,6 +1463,7 @@ static void handle_error_state(void) {
     
     // ✅ FIX: Reset pending transition flags in error state
     s_user_requested_stop = false;
+    s_vad_turn_ended = false;
     s_stt_stopped_awaiting_transcription = false;
     
     // Attempt recovery based on previous state
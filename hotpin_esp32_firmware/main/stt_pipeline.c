@@ -9,21 +9,32 @@
  * - EOS (End-of-Stream) signaling
  */
 
+// Before any include: esp_log.h reads LOG_LOCAL_LEVEL at each ESP_LOGx call
+#define LOG_LOCAL_LEVEL CONFIG_LOG_FLOOR_STT
+
 #include "stt_pipeline.h"
 #include "config.h"
+#include "log_manager.h"
+#include "stt_ring.h"
 #include "audio_driver.h"
 #include "websocket_client.h"
 #include "event_dispatcher.h"
 #include "system_events.h"
+#include "vad.h"
+#include "audio_codec.h"
+#include "feedback_player.h"
+#include "memory_manager.h"
+#include "trace.h"
+#include "turn_metrics.h"
 #include "esp_log.h"
 #include "esp_heap_caps.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/semphr.h"
 #include "freertos/event_groups.h"
 #include <string.h>
 #include <inttypes.h>
+#include <stdatomic.h>
 
 static const char *TAG = TAG_STT;
 
@@ -37,12 +48,37 @@ static stt_pipeline_handle_t s_pipeline_ctx = {
 };
 
 // Ring buffer for audio accumulation
+// Lock-free single-producer (audio_capture_task) / single-consumer (audio_streaming_task),
+// see stt_ring.h for the head/tail/read-cursor rules
 static uint8_t *g_audio_ring_buffer = NULL;
-static size_t g_ring_buffer_size = CONFIG_STT_RING_BUFFER_SIZE;
-static size_t g_ring_buffer_write_pos = 0;
-static size_t g_ring_buffer_read_pos = 0;
-static size_t g_ring_buffer_count = 0;
-static SemaphoreHandle_t g_ring_buffer_mutex = NULL;
+static const size_t g_ring_buffer_size = CONFIG_STT_RING_BUFFER_SIZE;
+static stt_ring_t g_ring;
+
+// Encoded uplink frames (streaming task only); unused when the session negotiates pcm16.
+// Two halves so one chunk can encode while the previous one waits in the send queue.
+#define UPLINK_ENCODE_HALVES 2
+static uint8_t *g_uplink_encode_buffer = NULL;
+static size_t g_uplink_encode_capacity = 0;         // Per half
+static bool g_uplink_encode_busy[UPLINK_ENCODE_HALVES];
+
+#if CONFIG_STT_VAD_ENABLED
+// VAD gate state (capture task only). While the gate is closed, audio goes into a
+// small pre-roll ring instead of the STT ring so the onset is not clipped when
+// speech is confirmed CONFIG_STT_VAD_ONSET_MS later.
+#define STT_VAD_PREROLL_BYTES  ((CONFIG_AUDIO_SAMPLE_RATE * 2 * CONFIG_STT_VAD_PREROLL_MS) / 1000)
+static vad_state_t s_vad;
+static uint8_t *g_vad_preroll = NULL;
+static size_t g_vad_preroll_pos = 0;      // Next write offset
+static size_t g_vad_preroll_fill = 0;     // Valid bytes (<= STT_VAD_PREROLL_BYTES)
+#endif
+
+#if CONFIG_AUDIO_FULL_DUPLEX
+// Full-duplex capture: started while a reply is still playing. The gate is
+// echo-aware and, while armed, a speech onset interrupts the reply.
+static atomic_bool s_duplex_capture = false;
+static atomic_bool s_barge_in_armed = false;
+static uint32_t s_echo_coupling_q8 = CONFIG_BARGE_IN_COUPLING_Q8;  // Capture task only, kept across turns
+#endif
 
 // Task handles
 static TaskHandle_t g_audio_capture_task_handle = NULL;
@@ -55,27 +91,68 @@ static bool is_recording = false;
 static bool is_running = false;
 static bool s_stop_event_posted = false;
 
-// ✅ PRIORITY 2: Flow control for backpressure handling
-// Tracks chunks sent vs acknowledged by server to prevent send buffer saturation
+// Audio capture configuration
+#define AUDIO_STREAM_CHUNK_MIN       1024  // Smallest adaptive chunk (32ms of audio)
+#define AUDIO_STREAM_CHUNK_MAX       8192  // Largest adaptive chunk (256ms of audio)
+#define AUDIO_STREAM_CHUNK_INITIAL   2048  // Starting chunk before any RTT sample
+#define AUDIO_STREAM_CHUNK_STEP      1024  // Additive growth per clean ACK
+#define AUDIO_STREAM_MAX_IN_FLIGHT   4     // Chunks allowed on the wire without ACK
+#define AUDIO_STREAM_DEFAULT_WINDOW  (16 * 1024)  // Credit used until the server advertises one
+#define AUDIO_STREAM_ACK_TIMEOUT_MS  1000  // Abort if no credit returns within this time
+#define AUDIO_STREAM_SLOW_SEND_MS    40    // A socket write taking longer than this is TX backpressure
+#define AUDIO_STREAM_BYTES_PER_SEC   (CONFIG_AUDIO_SAMPLE_RATE * 2)
+#define AUDIO_STREAM_TX_SLOTS        AUDIO_STREAM_MAX_IN_FLIGHT  // Chunks queued on the WebSocket, not yet written
+
+// Uplink chunks handed to the WebSocket send queue. Slots are filled and reaped
+// in order by the streaming task; the completion callback (WebSocket TX task)
+// only records the result. seq is the free-running submission number, so a
+// completion from an abandoned session never matches a reused slot.
+typedef struct {
+    uint32_t seq;
+    uint32_t ring_end;              // Read cursor after this chunk's span
+    int8_t encode_half;             // Encode buffer half holding the payload, -1 for a ring span
+    atomic_bool done;
+    esp_err_t result;
+    uint32_t send_ms;
+} uplink_tx_slot_t;
+
+static uplink_tx_slot_t g_uplink_tx[AUDIO_STREAM_TX_SLOTS];
+static uint32_t g_uplink_tx_head = 0;   // Next seq to submit
+static uint32_t g_uplink_tx_tail = 0;   // Oldest seq not yet reaped
+
+// Sliding-window (credit) flow control for the STT uplink.
+// The server advertises a byte window ("flow_window" on connect, "window_bytes" on
+// every ACK) and acknowledges cumulative "bytes_received". The streaming task keeps
+// up to AUDIO_STREAM_MAX_IN_FLIGHT chunks / window_bytes outstanding and sizes chunks
+// from the smoothed RTT, halving them when the TCP send path pushes back.
+// ACK fields are written from the WebSocket task; everything else is owned by the
+// streaming task.
 typedef struct {
     uint32_t chunks_sent;           // Total chunks sent to server
-    uint32_t last_ack_chunk;        // Last acknowledged chunk number from server
-    TickType_t last_ack_time;       // Timestamp of last ACK
+    uint32_t bytes_sent;            // Total bytes sent to server
+    volatile uint32_t last_ack_chunk;   // Last acknowledged chunk number from server
+    volatile uint32_t bytes_acked;      // Cumulative bytes acknowledged by server
+    volatile uint32_t window_bytes;     // Server-advertised credit (persists across sessions)
+    volatile bool byte_acks_seen;       // Server reports bytes (else fall back to chunk counting)
+    volatile TickType_t last_ack_time;  // Timestamp of last ACK
+    volatile int64_t last_ack_us;       // esp_timer time of last ACK (RTT sampling)
     bool waiting_for_ack;           // Flag indicating we're waiting for ACK
+    struct {
+        uint32_t end_offset;        // bytes_sent after this chunk
+        int64_t sent_us;            // esp_timer time the send completed
+    } in_flight[AUDIO_STREAM_MAX_IN_FLIGHT];
+    uint32_t in_flight_head;
+    uint32_t in_flight_tail;
+    uint32_t srtt_ms;               // Smoothed RTT (0 = no sample yet)
+    size_t chunk_size;              // Current adaptive chunk size
 } flow_control_t;
 
 static flow_control_t g_flow_control = {
-    .chunks_sent = 0,
-    .last_ack_chunk = 0,
-    .last_ack_time = 0,
-    .waiting_for_ack = false
+    .window_bytes = AUDIO_STREAM_DEFAULT_WINDOW,
+    .chunk_size = AUDIO_STREAM_CHUNK_INITIAL,
 };
-
-// Audio capture configuration
-#define AUDIO_CAPTURE_CHUNK_SIZE     1024  // Bytes per read (32ms @ 16kHz, 16-bit)
-#define AUDIO_STREAM_CHUNK_SIZE      4096  // Bytes per WebSocket send
-#define AUDIO_CAPTURE_TIMEOUT_MS     100
-#define AUDIO_STREAM_SEND_TIMEOUT_MS 250   // Timeout for WebSocket writes
+#define AUDIO_CAPTURE_TIMEOUT_MS     100   // Max wait for one RX DMA completion (one buffer = ~64ms)
+#define AUDIO_STREAM_SEND_TIMEOUT_MS 250   // Wait for room in the WebSocket send queue
 #define AUDIO_STREAM_HEALTH_LOG_MS   5000  // Periodic health log interval
 #define AUDIO_STREAM_MAX_SEND_FAILURES 3    // Abort threshold for consecutive send failures
 #define STT_TASK_STOP_WAIT_MS        500    // Wait time for tasks to self-terminate
@@ -89,7 +166,11 @@ static void audio_streaming_task(void *pvParameters);
 static size_t ring_buffer_available_space(void);
 static size_t ring_buffer_available_data(void);
 static esp_err_t ring_buffer_write(const uint8_t *data, size_t len) __attribute__((noinline));
-static esp_err_t ring_buffer_read(uint8_t *data, size_t len, size_t *bytes_read) __attribute__((noinline));
+static size_t ring_buffer_peek_contiguous(const uint8_t **span, size_t max_len);
+static void ring_buffer_commit_read(size_t len);
+static size_t ring_buffer_unsent_data(void);
+static void ring_buffer_release_to(uint32_t pos);
+static void ring_buffer_request_flush(void);
 static void stt_pipeline_mark_stopped(void);
 static void stt_pipeline_dispatch_stop_event(void);
 static void stt_pipeline_reset_ring_buffer(void);
@@ -97,6 +178,24 @@ static void stt_pipeline_wait_for_capture_idle(TickType_t deadline_ticks);
 static void stt_pipeline_wait_for_streaming_idle(TickType_t deadline_ticks);
 static bool stt_pipeline_stop_signal_received(void);
 static inline void stt_pipeline_notify_capture_idle(void);
+static void flow_control_reset_session(void);
+static bool flow_control_has_credit(size_t next_len);
+static void flow_control_on_sent(size_t len);
+static void flow_control_on_backpressure(void);
+static void flow_control_process_acks(void);
+static void uplink_tx_done(esp_err_t result, uint32_t send_ms, void *ctx);
+static esp_err_t uplink_tx_reap(uint32_t *consecutive_failures, uint32_t *dropped_send_fail);
+static void uplink_tx_drain(uint32_t timeout_ms);
+static int uplink_tx_free_encode_half(void);
+#if CONFIG_STT_VAD_ENABLED
+static void vad_preroll_push(const uint8_t *data, size_t len);
+static void vad_preroll_flush_to_ring(void);
+static void stt_pipeline_post_vad_event(system_event_type_t type, bool auto_eos);
+#endif
+#if CONFIG_AUDIO_FULL_DUPLEX
+static uint16_t echo_floor_for(uint16_t tx_level);
+static void echo_coupling_learn(uint16_t tx_level, uint16_t mic_level);
+#endif
 
 // ===========================
 // Public Functions
@@ -121,8 +220,8 @@ esp_err_t stt_pipeline_init(void) {
     ESP_LOGI(TAG, "  Free DMA-capable: %u bytes", (unsigned int)heap_caps_get_free_size(MALLOC_CAP_DMA));
     ESP_LOGI(TAG, "  Free PSRAM: %u bytes", (unsigned int)heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
     
-    ESP_LOGI(TAG, "[ALLOCATION] Allocating %zu KB ring buffer in external PSRAM...", g_ring_buffer_size / 1024);
-    g_audio_ring_buffer = heap_caps_malloc(g_ring_buffer_size, MALLOC_CAP_SPIRAM);
+    ESP_LOGI(TAG, "[ALLOCATION] Borrowing %zu KB ring buffer from the PSRAM arena...", g_ring_buffer_size / 1024);
+    g_audio_ring_buffer = memory_manager_arena_acquire(MEMORY_SLOT_STT_RING, g_ring_buffer_size);
     if (g_audio_ring_buffer == NULL) {
         ESP_LOGE(TAG, "❌ CRITICAL: Failed to allocate ring buffer in PSRAM");
         ESP_LOGE(TAG, "  Requested: %zu bytes (%zu KB)", g_ring_buffer_size, g_ring_buffer_size / 1024);
@@ -148,26 +247,48 @@ esp_err_t stt_pipeline_init(void) {
     for (size_t i = 0; i < g_ring_buffer_size; i++) {
         g_audio_ring_buffer[i] = 0;
     }
-    g_ring_buffer_write_pos = 0;
-    g_ring_buffer_read_pos = 0;
-    g_ring_buffer_count = 0;
-    
-    // Create ring buffer mutex
-    g_ring_buffer_mutex = xSemaphoreCreateMutex();
-    if (g_ring_buffer_mutex == NULL) {
-        ESP_LOGE(TAG, "Failed to create ring buffer mutex");
-        heap_caps_free(g_audio_ring_buffer);
+    stt_ring_init(&g_ring, g_audio_ring_buffer, g_ring_buffer_size);
+
+#if CONFIG_STT_VAD_ENABLED
+    g_vad_preroll = memory_manager_arena_acquire(MEMORY_SLOT_STT_VAD_PREROLL, STT_VAD_PREROLL_BYTES);
+    if (g_vad_preroll == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate %u byte VAD pre-roll buffer", (unsigned int)STT_VAD_PREROLL_BYTES);
+        memory_manager_arena_release(MEMORY_SLOT_STT_RING, g_audio_ring_buffer);
         g_audio_ring_buffer = NULL;
         return ESP_ERR_NO_MEM;
     }
+#endif
+
+    // Worst case over every codec this build can negotiate
+    g_uplink_encode_capacity = 0;
+    for (audio_codec_t codec = AUDIO_CODEC_IMA_ADPCM; codec <= AUDIO_CODEC_OPUS; codec++) {
+        if (audio_codec_is_supported(codec)) {
+            size_t cap = audio_codec_max_encoded_size(codec, AUDIO_STREAM_CHUNK_MAX);
+            if (cap > g_uplink_encode_capacity) {
+                g_uplink_encode_capacity = cap;
+            }
+        }
+    }
+    if (g_uplink_encode_capacity > 0) {
+        size_t total = g_uplink_encode_capacity * UPLINK_ENCODE_HALVES;
+        g_uplink_encode_buffer = memory_manager_arena_acquire(MEMORY_SLOT_STT_UPLINK_ENCODE, total);
+        if (g_uplink_encode_buffer == NULL) {
+            // Not fatal: sessions fall back to pcm16 when there is nowhere to encode into
+            ESP_LOGW(TAG, "Failed to allocate %u byte uplink encode buffer - PCM16 only",
+                     (unsigned int)total);
+            g_uplink_encode_capacity = 0;
+        }
+    }
 
     if (s_pipeline_ctx.stream_events == NULL) {
         s_pipeline_ctx.stream_events = xEventGroupCreate();
         if (s_pipeline_ctx.stream_events == NULL) {
             ESP_LOGE(TAG, "Failed to create stream control event group");
-            vSemaphoreDelete(g_ring_buffer_mutex);
-            g_ring_buffer_mutex = NULL;
-            heap_caps_free(g_audio_ring_buffer);
+#if CONFIG_STT_VAD_ENABLED
+            memory_manager_arena_release(MEMORY_SLOT_STT_VAD_PREROLL, g_vad_preroll);
+            g_vad_preroll = NULL;
+#endif
+            memory_manager_arena_release(MEMORY_SLOT_STT_RING, g_audio_ring_buffer);
             g_audio_ring_buffer = NULL;
             return ESP_ERR_NO_MEM;
         }
@@ -187,11 +308,13 @@ esp_err_t stt_pipeline_init(void) {
 
         if (stream_ret != pdPASS) {
             ESP_LOGE(TAG, "Failed to create persistent audio streaming task");
-            vSemaphoreDelete(g_ring_buffer_mutex);
-            g_ring_buffer_mutex = NULL;
             vEventGroupDelete(s_pipeline_ctx.stream_events);
             s_pipeline_ctx.stream_events = NULL;
-            heap_caps_free(g_audio_ring_buffer);
+#if CONFIG_STT_VAD_ENABLED
+            memory_manager_arena_release(MEMORY_SLOT_STT_VAD_PREROLL, g_vad_preroll);
+            g_vad_preroll = NULL;
+#endif
+            memory_manager_arena_release(MEMORY_SLOT_STT_RING, g_audio_ring_buffer);
             g_audio_ring_buffer = NULL;
             return ESP_FAIL;
         }
@@ -233,22 +356,30 @@ esp_err_t stt_pipeline_deinit(void) {
     }
 
     // Free resources in order with proper NULL checks
-    if (g_ring_buffer_mutex != NULL) {
-        vSemaphoreDelete(g_ring_buffer_mutex);
-        g_ring_buffer_mutex = NULL;
-    }
-
     if (s_pipeline_ctx.stream_events != NULL) {
         vEventGroupDelete(s_pipeline_ctx.stream_events);
         s_pipeline_ctx.stream_events = NULL;
     }
 
-    // Safely free the PSRAM ring buffer
+    // Hand the PSRAM ring buffer back to the arena
     if (g_audio_ring_buffer != NULL) {
-        heap_caps_free(g_audio_ring_buffer);
+        memory_manager_arena_release(MEMORY_SLOT_STT_RING, g_audio_ring_buffer);
         g_audio_ring_buffer = NULL;  // Set to NULL after freeing to prevent double-free
     }
 
+#if CONFIG_STT_VAD_ENABLED
+    if (g_vad_preroll != NULL) {
+        memory_manager_arena_release(MEMORY_SLOT_STT_VAD_PREROLL, g_vad_preroll);
+        g_vad_preroll = NULL;
+    }
+#endif
+
+    if (g_uplink_encode_buffer != NULL) {
+        memory_manager_arena_release(MEMORY_SLOT_STT_UPLINK_ENCODE, g_uplink_encode_buffer);
+        g_uplink_encode_buffer = NULL;
+        g_uplink_encode_capacity = 0;
+    }
+
     g_streaming_active = false;
 
     is_initialized = false;
@@ -275,12 +406,21 @@ esp_err_t stt_pipeline_start(void) {
         return ESP_ERR_INVALID_STATE;
     }
     
-    // Reset ring buffer positions
-    xSemaphoreTake(g_ring_buffer_mutex, portMAX_DELAY);
-    g_ring_buffer_write_pos = 0;
-    g_ring_buffer_read_pos = 0;
-    g_ring_buffer_count = 0;
-    xSemaphoreGive(g_ring_buffer_mutex);
+    // Arm the flags and reset the ring BEFORE the producer exists: the capture
+    // loop runs only while is_running, and nothing may reset the ring under it
+    is_running = true;
+    is_recording = true;
+    s_stop_event_posted = false;
+#if CONFIG_AUDIO_FULL_DUPLEX
+    atomic_store(&s_duplex_capture, false);
+    atomic_store(&s_barge_in_armed, false);
+#endif
+    stt_pipeline_reset_ring_buffer();
+
+    xEventGroupClearBits(s_pipeline_ctx.stream_events,
+                         STT_STREAM_EVENT_START |
+                         STT_STREAM_EVENT_STOP |
+                         STT_STREAM_EVENT_CAPTURE_IDLE);
     
     // CRITICAL FIX: Pin audio capture task to Core 0 (same as Wi-Fi) to resolve hardware bus contention
     // The LoadStoreError was caused by Wi-Fi (Core 0) and I2S DMA (Core 1) competing for memory bus access
@@ -299,18 +439,12 @@ esp_err_t stt_pipeline_start(void) {
     
     if (ret != pdPASS) {
         ESP_LOGE(TAG, "Failed to create audio capture task");
+        is_running = false;
+        is_recording = false;
+        g_audio_capture_task_handle = NULL;
         return ESP_FAIL;
     }
     
-    is_running = true;
-    is_recording = true;
-    s_stop_event_posted = false;
-    stt_pipeline_reset_ring_buffer();
-
-    xEventGroupClearBits(s_pipeline_ctx.stream_events,
-                         STT_STREAM_EVENT_START |
-                         STT_STREAM_EVENT_STOP |
-                         STT_STREAM_EVENT_CAPTURE_IDLE);
     xEventGroupSetBits(s_pipeline_ctx.stream_events, STT_STREAM_EVENT_START);
 
     system_event_t evt = {
@@ -344,25 +478,17 @@ esp_err_t stt_pipeline_stop(void) {
         xEventGroupClearBits(s_pipeline_ctx.stream_events, STT_STREAM_EVENT_CAPTURE_IDLE);
     }
 
+    // Button release: the turn's latency is measured from here
+    turn_metrics_speech_ended();
     stt_pipeline_mark_stopped();
 
     // CRITICAL: Drain the ring buffer to prevent data carryover to next session
-    // Also clear any accumulated data in PSRAM to prevent fragmentation
-    if (g_ring_buffer_count > 0) {
-        ESP_LOGI(TAG, "Draining ring buffer (%zu bytes pending) before shutdown...", (unsigned int)g_ring_buffer_count);
-        xSemaphoreTake(g_ring_buffer_mutex, portMAX_DELAY);
-        
-        // Zero out the ring buffer to clear accumulated audio data and reduce PSRAM fragmentation
-        // This is critical because PSRAM fragmentation can occur from repeated audio sessions
-        if (g_audio_ring_buffer != NULL) {
-            memset(g_audio_ring_buffer, 0, g_ring_buffer_size);
-        }
-        
-        g_ring_buffer_write_pos = 0;
-        g_ring_buffer_read_pos = 0;
-        g_ring_buffer_count = 0;
-        xSemaphoreGive(g_ring_buffer_mutex);
-        ESP_LOGI(TAG, "Ring buffer drained and cleared successfully");
+    // The consumer owns the tail, so ask it to drop pending bytes instead of
+    // rewinding indices underneath it. The full reset below runs once both tasks are idle.
+    size_t pending = ring_buffer_available_data();
+    if (pending > 0) {
+        ESP_LOGI(TAG, "Draining ring buffer (%u bytes pending) before shutdown...", (unsigned int)pending);
+        ring_buffer_request_flush();
     }
 
     TickType_t deadline_ticks = xTaskGetTickCount() + pdMS_TO_TICKS(STT_TASK_STOP_WAIT_MS);
@@ -387,17 +513,36 @@ bool stt_pipeline_is_recording(void) {
     return is_recording;
 }
 
-void stt_pipeline_update_flow_control(uint32_t ack_chunk_number) {
-    // ✅ PRIORITY 2: Update flow control state when server sends ACK
-    // This allows the streaming task to resume sending if it was waiting for backpressure
-    g_flow_control.last_ack_chunk = ack_chunk_number;
-    g_flow_control.last_ack_time = xTaskGetTickCount();
+void stt_pipeline_update_flow_control(uint32_t ack_chunk_number, uint32_t ack_bytes, uint32_t window_bytes) {
+    // Update credit state when the server sends an ACK / window advertisement.
+    // The streaming task is woken directly so it never polls for credit.
+    if (window_bytes > 0) {
+        g_flow_control.window_bytes = window_bytes;
+    }
+
+    if (ack_chunk_number > 0 || ack_bytes > 0) {
+        // Ignore stale ACKs from a previous utterance that arrive after the session reset
+        if (ack_bytes <= g_flow_control.bytes_sent && ack_chunk_number <= g_flow_control.chunks_sent) {
+            g_flow_control.last_ack_chunk = ack_chunk_number;
+            if (ack_bytes > 0) {
+                g_flow_control.bytes_acked = ack_bytes;
+                g_flow_control.byte_acks_seen = true;
+            }
+            g_flow_control.last_ack_time = xTaskGetTickCount();
+            g_flow_control.last_ack_us = esp_timer_get_time();
+        }
+    }
     
     // Log if we were waiting - indicates successful backpressure resolution
     if (g_flow_control.waiting_for_ack) {
-        ESP_LOGI(TAG, "Flow control: ACK received, resuming (sent=%u, acked=%u)",
-                 (unsigned int)g_flow_control.chunks_sent,
-                 (unsigned int)g_flow_control.last_ack_chunk);
+        ESP_LOGD(TAG, "Flow control: credit returned (sent=%u, acked=%u, window=%u)",
+                 (unsigned int)g_flow_control.bytes_sent,
+                 (unsigned int)g_flow_control.bytes_acked,
+                 (unsigned int)g_flow_control.window_bytes);
+    }
+
+    if (g_audio_streaming_task_handle != NULL) {
+        xTaskNotifyGive(g_audio_streaming_task_handle);
     }
 }
 
@@ -419,6 +564,34 @@ const stt_pipeline_handle_t *stt_pipeline_get_handle(void) {
     return &s_pipeline_ctx;
 }
 
+void stt_pipeline_arm_barge_in(void) {
+#if CONFIG_AUDIO_FULL_DUPLEX
+    if (!is_running || !is_recording) {
+        return;
+    }
+    atomic_store(&s_duplex_capture, true);
+    if (!atomic_exchange(&s_barge_in_armed, true)) {
+        ESP_LOGI(TAG, "Barge-in armed (echo coupling %u/256)", (unsigned int)s_echo_coupling_q8);
+    }
+#endif
+}
+
+void stt_pipeline_disarm_barge_in(void) {
+#if CONFIG_AUDIO_FULL_DUPLEX
+    if (atomic_exchange(&s_barge_in_armed, false)) {
+        ESP_LOGI(TAG, "Barge-in disarmed");
+    }
+#endif
+}
+
+bool stt_pipeline_is_duplex_capture(void) {
+#if CONFIG_AUDIO_FULL_DUPLEX
+    return is_running && atomic_load(&s_duplex_capture);
+#else
+    return false;
+#endif
+}
+
 // ===========================
 // Private Functions
 // ===========================
@@ -437,17 +610,6 @@ static void audio_capture_task(void *pvParameters) {
         return;
     }
     
-    // ESP_LOGI(TAG, "╔════════════════════════════════════════════════════");
-    // ESP_LOGI(TAG, "║ Audio Capture Task Started on Core %d", xPortGetCoreID());
-    // ESP_LOGI(TAG, "╚════════════════════════════════════════════════════");
-    
-    // CRITICAL: Extended wait for I2S hardware to fully stabilize before first read
-    ESP_LOGI(TAG, "[STABILIZATION] Phase 1: Waiting 200ms for I2S DMA...");
-    ESP_LOGI(TAG, "  Current time: %lld ms", (long long)(esp_timer_get_time() / 1000));
-    ESP_LOGI(TAG, "  Free heap: %u bytes", (unsigned int)esp_get_free_heap_size());
-    vTaskDelay(pdMS_TO_TICKS(200));
-    
-    ESP_LOGI(TAG, "[STABILIZATION] Phase 2: Verify audio driver state...");
     if (!audio_driver_is_initialized()) {
         ESP_LOGE(TAG, "❌ CRITICAL: Audio driver not initialized!");
         if (g_audio_capture_task_handle == xTaskGetCurrentTaskHandle()) {
@@ -457,168 +619,159 @@ static void audio_capture_task(void *pvParameters) {
         vTaskDelete(NULL);
         return;
     }
-    ESP_LOGI(TAG, "  ✓ Audio driver initialized");
-    
-    ESP_LOGI(TAG, "[STABILIZATION] Phase 3: Additional 100ms settle...");
-    vTaskDelay(pdMS_TO_TICKS(100));
-    ESP_LOGI(TAG, "  Total stabilization: 300ms");
-    ESP_LOGI(TAG, "  Timestamp: %lld ms", (long long)(esp_timer_get_time() / 1000));
-    
-    ESP_LOGI(TAG, "[BUFFER] Allocating %d byte capture buffer...", AUDIO_CAPTURE_CHUNK_SIZE);
-    // CRITICAL: Use DMA-capable memory from INTERNAL RAM (MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL)
-    // IMPORTANT: Add extra safety padding to prevent buffer overflows
-    uint8_t *capture_buffer = heap_caps_malloc(AUDIO_CAPTURE_CHUNK_SIZE + 32, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
-    if (capture_buffer == NULL) {
-        ESP_LOGE(TAG, "❌ Failed to allocate DMA-capable capture buffer");
-        ESP_LOGE(TAG, "  Requested: %d bytes", AUDIO_CAPTURE_CHUNK_SIZE + 32);
-        ESP_LOGE(TAG, "  Free heap: %u bytes", (unsigned int)esp_get_free_heap_size());
-        ESP_LOGE(TAG, "  Free DMA-capable: %u bytes", (unsigned int)heap_caps_get_free_size(MALLOC_CAP_DMA));
-        g_audio_capture_task_handle = NULL;
+
+    // ✅ Interrupt-driven capture: the I2S on_recv DMA callback publishes each completed
+    // DMA buffer and wakes this task. No polling delays and no g_i2s_access_mutex on the
+    // mic path; the first notification is itself the "RX DMA is running" signal, so the
+    // old fixed 300ms stabilization wait is gone too.
+    esp_err_t ret = audio_driver_rx_stream_start(xTaskGetCurrentTaskHandle());
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "❌ Failed to attach RX DMA stream: %s", esp_err_to_name(ret));
+        if (g_audio_capture_task_handle == xTaskGetCurrentTaskHandle()) {
+            g_audio_capture_task_handle = NULL;
+        }
         stt_pipeline_notify_capture_idle();
         vTaskDelete(NULL);
         return;
     }
-    ESP_LOGI(TAG, "  ✓ DMA-capable buffer allocated at %p (with safety padding)", capture_buffer);
-    
-    // Zero out buffer with extra safety padding to prevent memory corruption
-    memset(capture_buffer, 0, AUDIO_CAPTURE_CHUNK_SIZE + 32);
-    
-    // Add memory guard pattern to detect buffer overflows
-    memset(capture_buffer + AUDIO_CAPTURE_CHUNK_SIZE, 0xDE, 16);  // Guard bytes
-    memset(capture_buffer + AUDIO_CAPTURE_CHUNK_SIZE + 16, 0xAD, 16);  // More guard bytes
-    
-    // Verify memory alignment (must be 4-byte aligned for DMA)
-    if (((uintptr_t)capture_buffer) & 0x3) {
-        ESP_LOGW(TAG, "⚠ Capture buffer not 4-byte aligned - potential DMA issue");
-    }
-    
-    size_t bytes_read = 0;
+
+    audio_rx_frame_t frames[CONFIG_I2S_DMA_BUF_COUNT];
     uint32_t total_bytes_captured = 0;
-    uint32_t read_count = 0;
-    uint32_t error_count = 0;
+    uint32_t frame_count = 0;
+    uint32_t dropped_frames = 0;
+    uint32_t timeout_count = 0;
+    uint32_t last_overruns = 0;
+    bool end_of_speech = false;
+#if CONFIG_STT_VAD_ENABLED
+    uint32_t gated_bytes = 0;
+
+    vad_init(&s_vad);
+    g_vad_preroll_pos = 0;
+    g_vad_preroll_fill = 0;
+#endif
     
     // CANARY: Static counter for continuous health monitoring
     static uint32_t alive_counter = 0;
     
     ESP_LOGI(TAG, "╔════════════════════════════════════════════════════");
-    ESP_LOGI(TAG, "║ 🎤 STARTING AUDIO CAPTURE");
-    ESP_LOGI(TAG, "║ Chunk size: %d bytes | Timeout: %d ms", AUDIO_CAPTURE_CHUNK_SIZE, AUDIO_CAPTURE_TIMEOUT_MS);
+    ESP_LOGI(TAG, "║ 🎤 STARTING AUDIO CAPTURE (DMA callback driven)");
+    ESP_LOGI(TAG, "║ DMA buffers: %d x %d samples | Timeout: %d ms",
+             CONFIG_I2S_DMA_BUF_COUNT, CONFIG_I2S_DMA_BUF_LEN, AUDIO_CAPTURE_TIMEOUT_MS);
+#if CONFIG_STT_VAD_ENABLED
+    ESP_LOGI(TAG, "║ VAD gate: onset %d ms | hangover %d ms | pre-roll %d ms | auto-EOS %s",
+             CONFIG_STT_VAD_ONSET_MS, CONFIG_STT_VAD_HANGOVER_MS, CONFIG_STT_VAD_PREROLL_MS,
+             CONFIG_STT_VAD_AUTO_EOS ? "on" : "off");
+#endif
     ESP_LOGI(TAG, "╚════════════════════════════════════════════════════");
     
     while (is_running) {
+        // Block until the RX ISR signals at least one completed DMA buffer
+        uint32_t notified = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(AUDIO_CAPTURE_TIMEOUT_MS));
+        TRACE_SPAN_BEGIN(fetch);
+        size_t n = audio_driver_rx_stream_fetch(frames, CONFIG_I2S_DMA_BUF_COUNT);
+        TRACE_SPAN_END(fetch, TRACE_ID_I2S_RX_FETCH, n);
+
+        if (notified == 0 && n == 0) {
+            if (is_recording) {
+                timeout_count++;
+                LOGW_RL(TAG, "⚠ No RX DMA completion within %d ms (timeouts=%u)",
+                        AUDIO_CAPTURE_TIMEOUT_MS, (unsigned int)timeout_count);
+            }
+            continue;
+        }
+
+        // Not recording (e.g. capture cancelled while the pipeline is busy): consume and discard
         if (!is_recording) {
-            vTaskDelay(pdMS_TO_TICKS(20));
             continue;
         }
 
-        int64_t read_start = esp_timer_get_time();
-        
-        // Read audio from I2S RX (microphone)
-        esp_err_t ret = audio_driver_read(capture_buffer, AUDIO_CAPTURE_CHUNK_SIZE, 
-                                           &bytes_read, AUDIO_CAPTURE_TIMEOUT_MS);
-        
-        int64_t read_duration = (esp_timer_get_time() - read_start) / 1000;
-        read_count++;
-        
-        // Log first read with minimal diagnostics to prevent InstructionFetchError
-        if (read_count == 1) {
-            ESP_LOGD(TAG, "[FIRST READ] Completed: %zu bytes, duration: %lld ms", bytes_read, (long long)read_duration);
-            
-            // CRITICAL: Small delay for cache coherency after DMA transfer
-            if (bytes_read >= 16) {
-                vTaskDelay(pdMS_TO_TICKS(1)); // 1ms to ensure DMA completion
-                // Removed verbose hex dump logging to prevent InstructionFetchError from excessive logging
-                // ESP_LOGI(TAG, "  First 16 bytes: %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x",
-                //          capture_buffer[0], capture_buffer[1], capture_buffer[2], capture_buffer[3],
-                //          capture_buffer[4], capture_buffer[5], capture_buffer[6], capture_buffer[7],
-                //          capture_buffer[8], capture_buffer[9], capture_buffer[10], capture_buffer[11],
-                //          capture_buffer[12], capture_buffer[13], capture_buffer[14], capture_buffer[15]);
+        for (size_t i = 0; i < n && !end_of_speech; i++) {
+#if CONFIG_STT_VAD_ENABLED
+#if CONFIG_AUDIO_FULL_DUPLEX
+            // Echo reference: whatever the speaker played recently sets the gate's floor
+            uint16_t tx_level = audio_driver_tx_reference_level(CONFIG_BARGE_IN_ECHO_WINDOW_MS);
+            vad_set_echo_floor(&s_vad, echo_floor_for(tx_level));
+#endif
+            vad_event_t vad_evt = vad_process(&s_vad, (const int16_t *)frames[i].data,
+                                              frames[i].len / sizeof(int16_t));
+#if CONFIG_AUDIO_FULL_DUPLEX
+            if (vad_evt == VAD_EVENT_NONE && !vad_in_speech(&s_vad)) {
+                echo_coupling_learn(tx_level, s_vad.last_energy);
             }
-        }
-        
-        if (ret == ESP_OK && bytes_read > 0) {
-            // Write to ring buffer
-            ret = ring_buffer_write(capture_buffer, bytes_read);
+#endif
+            if (vad_evt == VAD_EVENT_SPEECH_START) {
+                ESP_LOGI(TAG, "🗣 Speech detected (energy=%u, zcr=%u) - opening uplink gate",
+                         (unsigned int)s_vad.last_energy, (unsigned int)s_vad.last_zcr);
+                vad_preroll_flush_to_ring();
+                stt_pipeline_post_vad_event(SYSTEM_EVENT_VAD_SPEECH_START, false);
+#if CONFIG_AUDIO_FULL_DUPLEX
+                if (atomic_exchange(&s_barge_in_armed, false)) {
+                    ESP_LOGI(TAG, "✋ Barge-in: speech over playback (tx level=%u)", (unsigned int)tx_level);
+                    stt_pipeline_post_vad_event(SYSTEM_EVENT_BARGE_IN, false);
+                }
+#endif
+            } else if (vad_evt == VAD_EVENT_NONE && !vad_in_speech(&s_vad)) {
+                // Gate closed: leading/inter-utterance silence stays on the device
+                vad_preroll_push(frames[i].data, frames[i].len);
+                gated_bytes += frames[i].len;
+                continue;
+            }
+#endif
+            TRACE_SPAN_BEGIN(ring);
+            ret = ring_buffer_write(frames[i].data, frames[i].len);
+            TRACE_SPAN_END(ring, TRACE_ID_STT_RING_WRITE, frames[i].len);
             if (ret == ESP_OK) {
-                total_bytes_captured += bytes_read;
+                total_bytes_captured += frames[i].len;
+                frame_count++;
                 
-                // CANARY: Continuous health monitoring - log every 500 successful reads (reduced frequency to prevent crash)
+                // CANARY: Continuous health monitoring - log every 500 DMA frames
                 alive_counter++;
-                if (alive_counter % 500 == 0) {  // Reduced from 100 to 500 to significantly reduce logging
-                    ESP_LOGI(TAG, "[CAPTURE] ✅ Alive... %u reads completed (Free Heap: %u bytes)", 
-                             (unsigned int)alive_counter, (unsigned int)esp_get_free_heap_size());
-                }
-                
-                // Reduce logging frequency - only log every 200 reads to prevent system overload
-                if (read_count % 200 == 0) {  // Changed from 10 to 200 to significantly reduce logging
-                    ESP_LOGD(TAG, "[CAPTURE] Read #%u: %zu bytes (total: %u bytes, %.1f KB)",
-                             (unsigned int)read_count, bytes_read, (unsigned int)total_bytes_captured, total_bytes_captured / 1024.0);
-                    ESP_LOGD(TAG, "  Avg read time: %lld ms | Errors: %u", (long long)read_duration, (unsigned int)error_count);
+                if (alive_counter % 500 == 0) {
+                    LOGI_DEFER(TAG, "[CAPTURE] ✅ Alive... %u frames captured (Free Heap: %u bytes)",
+                               (unsigned int)alive_counter, (unsigned int)esp_get_free_heap_size());
                 }
             } else {
-                ESP_LOGW(TAG, "⚠ Ring buffer full - dropping %zu bytes (read #%u)", bytes_read, (unsigned int)read_count);
-                // CRITICAL: Implement flow control to prevent buffer overruns
-                // Check available space and wait if buffer is too full
-                size_t available_space = ring_buffer_available_space();
-                if (available_space < (g_ring_buffer_size / 4)) {  // If less than 25% space available
-                    ESP_LOGW(TAG, "Buffer critically full - implementing backpressure (%zu bytes free)", (unsigned int)available_space);
-                    // Wait for buffer to drain before continuing
-                    const TickType_t wait_start = xTaskGetTickCount();
-                    const TickType_t max_wait = pdMS_TO_TICKS(1000);  // Maximum 1 second wait
-                    
-                    while ((xTaskGetTickCount() - wait_start) < max_wait) {
-                        available_space = ring_buffer_available_space();
-                        if (available_space >= (g_ring_buffer_size / 2)) {  // Wait until 50% space available
-                            break;
-                        }
-                        vTaskDelay(pdMS_TO_TICKS(50));  // Check every 50ms
-                    }
-                    
-                    if (available_space < (g_ring_buffer_size / 2)) {
-                        ESP_LOGE(TAG, "Buffer still full after backpressure wait - continuing with reduced sampling");
-                    }
-                }
-                vTaskDelay(pdMS_TO_TICKS(5));  // Small delay to reduce sampling rate
+                // Live audio cannot be paused, so a full ring means the frame is lost
+                dropped_frames++;
+                LOGW_RL(TAG, "⚠ Ring buffer full - dropping %zu bytes (dropped=%u, free=%u)",
+                        frames[i].len, (unsigned int)dropped_frames,
+                        (unsigned int)ring_buffer_available_space());
             }
-        } else if (ret != ESP_OK) {
-            error_count++;
-            ESP_LOGE(TAG, "❌ I2S read error #%u (read #%u): %s", (unsigned int)error_count, (unsigned int)read_count, esp_err_to_name(ret));
-            ESP_LOGE(TAG, "  Bytes read: %zu | Duration: %lld ms", bytes_read, (long long)read_duration);
-            ESP_LOGE(TAG, "  Free heap: %u bytes", (unsigned int)esp_get_free_heap_size());
-            
-            // If first few reads fail, something is seriously wrong
-            if (read_count < 5) {
-                ESP_LOGE(TAG, "❌ CRITICAL: Early read failure - I2S may not be properly initialized");
+
+#if CONFIG_STT_VAD_ENABLED
+            if (vad_evt == VAD_EVENT_SPEECH_END) {
+                ESP_LOGI(TAG, "🤫 End of speech after %u ms (hangover %d ms)",
+                         (unsigned int)s_vad.speech_ms, CONFIG_STT_VAD_HANGOVER_MS);
+                stt_pipeline_post_vad_event(SYSTEM_EVENT_VAD_SPEECH_END, CONFIG_STT_VAD_AUTO_EOS != 0);
+                end_of_speech = (CONFIG_STT_VAD_AUTO_EOS != 0);
             }
-            
-            vTaskDelay(pdMS_TO_TICKS(10));
+#endif
         }
-        
-        // Add a small delay to prevent the task from monopolizing the CPU
-        vTaskDelay(pdMS_TO_TICKS(1));
-    }
-    
-    ESP_LOGI(TAG, "Audio capture task stopped (captured %u bytes total)", (unsigned int)total_bytes_captured);
-    // Free buffer with safety padding
-    if (capture_buffer != NULL) {
-        // Check guard bytes before freeing (debug only)
-        #ifdef CONFIG_ENABLE_DEBUG_LOGS
-        const uint8_t *guard1 = capture_buffer + AUDIO_CAPTURE_CHUNK_SIZE;
-        const uint8_t *guard2 = capture_buffer + AUDIO_CAPTURE_CHUNK_SIZE + 16;
-        bool guards_ok = true;
-        for (int i = 0; i < 16; i++) {
-            if (guard1[i] != 0xDE) guards_ok = false;
-            if (guard2[i] != 0xAD) guards_ok = false;
+
+        if (end_of_speech) {
+            // Stop capturing; the streaming task drains what is queued, then sends EOS
+            ESP_LOGI(TAG, "Auto end-of-speech: stopping capture, EOS follows once the ring drains");
+            turn_metrics_speech_ended();
+            stt_pipeline_mark_stopped();
+            break;
         }
-        if (!guards_ok) {
-            ESP_LOGW(TAG, "⚠ Potential buffer overflow detected in capture buffer!");
+
+        uint32_t overruns = audio_driver_rx_stream_overruns();
+        if (overruns != last_overruns) {
+            LOGW_RL(TAG, "⚠ Capture task fell behind RX DMA (%u buffers overrun)", (unsigned int)overruns);
+            last_overruns = overruns;
         }
-        #endif
-        
-        heap_caps_free(capture_buffer);
-        capture_buffer = NULL;  // NULL the pointer after freeing to prevent double-free
     }
 
+    audio_driver_rx_stream_stop();
+    
+    ESP_LOGI(TAG, "Audio capture task stopped (captured %u bytes in %u frames, dropped=%u, overruns=%u)",
+             (unsigned int)total_bytes_captured, (unsigned int)frame_count,
+             (unsigned int)dropped_frames, (unsigned int)last_overruns);
+#if CONFIG_STT_VAD_ENABLED
+    ESP_LOGI(TAG, "VAD kept %u bytes of silence off the uplink", (unsigned int)gated_bytes);
+#endif
+
     if (g_audio_capture_task_handle == xTaskGetCurrentTaskHandle()) {
         g_audio_capture_task_handle = NULL;
     }
@@ -639,25 +792,8 @@ static void audio_streaming_task(void *pvParameters) {
         return;
     }
 
-    // CRITICAL: Allocate streaming buffer with safety padding to prevent overflows
-    uint8_t *stream_buffer = heap_caps_malloc(
-        AUDIO_STREAM_CHUNK_SIZE + 32,  // Extra padding for safety
-        MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT
-    );
-    if (stream_buffer == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate stream buffer with padding");
-        g_audio_streaming_task_handle = NULL;
-        vTaskDelete(NULL);
-        return;
-    }
-    ESP_LOGI(TAG, "  ✓ Stream buffer allocated at %p (with safety padding)", stream_buffer);
-    
-    // Initialize with zero padding
-    memset(stream_buffer, 0, AUDIO_STREAM_CHUNK_SIZE + 32);
-    
-    // Add guard bytes
-    memset(stream_buffer + AUDIO_STREAM_CHUNK_SIZE, 0xBE, 16);
-    memset(stream_buffer + AUDIO_STREAM_CHUNK_SIZE + 16, 0xEF, 16);
+    // Chunks are queued on the WebSocket straight from ring memory (peek/commit,
+    // released from uplink_tx_reap()), so no intermediate stream buffer is needed.
 
     for (;;) {
         EventBits_t wait_bits = xEventGroupWaitBits(
@@ -679,20 +815,20 @@ static void audio_streaming_task(void *pvParameters) {
 
         ESP_LOGI(TAG, "Audio streaming session activated");
 
+        const uint8_t *span = NULL;
         size_t bytes_read = 0;
         uint32_t total_bytes_streamed = 0;
+        uint32_t total_wire_bytes = 0;
         uint32_t chunk_count = 0;
+        audio_codec_t uplink_codec = AUDIO_CODEC_PCM16;
         uint32_t dropped_not_ready = 0;
         uint32_t dropped_send_fail = 0;
         uint32_t consecutive_send_failures = 0;
         TickType_t last_health_log = xTaskGetTickCount();
         bool aborted_due_to_error = false;
 
-        // ✅ PRIORITY 2: Reset flow control state for new session
-        g_flow_control.chunks_sent = 0;
-        g_flow_control.last_ack_chunk = 0;
-        g_flow_control.last_ack_time = xTaskGetTickCount();
-        g_flow_control.waiting_for_ack = false;
+        // Reset per-utterance flow control counters (window and chunk size carry over)
+        flow_control_reset_session();
 
         g_streaming_active = true;
 
@@ -703,13 +839,22 @@ static void audio_streaming_task(void *pvParameters) {
 
         if (!websocket_client_is_connected()) {
             ESP_LOGE(TAG, "WebSocket not connected - streaming session aborted");
+            esp_err_t prompt_ret = feedback_player_play_prompt(FEEDBACK_PROMPT_NO_CONNECTION, FEEDBACK_SOUND_ERROR);
+            if (prompt_ret != ESP_OK) {
+                ESP_LOGW(TAG, "Failed to play no-connection feedback: %s", esp_err_to_name(prompt_ret));
+            }
             aborted_due_to_error = true;
             stt_pipeline_mark_stopped();
             xEventGroupSetBits(s_pipeline_ctx.stream_events, STT_STREAM_EVENT_STOP);
         }
 
         while (!aborted_due_to_error && is_running && !stt_pipeline_stop_signal_received() && !websocket_client_session_ready()) {
-            ESP_LOGW(TAG, "Waiting for WebSocket session readiness...");
+            // A full-duplex capture waits out the reply on purpose; the VAD gate holds its audio back
+            if (stt_pipeline_is_duplex_capture()) {
+                ESP_LOGD(TAG, "Waiting for reply to finish before streaming...");
+            } else {
+                ESP_LOGW(TAG, "Waiting for WebSocket session readiness...");
+            }
             vTaskDelay(pdMS_TO_TICKS(250));
         }
 
@@ -720,33 +865,18 @@ static void audio_streaming_task(void *pvParameters) {
             xEventGroupSetBits(s_pipeline_ctx.stream_events, STT_STREAM_EVENT_STOP);
         }
 
+        // No stabilization delay: the credit window is what protects the TCP send
+        // buffer, so streaming starts as soon as the session is ready.
         if (!aborted_due_to_error) {
-            // ✅ FIX #4 (CRITICAL UPDATE): Increased stabilization delay from 500ms → 2000ms
-            // Analysis of WebSocket logs shows 500ms is insufficient for transport layer readiness:
-            // - TCP send buffers need time to allocate and initialize
-            // - Server session handlers require setup time
-            // - Flow control state must stabilize before burst traffic
-            // With 500ms: Connection failed after 2.3s with buffer overflow (100% failure rate)
-            // Expected with 2000ms: Sustained 30+ second streaming (based on buffer capacity analysis)
-            ESP_LOGI(TAG, "Connection stabilization delay (2000ms)...");
-            vTaskDelay(pdMS_TO_TICKS(2000));
-            
-            // Re-verify connection is still healthy after delay
-            if (!websocket_client_is_connected()) {
-                ESP_LOGE(TAG, "WebSocket disconnected during stabilization - aborting");
-                aborted_due_to_error = true;
-                stt_pipeline_mark_stopped();
-                xEventGroupSetBits(s_pipeline_ctx.stream_events, STT_STREAM_EVENT_STOP);
+            uplink_codec = websocket_client_get_uplink_codec();
+            if (uplink_codec != AUDIO_CODEC_PCM16 &&
+                (g_uplink_encode_buffer == NULL || audio_codec_encoder_reset(uplink_codec) != ESP_OK)) {
+                ESP_LOGW(TAG, "Uplink encoder unavailable for %s - sending pcm16", audio_codec_name(uplink_codec));
+                uplink_codec = AUDIO_CODEC_PCM16;
             }
-            
-            // REMOVED: Test packet was interfering with flow control counting
-            // The 16-byte test packet was counted as chunk 1 by server, but ESP32
-            // starts counting from 0, causing mismatch (sent: 3, acked: 4)
-            // Connection health is verified by successful handshake already
-        }
-        
-        if (!aborted_due_to_error) {
-            ESP_LOGI(TAG, "Starting audio streaming to server...");
+            ESP_LOGI(TAG, "Starting audio streaming to server (codec=%s, window=%u bytes, chunk=%u bytes)...",
+                     audio_codec_name(uplink_codec),
+                     (unsigned int)g_flow_control.window_bytes, (unsigned int)g_flow_control.chunk_size);
         }
 
         while (!aborted_due_to_error && !stt_pipeline_stop_signal_received()) {
@@ -769,19 +899,47 @@ static void audio_streaming_task(void *pvParameters) {
                 break;
             }
 
-            size_t available = ring_buffer_available_data();
+            flow_control_process_acks();
+
+            // Retire chunks the WebSocket TX task has finished with
+            esp_err_t tx_error = uplink_tx_reap(&consecutive_send_failures, &dropped_send_fail);
+            if (tx_error != ESP_OK) {
+                ESP_LOGW(TAG, "[STREAM] WebSocket send failed (%s). dropped_send_fail=%u",
+                         esp_err_to_name(tx_error), (unsigned int)dropped_send_fail);
+            }
+            if (consecutive_send_failures >= (AUDIO_STREAM_MAX_SEND_FAILURES * 2)) { // Double the failure threshold for more resilience
+                ESP_LOGE(TAG, "[STREAM] Aborting after %u consecutive send failures", (unsigned int)(AUDIO_STREAM_MAX_SEND_FAILURES * 2));
+                stt_pipeline_mark_stopped();
+                xEventGroupSetBits(s_pipeline_ctx.stream_events, STT_STREAM_EVENT_STOP);
+                aborted_due_to_error = true;
+                break;
+            }
+
+            size_t available = ring_buffer_unsent_data();
+            size_t target_chunk = g_flow_control.chunk_size;
 
             if (!is_running && available == 0U) {
                 ESP_LOGI(TAG, "Capture stopped and ring buffer drained; ending streaming loop");
                 break;
             }
 
-            if (available >= AUDIO_STREAM_CHUNK_SIZE || (!is_running && available > 0U)) {
-                size_t chunk_size = (available >= AUDIO_STREAM_CHUNK_SIZE) ?
-                                    AUDIO_STREAM_CHUNK_SIZE : available;
-                esp_err_t ret = ring_buffer_read(stream_buffer, chunk_size, &bytes_read);
+            // Every send-queue slot (or, when encoding, both encode halves) still
+            // waiting on the socket: sleep until the TX task completes one
+            if ((g_uplink_tx_head - g_uplink_tx_tail) >= AUDIO_STREAM_TX_SLOTS ||
+                (uplink_codec != AUDIO_CODEC_PCM16 && uplink_tx_free_encode_half() < 0)) {
+                ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(AUDIO_STREAM_SEND_TIMEOUT_MS));
+                continue;
+            }
+
+            if (available >= target_chunk || (!is_running && available > 0U)) {
+                size_t chunk_size = (available >= target_chunk) ? target_chunk : available;
+                // Zero-copy: span points into the ring and is queued by reference. A chunk
+                // that straddles the wrap point is sent as two shorter frames on
+                // consecutive iterations (the TX task may merge them again).
+                bytes_read = ring_buffer_peek_contiguous(&span, chunk_size);
+                esp_err_t ret = ESP_OK;
 
-                if (ret == ESP_OK && bytes_read > 0) {
+                if (bytes_read > 0) {
                     // CRITICAL FIX: Enhanced WebSocket connection checking before sending
                     if (!websocket_client_is_connected()) {
                         ESP_LOGW(TAG, "WebSocket disconnected during ring buffer read - aborting send");
@@ -802,44 +960,54 @@ static void audio_streaming_task(void *pvParameters) {
                     }
 
                     if (!websocket_client_can_stream_audio()) {
+                        ring_buffer_commit_read(bytes_read);
                         dropped_not_ready++;
                         if ((dropped_not_ready % 25U) == 0U) {
                             ESP_LOGW(TAG, "[STREAM] Dropping audio chunk (session busy). dropped_not_ready=%u buffer=%u",
                                      (unsigned int)dropped_not_ready,
-                                     (unsigned int)ring_buffer_available_data());
+                                     (unsigned int)ring_buffer_unsent_data());
                         }
                         vTaskDelay(pdMS_TO_TICKS(10));
                     } else {
-                        // ✅ PRIORITY 2: Backpressure handling - wait if 2+ chunks sent without ACK
-                        // Server sends ACK every 2 chunks, so we should never have >2 unacknowledged
-                        // This prevents overwhelming the WebSocket send buffer
-                        uint32_t unacknowledged = (g_flow_control.chunks_sent > g_flow_control.last_ack_chunk) 
-                            ? (g_flow_control.chunks_sent - g_flow_control.last_ack_chunk) 
-                            : 0;
-                        
-                        if (unacknowledged >= 2) {
+                        // Encode first: flow control counts bytes on the wire, not PCM bytes
+                        const uint8_t *payload = span;
+                        size_t payload_len = bytes_read;
+                        int encode_half = -1;
+                        if (uplink_codec != AUDIO_CODEC_PCM16) {
+                            bool flush = !is_running && bytes_read == available;
+                            encode_half = uplink_tx_free_encode_half();
+                            uint8_t *encode_out = g_uplink_encode_buffer + (size_t)encode_half * g_uplink_encode_capacity;
+                            ret = audio_codec_encode(uplink_codec, span, bytes_read, flush,
+                                                     encode_out, g_uplink_encode_capacity,
+                                                     &payload_len);
+                            if (ret != ESP_OK) {
+                                ESP_LOGW(TAG, "[STREAM] %s encode failed (%s) - dropping %zu bytes",
+                                         audio_codec_name(uplink_codec), esp_err_to_name(ret), bytes_read);
+                                ring_buffer_commit_read(bytes_read);
+                                continue;
+                            }
+                            if (payload_len == 0) {
+                                // Opus holds a partial 20ms frame until the next block
+                                ring_buffer_commit_read(bytes_read);
+                                continue;
+                            }
+                            payload = encode_out;
+                        }
+
+                        // Credit check: block (on a task notification from the ACK handler)
+                        // until the window and in-flight limit admit this chunk
+                        if (!flow_control_has_credit(payload_len)) {
                             g_flow_control.waiting_for_ack = true;
                             TickType_t wait_start = xTaskGetTickCount();
-                            const TickType_t ack_timeout = pdMS_TO_TICKS(1000);  // 1000ms timeout for ACK
+                            const TickType_t ack_timeout = pdMS_TO_TICKS(AUDIO_STREAM_ACK_TIMEOUT_MS);
                             
-                            ESP_LOGW(TAG, "Waiting for server ACK (sent: %u, acked: %u, unack: %u)",
-                                     (unsigned int)g_flow_control.chunks_sent,
-                                     (unsigned int)g_flow_control.last_ack_chunk,
-                                     (unsigned int)unacknowledged);
+                            ESP_LOGD(TAG, "Waiting for credit (sent=%u, acked=%u, window=%u, chunks unacked=%u)",
+                                     (unsigned int)g_flow_control.bytes_sent,
+                                     (unsigned int)g_flow_control.bytes_acked,
+                                     (unsigned int)g_flow_control.window_bytes,
+                                     (unsigned int)(g_flow_control.chunks_sent - g_flow_control.last_ack_chunk));
                             
-                            while (true) {
-                                // Recalculate unacknowledged count
-                                unacknowledged = (g_flow_control.chunks_sent > g_flow_control.last_ack_chunk) 
-                                    ? (g_flow_control.chunks_sent - g_flow_control.last_ack_chunk) 
-                                    : 0;
-                                
-                                if (unacknowledged < 2) {
-                                    ESP_LOGI(TAG, "ACK received, resuming (unack now: %u)", (unsigned int)unacknowledged);
-                                    break;
-                                }
-                                
-                                vTaskDelay(pdMS_TO_TICKS(10));  // Check every 10ms
-                                
+                            while (!flow_control_has_credit(payload_len)) {
                                 // Check for timeout
                                 if ((xTaskGetTickCount() - wait_start) >= ack_timeout) {
                                     ESP_LOGE(TAG, "ACK timeout - connection may be stalled (sent=%u, acked=%u)",
@@ -859,34 +1027,63 @@ static void audio_streaming_task(void *pvParameters) {
                                     xEventGroupSetBits(s_pipeline_ctx.stream_events, STT_STREAM_EVENT_STOP);
                                     break;
                                 }
+
+                                if (stt_pipeline_stop_signal_received()) {
+                                    break;
+                                }
+
+                                ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(50));
+                                flow_control_process_acks();
+                                uplink_tx_reap(&consecutive_send_failures, &dropped_send_fail);
                             }
                             
                             g_flow_control.waiting_for_ack = false;
                             
-                            if (aborted_due_to_error) {
+                            if (aborted_due_to_error || stt_pipeline_stop_signal_received()) {
                                 break;
                             }
                         }
-                        
-                        ret = websocket_client_send_audio(stream_buffer, bytes_read, AUDIO_STREAM_SEND_TIMEOUT_MS);
+
+                        // Hand the chunk to the send queue; its span (or encode half) stays
+                        // reserved until uplink_tx_done() reports the socket write
+                        ring_buffer_commit_read(bytes_read);
+                        uint32_t seq = g_uplink_tx_head;
+                        uplink_tx_slot_t *slot = &g_uplink_tx[seq % AUDIO_STREAM_TX_SLOTS];
+                        atomic_store_explicit(&slot->done, false, memory_order_relaxed);
+                        slot->seq = seq;
+                        slot->ring_end = g_ring.read;
+                        slot->encode_half = (int8_t)encode_half;
+                        slot->result = ESP_FAIL;
+                        slot->send_ms = 0;
+
+                        // ADPCM frames carry a block header each, so they must stay separate
+                        // messages; merged chunks also need byte ACKs to be counted correctly
+                        bool coalesce = g_flow_control.byte_acks_seen && uplink_codec != AUDIO_CODEC_IMA_ADPCM;
+                        websocket_tx_frame_t frame = {
+                            .payload = payload,
+                            .payload_len = payload_len,
+                            .flags = coalesce ? WEBSOCKET_TX_FLAG_COALESCE : 0,
+                            .done = uplink_tx_done,
+                            .ctx = (void *)(uintptr_t)seq,
+                        };
+                        ret = websocket_client_submit(&frame, AUDIO_STREAM_SEND_TIMEOUT_MS);
 
                         if (ret == ESP_OK) {
+                            g_uplink_tx_head++;
+                            if (encode_half >= 0) {
+                                g_uplink_encode_busy[encode_half] = true;
+                            }
                             total_bytes_streamed += bytes_read;
+                            total_wire_bytes += payload_len;
                             chunk_count++;
-                            g_flow_control.chunks_sent++;  // ✅ Track sent chunks for flow control
-                            consecutive_send_failures = 0;
-                            ESP_LOGD(TAG, "Streamed chunk #%u (%zu bytes, total: %u, flow: sent=%u acked=%u)",
-                                     (unsigned int)chunk_count, bytes_read, (unsigned int)total_bytes_streamed,
-                                     (unsigned int)g_flow_control.chunks_sent, (unsigned int)g_flow_control.last_ack_chunk);
-                            
-                            // ✅ PRIORITY 3: Increased delay from 10ms → 20ms to prevent burst flooding
-                            // At 16kHz with 1024-byte chunks, each chunk = 32ms of audio
-                            // 20ms delay → 52ms per chunk cycle → 62.5% of real-time transmission
-                            // This provides breathing room for WebSocket without falling behind capture
-                            vTaskDelay(pdMS_TO_TICKS(20));
+                            flow_control_on_sent(payload_len);
+                            ESP_LOGD(TAG, "Queued chunk #%u (%zu -> %zu bytes, total: %u, flow: sent=%u acked=%u srtt=%u)",
+                                     (unsigned int)chunk_count, bytes_read, payload_len,
+                                     (unsigned int)total_bytes_streamed,
+                                     (unsigned int)g_flow_control.bytes_sent, (unsigned int)g_flow_control.bytes_acked,
+                                     (unsigned int)g_flow_control.srtt_ms);
                         } else {
-                            // CRITICAL FIX: Enhanced error handling for send failures
-                            // Check if the failure is due to connection issue
+                            // Not queued: the span is dropped like a failed send
                             if (!websocket_client_is_connected()) {
                                 ESP_LOGE(TAG, "WebSocket disconnected during audio send - aborting stream");
                                 stt_pipeline_mark_stopped();
@@ -907,7 +1104,8 @@ static void audio_streaming_task(void *pvParameters) {
                             
                             dropped_send_fail++;
                             consecutive_send_failures++;
-                            ESP_LOGW(TAG, "[STREAM] WebSocket send failed (%s). dropped_send_fail=%u",
+                            flow_control_on_backpressure();
+                            ESP_LOGW(TAG, "[STREAM] WebSocket send queue rejected chunk (%s). dropped_send_fail=%u",
                                      esp_err_to_name(ret), (unsigned int)dropped_send_fail);
                             if (consecutive_send_failures >= (AUDIO_STREAM_MAX_SEND_FAILURES * 2)) { // Double the failure threshold for more resilience
                                 ESP_LOGE(TAG, "[STREAM] Aborting after %u consecutive send failures", (unsigned int)(AUDIO_STREAM_MAX_SEND_FAILURES * 2));
@@ -939,7 +1137,13 @@ static void audio_streaming_task(void *pvParameters) {
                     aborted_due_to_error = true;
                     break;
                 }
-                vTaskDelay(pdMS_TO_TICKS(50));
+                // Sleep roughly until capture has produced the rest of the next chunk,
+                // waking early on an ACK notification
+                uint32_t fill_ms = (uint32_t)(((target_chunk - available) * 1000U) / AUDIO_STREAM_BYTES_PER_SEC);
+                if (fill_ms < 5U) {
+                    fill_ms = 5U;
+                }
+                ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(fill_ms));
             }
 
             if ((xTaskGetTickCount() - last_health_log) >= pdMS_TO_TICKS(AUDIO_STREAM_HEALTH_LOG_MS * 2)) {  // Doubled the interval
@@ -948,12 +1152,9 @@ static void audio_streaming_task(void *pvParameters) {
                          (unsigned int)chunk_count,
                          (unsigned int)dropped_not_ready,
                          (unsigned int)dropped_send_fail,
-                         (unsigned int)ring_buffer_available_data());
+                         (unsigned int)ring_buffer_unsent_data());
                 last_health_log = xTaskGetTickCount();
             }
-            
-            // Add a small delay to prevent the task from monopolizing the CPU
-            vTaskDelay(pdMS_TO_TICKS(1));
         }
 
         if (stt_pipeline_stop_signal_received()) {
@@ -965,41 +1166,28 @@ static void audio_streaming_task(void *pvParameters) {
         }
 
         if (websocket_client_is_connected()) {
+            // Queued behind the last audio chunk, so it also marks the uplink drained
             ESP_LOGI(TAG, "Sending EOS signal...");
             websocket_client_send_eos();
         } else {
             ESP_LOGW(TAG, "Skipping EOS - WebSocket disconnected");
         }
+        // Ring spans must be released before stt_pipeline_stop() resets the ring
+        uplink_tx_drain(CONFIG_WS_TX_SEND_TIMEOUT_MS);
 
-        ESP_LOGI(TAG, "Audio streaming session complete (streamed %u bytes in %u chunks)",
+        ESP_LOGI(TAG, "Audio streaming session complete (streamed %u PCM bytes as %u %s bytes in %u chunks, srtt=%u ms, chunk=%u)",
                  (unsigned int)total_bytes_streamed,
-                 (unsigned int)chunk_count);
+                 (unsigned int)total_wire_bytes,
+                 audio_codec_name(uplink_codec),
+                 (unsigned int)chunk_count,
+                 (unsigned int)g_flow_control.srtt_ms,
+                 (unsigned int)g_flow_control.chunk_size);
 
         g_streaming_active = false;
         xEventGroupClearBits(s_pipeline_ctx.stream_events, STT_STREAM_EVENT_STOP);
         stt_pipeline_dispatch_stop_event();
     }
 
-    // Free streaming buffer with guard byte checking
-    if (stream_buffer != NULL) {
-        // Check guard bytes before freeing
-        #ifdef CONFIG_ENABLE_DEBUG_LOGS
-        const uint8_t *guard1 = stream_buffer + AUDIO_STREAM_CHUNK_SIZE;
-        const uint8_t *guard2 = stream_buffer + AUDIO_STREAM_CHUNK_SIZE + 16;
-        bool guards_ok = true;
-        for (int i = 0; i < 16; i++) {
-            if (guard1[i] != 0xBE) guards_ok = false;
-            if (guard2[i] != 0xEF) guards_ok = false;
-        }
-        if (!guards_ok) {
-            ESP_LOGW(TAG, "⚠ Potential buffer overflow detected in stream buffer!");
-        }
-        #endif
-        
-        heap_caps_free(stream_buffer);
-        stream_buffer = NULL;  // NULL the pointer after freeing to prevent double-free
-    }
-    
     g_audio_streaming_task_handle = NULL;
     vTaskDelete(NULL);
 }
@@ -1008,6 +1196,9 @@ static void audio_streaming_task(void *pvParameters) {
 static void stt_pipeline_mark_stopped(void) {
     is_running = false;
     is_recording = false;
+#if CONFIG_AUDIO_FULL_DUPLEX
+    atomic_store(&s_barge_in_armed, false);
+#endif
 }
 
 static void stt_pipeline_dispatch_stop_event(void) {
@@ -1032,25 +1223,10 @@ static void stt_pipeline_reset_ring_buffer(void) {
         return;
     }
 
-    if (g_ring_buffer_mutex != NULL) {
-        if (xSemaphoreTake(g_ring_buffer_mutex, pdMS_TO_TICKS(50))) {
-            // CRITICAL FIX: Zero out ring buffer data to prevent PSRAM fragmentation
-            // Accumulated audio data across sessions can cause fragmentation in PSRAM
-            // Clearing ensures clean memory state for next session
-            memset(g_audio_ring_buffer, 0, g_ring_buffer_size);
-            
-            g_ring_buffer_write_pos = 0;
-            g_ring_buffer_read_pos = 0;
-            g_ring_buffer_count = 0;
-            xSemaphoreGive(g_ring_buffer_mutex);
-        }
-    } else {
-        // Clear buffer even without mutex (shouldn't happen but safe)
-        memset(g_audio_ring_buffer, 0, g_ring_buffer_size);
-        g_ring_buffer_write_pos = 0;
-        g_ring_buffer_read_pos = 0;
-        g_ring_buffer_count = 0;
-    }
+    // Only called while neither the producer nor the consumer is touching the ring
+    // (before START is signalled, or after both tasks reported idle). Indices alone
+    // define valid data, so the 64KB PSRAM region is not re-zeroed here.
+    stt_ring_reset(&g_ring);
 }
 
 static inline void stt_pipeline_notify_capture_idle(void) {
@@ -1094,6 +1270,7 @@ static void stt_pipeline_wait_for_capture_idle(TickType_t deadline_ticks) {
         TaskHandle_t handle = g_audio_capture_task_handle;
         g_audio_capture_task_handle = NULL;
         ESP_LOGW(TAG, "Force deleting audio capture task after timeout");
+        audio_driver_rx_stream_stop();  // ISR must not notify a deleted task
         vTaskDelete(handle);
         stt_pipeline_notify_capture_idle();
     }
@@ -1109,116 +1286,337 @@ static void stt_pipeline_wait_for_streaming_idle(TickType_t deadline_ticks) {
     }
 }
 
-// Ring buffer helper functions
-// static size_t ring_buffer_available_space(void) {
-//     if (g_ring_buffer_mutex == NULL) {
-//         return g_ring_buffer_size - g_ring_buffer_count;
-//     }
-//
-//     size_t space;
-//     xSemaphoreTake(g_ring_buffer_mutex, portMAX_DELAY);
-//     space = g_ring_buffer_size - g_ring_buffer_count;
-//     xSemaphoreGive(g_ring_buffer_mutex);
-//     return space;
-// }
+#if CONFIG_STT_VAD_ENABLED
+// VAD pre-roll helpers (capture task only)
+static void vad_preroll_push(const uint8_t *data, size_t len) {
+    if (g_vad_preroll == NULL) {
+        return;
+    }
 
-static size_t ring_buffer_available_data(void) {
-    if (g_ring_buffer_mutex == NULL) {
-        return g_ring_buffer_count;
+    if (len >= STT_VAD_PREROLL_BYTES) {
+        // Only the newest pre-roll window matters
+        memcpy(g_vad_preroll, data + (len - STT_VAD_PREROLL_BYTES), STT_VAD_PREROLL_BYTES);
+        g_vad_preroll_pos = 0;
+        g_vad_preroll_fill = STT_VAD_PREROLL_BYTES;
+        return;
+    }
+
+    size_t first = STT_VAD_PREROLL_BYTES - g_vad_preroll_pos;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(g_vad_preroll + g_vad_preroll_pos, data, first);
+    if (len > first) {
+        memcpy(g_vad_preroll, data + first, len - first);
     }
 
-    size_t data;
-    xSemaphoreTake(g_ring_buffer_mutex, portMAX_DELAY);
-    data = g_ring_buffer_count;
-    xSemaphoreGive(g_ring_buffer_mutex);
-    return data;
+    g_vad_preroll_pos = (g_vad_preroll_pos + len) % STT_VAD_PREROLL_BYTES;
+    g_vad_preroll_fill += len;
+    if (g_vad_preroll_fill > STT_VAD_PREROLL_BYTES) {
+        g_vad_preroll_fill = STT_VAD_PREROLL_BYTES;
+    }
 }
 
-static size_t ring_buffer_available_space(void) {
-    if (g_ring_buffer_mutex == NULL) {
-        return g_ring_buffer_size - g_ring_buffer_count;
+static void vad_preroll_flush_to_ring(void) {
+    if (g_vad_preroll == NULL || g_vad_preroll_fill == 0) {
+        return;
+    }
+
+    // Oldest byte sits fill bytes behind the write position; keep sample alignment
+    size_t fill = g_vad_preroll_fill & ~(size_t)1U;
+    size_t start = (g_vad_preroll_pos + STT_VAD_PREROLL_BYTES - fill) % STT_VAD_PREROLL_BYTES;
+    size_t first = STT_VAD_PREROLL_BYTES - start;
+    if (first > fill) {
+        first = fill;
     }
 
-    size_t space;
-    xSemaphoreTake(g_ring_buffer_mutex, portMAX_DELAY);
-    space = g_ring_buffer_size - g_ring_buffer_count;
-    xSemaphoreGive(g_ring_buffer_mutex);
-    return space;
+    if (ring_buffer_write(g_vad_preroll + start, first) != ESP_OK ||
+        (fill > first && ring_buffer_write(g_vad_preroll, fill - first) != ESP_OK)) {
+        ESP_LOGW(TAG, "⚠ Ring buffer full - VAD pre-roll truncated");
+    }
+
+    g_vad_preroll_pos = 0;
+    g_vad_preroll_fill = 0;
 }
 
-static esp_err_t ring_buffer_write(const uint8_t *data, size_t len) {
-    // Validate inputs
-    if (data == NULL || len == 0) {
-        return ESP_ERR_INVALID_ARG;
+static void stt_pipeline_post_vad_event(system_event_type_t type, bool auto_eos) {
+    system_event_t evt = {
+        .type = type,
+        .timestamp_ms = (uint32_t)(esp_timer_get_time() / 1000ULL),
+        .data.vad = {
+            .speech_ms = s_vad.speech_ms,
+            .energy = s_vad.last_energy,
+            .auto_eos = auto_eos,
+        },
+    };
+    if (!event_dispatcher_post(&evt, pdMS_TO_TICKS(10))) {
+        ESP_LOGW(TAG, "Failed to enqueue VAD event");
     }
+}
+#endif
 
-    if (len > g_ring_buffer_size) {
-        return ESP_ERR_INVALID_SIZE;
+#if CONFIG_AUDIO_FULL_DUPLEX
+// Predicted mic level of the speaker's own output, with the configured margin on top
+static uint16_t echo_floor_for(uint16_t tx_level) {
+    if (tx_level == 0) {
+        return 0;
     }
+    uint32_t floor = ((uint32_t)tx_level * s_echo_coupling_q8) >> 8;
+    floor = (floor * CONFIG_BARGE_IN_MARGIN_Q4) >> 4;
+    return (uint16_t)(floor > UINT16_MAX ? UINT16_MAX : floor);
+}
 
-    if (!xSemaphoreTake(g_ring_buffer_mutex, pdMS_TO_TICKS(100))) {
-        ESP_LOGW(TAG, "⚠ Ring buffer mutex timeout");
-        return ESP_ERR_TIMEOUT;
+// Learn the speaker->mic ratio from non-speech frames heard during playback.
+// Rises quickly and decays slowly: over-estimating echo costs a late barge-in,
+// under-estimating it lets the reply interrupt itself.
+static void echo_coupling_learn(uint16_t tx_level, uint16_t mic_level) {
+    if (tx_level < CONFIG_STT_VAD_MIN_ENERGY) {
+        return;  // Too quiet for the ratio to mean anything
+    }
+    uint32_t measured = ((uint32_t)mic_level << 8) / tx_level;
+    if (measured > s_echo_coupling_q8) {
+        s_echo_coupling_q8 += (measured - s_echo_coupling_q8) / 4U;
+    } else {
+        s_echo_coupling_q8 -= (s_echo_coupling_q8 - measured) / 64U;
+    }
+    if (s_echo_coupling_q8 > CONFIG_BARGE_IN_COUPLING_MAX_Q8) {
+        s_echo_coupling_q8 = CONFIG_BARGE_IN_COUPLING_MAX_Q8;
+    } else if (s_echo_coupling_q8 < 1U) {
+        s_echo_coupling_q8 = 1U;
     }
+}
+#endif
+
+// Flow control helpers (streaming task only, except where noted)
+static void flow_control_reset_session(void) {
+    g_flow_control.chunks_sent = 0;
+    g_flow_control.bytes_sent = 0;
+    g_flow_control.last_ack_chunk = 0;
+    g_flow_control.bytes_acked = 0;
+    g_flow_control.byte_acks_seen = false;
+    g_flow_control.last_ack_time = xTaskGetTickCount();
+    g_flow_control.last_ack_us = 0;
+    g_flow_control.waiting_for_ack = false;
+    g_flow_control.in_flight_head = 0;
+    g_flow_control.in_flight_tail = 0;
+    // Drop stale wakeups from the previous utterance
+    ulTaskNotifyTake(pdTRUE, 0);
+}
 
-    size_t available = g_ring_buffer_size - g_ring_buffer_count;
-    if (available < len) {
-        xSemaphoreGive(g_ring_buffer_mutex);
-        // CRITICAL: Return specific error code for buffer full condition
-        return ESP_ERR_NO_MEM;
+static bool flow_control_has_credit(size_t next_len) {
+    if (!g_flow_control.byte_acks_seen) {
+        // Legacy server that only reports chunk counts: the in-flight limit is the window
+        uint32_t chunks_unacked = g_flow_control.chunks_sent - g_flow_control.last_ack_chunk;
+        return chunks_unacked < AUDIO_STREAM_MAX_IN_FLIGHT;
+    }
+
+    // Coalesced chunks reach the server as fewer messages than were sent, so with
+    // byte ACKs the in-flight limit counts sends whose bytes are not yet acknowledged
+    if ((g_flow_control.in_flight_head - g_flow_control.in_flight_tail) >= AUDIO_STREAM_MAX_IN_FLIGHT) {
+        return false;
     }
 
-    size_t write_pos = g_ring_buffer_write_pos;
-    for (size_t i = 0; i < len; i++) {
-        if (write_pos >= g_ring_buffer_size) {
-            write_pos = 0;
+    uint32_t bytes_unacked = g_flow_control.bytes_sent - g_flow_control.bytes_acked;
+    // Always allow one chunk when nothing is outstanding so a tiny window cannot deadlock
+    return bytes_unacked == 0 || (bytes_unacked + next_len) <= g_flow_control.window_bytes;
+}
+
+static void flow_control_on_sent(size_t len) {
+    g_flow_control.chunks_sent++;
+    g_flow_control.bytes_sent += (uint32_t)len;
+
+    uint32_t slot = g_flow_control.in_flight_head % AUDIO_STREAM_MAX_IN_FLIGHT;
+    if ((g_flow_control.in_flight_head - g_flow_control.in_flight_tail) >= AUDIO_STREAM_MAX_IN_FLIGHT) {
+        g_flow_control.in_flight_tail++;  // Oldest sample lost (legacy server), RTT just skips it
+    }
+    g_flow_control.in_flight[slot].end_offset = g_flow_control.bytes_sent;
+    g_flow_control.in_flight[slot].sent_us = esp_timer_get_time();
+    g_flow_control.in_flight_head++;
+}
+
+static void flow_control_on_backpressure(void) {
+    // Multiplicative decrease: smaller frames fit the remaining TCP send buffer
+    size_t next = g_flow_control.chunk_size / 2U;
+    if (next < AUDIO_STREAM_CHUNK_MIN) {
+        next = AUDIO_STREAM_CHUNK_MIN;
+    }
+    if (next != g_flow_control.chunk_size) {
+        ESP_LOGD(TAG, "Flow control: backpressure, chunk %u -> %u bytes",
+                 (unsigned int)g_flow_control.chunk_size, (unsigned int)next);
+        g_flow_control.chunk_size = next;
+    }
+}
+
+static void flow_control_process_acks(void) {
+    uint32_t acked = g_flow_control.byte_acks_seen ? g_flow_control.bytes_acked : 0;
+    int64_t ack_us = g_flow_control.last_ack_us;
+    bool sampled = false;
+
+    while (g_flow_control.in_flight_tail != g_flow_control.in_flight_head) {
+        uint32_t slot = g_flow_control.in_flight_tail % AUDIO_STREAM_MAX_IN_FLIGHT;
+        if (acked < g_flow_control.in_flight[slot].end_offset) {
+            break;
         }
-        g_audio_ring_buffer[write_pos] = data[i];
-        write_pos++;
+
+        if (ack_us > g_flow_control.in_flight[slot].sent_us) {
+            uint32_t rtt_ms = (uint32_t)((ack_us - g_flow_control.in_flight[slot].sent_us) / 1000);
+            // EWMA with gain 1/8 (RFC 6298 style)
+            g_flow_control.srtt_ms = (g_flow_control.srtt_ms == 0)
+                ? rtt_ms
+                : (g_flow_control.srtt_ms * 7U + rtt_ms) / 8U;
+            sampled = true;
+        }
+        g_flow_control.in_flight_tail++;
     }
 
-    g_ring_buffer_write_pos = (write_pos % g_ring_buffer_size);
-    g_ring_buffer_count += len;
+    if (!sampled) {
+        return;
+    }
 
-    xSemaphoreGive(g_ring_buffer_mutex);
-    return ESP_OK;
+    // Throughput is bounded by (in_flight - 1) * chunk / RTT, so the chunk must cover
+    // one RTT of audio spread over the pipelined slots; round up to a whole step.
+    size_t target = (size_t)(((uint64_t)AUDIO_STREAM_BYTES_PER_SEC * g_flow_control.srtt_ms) /
+                             (1000U * (AUDIO_STREAM_MAX_IN_FLIGHT - 1U)));
+    target = ((target + AUDIO_STREAM_CHUNK_STEP - 1U) / AUDIO_STREAM_CHUNK_STEP) * AUDIO_STREAM_CHUNK_STEP;
+    if (target < AUDIO_STREAM_CHUNK_MIN) {
+        target = AUDIO_STREAM_CHUNK_MIN;
+    } else if (target > AUDIO_STREAM_CHUNK_MAX) {
+        target = AUDIO_STREAM_CHUNK_MAX;
+    }
+
+    if (g_flow_control.chunk_size < target) {
+        // Additive increase back toward the RTT-derived target
+        g_flow_control.chunk_size += AUDIO_STREAM_CHUNK_STEP;
+        if (g_flow_control.chunk_size > target) {
+            g_flow_control.chunk_size = target;
+        }
+    } else if (g_flow_control.chunk_size > target) {
+        // Low RTT: shorter frames reach the recogniser sooner
+        g_flow_control.chunk_size = target;
+    }
 }
 
-static esp_err_t ring_buffer_read(uint8_t *data, size_t len, size_t *bytes_read) {
-    // Validate inputs
-    if (data == NULL || bytes_read == NULL) {
-        return ESP_ERR_INVALID_ARG;
+// Uplink send queue helpers (streaming task only, except uplink_tx_done)
+static void uplink_tx_done(esp_err_t result, uint32_t send_ms, void *ctx) {
+    uint32_t seq = (uint32_t)(uintptr_t)ctx;
+    uplink_tx_slot_t *slot = &g_uplink_tx[seq % AUDIO_STREAM_TX_SLOTS];
+    if (slot->seq != seq) {
+        return;  // Slot was abandoned and reused by a later session
     }
 
-    if (!xSemaphoreTake(g_ring_buffer_mutex, pdMS_TO_TICKS(100))) {
-        ESP_LOGW(TAG, "⚠ Ring buffer mutex timeout (read)");
-        *bytes_read = 0;
-        return ESP_ERR_TIMEOUT;
+    slot->result = result;
+    slot->send_ms = send_ms;
+    atomic_store_explicit(&slot->done, true, memory_order_release);
+
+    TaskHandle_t streaming_task = g_audio_streaming_task_handle;
+    if (streaming_task != NULL) {
+        xTaskNotifyGive(streaming_task);
     }
+}
 
-    size_t available = g_ring_buffer_count;
-    if (available == 0) {
-        xSemaphoreGive(g_ring_buffer_mutex);
-        *bytes_read = 0;
-        return ESP_OK;
+// Retire completed chunks in submission order: release their ring spans and
+// encode buffers and feed send timing back into flow control. Returns the
+// error of the last failed chunk, ESP_OK if none failed.
+static esp_err_t uplink_tx_reap(uint32_t *consecutive_failures, uint32_t *dropped_send_fail) {
+    esp_err_t last_error = ESP_OK;
+
+    while (g_uplink_tx_tail != g_uplink_tx_head) {
+        uplink_tx_slot_t *slot = &g_uplink_tx[g_uplink_tx_tail % AUDIO_STREAM_TX_SLOTS];
+        if (!atomic_load_explicit(&slot->done, memory_order_acquire)) {
+            break;
+        }
+
+        ring_buffer_release_to(slot->ring_end);
+        if (slot->encode_half >= 0) {
+            g_uplink_encode_busy[slot->encode_half] = false;
+        }
+
+        if (slot->result == ESP_OK) {
+            *consecutive_failures = 0;
+            if (slot->send_ms > AUDIO_STREAM_SLOW_SEND_MS) {
+                // The write blocked on a full TCP/WebSocket buffer
+                flow_control_on_backpressure();
+            }
+        } else {
+            (*dropped_send_fail)++;
+            (*consecutive_failures)++;
+            flow_control_on_backpressure();
+            last_error = slot->result;
+        }
+        g_uplink_tx_tail++;
+    }
+
+    if (g_uplink_tx_tail == g_uplink_tx_head) {
+        // Nothing queued references the ring, so dropped and flushed bytes go too
+        ring_buffer_release_to(g_ring.read);
     }
+    return last_error;
+}
 
-    size_t to_read = (len < available) ? len : available;
+// Wait for queued chunks at the end of a session. Chunks still queued after the
+// timeout are abandoned; their late completions no longer match a slot.
+static void uplink_tx_drain(uint32_t timeout_ms) {
+    uint32_t failures = 0;
+    uint32_t dropped = 0;
+    TickType_t start = xTaskGetTickCount();
+
+    uplink_tx_reap(&failures, &dropped);
+    while (g_uplink_tx_tail != g_uplink_tx_head &&
+           (xTaskGetTickCount() - start) < pdMS_TO_TICKS(timeout_ms)) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(50));
+        uplink_tx_reap(&failures, &dropped);
+    }
 
-    size_t read_pos = g_ring_buffer_read_pos;
-    for (size_t i = 0; i < to_read; i++) {
-        if (read_pos >= g_ring_buffer_size) {
-            read_pos = 0;
+    if (g_uplink_tx_tail != g_uplink_tx_head) {
+        ESP_LOGW(TAG, "[STREAM] Abandoning %u queued chunks at session end",
+                 (unsigned int)(g_uplink_tx_head - g_uplink_tx_tail));
+        g_uplink_tx_tail = g_uplink_tx_head;
+        ring_buffer_release_to(g_ring.read);
+    }
+    for (int i = 0; i < UPLINK_ENCODE_HALVES; i++) {
+        g_uplink_encode_busy[i] = false;
+    }
+}
+
+static int uplink_tx_free_encode_half(void) {
+    for (int i = 0; i < UPLINK_ENCODE_HALVES; i++) {
+        if (!g_uplink_encode_busy[i]) {
+            return i;
         }
-        data[i] = g_audio_ring_buffer[read_pos];
-        read_pos++;
     }
+    return -1;
+}
 
-    g_ring_buffer_read_pos = (read_pos % g_ring_buffer_size);
-    g_ring_buffer_count -= to_read;
+// Ring buffer helpers: thin wrappers so the call sites read as before (see stt_ring.h)
 
-    xSemaphoreGive(g_ring_buffer_mutex);
-    
-    *bytes_read = to_read;
-    return ESP_OK;
+static size_t ring_buffer_available_data(void) {
+    return stt_ring_available_data(&g_ring);
+}
+
+static size_t ring_buffer_available_space(void) {
+    return stt_ring_available_space(&g_ring);
+}
+
+static esp_err_t ring_buffer_write(const uint8_t *data, size_t len) {
+    return stt_ring_write(&g_ring, data, len);
+}
+
+static size_t ring_buffer_peek_contiguous(const uint8_t **span, size_t max_len) {
+    return stt_ring_peek_contiguous(&g_ring, span, max_len);
+}
+
+static void ring_buffer_commit_read(size_t len) {
+    stt_ring_commit_read(&g_ring, len);
+}
+
+static size_t ring_buffer_unsent_data(void) {
+    return stt_ring_unsent_data(&g_ring);
+}
+
+static void ring_buffer_release_to(uint32_t pos) {
+    stt_ring_release_to(&g_ring, pos);
+}
+
+static void ring_buffer_request_flush(void) {
+    stt_ring_request_flush(&g_ring);
 }
@@ -0,0 +1,129 @@
+/**
+ * @file tone_synth.c
+ * @brief Fixed-point DDS tone and noise rendering
+ */
+
+#include "tone_synth.h"
+#include "config.h"
+#include <math.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define TONE_SYNTH_SAMPLE_RATE CONFIG_AUDIO_SAMPLE_RATE
+
+// Envelope constants for fade-in/fade-out (reduces clicks)
+#define ENVELOPE_FADE_MS 5
+#define ENVELOPE_FADE_SAMPLES ((TONE_SYNTH_SAMPLE_RATE * ENVELOPE_FADE_MS) / 1000)
+
+// DDS oscillator: 32-bit phase accumulator, top bits index a Q15 sine table,
+// the next 16 bits interpolate between neighbouring entries
+#define SINE_TABLE_BITS 8
+#define SINE_TABLE_SIZE (1U << SINE_TABLE_BITS)
+
+static int16_t s_sine_table[SINE_TABLE_SIZE + 1];   // +1 guard entry for interpolation
+static bool s_table_ready = false;
+
+void tone_synth_init(void) {
+    if (s_table_ready) {
+        return;
+    }
+    // The only floating-point trig left: 256 entries, once per boot
+    for (size_t i = 0; i < SINE_TABLE_SIZE; ++i) {
+        s_sine_table[i] = (int16_t)lrintf(sinf(2.0f * (float)M_PI * (float)i / (float)SINE_TABLE_SIZE) * 32767.0f);
+    }
+    s_sine_table[SINE_TABLE_SIZE] = s_sine_table[0];
+    s_table_ready = true;
+}
+
+void tone_synth_reset(tone_synth_state_t *dds, uint32_t noise_seed) {
+    dds->phase_a = 0U;
+    dds->phase_b = 0U;
+    dds->noise = (noise_seed != 0U) ? noise_seed : 1U;
+}
+
+static inline uint32_t dds_increment(float freq_hz) {
+    if (freq_hz <= 0.0f) {
+        return 0U;
+    }
+    // freq / rate of a full 2^32 turn per sample
+    return (uint32_t)(((uint64_t)(freq_hz * 65536.0f) << 16) / TONE_SYNTH_SAMPLE_RATE);
+}
+
+static inline int32_t dds_sine(uint32_t phase) {
+    uint32_t index = phase >> (32U - SINE_TABLE_BITS);
+    int32_t frac = (int32_t)((phase >> (16U - SINE_TABLE_BITS)) & 0xFFFFU);
+    int32_t a = s_sine_table[index];
+    int32_t b = s_sine_table[index + 1U];
+    return a + (((b - a) * frac) >> 16);
+}
+
+static inline int16_t clamp_sample(int32_t value) {
+    if (value > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (value < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t)value;
+}
+
+static void render_noise(tone_synth_state_t *dds, int16_t *dst, size_t frame_count, int32_t amplitude_q15) {
+    uint32_t x = dds->noise;
+    for (size_t i = 0; i < frame_count; ++i) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        dst[i] = (int16_t)(((int32_t)(int16_t)(x >> 16) * amplitude_q15) >> 15);
+    }
+    dds->noise = x;
+}
+
+static void render_tone(tone_synth_state_t *dds, int16_t *dst, size_t frame_count,
+                        float freq_a, float freq_b, int32_t amplitude_q15) {
+    const uint32_t inc_a = dds_increment(freq_a);
+    const uint32_t inc_b = dds_increment(freq_b);
+    if (inc_a != 0U && inc_b != 0U) {
+        amplitude_q15 >>= 1;  // Prevent clipping with dual tones
+    }
+
+    // Calculate fade envelope samples
+    size_t fade_samples = (frame_count < ENVELOPE_FADE_SAMPLES * 2) ? (frame_count / 4) : ENVELOPE_FADE_SAMPLES;
+
+    for (size_t i = 0; i < frame_count; ++i) {
+        int32_t sample = 0;
+        if (inc_a != 0U) {
+            sample += dds_sine(dds->phase_a);
+            dds->phase_a += inc_a;   // Wraps naturally at 2^32
+        }
+        if (inc_b != 0U) {
+            sample += dds_sine(dds->phase_b);
+            dds->phase_b += inc_b;
+        }
+
+        int32_t value = (sample * amplitude_q15) >> 15;
+
+        // Apply envelope for smooth fade-in/fade-out
+        if (i < fade_samples) {
+            value = (value * (int32_t)i) / (int32_t)fade_samples;
+        } else if (i >= frame_count - fade_samples) {
+            value = (value * (int32_t)(frame_count - i)) / (int32_t)fade_samples;
+        }
+
+        dst[i] = clamp_sample(value);
+    }
+}
+
+void tone_synth_render_segment(tone_synth_state_t *dds, const tone_segment_t *segment,
+                               int16_t *dst, size_t frame_count) {
+    const int32_t amplitude_q15 = (int32_t)(segment->amplitude * 32767.0f);
+    if (segment->is_noise) {
+        render_noise(dds, dst, frame_count, amplitude_q15);
+    } else if (segment->primary_freq_hz <= 0.0f && segment->secondary_freq_hz <= 0.0f) {
+        memset(dst, 0, frame_count * sizeof(int16_t));
+    } else {
+        render_tone(dds, dst, frame_count, segment->primary_freq_hz, segment->secondary_freq_hz, amplitude_q15);
+    }
+}
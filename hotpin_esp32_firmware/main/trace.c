@@ -0,0 +1,145 @@
+/**
+ * @file trace.c
+ * @brief Lock-free span trace ring and Chrome trace dump
+ *
+ * Writers claim a slot with one atomic add on the head counter and fill it in
+ * place; the ring wraps silently, keeping the newest records. Only the dump
+ * reads the ring, after pausing writers, so no record is read half-written.
+ */
+
+#include "trace.h"
+#include "memory_manager.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = TAG_TRACE;
+
+static const char *const s_trace_names[TRACE_ID_COUNT] = {
+    [TRACE_ID_NONE]           = "none",
+    [TRACE_ID_I2S_RX_FETCH]   = "i2s_rx_fetch",
+    [TRACE_ID_STT_RING_WRITE] = "stt_ring_write",
+    [TRACE_ID_WS_SEND]        = "ws_send",
+    [TRACE_ID_TTS_BLOCK_RECV] = "tts_block_recv",
+    [TRACE_ID_I2S_TX_WRITE]   = "i2s_tx_write",
+    [TRACE_ID_MODE_SWITCH]    = "mode_switch",
+    [TRACE_ID_STATE]          = "state",
+};
+
+static trace_record_t *s_ring = NULL;
+static uint32_t s_head = 0;                 // Records ever claimed; slot = head & mask
+static volatile bool s_enabled = false;
+
+#define TRACE_RING_MASK     ((uint32_t)CONFIG_TRACE_RING_RECORDS - 1U)
+
+static inline void trace_write(trace_id_t id, uint32_t start_us, uint32_t dur_us,
+                               uint32_t arg, uint16_t flags) {
+    if (!s_enabled) {
+        return;
+    }
+    uint32_t index = __atomic_fetch_add(&s_head, 1U, __ATOMIC_RELAXED);
+    trace_record_t *rec = &s_ring[index & TRACE_RING_MASK];
+    rec->start_us = start_us;
+    rec->dur_us = dur_us;
+    rec->arg = arg;
+    rec->id = (uint8_t)id;
+    rec->core = (uint8_t)xPortGetCoreID();
+    rec->flags = flags;
+}
+
+void trace_record_span(trace_id_t id, uint32_t start_us, uint32_t arg) {
+    trace_write(id, start_us, trace_now_us() - start_us, arg, 0);
+}
+
+void trace_record_instant(trace_id_t id, uint32_t arg) {
+    trace_write(id, trace_now_us(), 0, arg, TRACE_FLAG_INSTANT);
+}
+
+esp_err_t trace_init(void) {
+#if CONFIG_TRACE_ENABLED
+    if (s_ring != NULL) {
+        return ESP_OK;
+    }
+
+    size_t bytes = (size_t)CONFIG_TRACE_RING_RECORDS * sizeof(trace_record_t);
+    s_ring = (trace_record_t *)memory_manager_arena_acquire(MEMORY_SLOT_TRACE_RING, bytes);
+    if (s_ring == NULL) {
+        ESP_LOGW(TAG, "No memory for the trace ring (%u bytes) - tracing disabled", (unsigned int)bytes);
+        return ESP_ERR_NO_MEM;
+    }
+    memset(s_ring, 0, bytes);
+    __atomic_store_n(&s_head, 0U, __ATOMIC_RELAXED);
+    s_enabled = true;
+
+    ESP_LOGI(TAG, "Trace ring: %d records (%u bytes)", CONFIG_TRACE_RING_RECORDS, (unsigned int)bytes);
+#endif
+    return ESP_OK;
+}
+
+void trace_set_enabled(bool enabled) {
+    s_enabled = enabled && (s_ring != NULL);
+}
+
+/**
+ * @brief Stop writers and wait out any that already passed the enabled check
+ */
+static bool trace_pause(void) {
+    bool was_enabled = s_enabled;
+    s_enabled = false;
+    vTaskDelay(2);
+    return was_enabled;
+}
+
+void trace_clear(void) {
+    if (s_ring == NULL) {
+        return;
+    }
+    bool was_enabled = trace_pause();
+    __atomic_store_n(&s_head, 0U, __ATOMIC_RELAXED);
+    trace_set_enabled(was_enabled);
+}
+
+void trace_dump_chrome(void) {
+    if (s_ring == NULL) {
+        printf("Tracing is not available (CONFIG_TRACE_ENABLED=%d)\n", CONFIG_TRACE_ENABLED);
+        return;
+    }
+
+    bool was_enabled = trace_pause();
+
+    uint32_t head = __atomic_load_n(&s_head, __ATOMIC_RELAXED);
+    uint32_t count = head < CONFIG_TRACE_RING_RECORDS ? head : CONFIG_TRACE_RING_RECORDS;
+    uint32_t first = head - count;
+
+    printf("=== TRACE BEGIN ===\n");
+    printf("{\"displayTimeUnit\":\"ms\",\"otherData\":{\"records\":%u,\"overwritten\":%u},\"traceEvents\":[\n",
+           (unsigned int)count, (unsigned int)(head - count));
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        printf("{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%d,\"args\":{\"name\":\"core %d\"}},\n",
+               core, core);
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        const trace_record_t *rec = &s_ring[(first + i) & TRACE_RING_MASK];
+        const char *name = rec->id < TRACE_ID_COUNT ? s_trace_names[rec->id] : "unknown";
+        const char *sep = (i + 1 < count) ? "," : "";
+        if (rec->flags & TRACE_FLAG_INSTANT) {
+            printf("{\"ph\":\"i\",\"s\":\"g\",\"name\":\"%s\",\"pid\":%u,\"tid\":%u,\"ts\":%u,\"args\":{\"v\":%u}}%s\n",
+                   name, (unsigned int)rec->core, (unsigned int)rec->id,
+                   (unsigned int)rec->start_us, (unsigned int)rec->arg, sep);
+        } else {
+            printf("{\"ph\":\"X\",\"name\":\"%s\",\"pid\":%u,\"tid\":%u,\"ts\":%u,\"dur\":%u,\"args\":{\"v\":%u}}%s\n",
+                   name, (unsigned int)rec->core, (unsigned int)rec->id,
+                   (unsigned int)rec->start_us, (unsigned int)rec->dur_us, (unsigned int)rec->arg, sep);
+        }
+        // Printing thousands of lines at 115200 baud; keep the idle task (and its watchdog) fed
+        if ((i & 63U) == 63U) {
+            vTaskDelay(1);
+        }
+    }
+    printf("]}\n");
+    printf("=== TRACE END ===\n");
+
+    trace_set_enabled(was_enabled);
+}
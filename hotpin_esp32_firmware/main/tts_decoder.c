@@ -3,29 +3,44 @@
  * @brief TTS audio decoder with WAV parsing and I2S playback
  * 
  * Implements:
- * - 44-byte WAV RIFF header parsing
+ * - Framed downlink (tts_frame.h): format per block from the frame header,
+ *   mid-reply format switches, segment flush and explicit end of reply
+ * - 44-byte WAV RIFF header parsing (CONFIG_TTS_WAV_COMPAT, servers without framing)
  * - Sample rate, channels, bit depth extraction
  * - PCM data streaming to I2S TX
  * - Multi-chunk WAV file handling
+ * - Zero-copy receive path: WebSocket payloads land once in a pooled playback
+ *   block, are stereo-expanded in place and written to I2S from that block
+ * - Jitter buffer: start threshold adapts to measured arrival jitter, underruns
+ *   are faded out/in instead of clicking
  */
 
+// Before any include: esp_log.h reads LOG_LOCAL_LEVEL at each ESP_LOGx call
+#define LOG_LOCAL_LEVEL CONFIG_LOG_FLOOR_TTS
+
 #include "tts_decoder.h"
 #include "config.h"
+#include "log_manager.h"
 #include "audio_driver.h"
+#include "audio_dsp.h"
 #include "audio_feedback.h"
 #include "feedback_player.h"
 #include "websocket_client.h"
 #include "event_dispatcher.h"
 #include "system_events.h"
+#include "memory_manager.h"
+#include "trace.h"
+#include "turn_metrics.h"
+#include "wav_header.h"
 #include "esp_log.h"
 #include "esp_heap_caps.h"
 #include "esp_task_wdt.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
-#include "freertos/stream_buffer.h"
 #include <string.h>
 #include <inttypes.h>
+#include <stdatomic.h>
 #include "esp_timer.h"
 #include <string.h>
 #include <stdint.h>
@@ -34,26 +49,76 @@
 
 static const char *TAG = TAG_TTS;
 
-// Runtime WAV metadata extracted from the RIFF header
+// ===========================
+// Playback Block Pool
+// ===========================
+// Replaces the 320 KB stream buffer + 4 KB dma_buffer + 8 KB stereo scratch chain.
+// The WebSocket callback copies each payload once into a free block and publishes
+// it on the ready queue; the playback task expands mono samples to stereo in place
+// (each block has room for twice its payload) and hands the block to I2S directly.
+#define TTS_BLOCK_STORAGE_BYTES (CONFIG_TTS_BLOCK_PAYLOAD_BYTES * 2U)
+#define TTS_BLOCK_POOL_BYTES    (TTS_BLOCK_STORAGE_BYTES * CONFIG_TTS_BLOCK_COUNT)
+
+typedef struct {
+    uint8_t *data;  // TTS_BLOCK_STORAGE_BYTES, first half holds received bytes
+    size_t len;     // Received (WAV/mono PCM) bytes in data
+    tts_stream_format_t format;  // Framed downlink format of data; sample_rate 0 = WAV stream
+} tts_block_t;
+
+static tts_block_t s_blocks[CONFIG_TTS_BLOCK_COUNT];
+static uint8_t *s_block_storage = NULL;             // Single PSRAM allocation backing all blocks
+static QueueHandle_t s_free_blocks = NULL;          // tts_block_t* ready to be filled
+static QueueHandle_t s_ready_blocks = NULL;         // tts_block_t* waiting for playback (NULL = wake-up)
+static tts_block_t *s_fill_block = NULL;            // Block being filled by the receive path
+static atomic_size_t s_pending_bytes = 0;           // Received bytes not yet handed to I2S
+
+// Framed downlink: the receive path stamps s_rx_format on each block it fills;
+// playback reconfigures whenever a block's format differs from s_play_format
+static tts_stream_format_t s_rx_format;             // Zero while the server sends WAV
+static tts_stream_format_t s_play_format;
+static volatile bool s_segment_flushed = false;     // FLUSH while buffering: start below the target
+
+// On-the-fly resampling for mono WAVs not at CONFIG_AUDIO_SAMPLE_RATE (I2S TX stays put)
+static audio_dsp_resampler_t s_resampler;
+static bool s_resample_active = false;
+static int16_t *s_resample_out = NULL;              // Stereo output for one resampled block
+static size_t s_resample_out_frames = 0;
+
+// ===========================
+// Jitter Buffer
+// ===========================
+// Playback holds received blocks until enough audio is queued to ride out the
+// measured inter-arrival jitter, then plays. If the ready queue runs dry mid-reply
+// the tail is faded out just before the I2S DMA empties (auto-clear would otherwise
+// cut hard to zero), the buffer re-fills to the start threshold and the next block
+// fades back in. Underruns also raise the threshold for later replies.
+#define TTS_JITTER_FADE_FRAMES  ((CONFIG_TTS_JITTER_FADE_MS * CONFIG_AUDIO_SAMPLE_RATE) / 1000)
+
 typedef struct {
-    uint16_t audio_format;   // Should be 1 (PCM)
-    uint16_t num_channels;   // 1 = mono, 2 = stereo
-    uint32_t sample_rate;    // Samples per second (e.g., 16000)
-    uint32_t byte_rate;      // sample_rate * channels * bits_per_sample / 8
-    uint16_t block_align;    // channels * bits_per_sample / 8
-    uint16_t bits_per_sample;// Typically 16 for PCM
-    uint32_t data_size;      // Bytes of PCM data reported by header
-} wav_runtime_info_t;
-
-// Stream buffer for audio data
-// ✅ CRITICAL FIX: Increased buffer size to handle larger TTS responses
-// Server generates responses up to 256KB - previous 192KB buffer was too small
-#define TTS_STREAM_BUFFER_SIZE (327680)      // 320 KB - handles typical responses with safety margin
-#define TTS_STREAM_BUFFER_TRIGGER_LEVEL (16 * 1024)  // Maintain reasonable trigger threshold for streaming
-#define AUDIO_CHUNK_SIZE        4096        // DMA buffer size for I2S playback
-static StreamBufferHandle_t g_audio_stream_buffer = NULL;
-static uint8_t* g_stream_buffer_storage = NULL; // Storage will be in PSRAM
-static StaticStreamBuffer_t s_stream_buffer_struct;
+    // Receive side (WebSocket callback)
+    int64_t first_arrival_us;       // First payload of the current reply, 0 = none yet
+    int64_t last_arrival_us;
+    int64_t last_frame_media_us;    // Audio duration carried by the previous payload
+    volatile uint32_t jitter_us;    // Smoothed lateness, kept across replies
+    uint32_t byte_rate;             // Source bytes per second from the last parsed header
+    // Playback side
+    bool buffering;                 // Holding blocks until the start threshold is met
+    bool started;                   // Playback started at least once this reply
+    bool fade_in_pending;           // Next block resumes after concealment
+    int64_t buffering_since_us;     // Re-buffer start, 0 = initial prebuffer
+    int64_t dry_at_us;              // When audio already queued to I2S runs out
+    int16_t last_frame[2];          // Final stereo frame written, seeds the fade-out
+    uint32_t margin_ms;             // Extra prebuffer learned from underruns
+    uint32_t reply_underruns;
+    tts_jitter_stats_t stats;
+} tts_jitter_t;
+
+static tts_jitter_t s_jitter = {
+    .jitter_us = CONFIG_TTS_JITTER_INITIAL_MS * 1000U,
+    .byte_rate = CONFIG_AUDIO_SAMPLE_RATE * 2U,
+    .buffering = true,
+};
+static int16_t s_conceal_frames[TTS_JITTER_FADE_FRAMES * 2];
 
 // State management
 static bool is_initialized = false;
@@ -68,37 +133,54 @@ static volatile uint32_t playback_start_time = 0; // Track when playback started
 static volatile bool is_session_active = false;   // Track if we're in an active audio session
 static volatile uint32_t session_start_time = 0;  // Track when current session started
 static volatile bool force_stop_requested = false; // Emergency stop flag
+static volatile bool s_interrupted = false;        // Reply cut short by barge-in
 static volatile bool session_ended = false;        // Track if current session has ended
 static volatile uint32_t session_bytes_played = 0;  // Track bytes played in current session
 
 // WAV header info
-static wav_runtime_info_t wav_info;
+static wav_header_info_t wav_info;
 static volatile size_t bytes_received = 0;
 static volatile size_t pcm_bytes_played = 0;
 
-// Stereo duplication scratch space (allocated on demand)
-static uint8_t *s_stereo_scratch = NULL;
-static size_t s_stereo_scratch_size = 0;
-static size_t s_stereo_scratch_capacity_samples = 0;
-
 // Playback task
 static TaskHandle_t g_playback_task_handle = NULL;
 
+#if CONFIG_TTS_WAV_COMPAT
 #define WAV_HEADER_BUFFER_MAX   8192
 
 // Buffer for header accumulation
 static uint8_t header_buffer[WAV_HEADER_BUFFER_MAX] __attribute__((aligned(4)));
-static volatile size_t header_bytes_received = 0;
+#endif
+static volatile size_t header_bytes_received = 0;   // Stays 0 for framed replies
 
 // ===========================
 // Private Function Declarations
 // ===========================
 static void tts_playback_task(void *pvParameters);
+#if CONFIG_TTS_WAV_COMPAT
 static esp_err_t parse_wav_header(const uint8_t *buffer, size_t length, size_t *header_consumed);
-static void print_wav_info(const wav_runtime_info_t *info);
+static void print_wav_info(const wav_header_info_t *info);
+#endif
+static void apply_stream_format(const tts_stream_format_t *format);
+static void setup_playback_rate(uint32_t sample_rate);
+static void publish_fill_block(void);
 static void audio_data_callback(const uint8_t *data, size_t len, void *arg);
-static esp_err_t write_pcm_chunk_to_driver(const uint8_t *data, size_t length, size_t *accounted_bytes);
-static bool ensure_stereo_scratch_buffer(void);
+static esp_err_t play_block(tts_block_t *block, size_t *accounted_bytes);
+static esp_err_t block_pool_create(void);
+static void block_pool_destroy(void);
+static void block_pool_reset(void);
+static bool configure_playback_rate(uint32_t sample_rate);
+static void release_resampler(void);
+static size_t block_pool_write(const uint8_t *data, size_t len);
+static void jitter_reset_reply(void);
+static void jitter_on_arrival(size_t len);
+static uint32_t jitter_target_ms(void);
+static bool jitter_prebuffer_ready(void);
+static void jitter_start_playback(void);
+static void jitter_on_block_written(int16_t *stereo, size_t frames);
+static TickType_t jitter_receive_timeout(void);
+static bool jitter_conceal_underrun(void);
+static void jitter_finish_reply(void);
 
 // Safe watchdog reset function to prevent errors when task is not registered
 // ✅ FIX #2: Only reset watchdog if we're in the correct task context and still registered
@@ -133,44 +215,11 @@ esp_err_t tts_decoder_init(void) {
         return ESP_OK;
     }
     
-    // Create audio stream buffer in PSRAM
-    if (g_audio_stream_buffer == NULL) {
-        // Check if sufficient PSRAM is available before allocating
-        size_t psram_free = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
-        size_t required = TTS_STREAM_BUFFER_SIZE + 32768; // Buffer + 32KB safety margin
-        
-        if (psram_free < required) {
-            ESP_LOGE(TAG, "Insufficient PSRAM for TTS buffer: need %u bytes, have %u bytes",
-                     (unsigned int)required, (unsigned int)psram_free);
-            return ESP_ERR_NO_MEM;
-        }
-        
-        ESP_LOGI(TAG, "Allocating %d byte PSRAM buffer for TTS stream", TTS_STREAM_BUFFER_SIZE);
-        ESP_LOGI(TAG, "  PSRAM available: %u bytes (%u KB)", 
-                 (unsigned int)psram_free, (unsigned int)(psram_free / 1024));
-        
-        g_stream_buffer_storage = (uint8_t *)heap_caps_malloc(TTS_STREAM_BUFFER_SIZE, MALLOC_CAP_SPIRAM);
-        if (g_stream_buffer_storage == NULL) {
-            ESP_LOGE(TAG, "Failed to allocate PSRAM for stream buffer storage");
-            ESP_LOGE(TAG, "  Requested: %d bytes", TTS_STREAM_BUFFER_SIZE);
-            ESP_LOGE(TAG, "  Available: %u bytes", (unsigned int)psram_free);
-            return ESP_ERR_NO_MEM;
-        }
-        
-        ESP_LOGI(TAG, "  ✓ TTS stream buffer allocated at %p", g_stream_buffer_storage);
-
-        g_audio_stream_buffer = xStreamBufferCreateStatic(
-            TTS_STREAM_BUFFER_SIZE,
-            TTS_STREAM_BUFFER_TRIGGER_LEVEL,
-            g_stream_buffer_storage,
-            &s_stream_buffer_struct
-        );
-
-        if (g_audio_stream_buffer == NULL) {
-            ESP_LOGE(TAG, "Failed to create audio stream buffer");
-            heap_caps_free(g_stream_buffer_storage);
-            g_stream_buffer_storage = NULL;
-            return ESP_ERR_NO_MEM;
+    // Create playback block pool in PSRAM
+    if (s_block_storage == NULL) {
+        esp_err_t pool_ret = block_pool_create();
+        if (pool_ret != ESP_OK) {
+            return pool_ret;
         }
     }
     
@@ -196,23 +245,9 @@ esp_err_t tts_decoder_deinit(void) {
         tts_decoder_stop();
     }
     
-    // Delete stream buffer
-    if (g_audio_stream_buffer != NULL) {
-        vStreamBufferDelete(g_audio_stream_buffer);
-        g_audio_stream_buffer = NULL;
-    }
-    if (g_stream_buffer_storage != NULL) {
-        heap_caps_free(g_stream_buffer_storage);
-        g_stream_buffer_storage = NULL;
-    }
-
-    if (s_stereo_scratch != NULL) {
-        ESP_LOGD(TAG, "Freeing stereo scratch buffer (%zu bytes)", s_stereo_scratch_size);
-        heap_caps_free(s_stereo_scratch);
-        s_stereo_scratch = NULL;
-        s_stereo_scratch_size = 0;
-        s_stereo_scratch_capacity_samples = 0;
-    }
+    // Release playback block pool
+    block_pool_destroy();
+    release_resampler();
     
     is_initialized = false;
     ESP_LOGI(TAG, "TTS decoder deinitialized");
@@ -257,13 +292,14 @@ esp_err_t tts_decoder_start(void) {
     eos_requested = false;
     playback_completed = false;
     audio_data_received = false;
+    force_stop_requested = false;
+    s_interrupted = false;
     playback_start_time = (uint32_t)(esp_timer_get_time() / 1000);
     memset(&wav_info, 0, sizeof(wav_info));
 
     // Ensure no stale PCM data remains from a previous session
-    if (g_audio_stream_buffer != NULL) {
-        xStreamBufferReset(g_audio_stream_buffer);
-    }
+    block_pool_reset();
+    jitter_reset_reply();
 
     // CRITICAL FIX: Move TTS playback task to Core 1 to prevent Core 0 starvation
     // Core 0 handles WiFi/TCP and STT input, Core 1 handles state management and TTS output
@@ -328,10 +364,8 @@ esp_err_t tts_decoder_stop(void) {
         session_bytes_played = 0;
         playback_start_time = 0;
         session_start_time = 0;
-        // Clear the stream buffer if it exists
-        if (g_audio_stream_buffer != NULL) {
-            xStreamBufferReset(g_audio_stream_buffer);
-        }
+        // Return every block to the free pool
+        block_pool_reset();
         return ESP_OK;
     }
 
@@ -341,14 +375,13 @@ esp_err_t tts_decoder_stop(void) {
     eos_requested = true;
     force_stop_requested = true;
 
-    // ✅ CRITICAL FIX: Unblock the stream buffer BEFORE deleting the task
-    // If the task is blocked in xStreamBufferReceive(), send dummy data to unblock it
+    // ✅ CRITICAL FIX: Unblock the ready queue BEFORE deleting the task
+    // If the task is blocked in xQueueReceive(), a NULL block wakes it up
     // This allows the task to see the stop flags and exit cleanly
-    if (g_playback_task_handle != NULL && g_audio_stream_buffer != NULL) {
-        ESP_LOGI(TAG, "Unblocking stream buffer to allow task cleanup...");
-        // Send a zero byte to wake up any blocked receiver
-        uint8_t dummy = 0;
-        xStreamBufferSend(g_audio_stream_buffer, &dummy, 1, 0);
+    if (g_playback_task_handle != NULL && s_ready_blocks != NULL) {
+        ESP_LOGI(TAG, "Unblocking playback queue to allow task cleanup...");
+        tts_block_t *wake = NULL;
+        xQueueSend(s_ready_blocks, &wake, 0);
         
         // Give the task a brief moment to notice the stop flags and exit cleanly
         vTaskDelay(pdMS_TO_TICKS(10));
@@ -365,12 +398,11 @@ esp_err_t tts_decoder_stop(void) {
         vTaskDelay(pdMS_TO_TICKS(5));
     }
 
-    // ✅ CRITICAL FIX: Reset stream buffer AFTER task deletion to clear dangling state
-    // This prevents "xTaskWaitingToReceive" assertion failure on next start
-    if (g_audio_stream_buffer != NULL) {
-        ESP_LOGI(TAG, "Resetting audio stream buffer to clear internal state.");
-        xStreamBufferReset(g_audio_stream_buffer);
-    }
+    // ✅ CRITICAL FIX: Reset block pool AFTER task deletion
+    // A force-deleted task may still own a block; rebuilding the free queue recovers it
+    ESP_LOGI(TAG, "Resetting playback block pool to clear internal state.");
+    block_pool_reset();
+    release_resampler();
 
     // Restore the default I2S clock rate as a safety measure
     esp_err_t clk_ret = audio_driver_set_tx_sample_rate(CONFIG_AUDIO_SAMPLE_RATE);
@@ -394,21 +426,31 @@ esp_err_t tts_decoder_stop(void) {
     session_bytes_played = 0;
     playback_start_time = 0;
     session_start_time = 0;
-    
-    // Free stereo scratch buffer to prevent DMA fragmentation
-    if (s_stereo_scratch != NULL) {
-        ESP_LOGI(TAG, "Freeing stereo scratch buffer (%zu bytes) to reduce fragmentation", s_stereo_scratch_size);
-        heap_caps_free(s_stereo_scratch);
-        s_stereo_scratch = NULL;
-        s_stereo_scratch_size = 0;
-        s_stereo_scratch_capacity_samples = 0;
-    }
     // ------------------------------------
 
     ESP_LOGI(TAG, "⏹️ TTS decoder stopped and reset.");
     return ESP_OK;
 }
 
+esp_err_t tts_decoder_interrupt(void) {
+    if (!is_running || g_playback_task_handle == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    ESP_LOGI(TAG, "✋ Interrupting playback (barge-in)");
+
+    // Unlike tts_decoder_stop(), let the task leave on its own: it may be inside
+    // audio_driver_write() holding the TX mutex, and it posts PLAYBACK_FINISHED
+    s_interrupted = true;
+    force_stop_requested = true;
+    eos_requested = true;
+    if (s_ready_blocks != NULL) {
+        tts_block_t *wake = NULL;
+        xQueueSendToFront(s_ready_blocks, &wake, 0);
+    }
+    return ESP_OK;
+}
+
 bool tts_decoder_is_playing(void) {
     return is_playing;
 }
@@ -433,7 +475,6 @@ bool tts_decoder_is_receiving_audio(void) {
 static void audio_data_callback(const uint8_t *data, size_t len, void *arg) {
     static uint32_t chunk_count = 0;
     static uint32_t rejected_count = 0;
-    static uint32_t last_log_count = 0;
     chunk_count++;
 
     // ✅ FIX #5: Reject audio data if TTS decoder is not running
@@ -441,43 +482,33 @@ static void audio_data_callback(const uint8_t *data, size_t len, void *arg) {
     if (!is_running || g_playback_task_handle == NULL) {
         rejected_count++;
 
-        // ✅ FIX: Further reduce log spam - only log first, every 50th, and reset on new session
-        // This prevents hundreds of warnings during mode transitions
-        if (rejected_count == 1 ||
-            (rejected_count >= 50 && (rejected_count % 50) == 0) ||
-            (rejected_count - last_log_count) >= 100) {
-            ESP_LOGW(TAG, "Rejecting audio chunks - TTS decoder not running (chunks rejected: %u, last: %zu bytes)",
-                     (unsigned int)rejected_count, len);
-            last_log_count = rejected_count;
-        }
+        // Mode transitions deliver hundreds of these; the bucket keeps a few
+        LOGW_RL(TAG, "Rejecting audio chunks - TTS decoder not running (chunks rejected: %u, last: %zu bytes)",
+                (unsigned int)rejected_count, len);
         return;
     }
 
     // Clear rejection counters once the decoder starts processing audio again
     if (rejected_count != 0) {
         rejected_count = 0;
-        last_log_count = 0;
     }
     
-    // ✅ BUFFER OVERFLOW DETECTION: Check buffer capacity BEFORE accepting data
-    size_t buffer_space = xStreamBufferSpacesAvailable(g_audio_stream_buffer);
-    size_t buffer_used = xStreamBufferBytesAvailable(g_audio_stream_buffer);
+    // ✅ BUFFER PRESSURE DETECTION: Report free blocks BEFORE accepting data
+    UBaseType_t free_blocks = (s_free_blocks != NULL) ? uxQueueMessagesWaiting(s_free_blocks) : 0;
     
-    ESP_LOGI(TAG, "Received audio chunk #%u: %zu bytes (buffer: %zu/%d used, %zu free)", 
-             (unsigned int)chunk_count, len, buffer_used, TTS_STREAM_BUFFER_SIZE, buffer_space);
+    LOGD_DEFER(TAG, "Received audio chunk #%u: %u bytes (blocks free: %u/" TOSTRING(CONFIG_TTS_BLOCK_COUNT)
+               ", pending: %u bytes)", (unsigned int)chunk_count, (unsigned int)len,
+               (unsigned int)free_blocks, (unsigned int)atomic_load(&s_pending_bytes));
     
-    // ✅ CRITICAL: Warn if incoming data exceeds available buffer space
-    if (len > buffer_space) {
-        ESP_LOGW(TAG, "⚠️ BUFFER PRESSURE: Incoming %zu bytes, only %zu bytes free", len, buffer_space);
-        ESP_LOGW(TAG, "   Buffer: %zu/%d bytes used (%.1f%% full)", 
-                 buffer_used, TTS_STREAM_BUFFER_SIZE, 
-                 (buffer_used * 100.0) / TTS_STREAM_BUFFER_SIZE);
-        ESP_LOGW(TAG, "   This may cause delays or data loss if playback is slow");
+    // ✅ Pool exhaustion is normal backpressure: the callback waits for playback to
+    // return a block, which in turn throttles the server through the TCP window
+    if (free_blocks == 0 && s_fill_block == NULL) {
+        ESP_LOGD(TAG, "Playback block pool exhausted - waiting for playback to drain");
     }
     
     // Log first few bytes of EVERY chunk for debugging WAV stream issues
     if (chunk_count <= 5 && len >= 12) {
-        ESP_LOGI(TAG, "Chunk #%u first 12 bytes: %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X",
+        ESP_LOGD(TAG, "Chunk #%u first 12 bytes: %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X",
                  (unsigned int)chunk_count,
                  data[0], data[1], data[2], data[3], data[4], data[5], 
                  data[6], data[7], data[8], data[9], data[10], data[11]);
@@ -490,7 +521,7 @@ static void audio_data_callback(const uint8_t *data, size_t len, void *arg) {
     }
 
     // ✅ FIX: Handle zero-length chunks early - don't mark as audio data received
-    if (g_audio_stream_buffer != NULL) {
+    if (s_block_storage != NULL) {
         // Handle special case: zero-length data with NULL pointer (used to signal EOS)
         if (len == 0) {
             if (data == NULL) {
@@ -509,50 +540,21 @@ static void audio_data_callback(const uint8_t *data, size_t len, void *arg) {
             }
         }
 
-        // Push the entire chunk into the stream buffer, yielding while we wait for space
-        const TickType_t per_attempt_wait = pdMS_TO_TICKS(40);
-        const TickType_t max_wait_ticks = pdMS_TO_TICKS(1000);  // Allow up to 1s per chunk before giving up
-        TickType_t wait_start = xTaskGetTickCount();
-        size_t total_sent = 0;
-
-        while (total_sent < len) {
-            size_t remaining = len - total_sent;
-            size_t sent = xStreamBufferSend(g_audio_stream_buffer,
-                                            data + total_sent,
-                                            remaining,
-                                            per_attempt_wait);
-
-            if (sent == 0) {
-                if ((xTaskGetTickCount() - wait_start) >= max_wait_ticks) {
-                    static uint32_t timeout_count = 0;
-                    timeout_count++;
-                    uint32_t waited_ms = (uint32_t)((xTaskGetTickCount() - wait_start) * portTICK_PERIOD_MS);
-                    ESP_LOGW(TAG, "Stream buffer congested - dropped %zu bytes after %u ms (timeouts: %u)",
-                             remaining,
-                             (unsigned int)waited_ms,
-                             (unsigned int)timeout_count);
-                    break;
-                }
-
-                // Give the playback task time to drain while keeping watchdog happy
-                safe_task_wdt_reset();
-                continue;
-            }
-
-            total_sent += sent;
-        }
-
+        // Copy the chunk into playback blocks (the only copy on the receive path)
+        size_t total_sent = block_pool_write(data, len);
         if (total_sent != len) {
             // Chunk was not fully enqueued - treat remaining bytes as dropped
             return;
         }
 
         bytes_received += len;
+        jitter_on_arrival(len);
 
         // ✅ FIX: Mark audio data received only AFTER successfully sending data to buffer
         if (!audio_data_received) {
             audio_data_received = true;
             ESP_LOGI(TAG, "🎙️ First real audio data received for session (%zu bytes)", len);
+            turn_metrics_mark(TURN_MARK_FIRST_AUDIO);
 
             // Send session start notification for the first audio chunk
             system_event_t evt = {
@@ -567,7 +569,7 @@ static void audio_data_callback(const uint8_t *data, size_t len, void *arg) {
         static uint32_t success_count = 0;
         success_count++;
         if ((success_count % 100) == 0) {  // Log every 100 successes to prevent log spam
-            ESP_LOGD(TAG, "Sent %zu bytes to stream buffer (total received: %zu, successes: %u)",
+            ESP_LOGD(TAG, "Queued %zu bytes to playback blocks (total received: %zu, successes: %u)",
                      len, bytes_received, (unsigned int)success_count);
         }
 
@@ -580,9 +582,7 @@ static void audio_data_callback(const uint8_t *data, size_t len, void *arg) {
         // Only log when decoder is not initialized at all
         static uint32_t drop_count = 0;
         drop_count++;
-        if ((drop_count % 50) == 0) {  // Log every 50 drops to prevent log spam
-            ESP_LOGW(TAG, "Decoder not initialized - dropping %zu-byte chunk (drops: %u)", len, (unsigned int)drop_count);
-        }
+        LOGW_RL(TAG, "Decoder not initialized - dropping %zu-byte chunk (drops: %u)", len, (unsigned int)drop_count);
     }
 }
 
@@ -612,17 +612,10 @@ static void tts_playback_task(void *pvParameters) {
         return;
     }
 
-    // CRITICAL FIX: Allocate DMA buffer in PSRAM instead of on stack to prevent stack overflow
-    // Stack allocation of 4KB buffer was causing stack overflow in tts_playback task
-    uint8_t *dma_buffer = heap_caps_malloc(AUDIO_CHUNK_SIZE, MALLOC_CAP_SPIRAM);
-    if (dma_buffer == NULL) {
-        ESP_LOGE(TAG, "❌ Failed to allocate %d-byte DMA buffer in PSRAM", AUDIO_CHUNK_SIZE);
-        ESP_LOGE(TAG, "  Free PSRAM: %u bytes", (unsigned int)heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
-        g_playback_task_handle = NULL;
-        vTaskDelete(NULL);
-        return;
-    }
-    ESP_LOGI(TAG, "  ✓ DMA buffer allocated in PSRAM at %p (%d bytes)", dma_buffer, AUDIO_CHUNK_SIZE);
+    // Blocks come straight from the receive path; no per-task staging buffer is needed.
+    // The block being played is returned to the free pool at the top of the next
+    // iteration (or after the loop), so every break path releases it.
+    tts_block_t *block = NULL;
     
     esp_err_t playback_result = ESP_OK;
     uint32_t last_activity_timestamp = (uint32_t)(esp_timer_get_time() / 1000);
@@ -637,13 +630,50 @@ static void tts_playback_task(void *pvParameters) {
             break;
         }
         
-        // Wait for data in the stream buffer
-        size_t bytes_received_from_stream = xStreamBufferReceive(
-            g_audio_stream_buffer,
-            dma_buffer,
-            AUDIO_CHUNK_SIZE,
-            pdMS_TO_TICKS(100) // 100ms timeout - short enough to check stop flags frequently
-        );
+        if (block != NULL) {
+            xQueueSend(s_free_blocks, &block, 0);
+            block = NULL;
+        }
+
+        // Jitter buffer: leave received blocks queued until the start threshold is met
+        bool receive_block = true;
+        if (s_jitter.buffering) {
+            if (jitter_prebuffer_ready()) {
+                jitter_start_playback();
+            } else {
+                tts_block_t *head = NULL;
+                if (xQueuePeek(s_ready_blocks, &head, pdMS_TO_TICKS(100)) == pdTRUE) {
+                    if (head == NULL) {
+                        // Stop wake-up - consume it and re-check stop flags
+                        xQueueReceive(s_ready_blocks, &head, 0);
+                        continue;
+                    }
+                    last_activity_timestamp = (uint32_t)(esp_timer_get_time() / 1000);
+                    safe_task_wdt_reset();
+                    vTaskDelay(pdMS_TO_TICKS(10));
+                    continue;
+                }
+                receive_block = false;  // Nothing arrived - fall through to the idle checks
+            }
+        }
+
+        // Wait for a filled block from the receive path
+        // Up to 100ms (short enough to check stop flags), less when I2S is about to run dry
+        if (receive_block) {
+            TRACE_SPAN_BEGIN(recv);
+            bool got = xQueueReceive(s_ready_blocks, &block, jitter_receive_timeout()) == pdTRUE;
+            TRACE_SPAN_END(recv, TRACE_ID_TTS_BLOCK_RECV, (got && block != NULL) ? block->len : 0);
+            if (got && block == NULL) {
+                // NULL block is the wake-up posted by tts_decoder_stop() - re-check stop flags
+                continue;
+            }
+        }
+
+        size_t bytes_received_from_stream = 0;
+        if (block != NULL) {
+            bytes_received_from_stream = block->len;
+            atomic_fetch_sub(&s_pending_bytes, block->len);
+        }
 
         if (bytes_received_from_stream > 0) {
             last_activity_timestamp = (uint32_t)(esp_timer_get_time() / 1000);
@@ -658,7 +688,9 @@ static void tts_playback_task(void *pvParameters) {
             
             // ✅ FIX: Check if all audio data has been received
             // Compare bytes_received against expected total (WAV header + data size)
-            if (header_parsed && bytes_received >= (wav_info.data_size + 44)) {
+            // Streaming headers (unknown length) rely on the zero-length EOS frame instead
+            if (header_parsed && WAV_DATA_SIZE_IS_KNOWN(wav_info.data_size) &&
+                bytes_received >= ((size_t)wav_info.data_size + 44)) {
                 ESP_LOGI(TAG, "✅ All audio data received (%zu bytes, expected %u + 44 header)", 
                          bytes_received, (unsigned int)wav_info.data_size);
                 // Continue processing this chunk, then exit on next iteration
@@ -669,33 +701,22 @@ static void tts_playback_task(void *pvParameters) {
             static uint32_t buffer_monitor_count = 0;
             buffer_monitor_count++;
             
-            // Monitor buffer levels periodically to detect overflow conditions early
+            // Monitor pool occupancy periodically (a full ready queue is normal backpressure)
             if ((buffer_monitor_count % 50) == 0) {  // Check every 50 iterations
-                size_t buffer_space = xStreamBufferSpacesAvailable(g_audio_stream_buffer);
-                size_t buffer_level = xStreamBufferBytesAvailable(g_audio_stream_buffer);
-                ESP_LOGD(TAG, "[BUFFER MONITOR] Level: %zu bytes | Space: %zu bytes | Ratio: %.2f%%", 
-                         buffer_level, buffer_space, 
-                         (buffer_level * 100.0) / (buffer_level + buffer_space));
-                         
-                // Warn if buffer is getting full
-                if (buffer_level > (TTS_STREAM_BUFFER_SIZE * 0.8)) {  // 80% full
-                    ESP_LOGW(TAG, "⚠ Stream buffer approaching capacity: %zu/%d bytes (%.1f%%)", 
-                             buffer_level, TTS_STREAM_BUFFER_SIZE, 
-                             (buffer_level * 100.0) / TTS_STREAM_BUFFER_SIZE);
-                }
+                ESP_LOGD(TAG, "[BLOCK MONITOR] Ready: %u | Free: %u | Pending: %zu bytes",
+                         (unsigned int)uxQueueMessagesWaiting(s_ready_blocks),
+                         (unsigned int)uxQueueMessagesWaiting(s_free_blocks),
+                         atomic_load(&s_pending_bytes));
             }
             
-            // Adaptive flow control - slow down when buffer is getting full
-            size_t current_level = xStreamBufferBytesAvailable(g_audio_stream_buffer);
-            if (current_level > (TTS_STREAM_BUFFER_SIZE * 0.75)) {
-                // Buffer is 75% full - add small delay to let processing catch up
-                vTaskDelay(pdMS_TO_TICKS(2));
-            } else if (current_level > (TTS_STREAM_BUFFER_SIZE * 0.9)) {
-                // Buffer is 90% full - add larger delay to prevent overflow
-                vTaskDelay(pdMS_TO_TICKS(5));
+            // Framed blocks say their own format; a change takes effect at this block
+            if (block->format.sample_rate != 0 &&
+                (!header_parsed || !tts_stream_format_equal(&block->format, &s_play_format))) {
+                apply_stream_format(&block->format);
             }
-            
+
             if (!header_parsed) {
+#if CONFIG_TTS_WAV_COMPAT
                 // Still parsing header - accumulate into header_buffer
                 if (header_bytes_received + bytes_received_from_stream > WAV_HEADER_BUFFER_MAX) {
                     ESP_LOGE(TAG, "Header staging buffer overflow (%zu + %zu)",
@@ -705,7 +726,7 @@ static void tts_playback_task(void *pvParameters) {
                     break;
                 }
 
-                memcpy(header_buffer + header_bytes_received, dma_buffer, bytes_received_from_stream);
+                memcpy(header_buffer + header_bytes_received, block->data, bytes_received_from_stream);
                 header_bytes_received += bytes_received_from_stream;
 
                 size_t header_consumed = 0;
@@ -713,17 +734,18 @@ static void tts_playback_task(void *pvParameters) {
                 if (ret == ESP_OK) {
                     header_parsed = true;
                     print_wav_info(&wav_info);
+                    if (wav_info.byte_rate > 0) {
+                        s_jitter.byte_rate = wav_info.byte_rate;
+                    }
 
                     // Removed redundant playback start beep - not needed during TTS streaming
                     playback_feedback_sent = true;
 
-                    esp_err_t clk_ret = audio_driver_set_tx_sample_rate(wav_info.sample_rate);
-                    if (clk_ret != ESP_OK) {
-                        ESP_LOGW(TAG, "Unable to set TX sample rate to %u Hz: %s",
-                                 (unsigned int)wav_info.sample_rate, esp_err_to_name(clk_ret));
-                    }
+                    setup_playback_rate(wav_info.sample_rate);
 
                     // Play any remaining PCM data from the header buffer
+                    // Staged back through the current block (already copied out) so it
+                    // takes the same in-place stereo path as every later block
                     size_t pcm_len = header_bytes_received - header_consumed;
                     if (pcm_len > 0) {
                         // Check I2S state before attempting write
@@ -736,9 +758,20 @@ static void tts_playback_task(void *pvParameters) {
                         }
                         
                         size_t accounted = 0;
-                        esp_err_t write_ret = write_pcm_chunk_to_driver(header_buffer + header_consumed,
-                                                                       pcm_len,
-                                                                       &accounted);
+                        esp_err_t write_ret = ESP_OK;
+                        for (size_t offset = header_consumed;
+                             offset < header_bytes_received && write_ret == ESP_OK;) {
+                            size_t piece = header_bytes_received - offset;
+                            if (piece > CONFIG_TTS_BLOCK_PAYLOAD_BYTES) {
+                                piece = CONFIG_TTS_BLOCK_PAYLOAD_BYTES;
+                            }
+                            memcpy(block->data, header_buffer + offset, piece);
+                            block->len = piece;
+                            size_t piece_accounted = 0;
+                            write_ret = play_block(block, &piece_accounted);
+                            accounted += piece_accounted;
+                            offset += piece;
+                        }
                         if (write_ret == ESP_OK) {
                             pcm_bytes_played += accounted;
                             ESP_LOGD(TAG, "Played %zu bytes from initial chunk (total: %zu)",
@@ -765,7 +798,7 @@ static void tts_playback_task(void *pvParameters) {
                     // ✅ STREAMING FIX: Header not found yet - keep accumulating
                     // In streaming scenarios, the WAV header can arrive in ANY chunk, not just the first
                     // PCM data might arrive before the header due to network fragmentation
-                    if (header_bytes_received < WAV_HEADER_BUFFER_MAX - AUDIO_CHUNK_SIZE) {
+                    if (header_bytes_received < WAV_HEADER_BUFFER_MAX - CONFIG_TTS_BLOCK_PAYLOAD_BYTES) {
                         // Still have room in accumulation buffer - keep waiting for header
                         ESP_LOGD(TAG, "⏳ WAV header not found yet - accumulating data (%zu/%d bytes collected)", 
                                  header_bytes_received, WAV_HEADER_BUFFER_MAX);
@@ -789,13 +822,18 @@ static void tts_playback_task(void *pvParameters) {
                     playback_result = ret;
                     break;
                 }
+#else
+                // Only a server that declined framing sends these
+                LOGW_RL(TAG, "Dropping %zu bytes of unframed TTS audio (WAV compatibility disabled)",
+                        bytes_received_from_stream);
+#endif
             } else {
-                // Header already parsed - play PCM data directly from dma_buffer
+                // Header already parsed - play PCM data directly from the received block
                 // Removed redundant delayed playback beep - not needed
                 playback_feedback_sent = true;
 
                 size_t accounted = 0;
-                esp_err_t ret = write_pcm_chunk_to_driver(dma_buffer, bytes_received_from_stream, &accounted);
+                esp_err_t ret = play_block(block, &accounted);
 
                 if (ret == ESP_OK) {
                     pcm_bytes_played += accounted;
@@ -828,6 +866,11 @@ static void tts_playback_task(void *pvParameters) {
         } else {
             // ✅ STABILITY FIX: Timeout occurred - prevent watchdog starvation during network failures
             uint32_t current_time = (uint32_t)(esp_timer_get_time() / 1000);
+
+            // Ready queue ran dry mid-reply: fade out before DMA empties and re-buffer
+            if (jitter_conceal_underrun()) {
+                continue;
+            }
             
             // CRITICAL: Reset watchdog during idle periods to prevent timeout
             // This is essential when waiting for audio that may never arrive due to network errors
@@ -867,7 +910,7 @@ static void tts_playback_task(void *pvParameters) {
                 
                 // ✅ FIX #6: If EOS was requested, check if buffer is empty OR has remnant bytes (< 100)
                 if (eos_requested) {
-                    size_t buffer_remaining = xStreamBufferBytesAvailable(g_audio_stream_buffer);
+                    size_t buffer_remaining = atomic_load(&s_pending_bytes);
                     
                     if (buffer_remaining == 0 || buffer_remaining < 100) {
                         if (buffer_remaining > 0) {
@@ -884,7 +927,7 @@ static void tts_playback_task(void *pvParameters) {
                 
                 // ✅ FIX #8: Even without EOS, exit if buffer has remnant bytes (< 100) and no new data for 1+ second
                 // This handles user interruption case where is_running=false but loop is still processing
-                size_t buffer_remaining = xStreamBufferBytesAvailable(g_audio_stream_buffer);
+                size_t buffer_remaining = atomic_load(&s_pending_bytes);
                 if (buffer_remaining > 0 && buffer_remaining < 100 && (current_time - last_activity_timestamp) > 1000) {
                     ESP_LOGI(TAG, "Buffer stuck with %zu remnant bytes (< 100) for 1+ second. Exiting playback task.", 
                              buffer_remaining);
@@ -913,7 +956,7 @@ static void tts_playback_task(void *pvParameters) {
             
             // Regular EOS check
             if (eos_requested) {
-                size_t buffer_remaining = xStreamBufferBytesAvailable(g_audio_stream_buffer);
+                size_t buffer_remaining = atomic_load(&s_pending_bytes);
                 
                 // ✅ FIX #6: Exit if buffer is empty OR has remnant bytes (< 100) that won't play
                 // Remnant bytes (typically 44-80 bytes) are smaller than minimum I2S DMA buffer size
@@ -935,6 +978,7 @@ static void tts_playback_task(void *pvParameters) {
     
     ESP_LOGI(TAG, "🎵 TTS playback task exiting (played %zu bytes, result: %s)", 
              pcm_bytes_played, esp_err_to_name(playback_result));
+    jitter_finish_reply();
     
     // ✅ CRITICAL FIX: Dispatch TTS_PLAYBACK_FINISHED event BEFORE cleanup
     // This allows the state manager to know playback is complete and transition states if needed
@@ -953,7 +997,7 @@ static void tts_playback_task(void *pvParameters) {
     
     // Play completion feedback if playback was successful (played significant audio)
     // This signals to user that response is complete and they can provide next input
-    if (playback_result == ESP_OK && pcm_bytes_played > 10000) {  // > 10KB indicates real content played
+    if (playback_result == ESP_OK && pcm_bytes_played > 10000 && !s_interrupted) {  // > 10KB indicates real content played
         ESP_LOGI(TAG, "Playing Nokia-themed TTS completion feedback to signal readiness");
         esp_err_t fb_ret = feedback_player_play(FEEDBACK_SOUND_TTS_COMPLETE);
         if (fb_ret != ESP_OK) {
@@ -963,31 +1007,17 @@ static void tts_playback_task(void *pvParameters) {
         vTaskDelay(pdMS_TO_TICKS(50));
     }
     
-    // CRITICAL FIX: Free PSRAM-allocated DMA buffer before task exits
-    if (dma_buffer != NULL) {
-        heap_caps_free(dma_buffer);
-        dma_buffer = NULL;
-        ESP_LOGI(TAG, "  ✓ DMA buffer freed from PSRAM");
-    }
-    
-    // CRITICAL FIX: Free stereo scratch buffer on task exit to prevent DMA fragmentation
-    // This ensures the buffer is freed even if tts_decoder_stop() wasn't called properly
-    if (s_stereo_scratch != NULL) {
-        ESP_LOGI(TAG, "  ✓ Freeing stereo scratch buffer (%zu bytes) on task exit", s_stereo_scratch_size);
-        heap_caps_free(s_stereo_scratch);
-        s_stereo_scratch = NULL;
-        s_stereo_scratch_size = 0;
-        s_stereo_scratch_capacity_samples = 0;
+    // Return the last block, then clear the pool to prevent data accumulation between sessions
+    if (block != NULL) {
+        xQueueSend(s_free_blocks, &block, 0);
+        block = NULL;
     }
-    
-    // Clear stream buffer to prevent data accumulation between sessions
-    if (g_audio_stream_buffer != NULL) {
-        size_t buffer_remaining = xStreamBufferBytesAvailable(g_audio_stream_buffer);
-        if (buffer_remaining > 0) {
-            ESP_LOGI(TAG, "  ✓ Clearing %zu bytes from stream buffer", buffer_remaining);
-            xStreamBufferReset(g_audio_stream_buffer);
-        }
+    size_t blocks_remaining = atomic_load(&s_pending_bytes);
+    if (blocks_remaining > 0) {
+        ESP_LOGI(TAG, "  ✓ Clearing %zu bytes from playback blocks", blocks_remaining);
     }
+    block_pool_reset();
+    release_resampler();
     
     // ✅ FIX #1: Unregister from watchdog BEFORE setting any completion flags
     // This MUST happen before setting g_playback_task_handle = NULL
@@ -1014,23 +1044,24 @@ static void tts_playback_task(void *pvParameters) {
     vTaskDelete(temp_handle);
 }
 
-static esp_err_t write_pcm_chunk_to_driver(const uint8_t *data, size_t length, size_t *accounted_bytes) {
+static esp_err_t play_block(tts_block_t *block, size_t *accounted_bytes) {
     static uint32_t s_duplication_logs = 0;
     static uint32_t s_passthrough_logs = 0;
     if (accounted_bytes) {
         *accounted_bytes = 0;
     }
 
-    if (data == NULL || length == 0) {
+    if (block == NULL || block->len == 0) {
         return ESP_OK;
     }
 
-    size_t accounted = length;
+    size_t accounted = block->len;
+    size_t out_len = block->len;
     bool duplicate_to_stereo = false;
 
     if (header_parsed && wav_info.num_channels == 1 && wav_info.bits_per_sample == 16) {
-        if ((length % sizeof(int16_t)) != 0) {
-            ESP_LOGW(TAG, "Mono chunk size %zu not aligned to 16-bit samples - writing raw", length);
+        if ((block->len % sizeof(int16_t)) != 0) {
+            ESP_LOGW(TAG, "Mono chunk size %zu not aligned to 16-bit samples - writing raw", block->len);
         } else {
             duplicate_to_stereo = true;
         }
@@ -1039,71 +1070,70 @@ static esp_err_t write_pcm_chunk_to_driver(const uint8_t *data, size_t length, s
                  (unsigned int)wav_info.bits_per_sample);
     }
 
+    const uint8_t *out = block->data;
+
     if (duplicate_to_stereo) {
-        if (!ensure_stereo_scratch_buffer()) {
-            ESP_LOGE(TAG, "Failed to provision stereo scratch buffer (%u bytes)", (unsigned int)CONFIG_TTS_STEREO_SCRATCH_BYTES);
-            return ESP_ERR_NO_MEM;
+        const size_t sample_count = block->len / sizeof(int16_t);
+        int16_t *samples = (int16_t *)block->data;
+
+        if (s_resample_active && s_resample_out != NULL) {
+            // Rate conversion changes the length, so it renders into its own stereo buffer
+            size_t frames = audio_dsp_resample(&s_resampler, samples, sample_count,
+                                               s_resample_out, s_resample_out_frames);
+            audio_dsp_apply_gain(s_resample_out, frames, CONFIG_TTS_PLAYBACK_GAIN_Q8,
+                                 CONFIG_TTS_SOFT_CLIP_ENABLED);
+            audio_dsp_mono_to_stereo(s_resample_out, frames);
+            out = (const uint8_t *)s_resample_out;
+            out_len = frames * sizeof(int16_t) * 2U;
+        } else {
+            // Gain on mono samples (half the work), then expand in place; each block
+            // has room for twice its payload
+            audio_dsp_apply_gain(samples, sample_count, CONFIG_TTS_PLAYBACK_GAIN_Q8,
+                                 CONFIG_TTS_SOFT_CLIP_ENABLED);
+            audio_dsp_mono_to_stereo(samples, sample_count);
+            out_len = block->len * 2U;
         }
 
-        const size_t sample_count = length / sizeof(int16_t);
-        const int16_t *src = (const int16_t *)data;
-        size_t processed_samples = 0;
-
         if (s_duplication_logs < 6) {
-            ESP_LOGD(TAG, "[PCM DUP] %zu mono samples -> chunked stereo writes (scratch=%zu bytes)",
-                     sample_count, s_stereo_scratch_size);
+            ESP_LOGD(TAG, "[PCM DUP] %zu mono samples -> %zu stereo bytes%s",
+                     sample_count, out_len, s_resample_active ? " (resampled)" : "");
             s_duplication_logs++;
         }
+    }
 
-        while (processed_samples < sample_count) {
-            size_t remaining = sample_count - processed_samples;
-            size_t block_samples = (remaining < s_stereo_scratch_capacity_samples) ? remaining : s_stereo_scratch_capacity_samples;
-            int16_t *dst = (int16_t *)s_stereo_scratch;
-
-            for (size_t i = 0; i < block_samples; ++i) {
-                int16_t sample = src[processed_samples + i];
-                size_t idx = i * 2;
-                dst[idx] = sample;
-                dst[idx + 1] = sample;
-            }
-
-            size_t block_bytes = block_samples * sizeof(int16_t) * 2U;
-            size_t written = 0;
-            esp_err_t ret = audio_driver_write((const uint8_t *)dst, block_bytes, &written, portMAX_DELAY);
-            if (ret != ESP_OK) {
-                ESP_LOGE(TAG, "Stereo duplication write failed mid-stream: %s", esp_err_to_name(ret));
-                return ret;
-            }
-            if (written != block_bytes) {
-                ESP_LOGW(TAG, "Stereo write partial: %zu/%zu bytes", written, block_bytes);
-            }
-
-            processed_samples += block_samples;
-        }
-
-        if (accounted_bytes) {
-            *accounted_bytes = accounted;
-        }
-        return ESP_OK;
+    size_t out_frames = out_len / (sizeof(int16_t) * 2U);
+    if (duplicate_to_stereo && s_jitter.fade_in_pending) {
+        // Resuming after an underrun: ramp in from the concealment silence
+        size_t fade_frames = (out_frames < TTS_JITTER_FADE_FRAMES) ? out_frames : TTS_JITTER_FADE_FRAMES;
+        audio_dsp_apply_fade((int16_t *)out, fade_frames, true);
     }
+    s_jitter.fade_in_pending = false;
 
     size_t written = 0;
-    esp_err_t ret = audio_driver_write(data, length, &written, portMAX_DELAY);
+    esp_err_t ret = audio_driver_write(out, out_len, &written, portMAX_DELAY);
     if (ret != ESP_OK) {
+        if (duplicate_to_stereo) {
+            ESP_LOGE(TAG, "Stereo block write failed mid-stream: %s", esp_err_to_name(ret));
+        }
         return ret;
     }
+    if (written != out_len) {
+        ESP_LOGW(TAG, "Block write partial: %zu/%zu bytes", written, out_len);
+    }
+    jitter_on_block_written(duplicate_to_stereo ? (int16_t *)out : NULL,
+                            written / (sizeof(int16_t) * 2U));
+    turn_metrics_mark(TURN_MARK_FIRST_SAMPLE);
 
     // Add comprehensive logging to verify audio playback
     static size_t total_bytes_played = 0;
     total_bytes_played += written;
     
     if (s_passthrough_logs < 6) {
-        ESP_LOGI(TAG, "[PCM PLAYBACK] Successfully wrote %zu bytes to I2S driver (total: %zu bytes)", 
-                 written, total_bytes_played);
-        s_passthrough_logs++;
+        LOGI_DEFER(TAG, "[PCM PLAYBACK] Successfully wrote %u bytes to I2S driver (total: %u bytes)",
+                   (unsigned int)written, (unsigned int)total_bytes_played);
     } else if ((s_passthrough_logs % 100) == 0) {
-        ESP_LOGI(TAG, "[PCM PLAYBACK] Ongoing - wrote %zu bytes (total: %zu bytes)", 
-                 written, total_bytes_played);
+        LOGI_DEFER(TAG, "[PCM PLAYBACK] Ongoing - wrote %u bytes (total: %u bytes)",
+                   (unsigned int)written, (unsigned int)total_bytes_played);
     }
     s_passthrough_logs++;
 
@@ -1113,156 +1143,483 @@ static esp_err_t write_pcm_chunk_to_driver(const uint8_t *data, size_t length, s
     return ESP_OK;
 }
 
-static inline uint16_t read_le16(const uint8_t *ptr) {
-    return (uint16_t)(ptr[0] | (ptr[1] << 8));
+// ===========================
+// Playback Block Pool
+// ===========================
+
+static esp_err_t block_pool_create(void) {
+    // Check if sufficient PSRAM is available before allocating
+    // Served from the boot-time arena when it fits; only a heap fallback needs the headroom check
+    size_t psram_free = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    size_t required = TTS_BLOCK_POOL_BYTES + 32768; // Pool + 32KB safety margin
+
+    if (memory_manager_arena_slot_capacity(MEMORY_SLOT_TTS_BLOCKS) < TTS_BLOCK_POOL_BYTES &&
+        psram_free < required) {
+        ESP_LOGE(TAG, "Insufficient PSRAM for TTS block pool: need %u bytes, have %u bytes",
+                 (unsigned int)required, (unsigned int)psram_free);
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Allocating TTS block pool: %d blocks x %u bytes (%u KB PSRAM)",
+             CONFIG_TTS_BLOCK_COUNT, (unsigned int)TTS_BLOCK_STORAGE_BYTES,
+             (unsigned int)(TTS_BLOCK_POOL_BYTES / 1024));
+
+    s_block_storage = memory_manager_arena_acquire(MEMORY_SLOT_TTS_BLOCKS, TTS_BLOCK_POOL_BYTES);
+    s_free_blocks = xQueueCreate(CONFIG_TTS_BLOCK_COUNT, sizeof(tts_block_t *));
+    // +1 slot so the NULL wake-up from tts_decoder_stop() always fits
+    s_ready_blocks = xQueueCreate(CONFIG_TTS_BLOCK_COUNT + 1, sizeof(tts_block_t *));
+
+    if (s_block_storage == NULL || s_free_blocks == NULL || s_ready_blocks == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate TTS block pool");
+        block_pool_destroy();
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (size_t i = 0; i < CONFIG_TTS_BLOCK_COUNT; i++) {
+        s_blocks[i].data = s_block_storage + (i * TTS_BLOCK_STORAGE_BYTES);
+        s_blocks[i].len = 0;
+    }
+    block_pool_reset();
+
+    ESP_LOGI(TAG, "  ✓ TTS block pool allocated at %p", s_block_storage);
+    return ESP_OK;
 }
 
-static inline uint32_t read_le32(const uint8_t *ptr) {
-    return (uint32_t)(ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | (ptr[3] << 24));
+static void block_pool_destroy(void) {
+    if (s_ready_blocks != NULL) {
+        vQueueDelete(s_ready_blocks);
+        s_ready_blocks = NULL;
+    }
+    if (s_free_blocks != NULL) {
+        vQueueDelete(s_free_blocks);
+        s_free_blocks = NULL;
+    }
+    if (s_block_storage != NULL) {
+        memory_manager_arena_release(MEMORY_SLOT_TTS_BLOCKS, s_block_storage);
+        s_block_storage = NULL;
+    }
+    s_fill_block = NULL;
+    atomic_store(&s_pending_bytes, 0);
 }
 
-static esp_err_t parse_wav_header(const uint8_t *buffer, size_t length, size_t *header_consumed) {
-    if (length < 12) {
-        ESP_LOGD(TAG, "WAV header too short: %zu bytes (need at least 12)", length);
-        return ESP_ERR_INVALID_SIZE;
+static void block_pool_reset(void) {
+    if (s_free_blocks == NULL || s_ready_blocks == NULL) {
+        return;
     }
 
-    // ✅ STREAMING FIX: Search for RIFF header within the buffer
-    // In streaming scenarios, PCM data might arrive before the header due to network fragmentation
-    // We need to find where the actual WAV header starts
-    size_t riff_offset = 0;
-    bool riff_found = false;
-    
-    if (memcmp(buffer, "RIFF", 4) == 0) {
-        // Header is at the beginning (normal case)
-        riff_found = true;
-    } else {
-        // Search for RIFF header within the accumulated buffer
-        ESP_LOGD(TAG, "🔍 RIFF not at start, searching within %zu bytes...", length);
-        for (size_t i = 0; i <= length - 4; i++) {
-            if (memcmp(buffer + i, "RIFF", 4) == 0) {
-                riff_offset = i;
-                riff_found = true;
-                ESP_LOGI(TAG, "✅ Found RIFF header at offset %zu (skipped %zu bytes of PCM data)", i, i);
-                break;
+    // Rebuild from scratch rather than draining: a force-deleted playback task
+    // may have been holding a block that would otherwise leak
+    xQueueReset(s_ready_blocks);
+    xQueueReset(s_free_blocks);
+    s_fill_block = NULL;
+    for (size_t i = 0; i < CONFIG_TTS_BLOCK_COUNT; i++) {
+        tts_block_t *blk = &s_blocks[i];
+        blk->len = 0;
+        xQueueSend(s_free_blocks, &blk, 0);
+    }
+    atomic_store(&s_pending_bytes, 0);
+}
+
+static size_t block_pool_write(const uint8_t *data, size_t len) {
+    // Wait for free blocks while playback drains, yielding so the watchdog stays happy
+    const TickType_t per_attempt_wait = pdMS_TO_TICKS(40);
+    const TickType_t max_wait_ticks = pdMS_TO_TICKS(1000);  // Allow up to 1s per chunk before giving up
+    TickType_t wait_start = xTaskGetTickCount();
+    size_t total = 0;
+
+    while (total < len) {
+        if (s_fill_block == NULL) {
+            if (xQueueReceive(s_free_blocks, &s_fill_block, per_attempt_wait) != pdTRUE) {
+                s_fill_block = NULL;
+                if ((xTaskGetTickCount() - wait_start) >= max_wait_ticks) {
+                    static uint32_t timeout_count = 0;
+                    timeout_count++;
+                    uint32_t waited_ms = (uint32_t)((xTaskGetTickCount() - wait_start) * portTICK_PERIOD_MS);
+                    ESP_LOGW(TAG, "Playback blocks exhausted - dropped %zu bytes after %u ms (timeouts: %u)",
+                             len - total,
+                             (unsigned int)waited_ms,
+                             (unsigned int)timeout_count);
+                    s_jitter.stats.overruns++;
+                    s_jitter.stats.overrun_bytes += (uint32_t)(len - total);
+                    break;
+                }
+                safe_task_wdt_reset();
+                continue;
             }
+            s_fill_block->len = 0;
+            s_fill_block->format = s_rx_format;
+        }
+
+        size_t space = CONFIG_TTS_BLOCK_PAYLOAD_BYTES - s_fill_block->len;
+        size_t n = (len - total < space) ? (len - total) : space;
+        memcpy(s_fill_block->data + s_fill_block->len, data + total, n);
+        s_fill_block->len += n;
+        total += n;
+        atomic_fetch_add(&s_pending_bytes, n);
+
+        if (s_fill_block->len == CONFIG_TTS_BLOCK_PAYLOAD_BYTES) {
+            xQueueSend(s_ready_blocks, &s_fill_block, 0);
+            s_fill_block = NULL;
         }
     }
-    
-    if (!riff_found) {
-        ESP_LOGD(TAG, "⏳ RIFF header not found in accumulated buffer (%zu bytes) - need more data", length);
-        ESP_LOGD(TAG, "   First 4 bytes: 0x%02X 0x%02X 0x%02X 0x%02X", 
-                 buffer[0], buffer[1], buffer[2], buffer[3]);
-        return ESP_ERR_INVALID_ARG;
+
+    // Publish a partial block at the end of each frame for latency, unless it ends
+    // mid-sample; the next frame (or EOS) completes that one
+    if (s_fill_block != NULL && s_fill_block->len > 0 && (s_fill_block->len & 1U) == 0) {
+        xQueueSend(s_ready_blocks, &s_fill_block, 0);
+        s_fill_block = NULL;
     }
-    
-    // Adjust buffer pointer and length to start from RIFF header
-    const uint8_t *original_buffer = buffer;  // Save original pointer for offset calculation
-    buffer = buffer + riff_offset;
-    length = length - riff_offset;
-    
-    if (length < 12) {
-        ESP_LOGD(TAG, "WAV header too short after offset adjustment: %zu bytes (need at least 12)", length);
-        return ESP_ERR_INVALID_SIZE;
+
+    return total;
+}
+
+// ===========================
+// Jitter Buffer
+// ===========================
+
+static void jitter_reset_reply(void) {
+    s_jitter.first_arrival_us = 0;
+    s_jitter.last_arrival_us = 0;
+    s_jitter.last_frame_media_us = 0;
+    s_jitter.buffering = true;
+    s_jitter.started = false;
+    s_jitter.fade_in_pending = false;
+    s_jitter.buffering_since_us = 0;
+    s_jitter.dry_at_us = 0;
+    s_jitter.last_frame[0] = 0;
+    s_jitter.last_frame[1] = 0;
+    s_jitter.reply_underruns = 0;
+    s_segment_flushed = false;
+}
+
+static void jitter_on_arrival(size_t len) {
+    int64_t now = esp_timer_get_time();
+
+    if (s_jitter.first_arrival_us == 0) {
+        s_jitter.first_arrival_us = now;
+    } else {
+        // RFC 3550 interarrival jitter, D = arrival spacing - audio carried by the
+        // previous payload, smoothed by 1/16. Only lateness counts: payloads that
+        // arrive early (server bursts faster than real time) just fill the buffer
+        int64_t lateness = (now - s_jitter.last_arrival_us) - s_jitter.last_frame_media_us;
+        if (lateness < 0) {
+            lateness = 0;
+        }
+        int64_t jitter = (int64_t)s_jitter.jitter_us;
+        jitter += (lateness - jitter) / 16;
+        s_jitter.jitter_us = (uint32_t)jitter;
     }
 
-    if (memcmp(buffer + 8, "WAVE", 4) != 0) {
-        ESP_LOGE(TAG, "Invalid WAVE signature - got: 0x%02X 0x%02X 0x%02X 0x%02X at offset 8", 
-                 buffer[8], buffer[9], buffer[10], buffer[11]);
-        return ESP_ERR_INVALID_ARG;
+    s_jitter.last_arrival_us = now;
+    s_jitter.last_frame_media_us = ((int64_t)len * 1000000LL) / s_jitter.byte_rate;
+}
+
+static uint32_t jitter_target_ms(void) {
+    uint32_t target = CONFIG_TTS_JITTER_MIN_PREBUFFER_MS +
+                      (CONFIG_TTS_JITTER_MULTIPLIER * (s_jitter.jitter_us / 1000U)) +
+                      s_jitter.margin_ms;
+    return (target > CONFIG_TTS_JITTER_MAX_PREBUFFER_MS) ? CONFIG_TTS_JITTER_MAX_PREBUFFER_MS : target;
+}
+
+static bool jitter_prebuffer_ready(void) {
+    if (eos_requested || force_stop_requested) {
+        return true;  // Nothing more is coming; play whatever is queued
     }
 
-    size_t offset = 12;
-    bool fmt_found = false;
-    bool data_found = false;
-    wav_runtime_info_t parsed = {0};
+    size_t pending = atomic_load(&s_pending_bytes);
+    if (pending == 0) {
+        return false;
+    }
 
-    while (offset + 8 <= length) {
-        const uint8_t *chunk = buffer + offset;
-        char chunk_id[5] = {0};
-        memcpy(chunk_id, chunk, 4);
-        uint32_t chunk_size = read_le32(chunk + 4);
-        size_t chunk_data_start = offset + 8;
+    // The server closed a segment: nothing more is due until the next one is synthesized
+    if (s_segment_flushed) {
+        return true;
+    }
 
-        if (chunk_data_start > length) {
-            return ESP_ERR_INVALID_SIZE;
-        }
+    // A full pool cannot buffer any deeper
+    if (s_free_blocks == NULL || uxQueueMessagesWaiting(s_free_blocks) == 0) {
+        return true;
+    }
 
-        size_t remaining = length - chunk_data_start;
+    size_t target_bytes = ((size_t)jitter_target_ms() * s_jitter.byte_rate) / 1000U;
+    if (pending >= target_bytes) {
+        return true;
+    }
 
-        if (memcmp(chunk_id, "fmt ", 4) == 0) {
-            if (remaining < chunk_size) {
-                return ESP_ERR_INVALID_SIZE;
-            }
+    // A trickle slower than real time never reaches the target; don't hold it forever
+    int64_t since = s_jitter.started ? s_jitter.buffering_since_us : s_jitter.first_arrival_us;
+    return since != 0 && (esp_timer_get_time() - since) >= (CONFIG_TTS_JITTER_MAX_WAIT_MS * 1000LL);
+}
 
-            if (chunk_size < 16) {
-                ESP_LOGE(TAG, "fmt chunk too small: %lu", (unsigned long)chunk_size);
-                return ESP_FAIL;
-            }
+static void jitter_start_playback(void) {
+    int64_t now = esp_timer_get_time();
+    uint32_t buffered_ms = (uint32_t)((atomic_load(&s_pending_bytes) * 1000U) / s_jitter.byte_rate);
+
+    s_jitter.buffering = false;
+    s_segment_flushed = false;
+    s_jitter.stats.last_prebuffer_ms = buffered_ms;
+
+    if (!s_jitter.started) {
+        s_jitter.started = true;
+        uint32_t delay_ms = (s_jitter.first_arrival_us != 0) ?
+                            (uint32_t)((now - s_jitter.first_arrival_us) / 1000) : 0;
+        s_jitter.stats.last_start_delay_ms = delay_ms;
+        ESP_LOGI(TAG, "Jitter buffer: starting playback with %u ms queued after %u ms (target %u ms, jitter %u ms)",
+                 (unsigned int)buffered_ms, (unsigned int)delay_ms,
+                 (unsigned int)jitter_target_ms(), (unsigned int)(s_jitter.jitter_us / 1000U));
+    } else {
+        uint32_t gap_ms = (uint32_t)((now - s_jitter.buffering_since_us) / 1000);
+        s_jitter.stats.concealed_ms += gap_ms;
+        ESP_LOGI(TAG, "Jitter buffer: resuming after %u ms gap with %u ms queued",
+                 (unsigned int)gap_ms, (unsigned int)buffered_ms);
+    }
+}
 
-            parsed.audio_format = read_le16(chunk + 8);
-            parsed.num_channels = read_le16(chunk + 10);
-            parsed.sample_rate = read_le32(chunk + 12);
-            parsed.byte_rate = read_le32(chunk + 16);
-            parsed.block_align = read_le16(chunk + 20);
-            parsed.bits_per_sample = read_le16(chunk + 22);
-
-            fmt_found = true;
-
-        } else if (memcmp(chunk_id, "data", 4) == 0) {
-            parsed.data_size = chunk_size;
-            if (header_consumed != NULL) {
-                // ✅ STREAMING FIX: Account for RIFF offset when calculating header_consumed
-                // If RIFF was found at offset N, we need to skip those N bytes plus the header
-                *header_consumed = riff_offset + chunk_data_start;
-            }
-            data_found = true;
-            break;
+static void jitter_on_block_written(int16_t *stereo, size_t frames) {
+    if (frames == 0) {
+        return;
+    }
 
-        } else {
-            if (remaining < chunk_size) {
-                return ESP_ERR_INVALID_SIZE;
-            }
-        }
+    // Resampled output is always at CONFIG_AUDIO_SAMPLE_RATE; otherwise TX runs at the WAV rate
+    uint32_t rate = (s_resample_active || wav_info.sample_rate == 0) ?
+                    CONFIG_AUDIO_SAMPLE_RATE : wav_info.sample_rate;
+    int64_t now = esp_timer_get_time();
+    if (s_jitter.dry_at_us < now) {
+        s_jitter.dry_at_us = now;
+    }
+    s_jitter.dry_at_us += ((int64_t)frames * 1000000LL) / rate;
 
-        size_t advance = chunk_size;
-        offset = chunk_data_start + advance;
-        if (advance & 1) {
-            if (offset >= length) {
-                return ESP_ERR_INVALID_SIZE;
-            }
-            offset += 1;
-        }
+    if (stereo != NULL) {
+        s_jitter.last_frame[0] = stereo[(frames - 1) * 2];
+        s_jitter.last_frame[1] = stereo[(frames - 1) * 2 + 1];
     }
+}
 
-    if (!fmt_found) {
-        ESP_LOGE(TAG, "fmt chunk missing in WAV header");
-        return ESP_FAIL;
+static TickType_t jitter_receive_timeout(void) {
+    const TickType_t idle_ticks = pdMS_TO_TICKS(100);
+    if (!s_jitter.started || s_jitter.buffering || eos_requested || s_jitter.dry_at_us == 0) {
+        return idle_ticks;
+    }
+
+    int64_t until_conceal_us = s_jitter.dry_at_us - (CONFIG_TTS_JITTER_CONCEAL_LEAD_MS * 1000LL) -
+                               esp_timer_get_time();
+    if (until_conceal_us <= 0) {
+        return 0;
+    }
+    TickType_t ticks = pdMS_TO_TICKS((uint32_t)(until_conceal_us / 1000));
+    if (ticks == 0) {
+        ticks = 1;
+    }
+    return (ticks < idle_ticks) ? ticks : idle_ticks;
+}
+
+static bool jitter_conceal_underrun(void) {
+    if (!s_jitter.started || s_jitter.buffering || eos_requested || force_stop_requested ||
+        s_jitter.dry_at_us == 0) {
+        return false;  // Nothing has reached I2S yet (or the reply is ending)
+    }
+    int64_t now = esp_timer_get_time();
+    if (now < s_jitter.dry_at_us - (CONFIG_TTS_JITTER_CONCEAL_LEAD_MS * 1000LL)) {
+        return false;
+    }
+
+    // Ramp the last written frame down to zero so the gap starts without a step
+    for (size_t i = 0; i < TTS_JITTER_FADE_FRAMES; i++) {
+        s_conceal_frames[2 * i] = s_jitter.last_frame[0];
+        s_conceal_frames[2 * i + 1] = s_jitter.last_frame[1];
     }
+    audio_dsp_apply_fade(s_conceal_frames, TTS_JITTER_FADE_FRAMES, false);
 
-    if (!data_found) {
-        return ESP_ERR_INVALID_SIZE;
+    size_t written = 0;
+    esp_err_t ret = audio_driver_write((const uint8_t *)s_conceal_frames, sizeof(s_conceal_frames),
+                                       &written, CONFIG_TTS_JITTER_CONCEAL_LEAD_MS);
+    if (ret != ESP_OK) {
+        ESP_LOGD(TAG, "Underrun fade-out not written: %s", esp_err_to_name(ret));
+    }
+
+    s_jitter.stats.underruns++;
+    s_jitter.reply_underruns++;
+    s_jitter.margin_ms += CONFIG_TTS_JITTER_UNDERRUN_STEP_MS;
+    if (s_jitter.margin_ms > CONFIG_TTS_JITTER_MAX_PREBUFFER_MS) {
+        s_jitter.margin_ms = CONFIG_TTS_JITTER_MAX_PREBUFFER_MS;
+    }
+    s_jitter.buffering = true;
+    s_jitter.buffering_since_us = now;
+    s_jitter.fade_in_pending = true;
+    s_jitter.dry_at_us = 0;
+
+    ESP_LOGW(TAG, "TTS underrun #%u - faded out, re-buffering to %u ms",
+             (unsigned int)s_jitter.stats.underruns, (unsigned int)jitter_target_ms());
+    return true;
+}
+
+static void jitter_finish_reply(void) {
+    // A clean reply lets the learned margin decay back toward the jitter estimate
+    if (s_jitter.started && s_jitter.reply_underruns == 0) {
+        s_jitter.margin_ms /= 2;
     }
 
-    if (parsed.audio_format != 1) {
-        ESP_LOGE(TAG, "Unsupported audio format: %u (only PCM=1)", parsed.audio_format);
+    ESP_LOGI(TAG, "Jitter buffer: jitter %u ms, next target %u ms, underruns %u (reply %u), overruns %u, concealed %u ms",
+             (unsigned int)(s_jitter.jitter_us / 1000U), (unsigned int)jitter_target_ms(),
+             (unsigned int)s_jitter.stats.underruns, (unsigned int)s_jitter.reply_underruns,
+             (unsigned int)s_jitter.stats.overruns, (unsigned int)s_jitter.stats.concealed_ms);
+}
+
+esp_err_t tts_decoder_get_jitter_stats(tts_jitter_stats_t *stats) {
+    if (stats == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
 
+    *stats = s_jitter.stats;
+    stats->jitter_ms = s_jitter.jitter_us / 1000U;
+    stats->prebuffer_target_ms = jitter_target_ms();
+    return ESP_OK;
+}
+
+static bool configure_playback_rate(uint32_t sample_rate) {
+    release_resampler();
+
+    if (sample_rate == CONFIG_AUDIO_SAMPLE_RATE) {
+        return true;
+    }
+
+#if CONFIG_TTS_DSP_RESAMPLE_ENABLED
+    if (wav_info.num_channels != 1 || wav_info.bits_per_sample != 16 ||
+        sample_rate < CONFIG_TTS_RESAMPLE_MIN_RATE || sample_rate > CONFIG_TTS_RESAMPLE_MAX_RATE) {
+        return false;
+    }
+
+    if (!audio_dsp_resampler_init(&s_resampler, sample_rate, CONFIG_AUDIO_SAMPLE_RATE)) {
+        return false;
+    }
+
+    size_t frames = audio_dsp_resampler_max_output(&s_resampler,
+                                                   CONFIG_TTS_BLOCK_PAYLOAD_BYTES / sizeof(int16_t));
+    size_t bytes = frames * sizeof(int16_t) * 2U;
+    s_resample_out = memory_manager_arena_acquire(MEMORY_SLOT_TTS_RESAMPLE, bytes);
+    if (s_resample_out == NULL) {
+        ESP_LOGW(TAG, "Resampler buffer allocation failed (%u bytes)", (unsigned int)bytes);
+        return false;
+    }
+
+    s_resample_out_frames = frames;
+    s_resample_active = true;
+    ESP_LOGI(TAG, "Resampling %u Hz -> %u Hz in software (I2S TX clock unchanged)",
+             (unsigned int)sample_rate, (unsigned int)CONFIG_AUDIO_SAMPLE_RATE);
+    return true;
+#else
+    return false;
+#endif
+}
+
+static void release_resampler(void) {
+    s_resample_active = false;
+    if (s_resample_out != NULL) {
+        memory_manager_arena_release(MEMORY_SLOT_TTS_RESAMPLE, s_resample_out);
+        s_resample_out = NULL;
+    }
+    s_resample_out_frames = 0;
+}
+
+static void setup_playback_rate(uint32_t sample_rate) {
+    if (configure_playback_rate(sample_rate)) {
+        // Native or resampled: TX runs at the capture rate (no-op unless a previous format reclocked it)
+        sample_rate = CONFIG_AUDIO_SAMPLE_RATE;
+    }
+    // Otherwise the resampler is unavailable - fall back to reclocking I2S TX
+    esp_err_t clk_ret = audio_driver_set_tx_sample_rate(sample_rate);
+    if (clk_ret != ESP_OK) {
+        ESP_LOGW(TAG, "Unable to set TX sample rate to %u Hz: %s",
+                 (unsigned int)sample_rate, esp_err_to_name(clk_ret));
+    }
+}
+
+static void apply_stream_format(const tts_stream_format_t *format) {
+    bool switching = header_parsed;
+
+    // Same fields the WAV path gets from the header, so play_block() needs no second case
+    memset(&wav_info, 0, sizeof(wav_info));
+    wav_info.audio_format = 1;
+    wav_info.num_channels = format->channels;
+    wav_info.sample_rate = format->sample_rate;
+    wav_info.bits_per_sample = 16;
+    wav_info.block_align = (uint16_t)(format->channels * 2U);
+    wav_info.byte_rate = tts_stream_format_byte_rate(format);
+    wav_info.data_size = WAV_STREAMING_DATA_SIZE;
+
+    s_play_format = *format;
+    header_parsed = true;
+    playback_feedback_sent = true;
+    setup_playback_rate(format->sample_rate);
+
+    ESP_LOGI(TAG, "%s framed TTS stream: %u Hz, %u channel(s)", switching ? "Switching to" : "Playing",
+             (unsigned int)format->sample_rate, (unsigned int)format->channels);
+}
+
+static void publish_fill_block(void) {
+    if (s_fill_block == NULL) {
+        return;
+    }
+
+    tts_block_t *tail = s_fill_block;
+    s_fill_block = NULL;
+    if (tail->len & 1U) {
+        tail->len--;  // Drop a dangling half-sample
+        atomic_fetch_sub(&s_pending_bytes, 1);
+    }
+    xQueueSend(s_ready_blocks, &tail, 0);
+}
+
+void tts_decoder_set_stream_format(const tts_stream_format_t *format) {
+    if (format == NULL) {
+        // Framing not negotiated on this connection: blocks are WAV stream bytes again
+        memset(&s_rx_format, 0, sizeof(s_rx_format));
+        return;
+    }
+    if (tts_stream_format_equal(format, &s_rx_format)) {
+        return;
+    }
+
+    // One format per block: close the block being filled before switching
+    publish_fill_block();
+    s_rx_format = *format;
+    s_jitter.byte_rate = tts_stream_format_byte_rate(format);
+}
+
+void tts_decoder_end_segment(void) {
+    if (!is_running) {
+        return;
+    }
+
+    publish_fill_block();
+    if (s_jitter.buffering) {
+        s_segment_flushed = true;
+    }
+}
+
+#if CONFIG_TTS_WAV_COMPAT
+static esp_err_t parse_wav_header(const uint8_t *buffer, size_t length, size_t *header_consumed) {
+    wav_header_info_t parsed;
+    esp_err_t ret = wav_header_parse(buffer, length, &parsed, header_consumed);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
     wav_info = parsed;
     ESP_LOGI(TAG, "✅ WAV header parsed successfully");
     return ESP_OK;
 }
+#endif
 
 bool tts_decoder_has_pending_audio(void) {
     if (!is_running && !is_playing) {
         return false;
     }
 
-    // ✅ FIX #5 (MOVED HERE): Check stream buffer but ignore remnant bytes < 100
+    // ✅ FIX #5 (MOVED HERE): Check queued blocks but ignore remnant bytes < 100
     // Remnant bytes are smaller than minimum I2S DMA buffer size and will never play
-    if (g_audio_stream_buffer != NULL) {
-        size_t buffer_bytes = xStreamBufferBytesAvailable(g_audio_stream_buffer);
+    if (s_block_storage != NULL) {
+        size_t buffer_bytes = atomic_load(&s_pending_bytes);
         if (buffer_bytes > 0 && buffer_bytes < 100) {
             // Remnant bytes - treat as "no pending audio"
             return false;
@@ -1502,14 +1859,13 @@ void tts_decoder_reset_session(void) {
     force_stop_requested = false;
     memset(&wav_info, 0, sizeof(wav_info));
     
-    // Clear the stream buffer
-    if (g_audio_stream_buffer != NULL) {
-        size_t buffer_level = xStreamBufferBytesAvailable(g_audio_stream_buffer);
-        if (buffer_level > 0) {
-            ESP_LOGI(TAG, "Clearing %zu bytes from stream buffer during session reset", buffer_level);
-        }
-        xStreamBufferReset(g_audio_stream_buffer);
+    // Return all queued blocks to the pool
+    size_t buffer_level = atomic_load(&s_pending_bytes);
+    if (buffer_level > 0) {
+        ESP_LOGI(TAG, "Clearing %zu bytes from playback blocks during session reset", buffer_level);
     }
+    block_pool_reset();
+    jitter_reset_reply();
     
     ESP_LOGI(TAG, "TTS decoder session reset for next audio stream");
 }
@@ -1545,54 +1901,23 @@ esp_err_t tts_decoder_flush_and_reset(void) {
     return ESP_OK;
 }
 
-static void print_wav_info(const wav_runtime_info_t *info) {
+#if CONFIG_TTS_WAV_COMPAT
+static void print_wav_info(const wav_header_info_t *info) {
     ESP_LOGI(TAG, "=== WAV File Info ===");
     ESP_LOGI(TAG, "Sample Rate: %lu Hz", (unsigned long)info->sample_rate);
     ESP_LOGI(TAG, "Channels: %u", (unsigned int)info->num_channels);
     ESP_LOGI(TAG, "Bits per Sample: %u", (unsigned int)info->bits_per_sample);
     ESP_LOGI(TAG, "Audio Format: %u (PCM)", (unsigned int)info->audio_format);
-    ESP_LOGI(TAG, "Declared Data Size: %lu bytes", (unsigned long)info->data_size);
+    if (WAV_DATA_SIZE_IS_KNOWN(info->data_size)) {
+        ESP_LOGI(TAG, "Declared Data Size: %lu bytes", (unsigned long)info->data_size);
+    } else {
+        ESP_LOGI(TAG, "Declared Data Size: streaming (length unknown, ends on EOS)");
+    }
     ESP_LOGI(TAG, "Block Align: %u", (unsigned int)info->block_align);
     ESP_LOGI(TAG, "Byte Rate: %lu", (unsigned long)info->byte_rate);
     ESP_LOGI(TAG, "====================");
 }
-
-static bool ensure_stereo_scratch_buffer(void) {
-    if (s_stereo_scratch != NULL) {
-        return true;
-    }
-
-    // CRITICAL FIX: Always allocate stereo scratch buffer in PSRAM to prevent internal DMA fragmentation
-    // Internal DMA-capable RAM is only ~60KB and gets severely fragmented when this 8KB buffer is allocated
-    // PSRAM has 4MB available and doesn't suffer from the same fragmentation issues
-    uint8_t *buf = heap_caps_aligned_alloc(4, CONFIG_TTS_STEREO_SCRATCH_BYTES, MALLOC_CAP_SPIRAM);
-    if (buf == NULL) {
-        // Fallback to internal DMA only if PSRAM allocation fails (shouldn't happen with 4MB PSRAM)
-        ESP_LOGW(TAG, "PSRAM allocation failed - attempting internal DMA (may cause fragmentation)");
-        buf = heap_caps_aligned_alloc(4, CONFIG_TTS_STEREO_SCRATCH_BYTES, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
-    }
-
-    if (buf == NULL) {
-        ESP_LOGE(TAG, "Unable to allocate stereo duplication scratch buffer (%u bytes)", (unsigned int)CONFIG_TTS_STEREO_SCRATCH_BYTES);
-        return false;
-    }
-
-    s_stereo_scratch = buf;
-    s_stereo_scratch_size = CONFIG_TTS_STEREO_SCRATCH_BYTES;
-    s_stereo_scratch_capacity_samples = s_stereo_scratch_size / (sizeof(int16_t) * 2U);
-
-    if (s_stereo_scratch_capacity_samples == 0) {
-        ESP_LOGE(TAG, "Stereo scratch buffer too small (%zu bytes) for duplication", s_stereo_scratch_size);
-        heap_caps_free(s_stereo_scratch);
-        s_stereo_scratch = NULL;
-        s_stereo_scratch_size = 0;
-        return false;
-    }
-
-    ESP_LOGI(TAG, "[PCM DUP] Scratch buffer ready: %zu bytes (%zu samples per block) in PSRAM",
-             s_stereo_scratch_size, s_stereo_scratch_capacity_samples);
-    return true;
-}
+#endif
 
 void tts_decoder_notify_end_of_stream(void) {
     if (!is_running) {
@@ -1629,8 +1954,11 @@ void tts_decoder_notify_end_of_stream(void) {
     // Draining the buffer would discard audio that should be played.
     // The playback task will naturally exit after playing all buffered audio.
     
-    if (g_audio_stream_buffer != NULL) {
-        size_t buffer_level = xStreamBufferBytesAvailable(g_audio_stream_buffer);
+    // Publish the partially filled block so the tail of the reply is played
+    publish_fill_block();
+
+    if (s_block_storage != NULL) {
+        size_t buffer_level = atomic_load(&s_pending_bytes);
         if (buffer_level > 0) {
             ESP_LOGI(TAG, "🎵 Playback task will drain %zu bytes of buffered audio", (unsigned int)buffer_level);
         }
@@ -1645,10 +1973,7 @@ void tts_decoder_notify_end_of_stream(void) {
     // ✅ CRITICAL FIX: Calculate timeout based on buffered audio duration
     // At 16kHz mono 16-bit: 32000 bytes/second (16000 samples * 2 bytes)
     // Add 2 seconds safety margin for I2S DMA latency and processing overhead
-    size_t buffer_level = 0;
-    if (g_audio_stream_buffer != NULL) {
-        buffer_level = xStreamBufferBytesAvailable(g_audio_stream_buffer);
-    }
+    size_t buffer_level = atomic_load(&s_pending_bytes);
     
     // Calculate playback duration: bytes ÷ (sample_rate * bytes_per_sample) + safety_margin
     uint32_t playback_duration_ms = (buffer_level * 1000) / 32000;  // milliseconds needed to play buffer
@@ -1691,11 +2016,9 @@ void tts_decoder_notify_end_of_stream(void) {
     playback_start_time = (uint32_t)(esp_timer_get_time() / 1000);
     
     // Additional improvements for sequential session handling
-    // Clear the stream buffer to prevent data carryover between sessions
-    if (g_audio_stream_buffer != NULL) {
-        xStreamBufferReset(g_audio_stream_buffer);
-        ESP_LOGD(TAG, "Stream buffer reset for next session");
-    }
+    // Return all blocks to the pool to prevent data carryover between sessions
+    block_pool_reset();
+    ESP_LOGD(TAG, "Playback block pool reset for next session");
     
     // Reset all counters for the next session
     bytes_received = 0;
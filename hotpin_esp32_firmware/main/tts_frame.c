@@ -0,0 +1,61 @@
+/**
+ * @file tts_frame.c
+ * @brief Framed TTS downlink decoding
+ */
+
+#include "tts_frame.h"
+#include <string.h>
+
+static inline uint32_t read_le32(const uint8_t *ptr) {
+    return (uint32_t)(ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | ((uint32_t)ptr[3] << 24));
+}
+
+bool tts_frame_is_framed(const uint8_t *data, size_t len) {
+    return data != NULL && len >= TTS_FRAME_HEADER_SIZE &&
+           memcmp(data, TTS_FRAME_MAGIC, 4) == 0 && data[4] == TTS_FRAME_VERSION;
+}
+
+esp_err_t tts_frame_parse(const uint8_t *data, size_t len, tts_frame_t *frame) {
+    if (data == NULL || frame == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (len < TTS_FRAME_HEADER_SIZE || memcmp(data, TTS_FRAME_MAGIC, 4) != 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (data[4] != TTS_FRAME_VERSION) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    frame->type = data[5];
+    frame->format.codec = data[6];
+    frame->format.channels = data[7];
+    frame->format.sample_rate = read_le32(data + 8);
+    frame->seq = read_le32(data + 12);
+    frame->payload = data + TTS_FRAME_HEADER_SIZE;
+    frame->payload_len = len - TTS_FRAME_HEADER_SIZE;
+
+    switch (frame->type) {
+        case TTS_FRAME_TYPE_AUDIO:
+            break;
+        case TTS_FRAME_TYPE_FLUSH:
+        case TTS_FRAME_TYPE_END:
+            // Control frames carry the format for the record only
+            frame->payload_len = 0;
+            return ESP_OK;
+        default:
+            return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    if (frame->format.codec != TTS_FRAME_CODEC_PCM16) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (frame->format.channels < 1 || frame->format.channels > 2 ||
+        frame->format.sample_rate < TTS_FRAME_MIN_RATE || frame->format.sample_rate > TTS_FRAME_MAX_RATE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // Whole sample frames only, so a block never starts mid-sample
+    if ((frame->payload_len % (2U * frame->format.channels)) != 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,165 @@
+/**
+ * @file turn_metrics.c
+ * @brief Per-turn stage timestamps and the TURN_METRICS report
+ *
+ * Marks come from the streaming, WebSocket and TTS tasks; the state manager
+ * closes the turn. A spinlock guards the few words of state, and nothing is
+ * formatted or sent while it is held.
+ */
+
+#include "turn_metrics.h"
+#include "config.h"
+#include "websocket_client.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = TAG_TURN;
+
+// Keys of the report's "ms" object; the server aggregates by these names
+static const char *const s_mark_names[TURN_MARK_COUNT] = {
+    [TURN_MARK_EOS_SENT]      = "eos_sent",
+    [TURN_MARK_TRANSCRIPTION] = "transcription",
+    [TURN_MARK_TRANSCRIPT]    = "transcript",
+    [TURN_MARK_REPLY]         = "reply",
+    [TURN_MARK_FIRST_AUDIO]   = "first_audio",
+    [TURN_MARK_FIRST_SAMPLE]  = "first_sample",
+    [TURN_MARK_COMPLETE]      = "complete",
+};
+
+typedef struct {
+    uint32_t id;
+    int64_t start_us;
+    uint32_t mark_ms[TURN_MARK_COUNT];  // Since start_us; UINT32_MAX = not reached
+    bool open;
+} turn_state_t;
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static turn_state_t s_turn = {0};
+static int64_t s_speech_end_us = 0;     // 0 = no release since the last turn opened
+static uint32_t s_next_id = 1;
+static uint32_t s_dropped = 0;
+
+void turn_metrics_speech_ended(void) {
+#if CONFIG_TURN_METRICS_ENABLED
+    int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&s_lock);
+    s_speech_end_us = now_us;
+    portEXIT_CRITICAL(&s_lock);
+#endif
+}
+
+uint32_t turn_metrics_begin(void) {
+#if CONFIG_TURN_METRICS_ENABLED
+    int64_t now_us = esp_timer_get_time();
+    bool dropped_open = false;
+
+    portENTER_CRITICAL(&s_lock);
+    if (s_turn.open) {
+        // No reply ever came (e.g. empty utterance); the server has nothing to match it with
+        dropped_open = true;
+        s_dropped++;
+    }
+    s_turn.id = s_next_id++;
+    if (s_next_id == 0) {
+        s_next_id = 1;
+    }
+    // EOS without a recorded release (stop issued elsewhere) starts the clock now
+    s_turn.start_us = (s_speech_end_us != 0 && s_speech_end_us <= now_us) ? s_speech_end_us : now_us;
+    for (int i = 0; i < TURN_MARK_COUNT; i++) {
+        s_turn.mark_ms[i] = UINT32_MAX;
+    }
+    s_turn.open = true;
+    s_speech_end_us = 0;
+    uint32_t id = s_turn.id;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (dropped_open) {
+        ESP_LOGD(TAG, "Previous turn closed without a reply (%u dropped)", (unsigned int)s_dropped);
+    }
+    return id;
+#else
+    return 0;
+#endif
+}
+
+void turn_metrics_mark(turn_mark_t mark) {
+#if CONFIG_TURN_METRICS_ENABLED
+    if ((unsigned int)mark >= TURN_MARK_COUNT) {
+        return;
+    }
+    int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&s_lock);
+    if (s_turn.open && s_turn.mark_ms[mark] == UINT32_MAX) {
+        s_turn.mark_ms[mark] = (uint32_t)((now_us - s_turn.start_us) / 1000);
+    }
+    portEXIT_CRITICAL(&s_lock);
+#else
+    (void)mark;
+#endif
+}
+
+bool turn_metrics_is_current(uint32_t turn) {
+    portENTER_CRITICAL(&s_lock);
+    bool current = s_turn.open && s_turn.id == turn;
+    portEXIT_CRITICAL(&s_lock);
+    return current;
+}
+
+esp_err_t turn_metrics_finish(const char *result) {
+#if CONFIG_TURN_METRICS_ENABLED
+    turn_state_t turn;
+    portENTER_CRITICAL(&s_lock);
+    turn = s_turn;
+    s_turn.open = false;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (!turn.open) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (result == NULL) {
+        result = "complete";
+    }
+
+    char report[320];
+    int len = snprintf(report, sizeof(report), "{\"signal\":\"TURN_METRICS\",\"turn\":%u,\"result\":\"%s\",\"ms\":{",
+                       (unsigned int)turn.id, result);
+    bool first = true;
+    for (int i = 0; i < TURN_MARK_COUNT && len > 0 && len < (int)sizeof(report); i++) {
+        if (turn.mark_ms[i] == UINT32_MAX) {
+            continue;
+        }
+        len += snprintf(report + len, sizeof(report) - (size_t)len, "%s\"%s\":%u",
+                        first ? "" : ",", s_mark_names[i], (unsigned int)turn.mark_ms[i]);
+        first = false;
+    }
+    if (len > 0 && len < (int)sizeof(report)) {
+        len += snprintf(report + len, sizeof(report) - (size_t)len, "}}");
+    }
+    if (len <= 0 || len >= (int)sizeof(report)) {
+        ESP_LOGW(TAG, "Turn %u report does not fit", (unsigned int)turn.id);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // The number people ask about: silence between "done talking" and the first word back
+    if (turn.mark_ms[TURN_MARK_FIRST_SAMPLE] != UINT32_MAX) {
+        ESP_LOGI(TAG, "⏱️ Turn %u (%s): first sample %u ms after end of speech "
+                 "(eos %d, transcript %d, reply %d, first byte %d)",
+                 (unsigned int)turn.id, result, (unsigned int)turn.mark_ms[TURN_MARK_FIRST_SAMPLE],
+                 (int)turn.mark_ms[TURN_MARK_EOS_SENT], (int)turn.mark_ms[TURN_MARK_TRANSCRIPT],
+                 (int)turn.mark_ms[TURN_MARK_REPLY], (int)turn.mark_ms[TURN_MARK_FIRST_AUDIO]);
+    } else {
+        ESP_LOGI(TAG, "⏱️ Turn %u (%s): no audio played", (unsigned int)turn.id, result);
+    }
+
+    if (!websocket_client_is_connected()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return websocket_client_send_text(report);
+#else
+    (void)result;
+    return ESP_ERR_INVALID_STATE;
+#endif
+}
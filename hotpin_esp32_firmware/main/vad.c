@@ -0,0 +1,114 @@
+/**
+ * @file vad.c
+ * @brief Energy + zero-crossing voice activity detector for the STT uplink.
+ *
+ * Per frame: mean |x| after DC removal (energy) and the zero-crossing count.
+ * Voiced speech is loud with few crossings; fricatives are quieter with many,
+ * so a frame counts as speech when it clears the noise-relative threshold, or
+ * clears half of it with a high crossing rate. The noise floor follows silent
+ * frames quickly and creeps up slowly during "speech" so a steady fan or hum
+ * cannot hold the gate open forever.
+ */
+
+#include "vad.h"
+#include "config.h"
+#include <string.h>
+
+#define VAD_FRAME_SAMPLES   ((CONFIG_AUDIO_SAMPLE_RATE * CONFIG_STT_VAD_FRAME_MS) / 1000)
+#define VAD_ZC_DEADBAND     8       // |x| below this does not count as a sign change
+
+void vad_init(vad_state_t *vad)
+{
+    memset(vad, 0, sizeof(*vad));
+    vad->noise_q4 = (uint32_t)CONFIG_STT_VAD_MIN_ENERGY << 4;
+}
+
+static bool vad_frame_is_speech(vad_state_t *vad, uint32_t energy, uint32_t crossings)
+{
+    uint32_t threshold = (vad->noise_q4 * CONFIG_STT_VAD_NOISE_FACTOR_Q4) >> 8;
+    if (threshold < CONFIG_STT_VAD_MIN_ENERGY) {
+        threshold = CONFIG_STT_VAD_MIN_ENERGY;
+    }
+    if (vad->echo_floor > 0 && energy <= vad->echo_floor) {
+        // Speaker output, not the room: leave the noise floor alone
+        return false;
+    }
+
+    bool speech = (energy > threshold) ||
+                  (energy > (threshold / 2U) && crossings >= CONFIG_STT_VAD_ZCR_UNVOICED);
+
+    int32_t delta = (int32_t)(energy << 4) - (int32_t)vad->noise_q4;
+    if (!speech) {
+        // Track silence quickly (1/8 per frame; 1/4 when the room gets quieter)
+        vad->noise_q4 = (uint32_t)((int32_t)vad->noise_q4 + (delta < 0 ? delta / 4 : delta / 8));
+    } else if (delta > 0) {
+        // ~5s time constant: stationary noise eventually stops looking like speech
+        vad->noise_q4 += (uint32_t)(delta / 256);
+    }
+
+    return speech;
+}
+
+vad_event_t vad_process(vad_state_t *vad, const int16_t *samples, size_t count)
+{
+    vad_event_t event = VAD_EVENT_NONE;
+    int32_t dc = vad->dc_q8 >> 8;
+    int64_t raw_sum = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        raw_sum += samples[i];
+        int32_t x = (int32_t)samples[i] - dc;
+        int32_t ax = (x < 0) ? -x : x;
+        vad->frame_abs_sum += (uint32_t)ax;
+
+        if (ax > VAD_ZC_DEADBAND) {
+            int16_t sign = (x < 0) ? -1 : 1;
+            if (vad->prev_sign != 0 && sign != vad->prev_sign) {
+                vad->frame_crossings++;
+            }
+            vad->prev_sign = sign;
+        }
+
+        if (++vad->frame_samples < VAD_FRAME_SAMPLES) {
+            continue;
+        }
+
+        // Frame complete
+        uint32_t energy = vad->frame_abs_sum / VAD_FRAME_SAMPLES;
+        uint32_t crossings = vad->frame_crossings;
+        bool speech = vad_frame_is_speech(vad, energy, crossings);
+
+        vad->last_energy = (uint16_t)(energy > UINT16_MAX ? UINT16_MAX : energy);
+        vad->last_zcr = (uint16_t)crossings;
+        vad->frame_abs_sum = 0;
+        vad->frame_samples = 0;
+        vad->frame_crossings = 0;
+
+        if (!vad->in_speech) {
+            vad->onset_ms = speech ? (uint16_t)(vad->onset_ms + CONFIG_STT_VAD_FRAME_MS) : 0;
+            if (vad->onset_ms >= CONFIG_STT_VAD_ONSET_MS) {
+                vad->in_speech = true;
+                vad->silence_ms = 0;
+                vad->speech_ms = vad->onset_ms;
+                vad->onset_ms = 0;
+                event = VAD_EVENT_SPEECH_START;
+            }
+        } else {
+            vad->speech_ms += CONFIG_STT_VAD_FRAME_MS;
+            vad->silence_ms = speech ? 0 : (uint16_t)(vad->silence_ms + CONFIG_STT_VAD_FRAME_MS);
+            if (vad->silence_ms >= CONFIG_STT_VAD_HANGOVER_MS) {
+                vad->in_speech = false;
+                vad->silence_ms = 0;
+                event = VAD_EVENT_SPEECH_END;
+            }
+        }
+    }
+
+    // Slow DC tracker on the block mean (mic DC offset drifts, it does not jump)
+    if (count > 0) {
+        int32_t block_mean_q8 = (int32_t)((raw_sum * 256) / (int64_t)count);
+        vad->dc_q8 += (block_mean_q8 - vad->dc_q8) / 8;
+    }
+
+    return event;
+}
@@ -0,0 +1,158 @@
+/**
+ * @file wav_header.c
+ * @brief RIFF/WAVE header parsing for the TTS stream
+ */
+
+// Before any include: esp_log.h reads LOG_LOCAL_LEVEL at each ESP_LOGx call
+#define LOG_LOCAL_LEVEL CONFIG_LOG_FLOOR_TTS
+
+#include "wav_header.h"
+#include "config.h"
+#include "esp_log.h"
+#include <stdbool.h>
+#include <string.h>
+
+static const char *TAG = TAG_TTS;
+
+static inline uint16_t read_le16(const uint8_t *ptr) {
+    return (uint16_t)(ptr[0] | (ptr[1] << 8));
+}
+
+static inline uint32_t read_le32(const uint8_t *ptr) {
+    return (uint32_t)(ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | (ptr[3] << 24));
+}
+
+esp_err_t wav_header_parse(const uint8_t *buffer, size_t length, wav_header_info_t *info,
+                           size_t *header_consumed) {
+    if (buffer == NULL || info == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (length < 12) {
+        ESP_LOGD(TAG, "WAV header too short: %zu bytes (need at least 12)", length);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // ✅ STREAMING FIX: Search for RIFF header within the buffer
+    // In streaming scenarios, PCM data might arrive before the header due to network fragmentation
+    // We need to find where the actual WAV header starts
+    size_t riff_offset = 0;
+    bool riff_found = false;
+    
+    if (memcmp(buffer, "RIFF", 4) == 0) {
+        // Header is at the beginning (normal case)
+        riff_found = true;
+    } else {
+        // Search for RIFF header within the accumulated buffer
+        ESP_LOGD(TAG, "🔍 RIFF not at start, searching within %zu bytes...", length);
+        for (size_t i = 0; i <= length - 4; i++) {
+            if (memcmp(buffer + i, "RIFF", 4) == 0) {
+                riff_offset = i;
+                riff_found = true;
+                ESP_LOGD(TAG, "Found RIFF header at offset %zu (skipped %zu bytes of PCM data)", i, i);
+                break;
+            }
+        }
+    }
+    
+    if (!riff_found) {
+        ESP_LOGD(TAG, "⏳ RIFF header not found in accumulated buffer (%zu bytes) - need more data", length);
+        ESP_LOGD(TAG, "   First 4 bytes: 0x%02X 0x%02X 0x%02X 0x%02X", 
+                 buffer[0], buffer[1], buffer[2], buffer[3]);
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    // Adjust buffer pointer and length to start from RIFF header
+    buffer = buffer + riff_offset;
+    length = length - riff_offset;
+    
+    if (length < 12) {
+        ESP_LOGD(TAG, "WAV header too short after offset adjustment: %zu bytes (need at least 12)", length);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if (memcmp(buffer + 8, "WAVE", 4) != 0) {
+        ESP_LOGE(TAG, "Invalid WAVE signature - got: 0x%02X 0x%02X 0x%02X 0x%02X at offset 8", 
+                 buffer[8], buffer[9], buffer[10], buffer[11]);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t offset = 12;
+    bool fmt_found = false;
+    bool data_found = false;
+    wav_header_info_t parsed = {0};
+
+    while (offset + 8 <= length) {
+        const uint8_t *chunk = buffer + offset;
+        char chunk_id[5] = {0};
+        memcpy(chunk_id, chunk, 4);
+        uint32_t chunk_size = read_le32(chunk + 4);
+        size_t chunk_data_start = offset + 8;
+
+        if (chunk_data_start > length) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+
+        size_t remaining = length - chunk_data_start;
+
+        if (memcmp(chunk_id, "fmt ", 4) == 0) {
+            if (remaining < chunk_size) {
+                return ESP_ERR_INVALID_SIZE;
+            }
+
+            if (chunk_size < 16) {
+                ESP_LOGE(TAG, "fmt chunk too small: %lu", (unsigned long)chunk_size);
+                return ESP_FAIL;
+            }
+
+            parsed.audio_format = read_le16(chunk + 8);
+            parsed.num_channels = read_le16(chunk + 10);
+            parsed.sample_rate = read_le32(chunk + 12);
+            parsed.byte_rate = read_le32(chunk + 16);
+            parsed.block_align = read_le16(chunk + 20);
+            parsed.bits_per_sample = read_le16(chunk + 22);
+
+            fmt_found = true;
+
+        } else if (memcmp(chunk_id, "data", 4) == 0) {
+            parsed.data_size = chunk_size;
+            if (header_consumed != NULL) {
+                // ✅ STREAMING FIX: Account for RIFF offset when calculating header_consumed
+                // If RIFF was found at offset N, we need to skip those N bytes plus the header
+                *header_consumed = riff_offset + chunk_data_start;
+            }
+            data_found = true;
+            break;
+
+        } else {
+            if (remaining < chunk_size) {
+                return ESP_ERR_INVALID_SIZE;
+            }
+        }
+
+        size_t advance = chunk_size;
+        offset = chunk_data_start + advance;
+        if (advance & 1) {
+            if (offset >= length) {
+                return ESP_ERR_INVALID_SIZE;
+            }
+            offset += 1;
+        }
+    }
+
+    if (!fmt_found) {
+        ESP_LOGE(TAG, "fmt chunk missing in WAV header");
+        return ESP_FAIL;
+    }
+
+    if (!data_found) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if (parsed.audio_format != 1) {
+        ESP_LOGE(TAG, "Unsupported audio format: %u (only PCM=1)", parsed.audio_format);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *info = parsed;
+    return ESP_OK;
+}
@@ -11,8 +11,12 @@
  * - Automatic reconnection on disconnect
  */
 
+// Before any include: esp_log.h reads LOG_LOCAL_LEVEL at each ESP_LOGx call
+#define LOG_LOCAL_LEVEL CONFIG_LOG_FLOOR_WEBSOCKET
+
 #include "websocket_client.h"
 #include "config.h"
+#include "log_manager.h"
 #include "event_dispatcher.h"
 #include "system_events.h"
 #include "stt_pipeline.h"
@@ -21,13 +25,31 @@
 #include "feedback_player.h"  // ✅ Added for processing/completion feedback sounds
 #include "led_controller.h"   // ✅ Added for LED state feedback during processing
 #include "state_manager.h"    // ✅ Added for state checking before TTS start
+#include "camera_controller.h"
+#include "mode_switch.h"
+#include "memory_manager.h"
+#include "trace.h"
+#include "turn_metrics.h"
+#include "network_profile.h"
 #include "esp_timer.h"
 #include "esp_log.h"
+#include "esp_heap_caps.h"
 #include "esp_websocket_client.h"
+#include "esp_transport.h"
+#include "esp_transport_tcp.h"
+#include "esp_transport_ssl.h"
+#include "esp_transport_ws.h"
+#if CONFIG_MBEDTLS_CERTIFICATE_BUNDLE
+#include "esp_crt_bundle.h"
+#endif
 #include "esp_task_wdt.h"  // Added for esp_task_wdt_reset
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "cJSON.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "json_protocol.h"
+#include "tts_frame.h"
+#include "prompt_store.h"
 #include "inttypes.h"
 #include <string.h>
 
@@ -66,6 +88,11 @@ static bool is_started = false;
 static char server_uri[128] = {0};
 static volatile websocket_pipeline_stage_t g_pipeline_stage = WEBSOCKET_PIPELINE_STAGE_IDLE;
 static volatile bool g_session_ready = false;
+static volatile audio_codec_t g_uplink_codec = AUDIO_CODEC_PCM16;  // Negotiated per connection
+static volatile bool g_binary_control = false;                      // Server sends binary control frames
+static volatile bool g_tts_framed = false;                          // Server sends framed TTS (tts_frame.h)
+static uint32_t s_tts_next_seq = 0;                                 // Expected framed TTS sequence number
+static volatile feedback_prompt_t g_error_prompt = FEEDBACK_PROMPT_PROCESSING_ERROR;  // Last server error
 static uint32_t s_reconnect_attempt_count = 0;
 static uint32_t s_last_reconnect_delay = CONFIG_WEBSOCKET_RECONNECT_DELAY_MS;
 
@@ -82,7 +109,41 @@ static void *g_status_callback_arg = NULL;
 
 // Task handles for reconnect tasks
 static TaskHandle_t s_reconnect_task_handle = NULL;
-static TaskHandle_t s_delayed_reconnect_task_handle = NULL;
+
+// The WebSocket transport is built here (not inside the client) when the socket
+// needs tuning or TLS sessions must survive reconnects; the client owns it once
+// passed as ext_transport
+#define WS_OWN_TRANSPORT (CONFIG_WS_TCP_NODELAY || CONFIG_WS_TLS_SESSION_TICKETS)
+#if WS_OWN_TRANSPORT
+static esp_transport_handle_t s_ws_transport = NULL;
+static esp_transport_handle_t create_ws_transport(const char *uri, const char *headers);
+#endif
+
+// Send queue entry: the header is copied in, the payload stays with the producer.
+// An entry with neither header nor payload is a barrier that only completes.
+typedef struct {
+    uint8_t header[WEBSOCKET_TX_MAX_HEADER];
+    uint8_t header_len;
+    uint8_t flags;
+    const uint8_t *payload;
+    size_t payload_len;
+    websocket_tx_done_cb_t done;
+    void *ctx;
+} ws_tx_desc_t;
+
+// Blocking sends wait on a semaphore living on the caller's stack
+typedef struct {
+    StaticSemaphore_t storage;
+    SemaphoreHandle_t done;
+    esp_err_t result;
+} ws_tx_waiter_t;
+
+// Send queue and its TX task (created once, kept across reconnects)
+static QueueHandle_t s_tx_queue = NULL;
+static TaskHandle_t s_tx_task_handle = NULL;
+static uint8_t s_tx_staging[CONFIG_WS_TX_COALESCE_BYTES];  // TX task only
+static uint32_t s_tx_wire_frames = 0;
+static uint32_t s_tx_coalesced_frames = 0;
 
 // ===========================
 // Private Function Declarations
@@ -91,14 +152,20 @@ static void websocket_event_handler(void *handler_args, esp_event_base_t base,
                                      int32_t event_id, void *event_data);
 static void handle_text_message(const char *data, size_t len);
 static void handle_binary_message(const uint8_t *data, size_t len);
+static void handle_end_of_audio(void);
+static void handle_control_message(const json_protocol_control_t *msg);
 static void update_pipeline_stage(const char *status, const char *stage);
+static void set_pipeline_stage(websocket_pipeline_stage_t stage);
 static const char *pipeline_stage_to_string(websocket_pipeline_stage_t stage);
 static void post_pipeline_stage_event(websocket_pipeline_stage_t stage);
 // Enhanced connection health check task
 static void websocket_health_check_task(void *pvParameters);
 // Helper functions for WebSocket reconnection tasks
 static void websocket_reconnect_task(void *pvParameters);
-static void websocket_delayed_reconnect_task(void *pvParameters);
+// Send queue
+static void websocket_tx_task(void *pvParameters);
+static esp_err_t tx_enqueue(const ws_tx_desc_t *desc, uint32_t timeout_ms);
+static esp_err_t tx_send_and_wait(ws_tx_desc_t *desc, uint32_t timeout_ms);
 
 // ===========================
 // Public Functions
@@ -128,6 +195,13 @@ esp_err_t websocket_client_init(const char *uri, const char *auth_token) {
         ESP_LOGI(TAG, "Authorization header configured");
     }
     
+#if WS_OWN_TRANSPORT
+    s_ws_transport = create_ws_transport(server_uri, headers[0] != '\0' ? headers : NULL);
+    if (s_ws_transport == NULL) {
+        ESP_LOGW(TAG, "Own WebSocket transport unavailable - using the client's (no socket tuning)");
+    }
+#endif
+
     // Configure WebSocket client with enhanced reliability settings
     // Using correct field names for ESP-IDF 5.4.2
     esp_websocket_client_config_t ws_cfg = {
@@ -147,6 +221,9 @@ esp_err_t websocket_client_init(const char *uri, const char *auth_token) {
         .transport = WEBSOCKET_TRANSPORT_OVER_TCP, // Explicit TCP transport
         .use_global_ca_store = false,      // No global CA store
         .skip_cert_common_name_check = true, // Skip certificate checks
+#if WS_OWN_TRANSPORT
+        .ext_transport = s_ws_transport,   // NULL: client builds its own
+#endif
     };
     
     g_ws_client = esp_websocket_client_init(&ws_cfg);
@@ -167,6 +244,34 @@ esp_err_t websocket_client_init(const char *uri, const char *auth_token) {
         return ret;
     }
     
+    if (s_tx_queue == NULL) {
+        s_tx_queue = xQueueCreate(CONFIG_WS_TX_QUEUE_DEPTH, sizeof(ws_tx_desc_t));
+        if (s_tx_queue == NULL) {
+            ESP_LOGE(TAG, "Failed to create WebSocket send queue");
+            esp_websocket_client_destroy(g_ws_client);
+            g_ws_client = NULL;
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    if (s_tx_task_handle == NULL) {
+        BaseType_t task_ret = xTaskCreatePinnedToCore(
+            websocket_tx_task,
+            "ws_tx",
+            TASK_STACK_SIZE_MEDIUM,
+            NULL,
+            TASK_PRIORITY_WEBSOCKET,
+            &s_tx_task_handle,
+            TASK_CORE_NETWORK_IO
+        );
+        if (task_ret != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create WebSocket TX task");
+            s_tx_task_handle = NULL;
+            esp_websocket_client_destroy(g_ws_client);
+            g_ws_client = NULL;
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    
     is_started = false;
     is_initialized = true;
     ESP_LOGI(TAG, "✅ WebSocket client initialized");
@@ -254,8 +359,9 @@ esp_err_t websocket_client_connect(void) {
     if (s_reconnect_attempt_count > 0) {
         // Calculate next delay: base delay * 2^(attempt count), with max and jitter
         uint32_t next_delay = s_last_reconnect_delay;
-        if (next_delay < 60000) { // Max 60 seconds (increased from 30)
-            next_delay = (s_last_reconnect_delay * 2 < 60000) ? s_last_reconnect_delay * 2 : 60000;
+        if (next_delay < CONFIG_NET_RECONNECT_MAX_MS) {
+            next_delay = (s_last_reconnect_delay * 2 < CONFIG_NET_RECONNECT_MAX_MS) ?
+                         s_last_reconnect_delay * 2 : CONFIG_NET_RECONNECT_MAX_MS;
         }
         
         // Add jitter to prevent thundering herd effect
@@ -504,7 +610,7 @@ esp_err_t websocket_client_disconnect(void) {
     }
     
     is_connected = false;
-    g_pipeline_stage = WEBSOCKET_PIPELINE_STAGE_IDLE;
+    set_pipeline_stage(WEBSOCKET_PIPELINE_STAGE_IDLE);
     g_session_ready = false;
     s_reconnect_attempt_count = 0; // Reset reconnect counter on explicit disconnect
     
@@ -533,7 +639,7 @@ esp_err_t websocket_client_disconnect(void) {
 esp_err_t websocket_client_force_stop(void) {
     if (!is_initialized || g_ws_client == NULL) {
         is_connected = false;
-        g_pipeline_stage = WEBSOCKET_PIPELINE_STAGE_IDLE;
+        set_pipeline_stage(WEBSOCKET_PIPELINE_STAGE_IDLE);
         g_session_ready = false;
         is_started = false;
         return ESP_OK;
@@ -559,7 +665,7 @@ esp_err_t websocket_client_force_stop(void) {
     }
 
     is_connected = false;
-    g_pipeline_stage = WEBSOCKET_PIPELINE_STAGE_IDLE;
+    set_pipeline_stage(WEBSOCKET_PIPELINE_STAGE_IDLE);
     g_session_ready = false;
     
     // Clean up the health check task if it exists
@@ -588,27 +694,31 @@ esp_err_t websocket_client_send_handshake(void) {
         return ESP_ERR_INVALID_STATE;
     }
     
-    // Create handshake JSON
-    cJSON *root = cJSON_CreateObject();
-    if (root == NULL) {
-        ESP_LOGE(TAG, "Failed to create JSON object");
-        return ESP_ERR_NO_MEM;
+    // Offer uplink codecs in preference order; the server picks one in its "connected" reply
+    static const audio_codec_t offer_order[] = {
+        AUDIO_CODEC_OPUS, AUDIO_CODEC_IMA_ADPCM, AUDIO_CODEC_PCM16
+    };
+    const char *codecs[sizeof(offer_order) / sizeof(offer_order[0])];
+    size_t codec_count = 0;
+    for (size_t i = 0; i < sizeof(offer_order) / sizeof(offer_order[0]); i++) {
+        if (audio_codec_is_supported(offer_order[i])) {
+            codecs[codec_count++] = audio_codec_name(offer_order[i]);
+        }
     }
-    
-    cJSON_AddStringToObject(root, "session_id", CONFIG_WEBSOCKET_SESSION_ID);
-    
-    char *json_str = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
-    
-    if (json_str == NULL) {
-        ESP_LOGE(TAG, "Failed to serialize JSON");
+
+    char json_str[256];
+    int json_len = json_protocol_build_handshake(CONFIG_WEBSOCKET_SESSION_ID, codecs, codec_count,
+                                                 CONFIG_AUDIO_SAMPLE_RATE, prompt_store_version(),
+                                                 CONFIG_WS_BINARY_CONTROL != 0, CONFIG_TTS_FRAMED_STREAM != 0,
+                                                 json_str, sizeof(json_str));
+    if (json_len < 0) {
+        ESP_LOGE(TAG, "Failed to build handshake");
         return ESP_ERR_NO_MEM;
     }
     
     ESP_LOGI(TAG, "Sending handshake: %s", json_str);
     
-    int ret = esp_websocket_client_send_text(g_ws_client, json_str, strlen(json_str), portMAX_DELAY);
-    free(json_str);
+    int ret = esp_websocket_client_send_text(g_ws_client, json_str, json_len, portMAX_DELAY);
     
     if (ret < 0) {
         ESP_LOGE(TAG, "Failed to send handshake");
@@ -619,17 +729,35 @@ esp_err_t websocket_client_send_handshake(void) {
     return ESP_OK;
 }
 
-esp_err_t websocket_client_send_audio(const uint8_t *data, size_t length, uint32_t timeout_ms) {
-    // CRITICAL: Validate connection before sending
-    if (!is_connected || g_ws_client == NULL) {
-        ESP_LOGE(TAG, "Cannot send audio - not connected");
+esp_err_t websocket_client_submit(const websocket_tx_frame_t *frame, uint32_t timeout_ms) {
+    if (frame == NULL || frame->payload == NULL || frame->payload_len == 0 ||
+        frame->header_len > WEBSOCKET_TX_MAX_HEADER ||
+        (frame->header_len > 0 && frame->header == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!is_connected || s_tx_queue == NULL) {
         return ESP_ERR_INVALID_STATE;
     }
-    
-    // Additional validation to ensure connection is still alive
-    if (!esp_websocket_client_is_connected(g_ws_client)) {
-        ESP_LOGE(TAG, "WebSocket connection lost - cannot send audio");
-        is_connected = false;
+
+    ws_tx_desc_t desc = {
+        .header_len = (uint8_t)frame->header_len,
+        .flags = frame->flags,
+        .payload = frame->payload,
+        .payload_len = frame->payload_len,
+        .done = frame->done,
+        .ctx = frame->ctx,
+    };
+    if (frame->header_len > 0) {
+        memcpy(desc.header, frame->header, frame->header_len);
+    }
+    return tx_enqueue(&desc, timeout_ms);
+}
+
+esp_err_t websocket_client_send_audio(const uint8_t *data, size_t length, uint32_t timeout_ms) {
+    if (!is_connected || g_ws_client == NULL) {
+        // Called per frame by the streaming task, so a dropped link would flood the console
+        LOGE_RL(TAG, "Cannot send audio - not connected");
         return ESP_ERR_INVALID_STATE;
     }
     
@@ -637,91 +765,107 @@ esp_err_t websocket_client_send_audio(const uint8_t *data, size_t length, uint32
         ESP_LOGE(TAG, "Invalid audio data");
         return ESP_ERR_INVALID_ARG;
     }
-    
-    // CRITICAL IMPROVEMENT: Implement exponential backoff for retries on send failures
-    static uint32_t s_send_failure_count = 0;
-    const uint32_t max_retries = 3;
-    esp_err_t last_error = ESP_OK;
-    
-    for (uint32_t attempt = 0; attempt <= max_retries; attempt++) {
-        // Re-check connection status before each send attempt
-        if (!esp_websocket_client_is_connected(g_ws_client)) {
-            ESP_LOGE(TAG, "WebSocket connection lost before send attempt %u", (unsigned int)(attempt + 1));
-            is_connected = false;
-            return ESP_ERR_INVALID_STATE;
+
+    ws_tx_desc_t desc = {
+        .payload = data,
+        .payload_len = length,
+    };
+    return tx_send_and_wait(&desc, timeout_ms);
+}
+
+// Completion for all but the last image frame; the last one is waited on directly
+static void image_frame_done(esp_err_t result, uint32_t send_ms, void *ctx) {
+    (void)send_ms;
+    esp_err_t *first_error = (esp_err_t *)ctx;
+    if (result != ESP_OK && *first_error == ESP_OK) {
+        *first_error = result;
+    }
+}
+
+esp_err_t websocket_client_send_image(const uint8_t *jpeg_data, size_t jpeg_len, uint32_t timeout_ms) {
+    if (!is_connected || g_ws_client == NULL) {
+        ESP_LOGE(TAG, "Cannot send image - not connected");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (jpeg_data == NULL || jpeg_len == 0 || jpeg_len > UINT32_MAX) {
+        ESP_LOGE(TAG, "Invalid image data");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t chunk_count = (jpeg_len + CONFIG_WS_IMAGE_CHUNK_BYTES - 1) / CONFIG_WS_IMAGE_CHUNK_BYTES;
+    if (chunk_count > UINT16_MAX + 1u) {
+        ESP_LOGE(TAG, "Image too large for frame sequence (%zu bytes)", jpeg_len);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    ESP_LOGI(TAG, "Sending image over WebSocket: %zu bytes in %u frames",
+             jpeg_len, (unsigned int)chunk_count);
+
+    // Every chunk is queued as header + JPEG span; the FIFO lets the final,
+    // waited-on frame act as the completion point for the whole image
+    const uint32_t total = (uint32_t)jpeg_len;
+    esp_err_t frame_error = ESP_OK;
+    esp_err_t ret = ESP_OK;
+    size_t offset = 0;
+    size_t seq = 0;
+    for (; seq < chunk_count; seq++) {
+        size_t chunk = jpeg_len - offset;
+        if (chunk > CONFIG_WS_IMAGE_CHUNK_BYTES) {
+            chunk = CONFIG_WS_IMAGE_CHUNK_BYTES;
         }
-        
-        // Calculate timeout with exponential backoff
-        uint32_t effective_timeout = timeout_ms;
-        if (attempt > 0) {
-            // Exponential backoff: base timeout * 2^attempt
-            effective_timeout = timeout_ms * (1 << attempt);
-            if (effective_timeout > (timeout_ms * 8)) {  // Cap at 8x base timeout
-                effective_timeout = timeout_ms * 8;
-            }
-            
-            // Add jitter to prevent thundering herd
-            uint32_t jitter = esp_random() % (effective_timeout / 4); // Up to 25% jitter
-            effective_timeout += jitter;
-            
-            ESP_LOGD(TAG, "WebSocket send attempt %u with backoff timeout: %u ms (base: %u ms)", 
-                     (unsigned int)(attempt + 1), (unsigned int)effective_timeout, (unsigned int)timeout_ms);
+
+        uint8_t flags = 0;
+        if (seq == 0) {
+            flags |= WS_IMAGE_FLAG_FIRST;
         }
-        
-        int ret = esp_websocket_client_send_bin(g_ws_client, (const char *)data, length, pdMS_TO_TICKS(effective_timeout));
-        
-        // CRITICAL FIX: Handle the case where send returns 0 (socket buffer full, need to wait)
-        if (ret == 0) {
-            ESP_LOGW(TAG, "WebSocket send buffer full (0 bytes sent), yielding and retrying (attempt %u/%u)", 
-                     (unsigned int)(attempt + 1), (unsigned int)(max_retries + 1));
-            // Yield to allow TCP/IP stack to drain send buffer
-            vTaskDelay(pdMS_TO_TICKS(100));
-            // Don't count this as a failure, just retry
-            if (attempt == max_retries) {
-                ESP_LOGE(TAG, "WebSocket send buffer remained full after %u attempts", (unsigned int)(max_retries + 1));
-                last_error = ESP_ERR_TIMEOUT;
-                s_send_failure_count++;
-            }
-            continue;  // Retry without incrementing failure counter
+        bool last = (seq + 1 == chunk_count);
+        if (last) {
+            flags |= WS_IMAGE_FLAG_LAST;
         }
-        
-        if (ret >= 0) {
-            // Success - reset failure counter
-            s_send_failure_count = 0;
-            
-            // Log success for first few attempts to verify reliability
-            static uint32_t s_success_count = 0;
-            s_success_count++;
-            if (s_success_count <= 10 || (s_success_count % 100) == 0) {
-                ESP_LOGD(TAG, "Sent %zu bytes of audio data (attempt: %u, success: %u)", 
-                         length, (unsigned int)(attempt + 1), (unsigned int)s_success_count);
-            }
-            
-            return ESP_OK;
-        }
-        
-        // ret < 0 indicates an actual error
-        last_error = ESP_FAIL;
-        s_send_failure_count++;
-        
-        if (attempt < max_retries) {
-            ESP_LOGW(TAG, "WebSocket send attempt %u failed (%d), retrying...", 
-                     (unsigned int)(attempt + 1), ret);
-            // Exponential backoff delay: 50ms, 100ms, 200ms
-            vTaskDelay(pdMS_TO_TICKS(50 * (1 << attempt)));
-            
-            // Re-check connection status after delay
-            if (!esp_websocket_client_is_connected(g_ws_client)) {
-                ESP_LOGE(TAG, "WebSocket connection lost during retry");
-                is_connected = false;
-                return ESP_ERR_INVALID_STATE;
-            }
+
+        ws_tx_desc_t desc = {
+            .header_len = WS_IMAGE_FRAME_HEADER_SIZE,
+            .payload = jpeg_data + offset,
+            .payload_len = chunk,
+            .done = image_frame_done,
+            .ctx = &frame_error,
+        };
+        memcpy(desc.header, WS_IMAGE_FRAME_MAGIC, 4);
+        desc.header[4] = WS_IMAGE_FRAME_VERSION;
+        desc.header[5] = flags;
+        desc.header[6] = (uint8_t)(seq & 0xFF);
+        desc.header[7] = (uint8_t)((seq >> 8) & 0xFF);
+        desc.header[8] = (uint8_t)(total & 0xFF);
+        desc.header[9] = (uint8_t)((total >> 8) & 0xFF);
+        desc.header[10] = (uint8_t)((total >> 16) & 0xFF);
+        desc.header[11] = (uint8_t)((total >> 24) & 0xFF);
+
+        ret = last ? tx_send_and_wait(&desc, timeout_ms) : tx_enqueue(&desc, timeout_ms);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Image frame %u/%u failed: %s", (unsigned int)(seq + 1),
+                     (unsigned int)chunk_count, esp_err_to_name(ret));
+            break;
         }
+        offset += chunk;
+        safe_task_wdt_reset();
     }
-    
-    ESP_LOGE(TAG, "Failed to send audio chunk (%zu bytes) after %u attempts", 
-             length, (unsigned int)(max_retries + 1));
-    return last_error;
+
+    if (ret != ESP_OK && seq > 0) {
+        // Frames already queued still reference the JPEG; wait them out before returning
+        ws_tx_desc_t barrier = {0};
+        tx_send_and_wait(&barrier, portMAX_DELAY);
+    }
+    if (ret == ESP_OK) {
+        ret = frame_error;
+    }
+
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Image sent over WebSocket (%u bytes)", (unsigned int)total);
+    } else {
+        ESP_LOGE(TAG, "Image send failed: %s", esp_err_to_name(ret));
+    }
+    return ret;
 }
 
 esp_err_t websocket_client_send_text(const char *message) {
@@ -735,10 +879,15 @@ esp_err_t websocket_client_send_text(const char *message) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    int ret = esp_websocket_client_send_text(g_ws_client, message, strlen(message), portMAX_DELAY);
-    if (ret < 0) {
-        ESP_LOGE(TAG, "Failed to send text message");
-        return ESP_FAIL;
+    ws_tx_desc_t desc = {
+        .flags = WEBSOCKET_TX_FLAG_TEXT,
+        .payload = (const uint8_t *)message,
+        .payload_len = strlen(message),
+    };
+    esp_err_t ret = tx_send_and_wait(&desc, portMAX_DELAY);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to send text message: %s", esp_err_to_name(ret));
+        return ret;
     }
     
     ESP_LOGD(TAG, "Sent text message: %s", message);
@@ -746,15 +895,33 @@ esp_err_t websocket_client_send_text(const char *message) {
 }
 
 esp_err_t websocket_client_send_eos(void) {
-    const char *eos_msg = "{\"signal\":\"EOS\"}";
-    ESP_LOGI(TAG, "Sending EOS signal");
-    return websocket_client_send_text(eos_msg);
+    char eos_msg[48];
+    uint32_t turn = turn_metrics_begin();
+    if (turn != 0) {
+        snprintf(eos_msg, sizeof(eos_msg), "{\"signal\":\"EOS\",\"turn\":%u}", (unsigned int)turn);
+    } else {
+        snprintf(eos_msg, sizeof(eos_msg), "{\"signal\":\"EOS\"}");
+    }
+    ESP_LOGI(TAG, "Sending EOS signal (turn %u)", (unsigned int)turn);
+    esp_err_t ret = websocket_client_send_text(eos_msg);
+    if (ret == ESP_OK) {
+        turn_metrics_mark(TURN_MARK_EOS_SENT);
+    }
+    return ret;
 }
 
 bool websocket_client_is_connected(void) {
     return is_connected;
 }
 
+bool websocket_client_is_connecting(void) {
+    return is_started && !is_connected;
+}
+
+audio_codec_t websocket_client_get_uplink_codec(void) {
+    return g_uplink_codec;
+}
+
 bool websocket_client_session_ready(void) {
     return is_connected && g_session_ready;
 }
@@ -786,6 +953,180 @@ void websocket_client_set_status_callback(websocket_status_callback_t callback,
 // Private Functions
 // ===========================
 
+static esp_err_t tx_enqueue(const ws_tx_desc_t *desc, uint32_t timeout_ms) {
+    if (s_tx_queue == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    TickType_t wait = (timeout_ms == portMAX_DELAY) ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    if (xQueueSend(s_tx_queue, desc, wait) != pdTRUE) {
+        ESP_LOGW(TAG, "WebSocket send queue full (%d frames)", CONFIG_WS_TX_QUEUE_DEPTH);
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+static void tx_waiter_done(esp_err_t result, uint32_t send_ms, void *ctx) {
+    (void)send_ms;
+    ws_tx_waiter_t *waiter = (ws_tx_waiter_t *)ctx;
+    waiter->result = result;
+    xSemaphoreGive(waiter->done);
+}
+
+// Queue desc and block until the TX task has written it. Once queued there is
+// no timeout: the caller's payload must outlive the frame, and every frame
+// completes within CONFIG_WS_TX_SEND_TIMEOUT_MS of reaching the queue head.
+static esp_err_t tx_send_and_wait(ws_tx_desc_t *desc, uint32_t timeout_ms) {
+    if (xTaskGetCurrentTaskHandle() == s_tx_task_handle) {
+        return ESP_ERR_INVALID_STATE;  // Would wait on itself
+    }
+
+    ws_tx_waiter_t waiter = { .result = ESP_FAIL };
+    waiter.done = xSemaphoreCreateBinaryStatic(&waiter.storage);
+    desc->done = tx_waiter_done;
+    desc->ctx = &waiter;
+
+    esp_err_t ret = tx_enqueue(desc, timeout_ms);
+    if (ret == ESP_OK) {
+        xSemaphoreTake(waiter.done, portMAX_DELAY);
+        ret = waiter.result;
+    }
+    vSemaphoreDelete(waiter.done);
+    return ret;
+}
+
+static inline void tx_complete(const ws_tx_desc_t *desc, esp_err_t result, uint32_t send_ms) {
+    if (desc->done != NULL) {
+        desc->done(result, send_ms, desc->ctx);
+    }
+}
+
+static inline size_t tx_frame_len(const ws_tx_desc_t *desc) {
+    return (size_t)desc->header_len + desc->payload_len;
+}
+
+static inline bool tx_can_coalesce(const ws_tx_desc_t *desc) {
+    return (desc->flags & WEBSOCKET_TX_FLAG_COALESCE) != 0 &&
+           (desc->flags & WEBSOCKET_TX_FLAG_TEXT) == 0 &&
+           desc->payload_len > 0 &&
+           tx_frame_len(desc) <= CONFIG_WS_TX_COALESCE_BYTES;
+}
+
+static esp_err_t tx_result_from(int ret, size_t len) {
+    if (ret < 0) {
+        return ESP_FAIL;
+    }
+    if (ret == 0 && len > 0) {
+        return ESP_ERR_TIMEOUT;  // Nothing left the TX buffer before the timeout
+    }
+    return ESP_OK;
+}
+
+// One socket write per wire frame; no retries - a frame that cannot be written
+// within the timeout is reported to its producer, which decides what to drop
+static esp_err_t tx_write(const uint8_t *header, size_t header_len,
+                          const uint8_t *payload, size_t payload_len, bool text) {
+    if (!is_connected || g_ws_client == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const TickType_t timeout = pdMS_TO_TICKS(CONFIG_WS_TX_SEND_TIMEOUT_MS);
+    int ret;
+    if (text) {
+        ret = esp_websocket_client_send_text(g_ws_client, (const char *)payload, (int)payload_len, timeout);
+        return tx_result_from(ret, payload_len);
+    }
+    if (header_len == 0) {
+        ret = esp_websocket_client_send_bin(g_ws_client, (const char *)payload, (int)payload_len, timeout);
+        return tx_result_from(ret, payload_len);
+    }
+
+    // Header and payload as one fragmented message, so neither is copied into a joint frame
+    ret = esp_websocket_client_send_bin_partial(g_ws_client, (const char *)header, (int)header_len, timeout);
+    esp_err_t result = tx_result_from(ret, header_len);
+    if (result == ESP_OK) {
+        ret = esp_websocket_client_send_cont_msg(g_ws_client, (const char *)payload, (int)payload_len, timeout);
+        result = tx_result_from(ret, payload_len);
+    }
+    if (result == ESP_OK) {
+        ret = esp_websocket_client_send_fin(g_ws_client, timeout);
+        result = (ret < 0) ? ESP_FAIL : ESP_OK;
+    }
+    return result;
+}
+
+static void websocket_tx_task(void *pvParameters) {
+    (void)pvParameters;
+    ws_tx_desc_t batch[CONFIG_WS_TX_QUEUE_DEPTH];
+
+    for (;;) {
+        if (xQueueReceive(s_tx_queue, &batch[0], portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        if (batch[0].header_len == 0 && batch[0].payload_len == 0 &&
+            (batch[0].flags & WEBSOCKET_TX_FLAG_TEXT) == 0) {
+            tx_complete(&batch[0], ESP_OK, 0);  // Barrier: everything ahead of it is done
+            continue;
+        }
+
+        // Merge a run of small frames into the staging buffer. A frame with nothing
+        // mergeable behind it is sent in place instead of being copied.
+        size_t count = 1;
+        size_t staged = 0;
+        if (tx_can_coalesce(&batch[0])) {
+            size_t used = tx_frame_len(&batch[0]);
+            ws_tx_desc_t next;
+            while (count < CONFIG_WS_TX_QUEUE_DEPTH &&
+                   xQueuePeek(s_tx_queue, &next, 0) == pdTRUE &&
+                   tx_can_coalesce(&next) &&
+                   (used + tx_frame_len(&next)) <= CONFIG_WS_TX_COALESCE_BYTES) {
+                if (count == 1) {
+                    memcpy(s_tx_staging, batch[0].header, batch[0].header_len);
+                    memcpy(s_tx_staging + batch[0].header_len, batch[0].payload, batch[0].payload_len);
+                }
+                // Single consumer, so the peeked entry is the one received
+                xQueueReceive(s_tx_queue, &batch[count], 0);
+                memcpy(s_tx_staging + used, batch[count].header, batch[count].header_len);
+                memcpy(s_tx_staging + used + batch[count].header_len,
+                       batch[count].payload, batch[count].payload_len);
+                used += tx_frame_len(&batch[count]);
+                count++;
+            }
+            if (count > 1) {
+                staged = used;
+            }
+        }
+
+        int64_t start_us = esp_timer_get_time();
+        TRACE_SPAN_BEGIN(send);
+        esp_err_t result;
+        if (staged > 0) {
+            result = tx_write(NULL, 0, s_tx_staging, staged, false);
+            s_tx_coalesced_frames += (uint32_t)count;
+        } else {
+            result = tx_write(batch[0].header, batch[0].header_len,
+                              batch[0].payload, batch[0].payload_len,
+                              (batch[0].flags & WEBSOCKET_TX_FLAG_TEXT) != 0);
+        }
+        TRACE_SPAN_END(send, TRACE_ID_WS_SEND, staged > 0 ? staged : tx_frame_len(&batch[0]));
+        uint32_t send_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+        s_tx_wire_frames++;
+
+        if (result != ESP_OK && result != ESP_ERR_INVALID_STATE) {
+            ESP_LOGW(TAG, "WebSocket TX frame (%u bytes, %u queued frames) failed: %s",
+                     (unsigned int)(staged > 0 ? staged : tx_frame_len(&batch[0])),
+                     (unsigned int)count, esp_err_to_name(result));
+        } else if ((s_tx_wire_frames % 200U) == 0U) {
+            ESP_LOGD(TAG, "WebSocket TX: %u wire frames, %u queued frames merged",
+                     (unsigned int)s_tx_wire_frames, (unsigned int)s_tx_coalesced_frames);
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            tx_complete(&batch[i], result, send_ms);
+        }
+    }
+}
+
 static void websocket_event_handler(void *handler_args, esp_event_base_t base,
                                      int32_t event_id, void *event_data) {
     esp_websocket_event_data_t *data = (esp_websocket_event_data_t *)event_data;
@@ -794,9 +1135,19 @@ static void websocket_event_handler(void *handler_args, esp_event_base_t base,
         case WEBSOCKET_EVENT_CONNECTED:
             ESP_LOGI(TAG, "✅ WebSocket connected to server");
             is_connected = true;
-            g_pipeline_stage = WEBSOCKET_PIPELINE_STAGE_IDLE;
+            set_pipeline_stage(WEBSOCKET_PIPELINE_STAGE_IDLE);
             g_session_ready = false;
+            g_uplink_codec = AUDIO_CODEC_PCM16;  // Until the server confirms a codec
+            g_binary_control = false;            // Likewise for binary control frames
+            g_tts_framed = false;                // And for the framed TTS downlink
+            s_tts_next_seq = 0;
+            tts_decoder_set_stream_format(NULL);
             is_started = true;
+#if WS_OWN_TRANSPORT
+            if (s_ws_transport != NULL) {
+                network_profile_tune_socket(esp_transport_get_socket(s_ws_transport));
+            }
+#endif
             
             // Send handshake immediately after connection
             websocket_client_send_handshake();
@@ -814,7 +1165,8 @@ static void websocket_event_handler(void *handler_args, esp_event_base_t base,
                      g_session_ready ? 1 : 0);
             
             is_connected = false;
-            g_pipeline_stage = WEBSOCKET_PIPELINE_STAGE_IDLE;
+            prompt_store_abort_update();
+            set_pipeline_stage(WEBSOCKET_PIPELINE_STAGE_IDLE);
             g_session_ready = false;
             is_started = false;
             
@@ -848,7 +1200,7 @@ static void websocket_event_handler(void *handler_args, esp_event_base_t base,
         case WEBSOCKET_EVENT_ERROR:
             ESP_LOGE(TAG, "❌ WebSocket error occurred");
             is_connected = false; // CRITICAL: Mark as disconnected on error
-            g_pipeline_stage = WEBSOCKET_PIPELINE_STAGE_IDLE;
+            set_pipeline_stage(WEBSOCKET_PIPELINE_STAGE_IDLE);
             g_session_ready = false;
             is_started = false; // CRITICAL: Mark as not started
             
@@ -863,18 +1215,8 @@ static void websocket_event_handler(void *handler_args, esp_event_base_t base,
                 g_status_callback(WEBSOCKET_STATUS_ERROR, g_status_callback_arg);
             }
             
-            // CRITICAL FIX: Trigger reconnection attempt after a short delay
-            // This prevents immediate retry loops that can overwhelm the system
-            // Only create task if it doesn't already exist to prevent multiple attempts
-            if (s_delayed_reconnect_task_handle == NULL) {
-                BaseType_t ret = xTaskCreate(websocket_delayed_reconnect_task, "ws_delayed_reconnect_task", 2048, NULL, TASK_PRIORITY_WEBSOCKET - 1, &s_delayed_reconnect_task_handle);
-                if (ret != pdPASS) {
-                    ESP_LOGE(TAG, "Failed to create delayed reconnect task");
-                    s_delayed_reconnect_task_handle = NULL;
-                }
-            } else {
-                ESP_LOGD(TAG, "Delayed reconnect task already exists, skipping creation");
-            }
+            // Like DISCONNECTED: websocket_connection_task in main.c owns reconnection
+            // and its backoff, so a second retry path cannot restart a live attempt
             break;
             
         default:
@@ -884,55 +1226,113 @@ static void websocket_event_handler(void *handler_args, esp_event_base_t base,
 }
 
 static void handle_text_message(const char *data, size_t len) {
-    // Parse JSON status messages
-    char *json_str = strndup(data, len);
-    if (json_str == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate memory for JSON parsing");
+    // Fixed-schema scan straight from the frame: no copy, no tree, no heap
+    json_protocol_control_t msg;
+    if (!json_protocol_parse_control(data, len, &msg)) {
+        ESP_LOGE(TAG, "Failed to parse JSON: %.*s", (int)len, data);
         return;
     }
-    
-    ESP_LOGI(TAG, "Received text message: %s", json_str);
-    
-    cJSON *root = cJSON_Parse(json_str);
-    free(json_str);
-    json_str = NULL;  // Set to NULL after freeing to prevent double-free
-    
-    if (root == NULL) {
-        ESP_LOGE(TAG, "Failed to parse JSON");
-        return;
+
+    // Flow-control ACKs arrive every chunk; keep them out of the INFO log
+    if (json_protocol_str_equals(&msg.status, "receiving")) {
+        ESP_LOGD(TAG, "Received text message: %.*s", (int)len, data);
+    } else {
+        ESP_LOGI(TAG, "Received text message: %.*s", (int)len, data);
+    }
+
+    handle_control_message(&msg);
+}
+
+static void handle_control_message(const json_protocol_control_t *msg) {
+    // Short names only; copies stay on the stack for update_pipeline_stage()
+    char status_buf[24];
+    char stage_buf[24];
+    const char *status_str = NULL;
+    const char *stage_str = NULL;
+    if (msg->fields & JSON_PROTO_FIELD_STATUS) {
+        json_protocol_str_copy(&msg->status, status_buf, sizeof(status_buf));
+        status_str = status_buf;
+    }
+    if (msg->fields & JSON_PROTO_FIELD_STAGE) {
+        json_protocol_str_copy(&msg->stage, stage_buf, sizeof(stage_buf));
+        stage_str = stage_buf;
     }
-    
-    // Check for status field
-    cJSON *status = cJSON_GetObjectItem(root, "status");
-    cJSON *stage = cJSON_GetObjectItem(root, "stage");
-    const char *status_str = (status != NULL && cJSON_IsString(status)) ? status->valuestring : NULL;
-    const char *stage_str = (stage != NULL && cJSON_IsString(stage)) ? stage->valuestring : NULL;
 
     if (status_str != NULL) {
-        ESP_LOGI(TAG, "Server status: %s", status_str);
-        
-        // ✅ PRIORITY 2: Handle server acknowledgment messages for flow control
-        // Server sends {"status": "receiving", "chunks_received": N, "bytes_received": M} every 2 chunks
-        // This allows us to implement backpressure and prevent send buffer overflow
+        // ✅ Sliding-window flow control
+        // Server sends {"status": "receiving", "chunks_received": N, "bytes_received": M,
+        // "window_bytes": W} for every chunk (or the binary ACK frame once negotiated),
+        // and advertises {"flow_window": W} on connect
         if (strcmp(status_str, "receiving") == 0) {
-            cJSON *chunks_received = cJSON_GetObjectItem(root, "chunks_received");
-            if (chunks_received != NULL && cJSON_IsNumber(chunks_received)) {
-                uint32_t ack_chunk = (uint32_t)chunks_received->valueint;
-                stt_pipeline_update_flow_control(ack_chunk);
-                ESP_LOGI(TAG, "Server ACK: %u chunks processed", (unsigned int)ack_chunk);
+            if (msg->fields & JSON_PROTO_FIELD_CHUNKS_RECEIVED) {
+                stt_pipeline_update_flow_control(msg->chunks_received, msg->bytes_received, msg->window_bytes);
+                ESP_LOGD(TAG, "Server ACK: %u chunks / %u bytes (window %u)",
+                         (unsigned int)msg->chunks_received, (unsigned int)msg->bytes_received,
+                         (unsigned int)msg->window_bytes);
+            }
+        } else {
+            ESP_LOGI(TAG, "Server status: %s", status_str);
+        }
+
+        if (strcmp(status_str, "connected") == 0) {
+            if ((msg->fields & JSON_PROTO_FIELD_FLOW_WINDOW) && msg->flow_window > 0) {
+                stt_pipeline_update_flow_control(0, 0, msg->flow_window);
+                ESP_LOGI(TAG, "Server flow window: %u bytes", (unsigned int)msg->flow_window);
+            }
+
+            // Servers without codec negotiation never send "codec" and keep PCM16
+            audio_codec_t negotiated = AUDIO_CODEC_PCM16;
+            if (msg->fields & JSON_PROTO_FIELD_CODEC) {
+                char codec_name[16];
+                json_protocol_str_copy(&msg->codec, codec_name, sizeof(codec_name));
+                if (!audio_codec_from_name(codec_name, &negotiated)) {
+                    ESP_LOGW(TAG, "Server selected unsupported codec '%s' - using pcm16", codec_name);
+                    negotiated = AUDIO_CODEC_PCM16;
+                }
+            }
+            g_uplink_codec = negotiated;
+            ESP_LOGI(TAG, "Uplink codec: %s", audio_codec_name(negotiated));
+
+            // Binary control frames only once the server has agreed to send them
+            g_binary_control = CONFIG_WS_BINARY_CONTROL &&
+                               json_protocol_str_equals(&msg->control, "binary");
+            ESP_LOGI(TAG, "Control framing: %s", g_binary_control ? "binary" : "json");
+
+            // Servers without TTS framing never send "tts" and stream one WAV per reply
+            g_tts_framed = CONFIG_TTS_FRAMED_STREAM && json_protocol_str_equals(&msg->tts, "framed");
+            if (!g_tts_framed) {
+                tts_decoder_set_stream_format(NULL);
+            }
+            ESP_LOGI(TAG, "TTS downlink: %s", g_tts_framed ? "framed" : "wav");
+#if !CONFIG_TTS_WAV_COMPAT
+            if (!g_tts_framed) {
+                ESP_LOGE(TAG, "Server declined framed TTS and WAV compatibility is disabled - replies will be silent");
+            }
+#endif
+        } else if (strcmp(status_str, "image_received") == 0) {
+            ESP_LOGI(TAG, "📷 Server stored image context (%u bytes)", (unsigned int)msg->size_bytes);
+        } else if (strcmp(status_str, "partial") == 0) {
+            // Streaming STT: server's running hypothesis while audio is still uploading
+            if (msg->fields & JSON_PROTO_FIELD_TRANSCRIPT) {
+                ESP_LOGI(TAG, "📝 Partial transcript: \"%.*s\"", (int)msg->transcript.len, msg->transcript.ptr);
             }
         }
         
-        // Check if this is an error message indicating empty transcription
+        // Classify the error before update_pipeline_stage() announces it, so the
+        // state manager picks the matching spoken prompt
         if (strcmp(status_str, "error") == 0) {
-            cJSON *message = cJSON_GetObjectItem(root, "message");
-            if (message != NULL && cJSON_IsString(message)) {
-                const char *message_str = message->valuestring;
-                if (message_str != NULL && strstr(message_str, "Could not understand audio") != NULL) {
+            feedback_prompt_t prompt = FEEDBACK_PROMPT_PROCESSING_ERROR;
+            if (json_protocol_str_equals(&msg->error_type, "busy")) {
+                prompt = FEEDBACK_PROMPT_SERVER_BUSY;
+            } else if (msg->fields & JSON_PROTO_FIELD_MESSAGE) {
+                char message_str[96];
+                json_protocol_str_copy(&msg->message, message_str, sizeof(message_str));
+                if (strstr(message_str, "Could not understand audio") != NULL) {
                     ESP_LOGW(TAG, "Received empty transcription error: %s", message_str);
-                    // Removed redundant error beep - state_manager already plays FEEDBACK_SOUND_ERROR
+                    prompt = FEEDBACK_PROMPT_NOT_UNDERSTOOD;
                 }
             }
+            g_error_prompt = prompt;
         }
     }
 
@@ -940,15 +1340,50 @@ static void handle_text_message(const char *data, size_t len) {
         ESP_LOGI(TAG, "Server stage: %s", stage_str);
     }
 
+    // Prompt pack push (binary control frames only), written as it arrives
+    if (msg->fields & JSON_PROTO_FIELD_PROMPT_CHUNK) {
+        esp_err_t pack_ret = prompt_store_write_chunk(msg->prompt_pack, msg->pack_size, msg->pack_offset,
+                                                      msg->pack_data, msg->pack_data_len);
+        if (pack_ret != ESP_OK && pack_ret != ESP_ERR_INVALID_STATE) {
+            ESP_LOGW(TAG, "Prompt pack chunk at %u rejected: %s",
+                     (unsigned int)msg->pack_offset, esp_err_to_name(pack_ret));
+        }
+    }
+
+    // Server-selected resolution/quality for the next capture (e.g. "thumbnail")
+    if (msg->fields & JSON_PROTO_FIELD_CAPTURE_PROFILE) {
+        char profile_name[16];
+        camera_profile_t profile;
+        json_protocol_str_copy(&msg->capture_profile, profile_name, sizeof(profile_name));
+        if (camera_profile_from_name(profile_name, &profile)) {
+            camera_controller_set_profile(profile);
+        } else {
+            ESP_LOGW(TAG, "Unknown capture profile '%s' ignored", profile_name);
+        }
+    }
+
+    // Stage times for the open turn; messages tagged with an older turn do not count
+    if (status_str != NULL &&
+        (!(msg->fields & JSON_PROTO_FIELD_TURN) || turn_metrics_is_current(msg->turn))) {
+        if (strcmp(status_str, "complete") == 0) {
+            turn_metrics_mark(TURN_MARK_COMPLETE);
+        } else if (strcmp(status_str, "processing") == 0 && stage_str != NULL) {
+            if (strcmp(stage_str, "transcription") == 0) {
+                turn_metrics_mark(TURN_MARK_TRANSCRIPTION);
+            } else if (strcmp(stage_str, "llm") == 0) {
+                turn_metrics_mark(TURN_MARK_TRANSCRIPT);
+            } else if (strcmp(stage_str, "tts") == 0) {
+                turn_metrics_mark(TURN_MARK_REPLY);
+            }
+        }
+    }
+
     update_pipeline_stage(status_str, stage_str);
     
     // Check for transcription result
-    cJSON *transcription = cJSON_GetObjectItem(root, "transcription");
-    if (transcription != NULL && cJSON_IsString(transcription)) {
-        ESP_LOGI(TAG, "Transcription: %s", transcription->valuestring);
+    if (msg->fields & JSON_PROTO_FIELD_TRANSCRIPTION) {
+        ESP_LOGI(TAG, "Transcription: %.*s", (int)msg->transcription.len, msg->transcription.ptr);
     }
-    
-    cJSON_Delete(root);
 }
 
 // Session tracking variables - moved to file scope to fix scoping issues
@@ -962,29 +1397,33 @@ static uint32_t s_session_message_count = 0;
 static bool s_session_ended = false; // Track if current session has ended
 
 // Missing handle_binary_message function implementation
+static void handle_end_of_audio(void) {
+    // Notify TTS decoder about end of stream
+    tts_decoder_notify_end_of_stream();
+    
+    // Call audio callback with NULL data to signal end of session
+    if (g_audio_callback) {
+        g_audio_callback(NULL, 0, g_audio_callback_arg);
+    }
+    
+    // Reset session tracking
+    s_current_session_active = false;
+    s_session_ended = true;
+    s_tts_next_seq = 0;
+    
+    ESP_LOGI(TAG, "🎵 Audio session complete: %u bytes in %u messages", 
+             (unsigned int)s_current_session_bytes, (unsigned int)s_session_message_count);
+    
+    s_current_session_bytes = 0;
+    s_session_message_count = 0;
+}
+
 static void handle_binary_message(const uint8_t *data, size_t len) {
     // CRITICAL FIX: Handle zero-length binary frames as end-of-stream signal
-    // Server sends zero-length binary frame after all audio chunks to signal completion
+    // Legacy (WAV) servers send a zero-length binary frame after all audio chunks
     if (len == 0) {
         ESP_LOGI(TAG, "✅ Received end-of-audio signal (zero-length binary frame)");
-        
-        // Notify TTS decoder about end of stream
-        tts_decoder_notify_end_of_stream();
-        
-        // Call audio callback with NULL data to signal end of session
-        if (g_audio_callback) {
-            g_audio_callback(NULL, 0, g_audio_callback_arg);
-        }
-        
-        // Reset session tracking
-        s_current_session_active = false;
-        s_session_ended = true;
-        
-        ESP_LOGI(TAG, "🎵 Audio session complete: %u bytes in %u messages", 
-                 (unsigned int)s_current_session_bytes, (unsigned int)s_session_message_count);
-        
-        s_current_session_bytes = 0;
-        s_session_message_count = 0;
+        handle_end_of_audio();
         return;
     }
     
@@ -993,6 +1432,49 @@ static void handle_binary_message(const uint8_t *data, size_t len) {
         ESP_LOGE(TAG, "Invalid binary message: NULL data pointer with non-zero length (%zu)", len);
         return;
     }
+
+    // Negotiated control frames share the socket with TTS audio; magic, version and
+    // exact length tell them apart
+    if (g_binary_control) {
+        json_protocol_control_t msg;
+        if (json_protocol_decode_control_frame(data, len, &msg)) {
+            handle_control_message(&msg);
+            return;
+        }
+    }
+
+    // Framed TTS: the header says what the frame is; only the payload goes on to the decoder
+    if (g_tts_framed && tts_frame_is_framed(data, len)) {
+        tts_frame_t frame;
+        esp_err_t frame_ret = tts_frame_parse(data, len, &frame);
+        if (frame_ret != ESP_OK) {
+            LOGW_RL(TAG, "Dropping bad TTS frame (%zu bytes): %s", len, esp_err_to_name(frame_ret));
+            return;
+        }
+        // TCP does not lose frames, so a gap means the server skipped audio (or a new reply began)
+        if (frame.seq != s_tts_next_seq && frame.seq != 0) {
+            LOGW_RL(TAG, "TTS frame sequence gap: got %u, expected %u",
+                    (unsigned int)frame.seq, (unsigned int)s_tts_next_seq);
+        }
+        s_tts_next_seq = frame.seq + 1U;
+
+        if (frame.type == TTS_FRAME_TYPE_END) {
+            ESP_LOGI(TAG, "✅ Received end-of-audio frame (seq %u)", (unsigned int)frame.seq);
+            handle_end_of_audio();
+            return;
+        }
+        if (frame.type == TTS_FRAME_TYPE_FLUSH) {
+            ESP_LOGD(TAG, "TTS segment flush (seq %u)", (unsigned int)frame.seq);
+            tts_decoder_end_segment();
+            return;
+        }
+        if (frame.payload_len == 0) {
+            return;
+        }
+        tts_decoder_set_stream_format(&frame.format);
+        data = frame.payload;
+        len = frame.payload_len;
+    }
     
     s_total_bytes_received += len;
     s_message_count++;
@@ -1069,6 +1551,14 @@ static void handle_binary_message(const uint8_t *data, size_t len) {
     }
 }
 
+// Single writer for g_pipeline_stage so mode switches can wait on it as an event
+static void set_pipeline_stage(websocket_pipeline_stage_t stage)
+{
+    g_pipeline_stage = stage;
+    mode_switch_set_pipeline_state(websocket_client_is_pipeline_active(),
+                                   stage == WEBSOCKET_PIPELINE_STAGE_COMPLETE);
+}
+
 static void update_session_ready_from_stage(websocket_pipeline_stage_t stage)
 {
     switch (stage) {
@@ -1116,6 +1606,10 @@ static void update_pipeline_stage(const char *status, const char *stage) {
     } else if (strcmp(status, "idle") == 0) {
         new_stage = WEBSOCKET_PIPELINE_STAGE_IDLE;
         explicit_ready = true;
+    } else if (strcmp(status, "interrupted") == 0) {
+        // Reply abandoned after BARGE_IN; the capture that interrupted it streams next
+        new_stage = WEBSOCKET_PIPELINE_STAGE_IDLE;
+        explicit_ready = true;
     } else if (strcmp(status, "error") == 0) {
         explicit_ready = false;
     }
@@ -1203,14 +1697,16 @@ static void update_pipeline_stage(const char *status, const char *stage) {
         }
         
         // Cancel STT capture when moving to processing stages
-        if (new_stage == WEBSOCKET_PIPELINE_STAGE_TRANSCRIPTION ||
-            new_stage == WEBSOCKET_PIPELINE_STAGE_LLM ||
-            new_stage == WEBSOCKET_PIPELINE_STAGE_TTS ||
-            new_stage == WEBSOCKET_PIPELINE_STAGE_COMPLETE) {
+        // (a full-duplex capture is listening for barge-in and must survive them)
+        if ((new_stage == WEBSOCKET_PIPELINE_STAGE_TRANSCRIPTION ||
+             new_stage == WEBSOCKET_PIPELINE_STAGE_LLM ||
+             new_stage == WEBSOCKET_PIPELINE_STAGE_TTS ||
+             new_stage == WEBSOCKET_PIPELINE_STAGE_COMPLETE) &&
+            !stt_pipeline_is_duplex_capture()) {
             stt_pipeline_cancel_capture();
         }
         
-        g_pipeline_stage = new_stage;
+        set_pipeline_stage(new_stage);
         post_pipeline_stage_event(new_stage);
     }
 
@@ -1218,6 +1714,12 @@ static void update_pipeline_stage(const char *status, const char *stage) {
         g_session_ready = explicit_ready;
     }
 
+    // The server's error ends the turn but carries no stage; tell the state manager
+    // without touching g_pipeline_stage, which the STT pipeline polls for aborts
+    if (strcmp(status, "error") == 0) {
+        post_pipeline_stage_event(WEBSOCKET_PIPELINE_STAGE_ERROR);
+    }
+
     update_session_ready_from_stage(g_pipeline_stage);
 }
 
@@ -1269,6 +1771,10 @@ const char *websocket_client_pipeline_stage_to_string(websocket_pipeline_stage_t
     return pipeline_stage_to_string(stage);
 }
 
+feedback_prompt_t websocket_client_error_prompt(void) {
+    return g_error_prompt;
+}
+
 // ===========================
 // Helper Functions for WebSocket Reconnection Tasks
 // ===========================
@@ -1292,23 +1798,63 @@ static void websocket_reconnect_task(void *pvParameters) {
     vTaskDelete(NULL); // Self-delete
 }
 
+#if WS_OWN_TRANSPORT
 /**
- * @brief Task to handle delayed WebSocket reconnection
- * 
- * This task waits for a longer delay and then attempts to reconnect
- * to the WebSocket server. It's used after errors to prevent immediate
- * retry loops that can overwhelm the system.
- * 
- * @param pvParameters Not used
+ * @brief Build the ws:// or wss:// transport stack for the server URI
+ *
+ * Keep-alive, path and headers are set on the transport itself, since the
+ * client only applies its config to transports it created. For wss:// the SSL
+ * layer keeps the last session ticket and offers it on the next connect, so a
+ * reconnect costs one round trip instead of a full handshake.
  */
-static void websocket_delayed_reconnect_task(void *pvParameters) {
-    vTaskDelay(pdMS_TO_TICKS(5000)); // Wait 5 seconds before reconnecting
-    websocket_client_connect(); // Attempt reconnection
-    
-    // Reset the global handle since this task is being deleted
-    s_delayed_reconnect_task_handle = NULL;
-    
-    vTaskDelete(NULL); // Self-delete
+static esp_transport_handle_t create_ws_transport(const char *uri, const char *headers) {
+    bool secure = strncmp(uri, "wss://", 6) == 0;
+    const char *host = strstr(uri, "://");
+    const char *path = host != NULL ? strchr(host + 3, '/') : NULL;
+
+    esp_transport_keep_alive_t keep_alive = {
+        .keep_alive_enable = true,
+        .keep_alive_idle = 10,             // Same as the client config below
+        .keep_alive_interval = 5,
+        .keep_alive_count = 3,
+    };
+
+    esp_transport_handle_t parent = secure ? esp_transport_ssl_init() : esp_transport_tcp_init();
+    if (parent == NULL) {
+        return NULL;
+    }
+    if (secure) {
+        esp_transport_set_default_port(parent, 443);
+        esp_transport_ssl_set_keep_alive(parent, &keep_alive);
+#if CONFIG_MBEDTLS_CERTIFICATE_BUNDLE
+        esp_transport_ssl_crt_bundle_attach(parent, esp_crt_bundle_attach);
+#endif
+#if CONFIG_WS_TLS_SESSION_TICKETS && defined(CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS)
+        esp_transport_ssl_session_tickets_enable(parent);
+#endif
+    } else {
+        esp_transport_set_default_port(parent, 80);
+        esp_transport_tcp_set_keep_alive(parent, &keep_alive);
+    }
+
+    esp_transport_handle_t ws = esp_transport_ws_init(parent);
+    if (ws == NULL) {
+        esp_transport_destroy(parent);
+        return NULL;
+    }
+    esp_transport_set_default_port(ws, secure ? 443 : 80);
+
+    esp_transport_ws_config_t ws_config = {
+        .ws_path = path != NULL ? path : "/",
+        .headers = headers,
+    };
+    esp_transport_ws_set_config(ws, &ws_config);
+
+    ESP_LOGI(TAG, "WebSocket transport: %s, TCP_NODELAY %s, TLS tickets %s (%s network profile)",
+             secure ? "wss" : "ws", CONFIG_WS_TCP_NODELAY ? "on" : "off",
+             (secure && CONFIG_WS_TLS_SESSION_TICKETS) ? "on" : "n/a", network_profile_name());
+    return ws;
 }
+#endif
 
 
@@ -89,6 +89,19 @@ esp_err_t websocket_client_send_audio(const uint8_t *data, size_t length, uint32
     return ESP_OK;
 }
 
+esp_err_t websocket_client_submit(const websocket_tx_frame_t *frame, uint32_t timeout_ms) {
+    (void)timeout_ms;
+    if (frame == NULL || frame->payload == NULL || frame->payload_len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ESP_LOGD(TAG, "WebSocket client STUB: would queue %d byte frame",
+             (int)(frame->header_len + frame->payload_len));
+    if (frame->done != NULL) {
+        frame->done(ESP_OK, 0, frame->ctx);
+    }
+    return ESP_OK;
+}
+
 esp_err_t websocket_client_send_text(const char *message) {
     ESP_LOGD(TAG, "WebSocket client STUB: would send text: %s", message);
     return ESP_OK;
@@ -10,17 +10,17 @@ Architecture:
 
 Concurrency Model:
 - Async: WebSocket I/O, Groq API calls
-- Sync (thread pool): Vosk transcription, pyttsx3 synthesis
+- Sync (bounded per-stage thread pools): Vosk transcription, pyttsx3 synthesis
+- Admission control: a turn is refused with "busy" once a stage's backlog is full
 """
 
 import os
-import io
 import json
 import asyncio
 import socket
 import subprocess
-import base64
-from typing import Dict
+from collections import deque
+from typing import AsyncIterator, Iterable, Optional
 from contextlib import asynccontextmanager
 from datetime import datetime
 from fastapi import FastAPI, WebSocket, WebSocketDisconnect, UploadFile, File, Form
@@ -44,38 +44,145 @@ from core.llm_client import (
     init_client, 
     close_client, 
     get_llm_response,
+    stream_llm_sentences,
     clear_session_context
 )
 from core.stt_worker import (
     initialize_vosk_model,
     process_audio_for_transcription,
-    get_model_info
+    get_model_info,
+    StreamingRecognizer
 )
 from core.tts_worker import (
     synthesize_response_audio,
+    synthesize_sentence_pcm,
+    split_sentences,
+    create_streaming_wav_header,
     test_tts_engine,
-    get_available_voices
+    get_available_voices,
+    prewarm_phrases,
+    get_tts_cache_stats,
+    synthesize_pcm,
+    TARGET_SAMPLE_RATE,
+    TARGET_CHANNELS
+)
+from core.audio_codec import (
+    UplinkDecoder,
+    negotiate_codec,
+    supported_codecs
+)
+from core.image_frames import (
+    ImageAssembler,
+    is_image_frame
+)
+from core.image_prep import ImagePreprocessor
+from core.control_frames import (
+    CONTROL_FRAMING_BINARY,
+    encode_ack,
+    encode_prompt_chunks,
+    negotiate_control_framing
+)
+from core.tts_frames import (
+    TTS_FRAMING_FRAMED,
+    TtsFrameWriter,
+    negotiate_tts_framing
+)
+from core.prompt_pack import build_prompt_pack
+from core.session_manager import (
+    Session,
+    SessionManager,
+    SessionLimitError
+)
+from core.stage_executor import (
+    StageExecutor,
+    StageBusyError,
+    default_workers
+)
+from core.turn_metrics import (
+    TurnMetrics,
+    TurnTimer
 )
 
 # Load environment variables
 load_dotenv()
 
-# In-memory session audio buffers
-# Maps session_id -> io.BytesIO buffer containing raw PCM audio
-SESSION_AUDIO_BUFFERS: Dict[str, io.BytesIO] = {}
-
-# Lightweight telemetry for debugging: tracks per-session audio chunks
-SESSION_AUDIO_STATS: Dict[str, Dict[str, int]] = {}
-
-# In-memory session image storage for multimodal context
-# Maps session_id -> base64-encoded JPEG image string
-# Cleared after each conversation turn to prevent stale context
-SESSION_IMAGES: Dict[str, str] = {}
-
 # Server configuration
 SERVER_HOST = os.getenv("SERVER_HOST", "0.0.0.0")
 SERVER_PORT = int(os.getenv("SERVER_PORT", 8000))
 
+# Connected devices allowed at once; further handshakes are closed with 1013 (try again later)
+MAX_SESSIONS = int(os.getenv("MAX_SESSIONS", 64))
+
+# Worker threads per blocking stage (default: one per core each; both engines run in native code)
+STT_WORKERS = int(os.getenv("STT_WORKERS", default_workers()))
+TTS_WORKERS = int(os.getenv("TTS_WORKERS", default_workers()))
+
+# Jobs allowed to wait for a worker before new turns are refused as "busy"
+STT_QUEUE_LIMIT = int(os.getenv("STT_QUEUE_LIMIT", 2 * STT_WORKERS))
+TTS_QUEUE_LIMIT = int(os.getenv("TTS_QUEUE_LIMIT", 2 * TTS_WORKERS))
+
+# Sliding-window flow control: bytes the ESP32 may have in flight before an ACK
+STT_FLOW_WINDOW_BYTES = int(os.getenv("STT_FLOW_WINDOW_BYTES", 32768))
+
+# Binary flow-control ACKs for devices that offer them (0 = always JSON status messages)
+WS_BINARY_CONTROL = os.getenv("WS_BINARY_CONTROL", "1").strip() not in ("0", "false", "no")
+
+# Framed TTS downlink (per-frame format header, explicit segment/end frames) for devices
+# that offer it (0 = always one streaming WAV per reply)
+TTS_FRAMED = os.getenv("TTS_FRAMED", "1").strip() not in ("0", "false", "no")
+
+# Streaming STT: decode audio while it arrives and send partial transcripts (0 = batch on EOS)
+STT_STREAMING = os.getenv("STT_STREAMING", "1").strip() not in ("0", "false", "no")
+
+# Sentence-pipelined TTS: synthesize sentence N+1 while sentence N streams (0 = one WAV per reply)
+TTS_PIPELINED = os.getenv("TTS_PIPELINED", "1").strip() not in ("0", "false", "no")
+
+# Synthesized sentences allowed to wait ahead of the sender (bounds server memory per session)
+TTS_PIPELINE_DEPTH = int(os.getenv("TTS_PIPELINE_DEPTH", 2))
+
+# Token-streaming LLM: feed sentences into pipelined TTS as Groq generates them
+# (requires TTS_PIPELINED; 0 = wait for the full completion first)
+LLM_STREAMING = os.getenv("LLM_STREAMING", "1").strip() not in ("0", "false", "no")
+
+TTS_STREAM_CHUNK_SIZE = 4096  # 4KB chunks, matches the ESP32 receive path
+
+# Spoken when the LLM returns nothing; synthesized at startup so the apology costs no engine run
+FALLBACK_RESPONSE = "I'm sorry, I couldn't generate a response. Please try again."
+
+# Extra fixed replies to prewarm into the TTS phrase cache, separated by "|"
+TTS_PREWARM_PHRASES = [p.strip() for p in os.getenv("TTS_PREWARM_PHRASES", "").split("|") if p.strip()]
+
+# Push spoken error prompts to devices with a flash prompt store (0 = devices keep their tones)
+PROMPT_PACK_ENABLED = os.getenv("PROMPT_PACK", "1").strip() not in ("0", "false", "no")
+
+# Rendered once at startup: (pack bytes, version); version 0 = no pack to offer
+PROMPT_PACK: tuple = (b"", 0)
+
+# Camera profile the device should use for its next capture: "thumbnail" (QVGA) is enough
+# for scene questions and costs far fewer vision tokens; "detail" is for reading text
+IMAGE_CAPTURE_PROFILE = os.getenv("IMAGE_CAPTURE_PROFILE", "standard").strip().lower()
+if IMAGE_CAPTURE_PROFILE not in ("thumbnail", "standard", "detail"):
+    print(f"⚠️ Unknown IMAGE_CAPTURE_PROFILE '{IMAGE_CAPTURE_PROFILE}', using 'standard'")
+    IMAGE_CAPTURE_PROFILE = "standard"
+
+# Uplink codec override (e.g. "pcm16" to disable compression); empty = device preference
+STT_UPLINK_CODEC = os.getenv("STT_UPLINK_CODEC", "").strip().lower() or None
+
+# Per-device connection state and stored captures
+# Images are raw JPEG bytes (base64 is produced only for the LLM request), cleared after each turn
+SESSIONS = SessionManager(MAX_SESSIONS)
+
+# Vision-sized copies of captures, keyed by content hash
+IMAGE_PREP = ImagePreprocessor()
+_IMAGE_PREP_TASKS: set = set()
+
+# Separate pools so a long synthesis for one device never delays another device's transcription
+STT_STAGE = StageExecutor("stt", STT_WORKERS, STT_QUEUE_LIMIT)
+TTS_STAGE = StageExecutor("tts", TTS_WORKERS, TTS_QUEUE_LIMIT)
+
+# End-to-end turn latency (server stages + device reports), served at /metrics
+TURN_METRICS = TurnMetrics()
+
 
 def get_network_info():
     """
@@ -132,6 +239,7 @@ async def lifespan(app: FastAPI):
     Application lifespan context manager.
     Handles startup and shutdown events using modern FastAPI approach.
     """
+    global PROMPT_PACK
     # Startup
     print("\n" + "="*60)
     print("Hotpin Prototype Server Starting...")
@@ -164,13 +272,21 @@ async def lifespan(app: FastAPI):
         print(f"Failed to initialize Vosk model: {e}")
         print("⚠ Server will start but STT functionality will not work")
     
-    # Test pyttsx3 TTS engine
+    # Test pyttsx3 TTS engine, then render the fixed prompts on the TTS stage
     try:
-        test_tts_engine()
+        if test_tts_engine():
+            warmed = await TTS_STAGE.run(prewarm_phrases, [FALLBACK_RESPONSE] + TTS_PREWARM_PHRASES,
+                                         admitted=True)
+            print(f"   TTS phrase cache: {warmed} prompt(s) prewarmed")
+            if PROMPT_PACK_ENABLED:
+                PROMPT_PACK = await TTS_STAGE.run(build_prompt_pack, synthesize_pcm, admitted=True)
+                print(f"   Prompt pack: v{PROMPT_PACK[1]:08x}, {len(PROMPT_PACK[0])} bytes")
     except Exception as e:
         print(f"Failed to test TTS engine: {e}")
         print("⚠ Server will start but TTS functionality may not work")
     
+    print(f"   Sessions: up to {MAX_SESSIONS}; STT workers: {STT_STAGE.workers} (queue {STT_STAGE.queue_limit}), "
+          f"TTS workers: {TTS_STAGE.workers} (queue {TTS_STAGE.queue_limit})")
     print("="*60)
     print(f"Server ready at ws://{SERVER_HOST}:{SERVER_PORT}/ws")
     print("="*60 + "\n")
@@ -185,8 +301,10 @@ async def lifespan(app: FastAPI):
     # Close Groq client
     await close_client()
     
-    # Clear all session data
-    SESSION_AUDIO_BUFFERS.clear()
+    # Clear all session data and stop the stage pools
+    SESSIONS.close_all()
+    STT_STAGE.shutdown()
+    TTS_STAGE.shutdown()
     
     print("All resources cleaned up")
     print("="*60 + "\n")
@@ -214,25 +332,262 @@ async def root():
         "protocol": {
             "handshake": "Send JSON with {session_id: str}",
             "audio_input": "Stream raw PCM audio (16-bit, 16kHz, mono) as binary",
-            "end_of_speech": "Send JSON with {signal: 'EOS'}",
-            "audio_output": "Receive WAV audio chunks as binary"
+            "end_of_speech": "Send JSON with {signal: 'EOS', turn: int}; replies echo the turn",
+            "barge_in": "Send JSON with {signal: 'BARGE_IN'} to cut a reply short",
+            "turn_metrics": "Send JSON with {signal: 'TURN_METRICS', turn: int, ms: {stage: ms}} after a turn",
+            "audio_output": "Receive WAV audio chunks as binary; handshake {tts: 'framed'} gets HPAU frames instead"
         }
     })
 
 
+def prepare_image_async(image_data: bytes) -> None:
+    """Start preprocessing a fresh capture so the voice turn that follows finds it cached."""
+    task = asyncio.create_task(asyncio.to_thread(IMAGE_PREP.prepare, image_data))
+    _IMAGE_PREP_TASKS.add(task)
+    task.add_done_callback(_IMAGE_PREP_TASKS.discard)
+
+
+async def session_image_base64(session_id: str) -> Optional[str]:
+    """Base64 of the stored capture, downscaled for the vision model (cached by content hash)."""
+    image_data = SESSIONS.image(session_id)
+    if not image_data:
+        return None
+    return await asyncio.to_thread(IMAGE_PREP.prepare, image_data)
+
+
+def save_captured_image(session: str, image_data: bytes) -> str:
+    """Write a capture to captured_images/ (blocking, run via asyncio.to_thread)."""
+    os.makedirs("captured_images", exist_ok=True)
+    timestamp = datetime.now().strftime("%Y%m%d_%H%M%S")
+    save_path = f"captured_images/{session}_{timestamp}.jpg"
+    with open(save_path, "wb") as f:
+        f.write(image_data)
+    return save_path
+
+
+async def iterate_sentences(sentences: Iterable[str]) -> AsyncIterator[str]:
+    """Adapt a ready-made sentence list to the async source stream_tts_pipelined() consumes."""
+    for sentence in sentences:
+        yield sentence
+
+
+async def announce_reply_sentences(websocket: WebSocket, session_id: str,
+                                   sentences: AsyncIterator[str], spoken: list,
+                                   timer: Optional[TurnTimer] = None) -> AsyncIterator[str]:
+    """
+    Pass LLM sentences through to the TTS pipeline, recording them in spoken.
+
+    The "tts" stage is announced with the first sentence, while the LLM is still
+    generating, so the device starts its decoder before the first audio byte
+    arrives. It runs in the TTS producer before any audio is queued, so it never
+    races the audio sender on the socket.
+    """
+    try:
+        async for sentence in sentences:
+            if not spoken:
+                print(f"🤖 [{session_id}] First LLM sentence: \"{sentence}\"")
+                message = {
+                    "status": "processing",
+                    "stage": "tts",
+                    "response": sentence,
+                    "llm_streaming": True
+                }
+                if timer is not None:
+                    timer.mark("llm_first")
+                    timer.stamp(message)
+                if websocket.client_state.value == 1:
+                    await websocket.send_text(json.dumps(message))
+            spoken.append(sentence)
+            yield sentence
+    finally:
+        # Closing early (disconnect) must also close the Groq stream underneath
+        await sentences.aclose()
+
+
+class BargeInWatch:
+    """
+    Read the socket while a reply is generated and streamed.
+
+    The endpoint loop is busy sending audio then, so without this a
+    {"signal": "BARGE_IN"} from a full-duplex device would sit unread until the
+    reply had finished. Every other message is handed back through `deferred`
+    in arrival order for the endpoint loop to process next.
+    """
+
+    def __init__(self, websocket: WebSocket, session_id: str, deferred: deque):
+        self.websocket = websocket
+        self.session_id = session_id
+        self.deferred = deferred
+        self.stop = asyncio.Event()     # Set on barge-in or disconnect
+        self.barged_in = False
+        self._task: Optional[asyncio.Task] = None
+
+    def start(self) -> None:
+        self._task = asyncio.create_task(self._watch())
+
+    async def close(self) -> None:
+        if self._task is None:
+            return
+        self._task.cancel()
+        try:
+            await self._task
+        except (asyncio.CancelledError, Exception):
+            pass
+        self._task = None
+
+    async def _watch(self) -> None:
+        while True:
+            message = await self.websocket.receive()
+            if message.get("type") == "websocket.disconnect":
+                self.deferred.append(message)
+                self.stop.set()
+                return
+            text = message.get("text")
+            if text:
+                try:
+                    signal = json.loads(text).get("signal")
+                except (ValueError, AttributeError):
+                    signal = None
+                if signal == "BARGE_IN":
+                    print(f"✋ [{self.session_id}] Barge-in: user spoke over the reply")
+                    self.barged_in = True
+                    self.stop.set()
+                    continue
+            self.deferred.append(message)
+
+
+async def stream_tts_pipelined(websocket: WebSocket, session_id: str,
+                               sentences: AsyncIterator[str],
+                               stop: Optional[asyncio.Event] = None,
+                               timer: Optional[TurnTimer] = None,
+                               frames: Optional[TtsFrameWriter] = None) -> int:
+    """
+    Synthesize and stream a reply sentence by sentence.
+
+    A producer task renders each sentence to PCM on the TTS stage while the
+    consumer streams the previous one, so time-to-first-audio is bounded by the
+    first sentence rather than the whole reply. The device sees one streaming WAV
+    header (unknown length) followed by continuous PCM, exactly like a single WAV;
+    with `frames` (framed downlink) each sentence goes out as AUDIO frames
+    followed by a FLUSH, and no WAV header is sent. Streaming ends early once `stop` is set (barge-in). `timer` gets the
+    "first_audio" mark as the first audio frame goes out.
+
+    Returns:
+        int: Bytes streamed (header included); 0 if nothing could be synthesized
+    """
+    queue: asyncio.Queue = asyncio.Queue(maxsize=max(1, TTS_PIPELINE_DEPTH))
+
+    async def produce() -> None:
+        index = 0
+        try:
+            async for sentence in sentences:
+                index += 1
+                try:
+                    # The turn passed admission at EOS; its remaining sentences are not refused
+                    pcm = await TTS_STAGE.run(synthesize_sentence_pcm, sentence, admitted=True)
+                except Exception as synth_error:
+                    print(f"⚠ [{session_id}] TTS sentence {index} failed, skipping: {synth_error}")
+                    continue
+                if pcm:
+                    await queue.put((index, pcm))
+        finally:
+            aclose = getattr(sentences, "aclose", None)
+            if aclose is not None:
+                await aclose()
+            await queue.put(None)
+
+    producer = asyncio.create_task(produce())
+    total_bytes = 0
+    total_chunks = 0
+    header_sent = False
+
+    try:
+        while True:
+            item = await queue.get()
+            if item is None or (stop is not None and stop.is_set()):
+                break
+            index, pcm = item
+
+            if websocket.client_state.value != 1:
+                print(f"⚠ [{session_id}] WebSocket disconnected during audio streaming")
+                break
+
+            if not header_sent:
+                # Header rides in the first frame, as it did with a complete WAV file
+                if frames is None:
+                    pcm = create_streaming_wav_header() + pcm
+                header_sent = True
+                print(f"🔊 [{session_id}] First audio ready (sentence {index}), streaming...")
+                if timer is not None:
+                    timer.mark("first_audio")
+
+            if frames is not None:
+                chunks = list(frames.audio(pcm, TARGET_SAMPLE_RATE, TARGET_CHANNELS))
+                # Sentence boundary: the device may start playing below its prebuffer target
+                chunks.append(frames.flush())
+            else:
+                chunks = [pcm[i:i + TTS_STREAM_CHUNK_SIZE] for i in range(0, len(pcm), TTS_STREAM_CHUNK_SIZE)]
+
+            for chunk in chunks:
+                if websocket.client_state.value != 1 or (stop is not None and stop.is_set()):
+                    break
+                await websocket.send_bytes(chunk)
+                total_chunks += 1
+                await asyncio.sleep(0.005)  # 5ms between audio chunks
+            total_bytes += len(pcm)
+    finally:
+        if not producer.done():
+            producer.cancel()
+        try:
+            await producer
+        except (asyncio.CancelledError, Exception):
+            pass
+
+    print(f"✓ [{session_id}] Streamed {total_chunks} audio chunks ({total_bytes} bytes, pipelined)")
+    return total_bytes
+
+
 @app.get("/health")
 async def health_check():
     """
     Health check endpoint
+
+    "stages" reports each worker pool's queue depth and recent queue-wait /
+    run latency, so a load balancer or the fleet dashboard can see which
+    stage is the bottleneck before devices start getting "busy" errors.
     """
     model_info = get_model_info()
+    session_stats = SESSIONS.stats()
+    busy = STT_STAGE.saturated() or TTS_STAGE.saturated()
     return JSONResponse({
-        "status": "healthy",
+        "status": "busy" if busy else "healthy",
         "vosk_model_loaded": model_info["model_loaded"],
-        "active_sessions": len(SESSION_AUDIO_BUFFERS)
+        "active_sessions": session_stats["active"],
+        "sessions": session_stats,
+        "stages": {
+            "stt": STT_STAGE.stats(),
+            "tts": TTS_STAGE.stats()
+        },
+        "tts_cache": get_tts_cache_stats(),
+        "image_cache": IMAGE_PREP.stats(),
+        "prompt_pack": {"version": PROMPT_PACK[1], "bytes": len(PROMPT_PACK[0])},
+        "uplink_codecs": supported_codecs()
     })
 
 
+@app.get("/metrics")
+async def turn_metrics():
+    """
+    End-to-end turn latency percentiles
+
+    "server.*" stages are timed from EOS receipt on this server; "device.*"
+    stages come from the devices' TURN_METRICS reports, timed from the end of
+    speech on the device ("device.first_sample" is the full silence the user
+    hears). Percentiles cover the last TURN_METRICS_WINDOW turns.
+    """
+    return JSONResponse(TURN_METRICS.snapshot())
+
+
 @app.get("/voices")
 async def list_voices():
     """
@@ -267,25 +622,13 @@ async def upload_image(
         
         print(f"📷 [{session}] Image received: {file.filename}, {image_size} bytes ({image_size/1024:.2f} KB)")
         
-        # Convert to base64 for multimodal LLM context
-        base64_image = base64.b64encode(image_data).decode('utf-8')
-        
-        # Store in session context for next audio interaction
-        SESSION_IMAGES[session] = base64_image
-        print(f"🖼️ [{session}] Image stored in session context (base64 size: {len(base64_image)} chars)")
+        # Store raw JPEG in session context for next audio interaction (base64 on use)
+        SESSIONS.store_image(session, image_data)
+        prepare_image_async(image_data)
+        print(f"🖼️ [{session}] Image stored in session context")
         
         # Optional: Save image to disk
-        
-        # Create images directory if it doesn't exist
-        os.makedirs("captured_images", exist_ok=True)
-        
-        # Generate filename with timestamp
-        timestamp = datetime.now().strftime("%Y%m%d_%H%M%S")
-        save_path = f"captured_images/{session}_{timestamp}.jpg"
-        
-        with open(save_path, "wb") as f:
-            f.write(image_data)
-        
+        save_path = await asyncio.to_thread(save_captured_image, session, image_data)
         print(f"💾 [{session}] Image saved: {save_path}")
         
         return JSONResponse({
@@ -316,20 +659,35 @@ async def websocket_endpoint(websocket: WebSocket):
     
     Protocol Flow:
     1. Client connects and sends JSON handshake with session_id
-    2. Client streams binary PCM audio chunks (16-bit, 16kHz, mono)
-    3. Client sends JSON with {"signal": "EOS"} to indicate end of speech
+    2. Client streams binary PCM audio chunks (16-bit, 16kHz, mono); binary frames
+       starting with the "HPIM" image header carry a camera capture instead
+    3. Client sends JSON with {"signal": "EOS", "turn": N} to indicate end of speech
+       (stage messages for that turn echo "turn"; the device reports its own stage
+       times afterwards with {"signal": "TURN_METRICS"}, aggregated at GET /metrics)
     4. Server processes: STT -> LLM -> TTS
-    5. Server streams binary WAV audio response in chunks
-    6. Loop continues until client disconnects
+    5. Server streams binary WAV audio response in chunks; if the handshake offered
+       "control": "binary", flow-control ACKs are "HPCT" binary frames instead of JSON;
+       if it offered "tts": "framed", audio arrives as "HPAU" frames (format header per
+       frame, FLUSH after each sentence, END instead of the zero-length marker)
+    6. A full-duplex client may send {"signal": "BARGE_IN"} while the reply plays;
+       streaming stops and {"status": "interrupted"} replaces the end-of-audio
+       marker and "complete", after which the client uploads its next utterance
+    7. Loop continues until client disconnects
     
     Concurrency:
     - WebSocket I/O: async (non-blocking)
-    - STT processing: sync in thread pool (via asyncio.to_thread)
+    - STT processing: bounded STT stage; a streaming session's audio batches and
+      final flush run there one at a time, in order (or the whole batch decode)
     - LLM API call: async (non-blocking)
-    - TTS synthesis: sync in thread pool (via asyncio.to_thread)
+    - TTS synthesis: bounded TTS stage, shared fairly by all sessions
+    - A turn that arrives while either stage's backlog is full gets an "error"
+      with error_type "busy" instead of queueing behind other devices
     """
     session_id = None
+    session: Optional[Session] = None
+    image_assembler = ImageAssembler()
     last_activity_time = asyncio.get_event_loop().time()
+    deferred_messages: deque = deque()  # Received by BargeInWatch during a reply
     audio_streaming_timeout = 180.0  # 3 minutes max for audio streaming phase (allows time for user to think/speak)
     
     try:
@@ -349,31 +707,85 @@ async def websocket_endpoint(websocket: WebSocket):
             await websocket.close(code=1008, reason="Missing session_id in handshake")
             return
         
-        print(f"Session initialized: {session_id}")
+        # Negotiate the uplink codec (legacy devices send no "codecs" and get pcm16)
+        uplink_codec = negotiate_codec(handshake_data.get("codecs"), STT_UPLINK_CODEC)
+        control_framing = negotiate_control_framing(handshake_data.get("control"), WS_BINARY_CONTROL)
+        binary_control = control_framing == CONTROL_FRAMING_BINARY
+        tts_framing = negotiate_tts_framing(handshake_data.get("tts"), TTS_FRAMED)
+        
+        # Register the connection; a reconnect replaces its own stale entry
+        try:
+            session = SESSIONS.attach(Session(session_id, decoder=UplinkDecoder(uplink_codec)))
+        except SessionLimitError as limit_error:
+            print(f"🚫 [{session_id}] Refusing connection: {limit_error}")
+            await websocket.send_text(json.dumps({
+                "status": "error",
+                "message": "Server is at capacity. Please try again later.",
+                "error_type": "busy"
+            }))
+            await websocket.close(code=1013, reason="Server at capacity")
+            session_id = None
+            return
+        print(f"Session initialized: {session_id} (uplink codec: {uplink_codec}, control: {control_framing}, tts: {tts_framing})")
         
-        # Initialize audio buffer for this session
-        SESSION_AUDIO_BUFFERS[session_id] = io.BytesIO()
-        SESSION_AUDIO_STATS[session_id] = {"chunks": 0, "bytes": 0}
+        if STT_STREAMING:
+            loop = asyncio.get_running_loop()
+
+            def send_partial(text: str, ws=websocket, sid=session_id) -> None:
+                # Runs on an STT stage worker: hop onto the event loop to send
+                async def _send():
+                    try:
+                        if ws.client_state.value == 1:
+                            await ws.send_text(json.dumps({"status": "partial", "transcript": text}))
+                    except Exception as partial_error:
+                        print(f"⚠ [{sid}] Could not send partial transcript: {partial_error}")
+                asyncio.run_coroutine_threadsafe(_send(), loop)
+
+            try:
+                session.recognizer = StreamingRecognizer(session_id, STT_STAGE, on_partial=send_partial)
+            except RuntimeError as recognizer_error:
+                # No usable Vosk model: keep the session and transcribe at EOS instead
+                print(f"⚠ [{session_id}] Streaming STT unavailable, using batch transcription: {recognizer_error}")
+                session.recognizer = None
+        session.reset_audio()
         
         # Send acknowledgment
         await websocket.send_text(json.dumps({
             "status": "connected",
-            "session_id": session_id
+            "session_id": session_id,
+            "flow_window": STT_FLOW_WINDOW_BYTES,
+            "codec": uplink_codec,
+            "control": control_framing,
+            "tts": tts_framing,
+            "capture_profile": IMAGE_CAPTURE_PROFILE,
+            "prompt_pack": PROMPT_PACK[1]
         }))
         
+        # Devices report the prompt pack they hold; send ours when it differs.
+        # Chunks ride binary control frames, so JSON-only devices never see them.
+        pack_bytes, pack_version = PROMPT_PACK
+        device_pack = handshake_data.get("prompt_pack")
+        if binary_control and pack_version and isinstance(device_pack, int) and device_pack != pack_version:
+            for frame in encode_prompt_chunks(pack_bytes, pack_version):
+                await websocket.send_bytes(frame)
+            print(f"🗣️ [{session_id}] Pushed prompt pack v{pack_version:08x} ({len(pack_bytes)} bytes, device had v{device_pack:08x})")
+        
         # Main communication loop
         while True:
             # Receive message with timeout to detect stale connections
             try:
-                message = await asyncio.wait_for(
-                    websocket.receive(),
-                    timeout=audio_streaming_timeout
-                )
+                if deferred_messages:
+                    message = deferred_messages.popleft()
+                else:
+                    message = await asyncio.wait_for(
+                        websocket.receive(),
+                        timeout=audio_streaming_timeout
+                    )
                 last_activity_time = asyncio.get_event_loop().time()
             except asyncio.TimeoutError:
                 # Check if we have pending audio data
-                if SESSION_AUDIO_BUFFERS.get(session_id) and SESSION_AUDIO_BUFFERS[session_id].tell() > 0:
-                    print(f"⏱️ [{session_id}] Streaming timeout with {SESSION_AUDIO_BUFFERS[session_id].tell()} bytes buffered - auto-processing")
+                if session.pcm_bytes() > 0:
+                    print(f"⏱️ [{session_id}] Streaming timeout with {session.pcm_bytes()} bytes buffered - auto-processing")
                     # Auto-trigger EOS processing
                     signal_data = {"signal": "EOS"}
                     message = {"text": json.dumps(signal_data)}
@@ -381,7 +793,7 @@ async def websocket_endpoint(websocket: WebSocket):
                     # ✅ CRITICAL FIX: Don't close connection or clear image context on idle timeout
                     # The device may have captured an image and is waiting for user to speak
                     # Keep connection alive and preserve image context for multimodal queries
-                    if session_id in SESSION_IMAGES:
+                    if SESSIONS.has_image(session_id):
                         print(f"⏱️ [{session_id}] Connection idle but image context present - keeping alive")
                         # Keep waiting for voice input
                         continue
@@ -397,61 +809,94 @@ async def websocket_endpoint(websocket: WebSocket):
                 print(f"🔌 [{session_id}] WebSocket disconnect received (code={code}, reason={reason})")
                 break
             
+            # Binary image frames share the socket with audio; the header tells them apart
+            if "bytes" in message and is_image_frame(message["bytes"]):
+                try:
+                    image_data = image_assembler.feed(message["bytes"])
+                except ValueError as frame_error:
+                    print(f"⚠️ [{session_id}] Dropping partial image: {frame_error}")
+                    continue
+                if image_data is None:
+                    continue
+
+                SESSIONS.store_image(session_id, image_data)
+                prepare_image_async(image_data)
+                print(f"📷 [{session_id}] Image received over WebSocket: {len(image_data)} bytes ({len(image_data)/1024:.2f} KB)")
+                save_path = await asyncio.to_thread(save_captured_image, session_id, image_data)
+                print(f"💾 [{session_id}] Image saved: {save_path}")
+                if websocket.client_state.value == 1:
+                    await websocket.send_text(json.dumps({
+                        "status": "image_received",
+                        "size_bytes": len(image_data),
+                        "context_ready": True,
+                        "capture_profile": IMAGE_CAPTURE_PROFILE
+                    }))
+
             # Handle binary audio data
-            if "bytes" in message:
+            elif "bytes" in message:
                 audio_chunk = message["bytes"]
                 
-                # Append to session buffer (with safe access in case of race condition)
-                buffer = SESSION_AUDIO_BUFFERS.get(session_id)
-                if buffer is None:
-                    print(f"⚠️ [{session_id}] Session buffer not found - possible race condition, reinitializing")
-                    SESSION_AUDIO_BUFFERS[session_id] = io.BytesIO()
-                    SESSION_AUDIO_STATS[session_id] = {"chunks": 0, "bytes": 0}
-                    buffer = SESSION_AUDIO_BUFFERS[session_id]
-                
-                buffer.write(audio_chunk)
-                stats = SESSION_AUDIO_STATS.get(session_id)
+                # Decode to PCM16 before buffering; stats/ACKs count wire bytes for flow control.
+                # The audioop-backed ADPCM path is cheap enough for the loop; Opus and the
+                # pure-Python fallback go to a thread so one device can't stall the others
+                decoder = session.decoder
+                if decoder is None:
+                    pcm_chunk = audio_chunk
+                elif decoder.blocking:
+                    pcm_chunk = await asyncio.to_thread(decoder.decode, audio_chunk)
+                else:
+                    pcm_chunk = decoder.decode(audio_chunk)
+                if session.recognizer is not None:
+                    # Streaming STT: Vosk decodes on its worker while the device keeps talking
+                    session.recognizer.feed(pcm_chunk)
+                else:
+                    session.audio_buffer.write(pcm_chunk)
+                stats = session.stats
                 if stats is not None:
                     stats["chunks"] += 1
                     stats["bytes"] += len(audio_chunk)
+                    stats["pcm_bytes"] = stats.get("pcm_bytes", 0) + len(pcm_chunk)
                     if stats["chunks"] <= 5 or (stats["chunks"] % 25) == 0:
                         print(
                             f"🔊 [{session_id}] Audio chunk {stats['chunks']}: "
-                            f"{len(audio_chunk)} bytes (total streamed: {stats['bytes']})"
+                            f"{len(audio_chunk)} bytes -> {len(pcm_chunk)} PCM (total streamed: {stats['bytes']})"
                         )
                     
-                    # CRITICAL FIX: Send acknowledgment every 2 chunks for aggressive flow control
-                    # This provides backpressure feedback to ESP32 to prevent send buffer saturation
-                    # More frequent ACKs = better flow control at cost of slightly more overhead
-                    if (stats["chunks"] % 2) == 0:
-                        try:
-                            # Check if WebSocket is still connected before sending ACK
-                            if websocket.client_state.value == 1:  # 1 = CONNECTED state
+                    # Sliding-window flow control: ACK every chunk with cumulative bytes and
+                    # the current window so the ESP32 can keep the pipe full without
+                    # overrunning its TCP send buffer
+                    try:
+                        # Check if WebSocket is still connected before sending ACK
+                        if websocket.client_state.value == 1:  # 1 = CONNECTED state
+                            if binary_control:
+                                # 20-byte frame the device decodes without a JSON parse
+                                await websocket.send_bytes(encode_ack(
+                                    stats["chunks"], stats["bytes"], STT_FLOW_WINDOW_BYTES
+                                ))
+                            else:
                                 await websocket.send_text(json.dumps({
                                     "status": "receiving",
                                     "chunks_received": stats["chunks"],
-                                    "bytes_received": stats["bytes"]
+                                    "bytes_received": stats["bytes"],
+                                    "window_bytes": STT_FLOW_WINDOW_BYTES
                                 }))
-                                # Add small delay to prevent overwhelming the client with rapid ACKs
-                                await asyncio.sleep(0.01)  # 10ms breathing room
-                                # Reduced logging frequency to avoid spam
-                                if (stats["chunks"] % 10) == 0:
-                                    print(f"✓ [{session_id}] Sent acknowledgment at chunk {stats['chunks']}")
-                            else:
-                                print(f"⚠ [{session_id}] WebSocket disconnected, skipping ACK for chunk {stats['chunks']}")
-                                # Connection broken, abort audio reception
-                                break
-                        except Exception as ack_error:
-                            print(f"⚠ [{session_id}] Failed to send acknowledgment: {ack_error}")
-                            # Connection likely broken, abort gracefully
-                            print(f"   Connection state: {websocket.client_state}")
+                            # Reduced logging frequency to avoid spam
+                            if (stats["chunks"] % 10) == 0:
+                                print(f"✓ [{session_id}] Sent acknowledgment at chunk {stats['chunks']}")
+                        else:
+                            print(f"⚠ [{session_id}] WebSocket disconnected, skipping ACK for chunk {stats['chunks']}")
+                            # Connection broken, abort audio reception
                             break
+                    except Exception as ack_error:
+                        print(f"⚠ [{session_id}] Failed to send acknowledgment: {ack_error}")
+                        # Connection likely broken, abort gracefully
+                        print(f"   Connection state: {websocket.client_state}")
+                        break
                 
-                # Optional: Send progress indicator (defensive check for race conditions)
-                if session_id in SESSION_AUDIO_BUFFERS:
-                    buffer_size = SESSION_AUDIO_BUFFERS[session_id].tell()
-                    if buffer_size % 32000 == 0:  # Every ~1 second at 16kHz
-                        print(f"📊 [{session_id}] Buffer: {buffer_size} bytes (~{buffer_size/32000:.1f}s)")
+                # Optional: Send progress indicator
+                buffer_size = session.pcm_bytes()
+                if buffer_size % 32000 == 0:  # Every ~1 second at 16kHz
+                    print(f"📊 [{session_id}] Buffer: {buffer_size} bytes (~{buffer_size/32000:.1f}s)")
             
             # Handle text signals (EOS, commands, etc.)
             elif "text" in message:
@@ -461,149 +906,218 @@ async def websocket_endpoint(websocket: WebSocket):
                 if signal_type == "EOS":
                     print(f"🎤 [{session_id}] End-of-speech signal received")
                     
-                    # Extract buffered PCM audio (with defensive check for race conditions)
-                    if session_id not in SESSION_AUDIO_BUFFERS:
-                        print(f"⚠️ [{session_id}] Audio buffer not found (race condition), reinitializing")
-                        SESSION_AUDIO_BUFFERS[session_id] = io.BytesIO()
-                        SESSION_AUDIO_STATS[session_id] = {"chunks": 0, "bytes": 0}
-                    
-                    pcm_data = SESSION_AUDIO_BUFFERS[session_id].getvalue()
+                    pcm_length = session.pcm_bytes()
+                    recognizer = session.recognizer
                     
-                    if len(pcm_data) == 0:
+                    if pcm_length == 0:
                         print(f"⚠ [{session_id}] Empty audio buffer, skipping processing")
                         # Reset buffer
-                        SESSION_AUDIO_BUFFERS[session_id] = io.BytesIO()
-                        SESSION_AUDIO_STATS[session_id] = {"chunks": 0, "bytes": 0}
+                        session.reset_audio()
                         continue
                     
-                    print(f"🔄 [{session_id}] Processing {len(pcm_data)} bytes of audio...")
+                    print(f"🔄 [{session_id}] Processing {pcm_length} bytes of audio "
+                          f"({'streaming' if recognizer is not None else 'batch'} STT)...")
                     
+                    # Stage clock for this turn; replies carry the device's turn id back
+                    timer = TurnTimer(session_id, signal_data.get("turn"))
+                    watch = BargeInWatch(websocket, session_id, deferred_messages)
+                    # Framed downlink: sequence numbers restart with every reply
+                    frames = TtsFrameWriter(TARGET_SAMPLE_RATE, TARGET_CHANNELS) if tts_framing == TTS_FRAMING_FRAMED else None
                     try:
                         # Send processing indicator (check connection first)
                         if websocket.client_state.value == 1:  # 1 = CONNECTED
-                            await websocket.send_text(json.dumps({
+                            await websocket.send_text(json.dumps(timer.stamp({
                                 "status": "processing",
                                 "stage": "transcription"
-                            }))
+                            })))
                             await asyncio.sleep(0.01)  # Small delay between sends
                         else:
                             print(f"⚠ [{session_id}] WebSocket disconnected before processing - aborting")
                             continue
                         
-                        # Step 2: STT - Transcribe audio (blocking, run in thread pool)
-                        transcript = await asyncio.to_thread(
-                            process_audio_for_transcription,
-                            session_id,
-                            pcm_data
-                        )
+                        # Admission: refuse the turn now rather than leave the device waiting
+                        # behind every other session's synthesis
+                        TTS_STAGE.admit()
+
+                        # Step 2: STT - streaming mode only flushes the last frames; batch mode
+                        # decodes the whole buffer (both blocking, run on the STT stage)
+                        if recognizer is not None:
+                            transcript = await recognizer.finish()
+                        else:
+                            transcript = await STT_STAGE.run(
+                                process_audio_for_transcription,
+                                session_id,
+                                session.audio_buffer.getvalue()
+                            )
+                        timer.mark("stt")
                         
                         if not transcript or transcript.strip() == "":
                             print(f"⚠ [{session_id}] Empty transcription")
+                            timer.result = "not_understood"
                             if websocket.client_state.value == 1:  # Check connection before sending
-                                await websocket.send_text(json.dumps({
+                                await websocket.send_text(json.dumps(timer.stamp({
                                     "status": "error",
                                     "message": "Could not understand audio. Please try again."
-                                }))
+                                })))
                                 await asyncio.sleep(0.01)
                             # Reset buffer
-                            SESSION_AUDIO_BUFFERS[session_id] = io.BytesIO()
+                            session.reset_audio()
                             continue
                         
                         print(f"📝 [{session_id}] Transcript: \"{transcript}\"")
                         
                         # Check for stored image context
-                        image_context = SESSION_IMAGES.get(session_id)
+                        image_context = await session_image_base64(session_id)
                         if image_context:
                             print(f"🖼️ [{session_id}] Using stored image context for LLM request (base64 length: {len(image_context)})")
                         else:
                             print(f"ℹ️ [{session_id}] No image context found for this session")
-                            print(f"   Available sessions with images: {list(SESSION_IMAGES.keys())}")
+                            print(f"   Available sessions with images: {SESSIONS.image_sessions()}")
                         
+                        # Keep reading the socket from here on so a barge-in is seen mid-reply
+                        watch.start()
+
                         # Send transcript to client (optional feedback)
                         if websocket.client_state.value == 1:
-                            await websocket.send_text(json.dumps({
+                            await websocket.send_text(json.dumps(timer.stamp({
                                 "status": "processing",
                                 "stage": "llm",
                                 "transcript": transcript,
                                 "has_image": image_context is not None
-                            }))
+                            })))
                             await asyncio.sleep(0.01)
                         
-                        # Step 3: LLM - Get response (async, non-blocking) with optional image
-                        llm_response = await get_llm_response(session_id, transcript, image_base64=image_context)
+                        if TTS_PIPELINED and LLM_STREAMING:
+                            # Step 3-5: LLM tokens -> sentences -> TTS -> device, overlapped.
+                            # "llm" was announced above; "tts" follows with the first sentence.
+                            spoken: list = []
+                            sentence_source = announce_reply_sentences(
+                                websocket, session_id,
+                                stream_llm_sentences(session_id, transcript, image_base64=image_context),
+                                spoken,
+                                timer=timer
+                            )
+                            streamed = await stream_tts_pipelined(websocket, session_id, sentence_source,
+                                                                  stop=watch.stop, timer=timer, frames=frames)
+                            llm_response = " ".join(spoken)
+                            print(f"🤖 [{session_id}] LLM response: \"{llm_response}\"")
+
+                            if image_context:
+                                SESSIONS.clear_image(session_id)
+                                print(f"🗑️ [{session_id}] Cleared image context after use")
+
+                            if streamed == 0 and websocket.client_state.value == 1 and not watch.barged_in:
+                                raise RuntimeError("TTS produced no audio for the streamed LLM response")
+                        else:
+                            # Step 3: LLM - Get response (async, non-blocking) with optional image
+                            llm_response = await get_llm_response(session_id, transcript, image_base64=image_context)
+                            timer.mark("llm_first")
                         
-                        print(f"🤖 [{session_id}] LLM response: \"{llm_response}\"")
+                            print(f"🤖 [{session_id}] LLM response: \"{llm_response}\"")
                         
-                        # Clear image context after use to prevent stale context
-                        if image_context:
-                            del SESSION_IMAGES[session_id]
-                            print(f"🗑️ [{session_id}] Cleared image context after use")
+                            # Clear image context after use to prevent stale context
+                            if image_context:
+                                SESSIONS.clear_image(session_id)
+                                print(f"🗑️ [{session_id}] Cleared image context after use")
                         
-                        # Validate LLM response before TTS synthesis
-                        if not llm_response or llm_response.strip() == "":
-                            print(f"⚠ [{session_id}] Empty LLM response, using fallback message")
-                            llm_response = "I'm sorry, I couldn't generate a response. Please try again."
+                            # Validate LLM response before TTS synthesis
+                            if not llm_response or llm_response.strip() == "":
+                                print(f"⚠ [{session_id}] Empty LLM response, using fallback message")
+                                llm_response = FALLBACK_RESPONSE
                         
-                        # Send LLM response text (optional feedback)
-                        if websocket.client_state.value == 1:
-                            await websocket.send_text(json.dumps({
-                                "status": "processing",
-                                "stage": "tts",
-                                "response": llm_response
-                            }))
-                            await asyncio.sleep(0.01)
-                        else:
-                            print(f"⚠ [{session_id}] WebSocket disconnected during LLM response")
-                            # Continue to cleanup section
+                            # Send LLM response text (optional feedback)
+                            if websocket.client_state.value == 1:
+                                await websocket.send_text(json.dumps(timer.stamp({
+                                    "status": "processing",
+                                    "stage": "tts",
+                                    "response": llm_response
+                                })))
+                                await asyncio.sleep(0.01)
+                            else:
+                                print(f"⚠ [{session_id}] WebSocket disconnected during LLM response")
+                                # Continue to cleanup section
                         
-                        # Step 4: TTS - Synthesize COMPLETE audio in ONE WAV file
-                        # CRITICAL FIX: Generate one continuous WAV instead of multiple WAV files per sentence
-                        # The ESP32 TTS decoder expects a single WAV header followed by PCM data,
-                        # not multiple concatenated WAV files (which would have multiple headers)
-                        print(f"🔊 [{session_id}] Synthesizing complete audio response...")
-                        wav_bytes = await asyncio.to_thread(
-                            synthesize_response_audio,
-                            llm_response  # Send FULL response, not sentence-by-sentence
-                        )
+                            if TTS_PIPELINED:
+                                # Step 4+5: TTS - pipelined per sentence behind a single streaming WAV header
+                                sentences = split_sentences(llm_response)
+                                print(f"🔊 [{session_id}] Pipelining TTS over {len(sentences)} sentence(s)...")
+                                streamed = await stream_tts_pipelined(websocket, session_id, iterate_sentences(sentences),
+                                                                      stop=watch.stop, timer=timer, frames=frames)
+                                if streamed == 0 and websocket.client_state.value == 1 and not watch.barged_in:
+                                    raise RuntimeError("TTS produced no audio for any sentence")
+                            else:
+                                # Step 4: TTS - Synthesize COMPLETE audio in ONE WAV file
+                                # CRITICAL FIX: Generate one continuous WAV instead of multiple WAV files per sentence
+                                # The ESP32 TTS decoder expects a single WAV header followed by PCM data,
+                                # not multiple concatenated WAV files (which would have multiple headers)
+                                print(f"🔊 [{session_id}] Synthesizing complete audio response...")
+                                wav_bytes = await TTS_STAGE.run(
+                                    synthesize_pcm if frames is not None else synthesize_response_audio,
+                                    llm_response,  # Send FULL response, not sentence-by-sentence
+                                    admitted=True
+                                )
                         
-                        print(f"🔊 [{session_id}] Streaming {len(wav_bytes)} bytes of audio response...")
+                                print(f"🔊 [{session_id}] Streaming {len(wav_bytes)} bytes of audio response...")
                         
-                        # Step 5: Stream audio response in chunks (async)
-                        chunk_size = 4096  # 4KB chunks
-                        total_chunks = 0
-                        for i in range(0, len(wav_bytes), chunk_size):
-                            # Check connection before each chunk
-                            if websocket.client_state.value != 1:
-                                print(f"⚠ [{session_id}] WebSocket disconnected during audio streaming")
-                                break
-                            chunk = wav_bytes[i:i + chunk_size]
-                            await websocket.send_bytes(chunk)
-                            total_chunks += 1
-                            # Small delay between chunks to prevent overwhelming client
-                            await asyncio.sleep(0.005)  # 5ms between audio chunks
+                                # Step 5: Stream audio response in chunks (async)
+                                chunk_size = 4096  # 4KB chunks
+                                if frames is not None:
+                                    # Headerless PCM, one AUDIO frame per chunk
+                                    chunks = list(frames.audio(wav_bytes, TARGET_SAMPLE_RATE, TARGET_CHANNELS))
+                                else:
+                                    chunks = [wav_bytes[i:i + chunk_size] for i in range(0, len(wav_bytes), chunk_size)]
+                                total_chunks = 0
+                                for chunk in chunks:
+                                    # Check connection before each chunk
+                                    if websocket.client_state.value != 1:
+                                        print(f"⚠ [{session_id}] WebSocket disconnected during audio streaming")
+                                        break
+                                    if watch.stop.is_set():
+                                        break
+                                    timer.mark("first_audio")
+                                    await websocket.send_bytes(chunk)
+                                    total_chunks += 1
+                                    # Small delay between chunks to prevent overwhelming client
+                                    await asyncio.sleep(0.005)  # 5ms between audio chunks
                         
-                        print(f"✓ [{session_id}] Streamed {total_chunks} audio chunks ({len(wav_bytes)} bytes)")
+                                print(f"✓ [{session_id}] Streamed {total_chunks} audio chunks ({len(wav_bytes)} bytes)")
                         
-                        # CRITICAL FIX: Wait for all audio chunks to be buffered on client side
-                        # before sending completion signal. This prevents race condition where
-                        # "complete" message arrives before all audio bytes are received.
-                        await asyncio.sleep(0.2)  # 200ms buffer time for network/processing
+                        # No settle delay before EOS: frames on one WebSocket arrive in order, and
+                        # the ESP32 jitter buffer plays out whatever is still queued after EOS
                         
+                        # The watcher must not hold a pending receive once the loop reads again
+                        await watch.close()
+
                         # Send end-of-audio marker and completion signal
                         # Wrap in try-except to handle client disconnection gracefully
                         try:
-                            # Send end-of-audio marker (zero-length binary frame)
+                            if watch.barged_in:
+                                # The device already stopped playback and is capturing the next turn
+                                timer.result = "interrupted"
+                                if websocket.client_state.value == 1:
+                                    await websocket.send_text(json.dumps(timer.stamp({"status": "interrupted"})))
+                                print(f"✋ [{session_id}] Reply interrupted, waiting for the next utterance")
+                                continue
+                            
+                            # Send end-of-audio marker (END frame, or a zero-length binary frame)
                             # This gives ESP32 an explicit signal that audio streaming is complete
                             if websocket.client_state.value == 1:
-                                await websocket.send_bytes(b"")  # Zero-length binary frame as EOS marker
-                                await asyncio.sleep(0.01)
-                                print(f"✓ [{session_id}] End-of-audio marker sent (zero-length frame)")
+                                if frames is not None:
+                                    await websocket.send_bytes(frames.end())
+                                    print(f"✓ [{session_id}] End-of-audio marker sent (END frame, seq {frames.seq - 1})")
+                                else:
+                                    await websocket.send_bytes(b"")  # Zero-length binary frame as EOS marker
+                                    await asyncio.sleep(0.01)
+                                    print(f"✓ [{session_id}] End-of-audio marker sent (zero-length frame)")
                             
                             # Send completion signal (check connection first)
+                            timer.mark("complete")
+                            timer.result = "complete"
                             if websocket.client_state.value == 1:
-                                await websocket.send_text(json.dumps({
-                                    "status": "complete"
-                                }))
+                                await websocket.send_text(json.dumps(timer.stamp({
+                                    "status": "complete",
+                                    "response": llm_response
+                                })))
                                 await asyncio.sleep(0.01)
                                 print(f"✓ [{session_id}] Completion signal sent")
                             
@@ -613,34 +1127,63 @@ async def websocket_endpoint(websocket: WebSocket):
                             print(f"⚠ [{session_id}] Could not send completion signals: {send_error}")
                             print(f"   Client likely disconnected during playback - not an error")
                     
+                    except StageBusyError as busy_error:
+                        # Not a fault: the device may retry the utterance after a moment
+                        print(f"🚦 [{session_id}] Turn refused: {busy_error}")
+                        timer.result = "busy"
+                        if websocket.client_state.value == 1:
+                            try:
+                                await websocket.send_text(json.dumps(timer.stamp({
+                                    "status": "error",
+                                    "message": "Server busy. Please try again in a moment.",
+                                    "error_type": "busy"
+                                })))
+                            except Exception as send_error:
+                                print(f"⚠ [{session_id}] Could not send busy message: {send_error}")
+                    
                     except Exception as processing_error:
                         import traceback
                         error_details = traceback.format_exc()
                         print(f"✗ [{session_id}] Processing error: {processing_error}")
                         print(f"   Stack trace:\n{error_details}")
+                        timer.result = "error"
                         # Only send error message if connection still active
                         if websocket.client_state.value == 1:
                             try:
-                                await websocket.send_text(json.dumps({
+                                await websocket.send_text(json.dumps(timer.stamp({
                                     "status": "error",
                                     "message": "An error occurred while processing your request.",
                                     "error_type": type(processing_error).__name__
-                                }))
+                                })))
                             except Exception as send_error:
                                 print(f"⚠ [{session_id}] Could not send error message: {send_error}")
                     
                     finally:
+                        await watch.close()
+                        TURN_METRICS.finish_server(timer)
                         # Reset audio buffer for next utterance
-                        SESSION_AUDIO_BUFFERS[session_id] = io.BytesIO()
-                        SESSION_AUDIO_STATS[session_id] = {"chunks": 0, "bytes": 0}
+                        session.reset_audio()
                         print(f"🔄 [{session_id}] Buffer reset, ready for next input")
                 
+                elif signal_type == "TURN_METRICS":
+                    # Device-side breakdown of a finished turn (times from its end of speech)
+                    accepted = TURN_METRICS.record_device(session_id, signal_data)
+                    if accepted and "first_sample" in accepted:
+                        print(f"⏱️ [{session_id}] Turn {signal_data.get('turn')}: first sample "
+                              f"{accepted['first_sample']:.0f} ms after end of speech "
+                              f"({signal_data.get('result', '?')})")
+                
+                elif signal_type == "BARGE_IN":
+                    # Arrived after the reply finished streaming (device was still playing it)
+                    print(f"✋ [{session_id}] Barge-in after reply streaming ended")
+                    if websocket.client_state.value == 1:
+                        await websocket.send_text(json.dumps({"status": "interrupted"}))
+                
                 elif signal_type == "RESET":
                     # Reset conversation context
                     clear_session_context(session_id)
-                    SESSION_AUDIO_BUFFERS[session_id] = io.BytesIO()
-                    if session_id in SESSION_IMAGES:
-                        del SESSION_IMAGES[session_id]
+                    session.reset_audio()
+                    if SESSIONS.clear_image(session_id):
                         print(f"🗑️ [{session_id}] Cleared stored image context on reset")
                     if websocket.client_state.value == 1:
                         await websocket.send_text(json.dumps({
@@ -660,23 +1203,26 @@ async def websocket_endpoint(websocket: WebSocket):
     
     finally:
         # Cleanup session data
-        if session_id:
-            if session_id in SESSION_AUDIO_BUFFERS:
-                del SESSION_AUDIO_BUFFERS[session_id]
-            if session_id in SESSION_AUDIO_STATS:
-                del SESSION_AUDIO_STATS[session_id]
+        if session is not None:
+            # A reconnect with the same session_id may already own a newer Session
+            SESSIONS.detach(session)
             
             # ✅ CRITICAL FIX: Don't clear image context on disconnect
             # ESP32 may disconnect/reconnect between image capture and voice query
             # Image context should persist across reconnections for same session_id
             # Images will be cleared after use in LLM processing or after extended timeout
-            if session_id in SESSION_IMAGES:
+            if SESSIONS.has_image(session_id):
                 print(f"� [{session_id}] Image context preserved for reconnection")
                 # Optional: Start a timer to clear stale images after 5 minutes
                 # For now, images cleared after use in LLM processing
             
-            clear_session_context(session_id)
-            print(f"🧹 [{session_id}] Session cleaned up")
+            if SESSIONS.get(session_id) is None:
+                clear_session_context(session_id)
+                print(f"🧹 [{session_id}] Session cleaned up")
+            else:
+                # The device reconnected before this socket died: its new connection
+                # keeps the LLM history and running summary
+                print(f"🧹 [{session_id}] Stale connection cleaned up (newer connection keeps context)")
 
 
 if __name__ == "__main__":
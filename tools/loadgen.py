@@ -0,0 +1,508 @@
+#!/usr/bin/env python3
+"""
+Device-Fleet Load Generator - simulated HotPin devices against main.py
+Each device speaks the firmware protocol: the websocket_client_send_handshake()
+handshake, real-time 4 KB PCM chunks under the server's ACK flow window (JSON
+or HPCT binary), {"signal": "EOS", "turn": N}, TTS reception up to the
+END frame (HPAU framed downlink) or zero-length end frame, optional image uploads (multipart /image or HPIM
+frames) and the TURN_METRICS report. Concurrency levels run one after the
+other and each prints per-stage latency percentiles and server throughput.
+
+Usage:
+    python tools/loadgen.py --devices 1,4,16 --turns 5 --wav utterance.wav
+    python tools/loadgen.py --devices 8 --image photo.jpg --json report.json
+"""
+
+import argparse
+import asyncio
+import json
+import os
+import random
+import sys
+import time
+import wave
+from array import array
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Dict, List, Optional
+
+# Reuse the server's framing and percentile code so both sides agree on the numbers
+sys.path.insert(0, str(Path(__file__).resolve().parent.parent))
+from core.control_frames import (  # noqa: E402
+    ACK_PAYLOAD,
+    CONTROL_FRAME_HEADER,
+    CONTROL_FRAME_MAGIC,
+    CONTROL_FRAME_TYPE_ACK,
+)
+from core.image_frames import (  # noqa: E402
+    IMAGE_FLAG_FIRST,
+    IMAGE_FLAG_LAST,
+    IMAGE_FRAME_HEADER,
+    IMAGE_FRAME_MAGIC,
+    IMAGE_FRAME_VERSION,
+)
+from core.tts_frames import (  # noqa: E402
+    TTS_FRAME_HEADER,
+    TTS_FRAME_TYPE_AUDIO,
+    TTS_FRAME_TYPE_END,
+    is_tts_frame,
+)
+from core.turn_metrics import _percentile  # noqa: E402
+
+try:
+    import httpx
+    import websockets
+except ImportError as import_error:
+    print(f"❌ Missing dependency: {import_error} (pip install -r requirements.txt)")
+    sys.exit(1)
+
+# Firmware constants (config.h): 16 kHz mono PCM16 in 4 KB chunks, 4 KB image frames
+SAMPLE_RATE = 16000
+BYTES_PER_SECOND = SAMPLE_RATE * 2
+AUDIO_CHUNK_BYTES = 4096
+IMAGE_CHUNK_BYTES = 4096
+
+# Used until the server advertises its window in the "connected" reply
+DEFAULT_FLOW_WINDOW = 32768
+
+# Stages timed per turn, in turn order, in ms from EOS sent (device.* names in turn_metrics.c)
+TURN_STAGES = ("transcription", "transcript", "reply", "first_audio", "end_audio", "complete")
+
+LOADGEN_SERVER = os.getenv("LOADGEN_SERVER", "ws://localhost:8000")
+
+
+@dataclass
+class TurnResult:
+    device: int
+    turn: int
+    result: str = "timeout"           # complete, not_understood, busy, error, timeout, closed
+    marks: Dict[str, float] = field(default_factory=dict)
+    stall_ms: float = 0.0             # Time the uplink waited on the flow window
+    upload_ms: Optional[float] = None
+    uplink_bytes: int = 0
+    downlink_bytes: int = 0
+
+
+@dataclass
+class LevelResult:
+    devices: int
+    wall_s: float = 0.0
+    connect_ms: List[float] = field(default_factory=list)
+    refused: int = 0
+    turns: List[TurnResult] = field(default_factory=list)
+
+
+def load_speech(path: Optional[str], speech_ms: int) -> bytes:
+    """
+    Utterance PCM for every turn: a 16 kHz mono 16-bit WAV, looped or cut to
+    speech_ms. Without a file, a syllable-rate modulated tone stands in; Vosk
+    hears no words in it, so those turns end as "not_understood" after STT.
+    """
+    target = (BYTES_PER_SECOND * speech_ms // 1000) & ~1
+    if path:
+        with wave.open(path, "rb") as wav:
+            if wav.getframerate() != SAMPLE_RATE or wav.getnchannels() != 1 or wav.getsampwidth() != 2:
+                raise ValueError(f"{path}: need 16 kHz mono 16-bit PCM (device capture format)")
+            pcm = wav.readframes(wav.getnframes())
+        if speech_ms <= 0:
+            return pcm
+        if not pcm:
+            raise ValueError(f"{path}: no audio frames")
+        return (pcm * (target // len(pcm) + 1))[:target]
+
+    import math
+    samples = array("h", (
+        int(6000 * math.sin(2 * math.pi * 220 * n / SAMPLE_RATE)
+            * (0.5 + 0.5 * math.sin(2 * math.pi * 4 * n / SAMPLE_RATE)))
+        for n in range(target // 2)
+    ))
+    if sys.byteorder != "little":
+        samples.byteswap()
+    return samples.tobytes()
+
+
+def image_frames(jpeg: bytes) -> List[bytes]:
+    """Split a JPEG into HPIM frames the way websocket_client_send_image() does."""
+    chunks = [jpeg[i:i + IMAGE_CHUNK_BYTES] for i in range(0, len(jpeg), IMAGE_CHUNK_BYTES)]
+    frames = []
+    for seq, chunk in enumerate(chunks):
+        flags = (IMAGE_FLAG_FIRST if seq == 0 else 0) | (IMAGE_FLAG_LAST if seq == len(chunks) - 1 else 0)
+        frames.append(IMAGE_FRAME_HEADER.pack(IMAGE_FRAME_MAGIC, IMAGE_FRAME_VERSION, flags, seq, len(jpeg)) + chunk)
+    return frames
+
+
+class SimulatedDevice:
+    """
+    One pin: a single WebSocket session running turns back to back.
+
+    A reader task owns the socket's receive side, like the firmware's event
+    handler: ACKs move the flow window, stage messages and audio frames are
+    timestamped against the current turn's EOS.
+    """
+
+    def __init__(self, index: int, args: argparse.Namespace, speech: bytes,
+                 jpeg: Optional[bytes], http: httpx.AsyncClient, level: LevelResult):
+        self.index = index
+        self.args = args
+        self.speech = speech
+        self.jpeg = jpeg
+        self.http = http
+        self.level = level
+        self.session_id = f"{args.session_prefix}-{index:04d}"
+        self.rng = random.Random(args.seed * 1000003 + index)
+
+        self.ws = None
+        self.binary_control = False
+        self.tts_framed = False
+        self.window = DEFAULT_FLOW_WINDOW
+        self.sent_bytes = 0           # Per utterance, like the server's stats["bytes"]
+        self.acked_bytes = 0
+        self.ack_event = asyncio.Event()
+
+        self.current: Optional[TurnResult] = None
+        self.eos_time = 0.0
+        self.turn_done = asyncio.Event()
+
+    def _jitter(self, value_ms: int) -> float:
+        spread = value_ms * self.args.jitter
+        return max(0.0, value_ms + self.rng.uniform(-spread, spread)) / 1000.0
+
+    def _since_eos_ms(self) -> float:
+        return round((time.perf_counter() - self.eos_time) * 1000.0, 1)
+
+    def _mark(self, stage: str) -> None:
+        if self.current is not None and self.eos_time:
+            self.current.marks.setdefault(stage, self._since_eos_ms())
+
+    def _finish(self, result: str) -> None:
+        if self.current is not None and not self.turn_done.is_set():
+            self.current.result = result
+            self.turn_done.set()
+
+    def _on_ack(self, bytes_received: int, window_bytes: int) -> None:
+        self.acked_bytes = max(self.acked_bytes, bytes_received)
+        if window_bytes > 0:
+            self.window = window_bytes
+        self.ack_event.set()
+
+    def _on_binary(self, data: bytes) -> None:
+        if len(data) >= CONTROL_FRAME_HEADER.size and data[:4] == CONTROL_FRAME_MAGIC:
+            magic, version, frame_type, length = CONTROL_FRAME_HEADER.unpack_from(data, 0)
+            if frame_type == CONTROL_FRAME_TYPE_ACK and length >= ACK_PAYLOAD.size:
+                chunks, received, window = ACK_PAYLOAD.unpack_from(data, CONTROL_FRAME_HEADER.size)
+                self._on_ack(received, window)
+            # Prompt-pack chunks are ignored: the pack is never written anywhere here
+            return
+        if self.current is None:
+            return
+        if self.tts_framed and is_tts_frame(data):
+            frame_type = data[5]
+            if frame_type == TTS_FRAME_TYPE_END:
+                self._mark("end_audio")
+            elif frame_type == TTS_FRAME_TYPE_AUDIO:
+                self._mark("first_audio")
+                self.current.downlink_bytes += len(data) - TTS_FRAME_HEADER.size
+            return
+        if len(data) == 0:
+            self._mark("end_audio")
+            return
+        self._mark("first_audio")
+        self.current.downlink_bytes += len(data)
+
+    def _on_text(self, text: str) -> None:
+        try:
+            msg = json.loads(text)
+        except ValueError:
+            return
+        status = msg.get("status")
+        if status == "receiving":
+            self._on_ack(int(msg.get("bytes_received", 0)), int(msg.get("window_bytes", 0)))
+            return
+        if self.current is None or status in ("partial", "image_received", "connected"):
+            return
+        turn = msg.get("turn")
+        if turn is not None and turn != self.current.turn:
+            return  # Late message from an earlier turn
+
+        if status == "processing":
+            stage = msg.get("stage")
+            self._mark({"transcription": "transcription", "llm": "transcript", "tts": "reply"}.get(stage, stage))
+        elif status == "complete":
+            self._mark("complete")
+            self._finish("complete")
+        elif status == "interrupted":
+            self._finish("interrupted")
+        elif status == "error":
+            if msg.get("error_type") == "busy":
+                self._finish("busy")
+            elif "transcript" not in self.current.marks and not msg.get("error_type"):
+                self._finish("not_understood")
+            else:
+                self._finish("error")
+
+    async def _reader(self) -> None:
+        try:
+            async for message in self.ws:
+                if isinstance(message, (bytes, bytearray)):
+                    self._on_binary(bytes(message))
+                else:
+                    self._on_text(message)
+        except websockets.ConnectionClosed:
+            pass
+        finally:
+            self._finish("closed")
+            self.ack_event.set()
+
+    async def _connect(self) -> bool:
+        started = time.perf_counter()
+        self.ws = await websockets.connect(f"{self.args.server}/ws", max_size=None,
+                                           open_timeout=self.args.timeout)
+        handshake = {
+            "session_id": self.session_id,
+            "codecs": ["pcm16"],
+            "sample_rate": SAMPLE_RATE,
+            "prompt_pack": self.args.prompt_pack,
+        }
+        if self.args.control == "binary":
+            handshake["control"] = "binary"
+        if self.args.tts == "framed":
+            handshake["tts"] = "framed"
+        await self.ws.send(json.dumps(handshake))
+
+        reply = json.loads(await asyncio.wait_for(self.ws.recv(), timeout=self.args.timeout))
+        if reply.get("status") != "connected":
+            if reply.get("error_type") == "busy":
+                self.level.refused += 1
+            else:
+                print(f"⚠️ [{self.session_id}] Handshake refused: {reply}")
+            await self.ws.close()
+            return False
+        self.binary_control = reply.get("control") == "binary"
+        self.tts_framed = reply.get("tts") == "framed"
+        self.window = int(reply.get("flow_window") or DEFAULT_FLOW_WINDOW)
+        self.level.connect_ms.append(round((time.perf_counter() - started) * 1000.0, 1))
+        return True
+
+    async def _upload_image(self, result: TurnResult) -> None:
+        started = time.perf_counter()
+        if self.args.image_transport == "ws":
+            for frame in image_frames(self.jpeg):
+                await self.ws.send(frame)
+        else:
+            http_base = self.args.server.replace("ws://", "http://", 1).replace("wss://", "https://", 1)
+            response = await self.http.post(
+                f"{http_base}/image",
+                data={"session": self.session_id},
+                files={"file": ("image.jpg", self.jpeg, "image/jpeg")},
+            )
+            response.raise_for_status()
+        result.upload_ms = round((time.perf_counter() - started) * 1000.0, 1)
+        result.uplink_bytes += len(self.jpeg)
+
+    async def _stream_speech(self, result: TurnResult) -> None:
+        """Real-time capture pace; never more than the window unacknowledged (stt_pipeline.c)."""
+        self.sent_bytes = 0
+        self.acked_bytes = 0
+        chunk_s = AUDIO_CHUNK_BYTES / BYTES_PER_SECOND
+        start = time.perf_counter()
+        for index, offset in enumerate(range(0, len(self.speech), AUDIO_CHUNK_BYTES)):
+            chunk = self.speech[offset:offset + AUDIO_CHUNK_BYTES]
+            delay = start + (index + 1) * chunk_s - time.perf_counter()
+            if delay > 0:
+                await asyncio.sleep(delay)
+
+            stalled = time.perf_counter()
+            while self.sent_bytes - self.acked_bytes + len(chunk) > self.window and not self.turn_done.is_set():
+                self.ack_event.clear()
+                try:
+                    await asyncio.wait_for(self.ack_event.wait(), timeout=self.args.timeout)
+                except asyncio.TimeoutError:
+                    raise RuntimeError("no ACK within the timeout")
+            result.stall_ms += (time.perf_counter() - stalled) * 1000.0
+            if self.turn_done.is_set():
+                return
+
+            await self.ws.send(chunk)
+            self.sent_bytes += len(chunk)
+            result.uplink_bytes += len(chunk)
+
+    async def _report_metrics(self, result: TurnResult) -> None:
+        # Same shape as turn_metrics.c; the device clock starts at EOS here (no VAD hangover)
+        ms = {"eos_sent": 0}
+        ms.update({name: int(result.marks[name])
+                   for name in ("transcription", "transcript", "reply", "first_audio", "complete")
+                   if name in result.marks})
+        await self.ws.send(json.dumps({"signal": "TURN_METRICS", "turn": result.turn,
+                                       "result": result.result, "ms": ms}))
+
+    async def run_turn(self, turn: int) -> TurnResult:
+        result = TurnResult(device=self.index, turn=turn)
+        self.current = result
+        self.eos_time = 0.0
+        self.turn_done.clear()
+
+        if self.jpeg is not None and self.args.image_every > 0 and (turn - 1) % self.args.image_every == 0:
+            await self._upload_image(result)
+        await self._stream_speech(result)
+        if self.turn_done.is_set():
+            return result
+
+        self.eos_time = time.perf_counter()
+        await self.ws.send(json.dumps({"signal": "EOS", "turn": turn}))
+        try:
+            await asyncio.wait_for(self.turn_done.wait(), timeout=self.args.timeout)
+        except asyncio.TimeoutError:
+            result.result = "timeout"
+
+        if self.args.report_metrics and result.result in ("complete", "not_understood", "error"):
+            await self._report_metrics(result)
+        return result
+
+    async def run(self) -> None:
+        await asyncio.sleep(self.rng.uniform(0, self.args.ramp_s))
+        try:
+            if not await self._connect():
+                return
+        except (OSError, asyncio.TimeoutError, websockets.WebSocketException) as connect_error:
+            print(f"⚠️ [{self.session_id}] Connect failed: {connect_error}")
+            self.level.refused += 1
+            return
+
+        reader = asyncio.create_task(self._reader())
+        try:
+            for turn in range(1, self.args.turns + 1):
+                try:
+                    result = await self.run_turn(turn)
+                except (RuntimeError, httpx.HTTPError, websockets.WebSocketException) as turn_error:
+                    print(f"⚠️ [{self.session_id}] Turn {turn} failed: {turn_error}")
+                    self.current.result = "error"
+                    result = self.current
+                self.level.turns.append(result)
+                if result.result == "closed":
+                    break
+                if turn < self.args.turns:
+                    await asyncio.sleep(self._jitter(self.args.think_ms))
+        finally:
+            self.current = None
+            await self.ws.close()
+            reader.cancel()
+
+
+def percentiles(values: List[float]) -> str:
+    if not values:
+        return "-"
+    ordered = sorted(values)
+    return (f"{_percentile(ordered, 0.50):7.0f} {_percentile(ordered, 0.95):7.0f} "
+            f"{_percentile(ordered, 0.99):7.0f}")
+
+
+def summarise(level: LevelResult) -> dict:
+    results: Dict[str, int] = {}
+    for turn in level.turns:
+        results[turn.result] = results.get(turn.result, 0) + 1
+    stages = {}
+    for stage in TURN_STAGES:
+        values = sorted(t.marks[stage] for t in level.turns if stage in t.marks)
+        if values:
+            stages[stage] = {"count": len(values), "p50": _percentile(values, 0.50),
+                             "p95": _percentile(values, 0.95), "p99": _percentile(values, 0.99)}
+    wall = max(level.wall_s, 1e-6)
+    return {
+        "devices": level.devices,
+        "wall_s": round(level.wall_s, 2),
+        "connected": len(level.connect_ms),
+        "refused": level.refused,
+        "results": results,
+        "turns_per_s": round(results.get("complete", 0) / wall, 3),
+        "uplink_kbps": round(sum(t.uplink_bytes for t in level.turns) / wall / 1024.0, 1),
+        "downlink_kbps": round(sum(t.downlink_bytes for t in level.turns) / wall / 1024.0, 1),
+        "stages_ms": stages,
+    }
+
+
+def print_level(level: LevelResult, summary: dict) -> None:
+    print(f"\n📊 {level.devices} device(s): {len(level.turns)} turns in {summary['wall_s']} s, "
+          f"results {summary['results']}, refused {summary['refused']}")
+    print(f"   Throughput: {summary['turns_per_s']} complete turns/s, "
+          f"uplink {summary['uplink_kbps']} KB/s, TTS downlink {summary['downlink_kbps']} KB/s")
+    print(f"   {'stage (ms)':<22} {'p50':>7} {'p95':>7} {'p99':>7}")
+    print(f"   {'connect':<22} {percentiles(level.connect_ms)}")
+    uploads = [t.upload_ms for t in level.turns if t.upload_ms is not None]
+    if uploads:
+        print(f"   {'image upload':<22} {percentiles(uploads)}")
+    print(f"   {'uplink flow stall':<22} {percentiles([t.stall_ms for t in level.turns])}")
+    for stage in TURN_STAGES:
+        values = [t.marks[stage] for t in level.turns if stage in t.marks]
+        if values:
+            print(f"   {'EOS -> ' + stage:<22} {percentiles(values)}")
+
+
+async def run_level(devices: int, args: argparse.Namespace, speech: bytes, jpeg: Optional[bytes]) -> LevelResult:
+    level = LevelResult(devices=devices)
+    limits = httpx.Limits(max_connections=max(devices, 1))
+    async with httpx.AsyncClient(timeout=args.timeout, limits=limits) as http:
+        fleet = [SimulatedDevice(i, args, speech, jpeg, http, level) for i in range(devices)]
+        started = time.perf_counter()
+        await asyncio.gather(*(device.run() for device in fleet))
+        level.wall_s = time.perf_counter() - started
+    return level
+
+
+async def main_async(args: argparse.Namespace) -> int:
+    speech = load_speech(args.wav, args.speech_ms)
+    jpeg = Path(args.image).read_bytes() if args.image else None
+    levels = [int(n) for n in args.devices.split(",") if n.strip()]
+
+    print(f"🚀 Load test against {args.server}: levels {levels}, {args.turns} turn(s) per device, "
+          f"{len(speech) / BYTES_PER_SECOND:.1f} s speech, {args.think_ms} ms think, "
+          f"control {args.control}, tts {args.tts}, image {'%s/%d B' % (args.image_transport, len(jpeg)) if jpeg else 'none'}")
+
+    report = []
+    for devices in levels:
+        level = await run_level(devices, args, speech, jpeg)
+        summary = summarise(level)
+        print_level(level, summary)
+        report.append(summary)
+        if devices != levels[-1]:
+            await asyncio.sleep(args.settle_s)
+
+    if args.json:
+        Path(args.json).write_text(json.dumps({"server": args.server, "levels": report}, indent=2))
+        print(f"\n💾 Report written to {args.json}")
+
+    failed = sum(s["results"].get("error", 0) + s["results"].get("timeout", 0) for s in report)
+    return 1 if failed else 0
+
+
+def parse_args() -> argparse.Namespace:
+    parser = argparse.ArgumentParser(description="Simulate a fleet of HotPin devices against the server")
+    parser.add_argument("--server", default=LOADGEN_SERVER, help="ws:// base URL (env LOADGEN_SERVER)")
+    parser.add_argument("--devices", default="1,4,16", help="Comma-separated concurrency levels")
+    parser.add_argument("--turns", type=int, default=3, help="Turns per device per level")
+    parser.add_argument("--wav", help="16 kHz mono 16-bit utterance (default: synthetic tone)")
+    parser.add_argument("--speech-ms", type=int, default=2000, help="Speech per turn (0 = whole WAV)")
+    parser.add_argument("--think-ms", type=int, default=3000, help="Pause between a reply and the next turn")
+    parser.add_argument("--jitter", type=float, default=0.25, help="Think-time spread, fraction of --think-ms")
+    parser.add_argument("--ramp-s", type=float, default=2.0, help="Devices connect at random within this")
+    parser.add_argument("--control", choices=("binary", "json"), default="binary",
+                        help="Offer HPCT binary ACKs (CONFIG_WS_BINARY_CONTROL) or stay on JSON")
+    parser.add_argument("--tts", choices=("framed", "wav"), default="framed",
+                        help="Offer the HPAU framed TTS downlink (CONFIG_TTS_FRAMED_STREAM) or take WAV")
+    parser.add_argument("--prompt-pack", type=int, default=0,
+                        help="Prompt pack version the devices claim (0 = fresh device, server pushes its pack)")
+    parser.add_argument("--image", help="JPEG to send before turns")
+    parser.add_argument("--image-every", type=int, default=1, help="Send the image every N turns")
+    parser.add_argument("--image-transport", choices=("http", "ws"), default="http",
+                        help="Multipart POST /image or HPIM frames on the session socket")
+    parser.add_argument("--no-report-metrics", dest="report_metrics", action="store_false",
+                        help="Skip the TURN_METRICS report after each turn")
+    parser.add_argument("--timeout", type=float, default=60.0, help="Per-wait timeout in seconds")
+    parser.add_argument("--settle-s", type=float, default=5.0, help="Pause between concurrency levels")
+    parser.add_argument("--session-prefix", default="loadgen", help="Session ids are <prefix>-NNNN")
+    parser.add_argument("--seed", type=int, default=1, help="Seed for ramp and think-time jitter")
+    parser.add_argument("--json", help="Write the per-level summary to this file")
+    return parser.parse_args()
+
+
+if __name__ == "__main__":
+    sys.exit(asyncio.run(main_async(parse_args())))